@@ -0,0 +1,434 @@
+/*
+ * bitpar.c
+ *
+ * Bit-parallel matching algorithms, which keep the state of all of the
+ * alignments of the pattern ending at the current text position in
+ * machine words.  The variants are 1) Shift-Or, for exact matching,
+ * 2) BNDM (backward nondeterministic DAWG matching), for exact matching
+ * with shifts, and 3) Shift-Add, for matching with at most k mismatches.
+ *
+ * Shift-Or and Shift-Add use as many 64 bit words as the pattern needs.
+ * BNDM runs the automaton on the first 64 characters of the pattern and
+ * verifies the rest of the pattern at each of their occurrences.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitpar.h"
+
+
+/*
+ * bitpar_alloc
+ *
+ * Allocate a BITPAR_STRUCT with W words per character mask and per
+ * state vector.
+ */
+static BITPAR_STRUCT *bitpar_alloc(char *S, int M, int copyflag,
+                                   BITPAR_TYPE type, int W)
+{
+  BITPAR_STRUCT *node;
+
+  if (S == NULL || M <= 0)
+    return NULL;
+
+  if ((node = malloc(sizeof(BITPAR_STRUCT))) == NULL)
+    return NULL;
+  memset(node, 0, sizeof(BITPAR_STRUCT));
+
+  node->type = type;
+  node->M = M;
+  node->W = W;
+  node->copyflag = copyflag;
+
+  if (!copyflag)
+    node->P = S;
+  else {
+    if ((node->P = malloc(M+1)) == NULL) {
+      free(node);
+      return NULL;
+    }
+    memcpy(node->P, S, M);
+    node->P[M] = '\0';
+  }
+
+  node->B = malloc(256 * W * sizeof(BITPAR_WORD));
+  node->D = malloc(W * sizeof(BITPAR_WORD));
+  node->O = malloc(W * sizeof(BITPAR_WORD));
+  if (node->B == NULL || node->D == NULL || node->O == NULL) {
+    bitpar_free(node);
+    return NULL;
+  }
+
+  return node;
+}
+
+
+/*
+ * shiftor_prep
+ *
+ * Preprocessing for the Shift-Or algorithm.  Bit i of the mask of
+ * character c is zero when P[i+1] is c (and the bits past the end of
+ * the pattern are one).
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized BITPAR_STRUCT structure, or NULL.
+ */
+BITPAR_STRUCT *shiftor_prep(char *S, int M, int copyflag)
+{
+  int i, W;
+  BITPAR_WORD *B;
+  BITPAR_STRUCT *node;
+
+  W = (M + BITPAR_BITS - 1) / BITPAR_BITS;
+  if ((node = bitpar_alloc(S, M, copyflag, BITPAR_SHIFTOR, W)) == NULL)
+    return NULL;
+
+  B = node->B;
+  memset(B, 0xff, 256 * W * sizeof(BITPAR_WORD));
+  for (i=0; i < M; i++)
+    B[(unsigned char) node->P[i] * W + i / BITPAR_BITS] &=
+      ~((BITPAR_WORD) 1 << (i % BITPAR_BITS));
+
+  return node;
+}
+
+
+/*
+ * shiftor_search
+ *
+ * Search a sequence text using the Shift-Or algorithm.  Bit i of the
+ * state is zero when P[1..i+1] matches the text ending at the current
+ * position, so a match ends wherever bit M-1 is zero.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *shiftor_search(BITPAR_STRUCT *node, char *T, int N, int initmatch)
+{
+  int j, w, M, W;
+  BITPAR_WORD d, hi, carry, next, *B, *D;
+
+  if (node->type != BITPAR_SHIFTOR)
+    return NULL;
+
+  M = node->M;
+  W = node->W;
+  B = node->B;
+
+  j = (initmatch ? 1 : 0);
+  if (N - j < M)
+    return NULL;
+
+  hi = (BITPAR_WORD) 1 << ((M - 1) % BITPAR_BITS);
+
+  /*
+   * The one word version.
+   */
+  if (W == 1) {
+    for (d=~(BITPAR_WORD) 0; j < N; j++) {
+      d = (d << 1) | B[(unsigned char) T[j]];
+
+#ifdef STATS
+      node->num_steps++;
+#endif
+
+      if ((d & hi) == 0)
+        return &T[j-M+1];
+    }
+    return NULL;
+  }
+
+  /*
+   * The multi-word version, shifting the vector one word at a time.
+   */
+  D = node->D;
+  for (w=0; w < W; w++)
+    D[w] = ~(BITPAR_WORD) 0;
+
+  for ( ; j < N; j++) {
+    B = node->B + (unsigned char) T[j] * W;
+    for (w=0,carry=0; w < W; w++) {
+      next = D[w] >> (BITPAR_BITS - 1);
+      D[w] = (D[w] << 1) | carry | B[w];
+      carry = next;
+    }
+
+#ifdef STATS
+    node->num_steps++;
+#endif
+
+    if ((D[W-1] & hi) == 0)
+      return &T[j-M+1];
+  }
+
+  return NULL;
+}
+
+
+/*
+ * bndm_prep
+ *
+ * Preprocessing for the BNDM algorithm, over the first m = min(M, 64)
+ * characters of the pattern.  Bit m-1-i of the mask of character c is
+ * one when P[i+1] is c.
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized BITPAR_STRUCT structure, or NULL.
+ */
+BITPAR_STRUCT *bndm_prep(char *S, int M, int copyflag)
+{
+  int i, m;
+  BITPAR_STRUCT *node;
+
+  if ((node = bitpar_alloc(S, M, copyflag, BITPAR_BNDM, 1)) == NULL)
+    return NULL;
+
+  m = (M < BITPAR_BITS ? M : BITPAR_BITS);
+  memset(node->B, 0, 256 * sizeof(BITPAR_WORD));
+  for (i=0; i < m; i++)
+    node->B[(unsigned char) node->P[i]] |= (BITPAR_WORD) 1 << (m - 1 - i);
+
+  return node;
+}
+
+
+/*
+ * bndm_search
+ *
+ * Search a sequence text using the BNDM algorithm.  Each window of the
+ * text is read backwards while it is still a factor of the pattern
+ * prefix, remembering the last point where it was a prefix (which
+ * gives the shift).  When the whole prefix is read, the rest of the
+ * pattern is compared.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *bndm_search(BITPAR_STRUCT *node, char *T, int N, int initmatch)
+{
+  int i, j, m, M, pos, last;
+  char *P;
+  BITPAR_WORD d, hi, *B;
+
+  if (node->type != BITPAR_BNDM)
+    return NULL;
+
+  P = node->P;
+  M = node->M;
+  B = node->B;
+  m = (M < BITPAR_BITS ? M : BITPAR_BITS);
+  hi = (BITPAR_WORD) 1 << (m - 1);
+
+  pos = (initmatch ? 1 : 0);
+  while (pos <= N - M) {
+#ifdef STATS
+    node->num_windows++;
+#endif
+
+    j = m;
+    last = m;
+    d = (m < BITPAR_BITS ? (hi << 1) - 1 : ~(BITPAR_WORD) 0);
+    while (j > 0 && d != 0) {
+      d &= B[(unsigned char) T[pos+j-1]];
+      j--;
+
+#ifdef STATS
+      node->num_steps++;
+#endif
+
+      if (d & hi) {
+        if (j > 0)
+          last = j;
+        else {
+          for (i=m; i < M && P[i] == T[pos+i]; i++) ;
+
+#ifdef STATS
+          node->num_verify++;
+          node->num_compares += i - m + (i < M ? 1 : 0);
+#endif
+
+          if (i == M)
+            return &T[pos];
+        }
+      }
+      d <<= 1;
+    }
+
+    pos += last;
+  }
+
+  return NULL;
+}
+
+
+/*
+ * shiftadd_prep
+ *
+ * Preprocessing for the Shift-Add algorithm.  The state holds one
+ * counter of fbits bits per pattern position, with the top bit of
+ * each counter catching its overflow, so fbits is the smallest width
+ * where the counters can reach k+1 before overflowing.  The counters
+ * do not straddle words.  Counter i of the mask of character c is one
+ * when P[i+1] is not c.
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               k         -  the number of mismatches allowed
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized BITPAR_STRUCT structure, or NULL.
+ */
+BITPAR_STRUCT *shiftadd_prep(char *S, int M, int k, int copyflag)
+{
+  int c, i, W, fbits, nfields;
+  BITPAR_STRUCT *node;
+
+  if (k < 0)
+    return NULL;
+  if (k > M)
+    k = M;
+
+  for (fbits=1; fbits < BITPAR_BITS / 2 && (1 << (fbits - 1)) <= k; fbits++)
+    ;
+  nfields = BITPAR_BITS / fbits;
+  W = (M + nfields - 1) / nfields;
+
+  if ((node = bitpar_alloc(S, M, copyflag, BITPAR_SHIFTADD, W)) == NULL)
+    return NULL;
+
+  node->k = k;
+  node->fbits = fbits;
+  node->nfields = nfields;
+
+  memset(node->B, 0, 256 * W * sizeof(BITPAR_WORD));
+  for (c=0; c < 256; c++)
+    for (i=0; i < M; i++)
+      if ((unsigned char) node->P[i] != c)
+        node->B[c * W + i / nfields] |=
+          (BITPAR_WORD) 1 << ((i % nfields) * fbits);
+
+  return node;
+}
+
+
+/*
+ * shiftadd_search
+ *
+ * Search a sequence text for the alignments of the pattern with at
+ * most k mismatches, using the Shift-Add algorithm.  Counter i of D
+ * holds the mismatches between P[1..i+1] and the text ending at the
+ * current position, and O holds the counters which have overflowed.
+ * The number of mismatches of the match found is left in node->score.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *shiftadd_search(BITPAR_STRUCT *node, char *T, int N, int initmatch)
+{
+  int j, w, M, W, fbits, top, shift, start, count;
+  BITPAR_WORD used, high, field, dcarry, ocarry, dnext, onext;
+  BITPAR_WORD *B, *D, *O;
+
+  if (node->type != BITPAR_SHIFTADD)
+    return NULL;
+
+  M = node->M;
+  W = node->W;
+  D = node->D;
+  O = node->O;
+  fbits = node->fbits;
+
+  start = (initmatch ? 1 : 0);
+  if (N - start < M)
+    return NULL;
+
+  /*
+   * The masks of the used bits, of the overflow bits and of one
+   * counter, and the positions of the top counter of a word and of
+   * counter M-1.
+   */
+  top = (node->nfields - 1) * fbits;
+  used = (node->nfields * fbits < BITPAR_BITS
+            ? ((BITPAR_WORD) 1 << (node->nfields * fbits)) - 1
+            : ~(BITPAR_WORD) 0);
+  field = ((BITPAR_WORD) 1 << fbits) - 1;
+  for (high=0,w=0; w < node->nfields; w++)
+    high |= (BITPAR_WORD) 1 << (w * fbits + fbits - 1);
+  shift = ((M - 1) % node->nfields) * fbits;
+
+  for (w=0; w < W; w++)
+    D[w] = O[w] = 0;
+
+  for (j=start; j < N; j++) {
+    B = node->B + (unsigned char) T[j] * W;
+    for (w=0,dcarry=ocarry=0; w < W; w++) {
+      dnext = D[w] >> top;
+      onext = O[w] >> top;
+      D[w] = (((D[w] << fbits) & used) | dcarry) + B[w];
+      O[w] = (((O[w] << fbits) & used) | ocarry) | (D[w] & high);
+      D[w] &= ~high;
+      dcarry = dnext;
+      ocarry = onext;
+    }
+
+#ifdef STATS
+    node->num_steps++;
+#endif
+
+    if (j - start >= M - 1 && ((O[W-1] >> shift) & field) == 0) {
+      count = (int) ((D[W-1] >> shift) & field);
+      if (count <= node->k) {
+        node->score = count;
+        return &T[j-M+1];
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
+/*
+ * bitpar_free
+ *
+ * Free up the allocated BITPAR_STRUCT structure (of any of the
+ * variants).
+ *
+ * Parameters:   node  -  a BITPAR_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
+void bitpar_free(BITPAR_STRUCT *node)
+{
+  if (node == NULL)
+    return;
+
+  if (node->copyflag && node->P != NULL)
+    free(node->P);
+  if (node->B != NULL)
+    free(node->B);
+  if (node->D != NULL)
+    free(node->D);
+  if (node->O != NULL)
+    free(node->O);
+  free(node);
+}
@@ -0,0 +1,36 @@
+
+#ifndef _BITPAR_H_
+#define _BITPAR_H_
+
+typedef unsigned long long BITPAR_WORD;
+
+#define BITPAR_BITS 64
+
+typedef enum {
+  BITPAR_SHIFTOR, BITPAR_BNDM, BITPAR_SHIFTADD
+} BITPAR_TYPE;
+
+typedef struct {
+  BITPAR_TYPE type;
+
+  char *P;
+  int M, copyflag;
+  int k, W, fbits, nfields;   /* mismatch bound, words per vector, and the
+                                 bits and fields per word (Shift-Add) */
+  BITPAR_WORD *B;             /* the character masks, W words each */
+  BITPAR_WORD *D, *O;         /* the state vectors */
+
+  int score;                  /* the mismatches of the last match */
+
+  int num_steps, num_windows, num_verify, num_compares;
+} BITPAR_STRUCT;
+
+BITPAR_STRUCT *shiftor_prep(char *S, int M, int copyflag);
+char *shiftor_search(BITPAR_STRUCT *node, char *T, int N, int initmatch);
+BITPAR_STRUCT *bndm_prep(char *S, int M, int copyflag);
+char *bndm_search(BITPAR_STRUCT *node, char *T, int N, int initmatch);
+BITPAR_STRUCT *shiftadd_prep(char *S, int M, int k, int copyflag);
+char *shiftadd_search(BITPAR_STRUCT *node, char *T, int N, int initmatch);
+void bitpar_free(BITPAR_STRUCT *node);
+
+#endif
@@ -475,7 +475,8 @@ BM_STRUCT *bmgood_prep(char *P, int M, int copyflag)
    */
   for (j=1; j < M; j++) {
     i = M - Z[M-j+1] + 1;
-    Lprime[i] = j;
+    if (i <= M)
+      Lprime[i] = j;
 
 #ifdef STATS
     node->prep_compares++;
@@ -533,7 +534,7 @@ char *bmgood_search(BM_STRUCT *node, char *T, int N, int initmatch)
     /*
      * Perform a good shift to shift past the match.
      */
-    gshift = M - lprime[2];
+    gshift = (M > 1 ? M - lprime[2] : 1);
     k += gshift;
 
 #ifdef STATS
@@ -758,7 +759,8 @@ BM_STRUCT *bmextgood_prep(char *P, int M, int copyflag)
    */
   for (j=1; j < M; j++) {
     i = M - Z[M-j+1] + 1;
-    Lprime[i] = j;
+    if (i <= M)
+      Lprime[i] = j;
 
 #ifdef STATS
     node->prep_compares++;
@@ -817,7 +819,7 @@ char *bmextgood_search(BM_STRUCT *node, char *T, int N, int initmatch)
     /*
      * Perform a good shift to shift past the match.
      */
-    gshift = M - lprime[2];
+    gshift = (M > 1 ? M - lprime[2] : 1);
     k += gshift;
 
 #ifdef STATS
@@ -940,3 +942,218 @@ void bm_free(BM_STRUCT *node)
   
   free(node);
 }
+
+
+/*
+ * bm_stream_search
+ *
+ * Call the search function matching the variant of a preprocessed
+ * pattern.
+ */
+static char *bm_stream_search(BM_STRUCT *node, char *T, int N, int initmatch)
+{
+  switch (node->type) {
+  case BM_BAD:       return bmbad_search(node, T, N, initmatch);
+  case BM_EXT:       return bmext_search(node, T, N, initmatch);
+  case BM_GOOD:      return bmgood_search(node, T, N, initmatch);
+  case BM_EXTGOOD:   return bmextgood_search(node, T, N, initmatch);
+  default:           return NULL;
+  }
+}
+
+
+/*
+ * bm_stream_open
+ *
+ * Start a streaming search with a preprocessed pattern (of any of the
+ * variants), where the text is passed in as a sequence of buffers.  The
+ * state kept between the buffers is the last M-1 characters of the
+ * stream, so a match crossing a buffer boundary is found by searching
+ * that tail joined to the first M-1 characters of the next buffer.  The
+ * rest of each buffer is searched in place.
+ *
+ * Parameters:   node  -  a preprocessed pattern
+ *
+ * Returns:  A BM_STREAM structure, or NULL if out of memory.
+ */
+BM_STREAM *bm_stream_open(BM_STRUCT *node)
+{
+  BM_STREAM *bs;
+
+  if (node == NULL)
+    return NULL;
+
+  if ((bs = malloc(sizeof(BM_STREAM))) == NULL)
+    return NULL;
+  memset(bs, 0, sizeof(BM_STREAM));
+
+  bs->node = node;
+  if ((bs->tail = malloc(node->M)) == NULL ||
+      (bs->next_tail = malloc(node->M)) == NULL ||
+      (bs->joint = malloc(2 * node->M)) == NULL) {
+    bm_stream_close(bs);
+    return NULL;
+  }
+
+  return bs;
+}
+
+
+/*
+ * bm_stream_feed
+ *
+ * Pass the next buffer of the text to a streaming search.  The matches
+ * ending in the buffer are then returned by bm_stream_next.  The buffer
+ * must stay valid until the next call to bm_stream_feed or
+ * bm_stream_flush, and any of its matches not yet returned then are
+ * skipped.
+ *
+ * Parameters:   bs   -  a streaming search
+ *               buf  -  the buffer
+ *               len  -  the buffer length
+ *
+ * Returns:  nothing.
+ */
+void bm_stream_feed(BM_STREAM *bs, char *buf, int len)
+{
+  int head, keep;
+  char *temp;
+
+  /*
+   * The tail saved by the previous call becomes the current tail.
+   */
+  temp = bs->tail;
+  bs->tail = bs->next_tail;
+  bs->next_tail = temp;
+  bs->tail_len = bs->next_len;
+  bs->offset += bs->len;
+
+  bs->buf = buf;
+  bs->len = len;
+  bs->phase = 0;
+  bs->last = NULL;
+
+  /*
+   * Join the tail and the start of the buffer, and save the last M-1
+   * characters of the stream for the next call.
+   */
+  head = (len < bs->node->M - 1 ? len : bs->node->M - 1);
+  memcpy(bs->joint, bs->tail, bs->tail_len);
+  memcpy(bs->joint + bs->tail_len, buf, head);
+  bs->joint_len = bs->tail_len + head;
+
+  keep = bs->tail_len + len;
+  if (keep > bs->node->M - 1)
+    keep = bs->node->M - 1;
+  if (len >= keep)
+    memcpy(bs->next_tail, buf + len - keep, keep);
+  else {
+    memcpy(bs->next_tail, bs->tail + bs->tail_len - (keep - len), keep - len);
+    memcpy(bs->next_tail + keep - len, buf, len);
+  }
+  bs->next_len = keep;
+}
+
+
+/*
+ * bm_stream_next
+ *
+ * Find the next match ending in the current buffer of a streaming
+ * search.  The matches starting in the tail are found in the joined
+ * string (any match found there starting in the buffer is left for
+ * the search of the buffer itself).
+ *
+ * Parameters:   bs  -  a streaming search
+ *
+ * Returns:  The position of the match in the whole stream (with the
+ *           first character at position 1), or 0 if the rest of the
+ *           buffer holds no match.
+ */
+long bm_stream_next(BM_STREAM *bs)
+{
+  char *s;
+
+  if (bs->phase == 0) {
+    if (bs->last == NULL)
+      s = bm_stream_search(bs->node, bs->joint, bs->joint_len, 0);
+    else
+      s = bm_stream_search(bs->node, bs->last,
+                           bs->joint_len - (bs->last - bs->joint), 1);
+
+    if (s != NULL && s - bs->joint < bs->tail_len) {
+      bs->last = s;
+      bs->num_matches++;
+      return bs->offset - bs->tail_len + (s - bs->joint) + 1;
+    }
+
+    bs->phase = 1;
+    bs->last = NULL;
+  }
+
+  if (bs->phase == 1) {
+    if (bs->last == NULL)
+      s = bm_stream_search(bs->node, bs->buf, bs->len, 0);
+    else
+      s = bm_stream_search(bs->node, bs->last,
+                           bs->len - (bs->last - bs->buf), 1);
+
+    if (s != NULL) {
+      bs->last = s;
+      bs->num_matches++;
+      return bs->offset + (s - bs->buf) + 1;
+    }
+
+    bs->phase = 2;
+  }
+
+  return 0;
+}
+
+
+/*
+ * bm_stream_flush
+ *
+ * Complete a streaming search (skipping any matches of the last buffer
+ * not yet returned), and reset it so that another stream can be fed.
+ * The match count is left in place for the caller.
+ *
+ * Parameters:   bs  -  a streaming search
+ *
+ * Returns:  The length of the stream.
+ */
+long bm_stream_flush(BM_STREAM *bs)
+{
+  long total;
+
+  total = bs->offset + bs->len;
+
+  bs->tail_len = bs->next_len = bs->joint_len = 0;
+  bs->buf = bs->last = NULL;
+  bs->len = bs->phase = 0;
+  bs->offset = 0;
+  return total;
+}
+
+
+/*
+ * bm_stream_close
+ *
+ * Free up a BM_STREAM structure (but not its preprocessed pattern).
+ *
+ * Parameters:   bs  -  a streaming search
+ *
+ * Returns:  nothing.
+ */
+void bm_stream_close(BM_STREAM *bs)
+{
+  if (bs == NULL)
+    return;
+
+  if (bs->tail != NULL)
+    free(bs->tail);
+  if (bs->next_tail != NULL)
+    free(bs->next_tail);
+  if (bs->joint != NULL)
+    free(bs->joint);
+  free(bs);
+}
@@ -18,6 +18,22 @@ typedef struct {
   int num_init_mismatch;
 } BM_STRUCT;
 
+typedef struct {
+  BM_STRUCT *node;
+
+  char *tail, *next_tail;     /* the last M-1 characters before/after buf */
+  int tail_len, next_len;
+  char *joint;                /* tail followed by the start of buf */
+  int joint_len;
+
+  char *buf;                  /* the buffer being scanned */
+  int len, phase;
+  char *last;                 /* the last match returned, or NULL */
+  long offset;                /* the stream length before buf */
+
+  long num_matches;           /* the matches returned */
+} BM_STREAM;
+
 
 BM_STRUCT *bmbad_prep(char *S, int M, int copyflag);
 char *bmbad_search(BM_STRUCT *node, char *T, int N, int initmatch);
@@ -29,4 +45,10 @@ BM_STRUCT *bmextgood_prep(char *S, int M, int copyflag);
 char *bmextgood_search(BM_STRUCT *node, char *T, int N, int initmatch);
 void bm_free(BM_STRUCT *node);
 
+BM_STREAM *bm_stream_open(BM_STRUCT *node);
+void bm_stream_feed(BM_STREAM *bs, char *buf, int len);
+long bm_stream_next(BM_STREAM *bs);
+long bm_stream_flush(BM_STREAM *bs);
+void bm_stream_close(BM_STREAM *bs);
+
 #endif
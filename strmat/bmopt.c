@@ -1,3 +1,20 @@
+/*
+ * bmopt.c
+ *
+ * Tuned versions of the Boyer-Moore family of algorithms, for callers
+ * that want speed rather than statistics (the skip loops have no STATS
+ * code, only the verification of the candidate alignments is counted).
+ * The variants are 1) Boyer-Moore with an unrolled skip loop over the
+ * bad character shifts and the strong good suffix rule, 2) Horspool's
+ * simplification, which shifts on the text character aligned with the
+ * end of the pattern, and 3) Sunday's quick search, which shifts on the
+ * text character just past the end of the pattern.
+ *
+ * NOTES:
+ *   10/26  -  Added to strmat, with the Horspool and Sunday variants,
+ *             the strmat calling convention and bounds checks on the
+ *             unrolled skip loop.
+ */
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -5,45 +22,94 @@
 #include "bmopt.h"
 
 
-BMOPT_STRUCT *bmopt_prep(char *P, int M)
+/*
+ * bmopt_alloc
+ *
+ * Allocate a BMOPT_STRUCT with its shift tables, and compute the
+ * (simple) bad character rule R.  The tables are indexed by characters
+ * as ints, so they cover -128..255 whether or not char is signed.
+ */
+static BMOPT_STRUCT *bmopt_alloc(char *S, int M, int copyflag,
+                                 BMOPT_TYPE type)
 {
-  int i, j, size, count, *buf, *R, *B, *Z, *L, *l;
-  char *p, *t;
+  int i, size, *buf;
+  char *p;
   BMOPT_STRUCT *node;
 
-  if ((node = malloc(sizeof(BMOPT_STRUCT))) == NULL)
+  if (S == NULL || M <= 0)
     return NULL;
 
-  if ((node->P = malloc(M+1)) == NULL) {
-    free(node);
+  if ((node = malloc(sizeof(BMOPT_STRUCT))) == NULL)
     return NULL;
-  }
-  memcpy(node->P, P, M);
-  node->P[M] = '\0';
+  memset(node, 0, sizeof(BMOPT_STRUCT));
+
+  node->type = type;
   node->M = M;
+  node->copyflag = copyflag;
+
+  if (!copyflag)
+    node->P = S;
+  else {
+    if ((node->P = malloc(M+1)) == NULL) {
+      free(node);
+      return NULL;
+    }
+    memcpy(node->P, S, M);
+    node->P[M] = '\0';
+  }
 
-  size = (770 + 3 * (M + 1)) * sizeof(int);
+  size = (770 + (type == BMOPT_TUNED ? 3 * (M + 1) : 0)) * sizeof(int);
   if ((buf = malloc(size)) == NULL) {
-    free(node->P);
-    free(node);
+    bmopt_free(node);
     return NULL;
   }
   memset(buf, 0, size);
 
-  node->R = R = buf + 129;  buf += 385;
-  node->B = B = buf + 129;  buf += 385;
-  Z = buf;  buf += M + 1;
-  node->L = L = buf;  buf += M + 1;
-  l = buf;
+  node->R = buf + 129;
+  node->B = buf + 385 + 129;
+  if (type == BMOPT_TUNED)
+    node->L = buf + 770 + M + 1;
+
+  for (i=1,p=node->P; i <= M; i++,p++)
+    node->R[(int) *p] = i;
+
+  return node;
+}
+
+
+/*
+ * bmopt_prep
+ *
+ * Preprocessing for the tuned Boyer-Moore algorithm.
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized BMOPT_STRUCT structure, or NULL.
+ */
+BMOPT_STRUCT *bmopt_prep(char *S, int M, int copyflag)
+{
+  int i, j, count, *R, *B, *Z, *L, *l;
+  char *p, *t, *P;
+  BMOPT_STRUCT *node;
+
+  if ((node = bmopt_alloc(S, M, copyflag, BMOPT_TUNED)) == NULL)
+    return NULL;
+
+  P = node->P;
+  R = node->R;
+  B = node->B;
+  L = node->L;
+  Z = L - (M + 1);
+  l = L + (M + 1);
 
   /*
    * Preprocess the keyword.
    *
-   * Simple bad character rule.
+   * Simple bad character rule, with the shift of the pattern's last
+   * character being zero (which stops the skip loop).
    */
-  for (i=1,p=P; i <= M; i++,p++)
-    R[(int) *p] = i;
-
   for (i=-128; i < 256; i++)
     B[i] = M - R[i];
 
@@ -85,10 +151,26 @@ BMOPT_STRUCT *bmopt_prep(char *P, int M)
   return node;
 }
 
-char *bmopt_search(BMOPT_STRUCT *node, char *T, char *Tend)
+
+/*
+ * bmopt_search
+ *
+ * Search a sequence text using the tuned Boyer-Moore algorithm.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *bmopt_search(BMOPT_STRUCT *node, char *T, int N, int initmatch)
 {
   int i, shift, gshift, M, *R, *B, *L;
-  char *p, *pend, *t, *t2, *P;
+  char *p, *pend, *t, *t2, *P, *Tend;
+
+  if (node->type != BMOPT_TUNED)
+    return NULL;
 
   P = node->P;
   M = node->M;
@@ -97,20 +179,26 @@ char *bmopt_search(BMOPT_STRUCT *node, char *T, char *Tend)
   L = node->L;
 
   pend = P + M;
+  Tend = T + N;
 
-  t = T + M - 1;
+  t = T + M - 1 + (initmatch ? 1 : 0);
   while (t < Tend) {
     /*
-     * Run a small loop handling the cases of initial mismatches.
+     * Run a small loop handling the cases of initial mismatches, three
+     * shifts at a time while they cannot run off the end of the text
+     * (each shift is at most M), then one at a time.
      */
-    t += (shift = B[(int) *t]);
-    while (shift) {
+    while (Tend - t > 2 * M) {
       t += B[(int) *t];
       t += B[(int) *t];
-      t += (shift = B[(int) *t]);
-      if (t >= Tend)
-        goto BMOPT_LOOP_END;
+      t += B[(int) *t];
+      if (t >= Tend || B[(int) *t] == 0)
+        break;
     }
+    while (t < Tend && (shift = B[(int) *t]) != 0)
+      t += shift;
+    if (t >= Tend)
+      break;
 
     /*
      * Check the possible match.
@@ -124,6 +212,11 @@ char *bmopt_search(BMOPT_STRUCT *node, char *T, char *Tend)
       t2--;
     }
 
+#ifdef STATS
+    node->num_verify++;
+    node->num_compares += M - i + (i ? 1 : 0);
+#endif
+
     if (i) {
       gshift = L[i+1];
       if ((i -= R[(int) *t2]) > gshift)
@@ -134,19 +227,191 @@ char *bmopt_search(BMOPT_STRUCT *node, char *T, char *Tend)
     else
       return t-M+1;
   }
-BMOPT_LOOP_END:
 
   return NULL;
 }
 
+
+/*
+ * horspool_prep
+ *
+ * Preprocessing for Horspool's algorithm, whose shift is M minus the
+ * position of the last occurrence of the character in P[1..M-1].
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized BMOPT_STRUCT structure, or NULL.
+ */
+BMOPT_STRUCT *horspool_prep(char *S, int M, int copyflag)
+{
+  int i, *B;
+  BMOPT_STRUCT *node;
+
+  if ((node = bmopt_alloc(S, M, copyflag, BMOPT_HORSPOOL)) == NULL)
+    return NULL;
+
+  B = node->B;
+  for (i=-128; i < 256; i++)
+    B[i] = M;
+  for (i=1; i < M; i++)
+    B[(int) node->P[i-1]] = M - i;
+
+  return node;
+}
+
+
+/*
+ * horspool_search
+ *
+ * Search a sequence text using Horspool's algorithm.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *horspool_search(BMOPT_STRUCT *node, char *T, int N, int initmatch)
+{
+  int i, k, M, *B;
+  char ch, last, *P;
+
+  if (node->type != BMOPT_HORSPOOL)
+    return NULL;
+
+  T--;            /* Shift to make sequence be T[1],...,T[N] */
+
+  P = node->P;
+  M = node->M;
+  B = node->B;
+  last = P[M-1];
+
+  /*
+   * k is the text position aligned with the end of the pattern.
+   */
+  k = M + (initmatch ? 1 : 0);
+  while (k <= N) {
+    ch = T[k];
+    if (ch == last) {
+      for (i=M-1; i > 0 && P[i-1] == T[k-M+i]; i--) ;
+
+#ifdef STATS
+      node->num_verify++;
+      node->num_compares += M - i + (i ? 1 : 0);
+#endif
+
+      if (i == 0)
+        return &T[k-M+1];
+    }
+#ifdef STATS
+    else
+      node->num_compares++;
+#endif
+
+    k += B[(int) ch];
+  }
+
+  return NULL;
+}
+
+
+/*
+ * sunday_prep
+ *
+ * Preprocessing for Sunday's quick search, whose shift is M + 1 minus
+ * the position of the last occurrence of the character in P[1..M].
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized BMOPT_STRUCT structure, or NULL.
+ */
+BMOPT_STRUCT *sunday_prep(char *S, int M, int copyflag)
+{
+  int i;
+  BMOPT_STRUCT *node;
+
+  if ((node = bmopt_alloc(S, M, copyflag, BMOPT_SUNDAY)) == NULL)
+    return NULL;
+
+  for (i=-128; i < 256; i++)
+    node->B[i] = M + 1 - node->R[i];
+
+  return node;
+}
+
+
+/*
+ * sunday_search
+ *
+ * Search a sequence text using Sunday's quick search.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *sunday_search(BMOPT_STRUCT *node, char *T, int N, int initmatch)
+{
+  int j, k, M, *B;
+  char *P;
+
+  if (node->type != BMOPT_SUNDAY)
+    return NULL;
+
+  T--;            /* Shift to make sequence be T[1],...,T[N] */
+
+  P = node->P;
+  M = node->M;
+  B = node->B;
+
+  /*
+   * k is the text position aligned with the start of the pattern.
+   */
+  k = (!initmatch ? 1 : 2);
+  while (k + M - 1 <= N) {
+    for (j=0; j < M && P[j] == T[k+j]; j++) ;
+
+#ifdef STATS
+    node->num_verify++;
+    node->num_compares += j + (j < M ? 1 : 0);
+#endif
+
+    if (j == M)
+      return &T[k];
+    if (k + M > N)
+      break;
+
+    k += B[(int) T[k+M]];
+  }
+
+  return NULL;
+}
+
+
+/*
+ * bmopt_free
+ *
+ * Free up the allocated BMOPT_STRUCT structure (of any of the variants).
+ *
+ * Parameters:   node  -  a BMOPT_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
 void bmopt_free(BMOPT_STRUCT *node)
 {
   if (node == NULL)
     return;
 
-  if (node->P != NULL)
+  if (node->copyflag && node->P != NULL)
     free(node->P);
   if (node->R != NULL)
-    free(node->R);
+    free(node->R - 129);
   free(node);
 }
@@ -1,12 +1,27 @@
 
+#ifndef _BMOPT_H_
+#define _BMOPT_H_
+
+typedef enum {
+  BMOPT_TUNED, BMOPT_HORSPOOL, BMOPT_SUNDAY
+} BMOPT_TYPE;
+
 typedef struct {
+  BMOPT_TYPE type;
+
   char *P;
-  int M;
+  int M, copyflag;
   int *R, *B, *L;
+
+  int num_verify, num_compares;
 } BMOPT_STRUCT;
 
-BMOPT_STRUCT *bmopt_prep(char *P, int M);
-char *bmopt_search(BMOPT_STRUCT *node, char *T, char *Tend);
+BMOPT_STRUCT *bmopt_prep(char *S, int M, int copyflag);
+char *bmopt_search(BMOPT_STRUCT *node, char *T, int N, int initmatch);
+BMOPT_STRUCT *horspool_prep(char *S, int M, int copyflag);
+char *horspool_search(BMOPT_STRUCT *node, char *T, int N, int initmatch);
+BMOPT_STRUCT *sunday_prep(char *S, int M, int copyflag);
+char *sunday_search(BMOPT_STRUCT *node, char *T, int N, int initmatch);
 void bmopt_free(BMOPT_STRUCT *node);
 
-
+#endif
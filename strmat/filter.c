@@ -0,0 +1,312 @@
+/*
+ * filter.c
+ *
+ * Exact matching of a pattern to a text using a first/last character
+ * filter:  the first and last characters of the pattern are compared
+ * against 16 (SSE2) or 32 (AVX2) alignments of the text at once, and
+ * only the alignments where both of them match are verified.  The
+ * kernel is picked at run time from what the processor supports, with
+ * a scalar loop as the fallback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "filter.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FILTER_HAVE_X86
+#include <immintrin.h>
+#endif
+
+
+/*
+ * filter_prep
+ *
+ * Preprocessing for the filter search algorithm, which just picks the
+ * widest kernel the processor supports.
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized FILTER_STRUCT structure.
+ */
+FILTER_STRUCT *filter_prep(char *S, int M, int copyflag)
+{
+  char *buf;
+  FILTER_STRUCT *node;
+
+  S--;            /* Shift to make sequence be S[1],...,S[M] */
+
+  if ((node = malloc(sizeof(FILTER_STRUCT))) == NULL)
+    return NULL;
+  memset(node, 0, sizeof(FILTER_STRUCT));
+
+  node->M = M;
+  node->copyflag = copyflag;
+
+  if (!copyflag)
+    node->S = S;
+  else {
+    if ((buf = malloc(M + 2)) == NULL) {
+      free(node);
+      return NULL;
+    }
+
+    buf[0] = buf[M+1] = '\0';
+    memcpy(buf + 1, S + 1, M);
+    node->S = buf;
+  }
+
+  filter_select(node, FILTER_AUTO);
+
+  return node;
+}
+
+
+/*
+ * filter_select
+ *
+ * Choose the kernel used by filter_search (for benchmarking them
+ * against each other).  FILTER_AUTO picks the widest kernel the
+ * processor supports.
+ *
+ * Parameters:   node    -  a preprocessed pattern
+ *               kernel  -  the kernel to use
+ *
+ * Returns:  non-zero if the kernel is available, zero otherwise (and
+ *           the current kernel is left in place).
+ */
+int filter_select(FILTER_STRUCT *node, FILTER_KERNEL kernel)
+{
+  if (kernel == FILTER_AUTO) {
+#ifdef FILTER_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      kernel = FILTER_AVX2;
+    else if (__builtin_cpu_supports("sse2"))
+      kernel = FILTER_SSE2;
+    else
+      kernel = FILTER_SCALAR;
+#else
+    kernel = FILTER_SCALAR;
+#endif
+  }
+
+  switch (kernel) {
+  case FILTER_SCALAR:
+    break;
+
+#ifdef FILTER_HAVE_X86
+  case FILTER_SSE2:
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse2"))
+      return 0;
+    break;
+
+  case FILTER_AVX2:
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2"))
+      return 0;
+    break;
+#endif
+
+  default:
+    return 0;
+  }
+
+  node->kernel = kernel;
+  return 1;
+}
+
+
+/*
+ * filter_name
+ *
+ * The name of the kernel a preprocessed pattern uses.
+ */
+char *filter_name(FILTER_STRUCT *node)
+{
+  switch (node->kernel) {
+  case FILTER_SCALAR:  return "scalar";
+  case FILTER_SSE2:    return "SSE2";
+  case FILTER_AVX2:    return "AVX2";
+  default:             return "none";
+  }
+}
+
+
+/*
+ * The kernels
+ *
+ * Each kernel tries the alignments k..last of the pattern against
+ * T[1..N] (where last = N - M + 1), and returns the first alignment
+ * where the pattern occurs, or 0.  The vector kernels load T[k..] and
+ * T[k+M-1..] a block at a time, AND the two byte equality masks and
+ * verify each set bit in increasing order, so the first match found
+ * is the leftmost.  A block is only loaded when all of its alignments
+ * are no greater than last, which keeps the loads inside T[1..N]; the
+ * scalar kernel finishes off the rest.
+ */
+static int filter_verify(FILTER_STRUCT *node, char *T, int k)
+{
+  int M;
+  char *P;
+#ifdef STATS
+  int j;
+#endif
+
+  P = node->S;
+  M = node->M;
+
+#ifdef STATS
+  node->num_candidates++;
+
+  j = 2;
+  while (j < M && P[j] == T[k+j-1]) {
+    j++;
+    node->num_compares++;
+  }
+  if (j < M)
+    node->num_compares++;
+
+  return (j >= M);
+#else
+  return (M <= 2 || memcmp(&P[2], &T[k+1], M - 2) == 0);
+#endif
+}
+
+static int filter_scalar(FILTER_STRUCT *node, char *T, int k, int last)
+{
+  int M;
+  char first, final, *P;
+
+  P = node->S;
+  M = node->M;
+  first = P[1];
+  final = P[M];
+
+  for ( ; k <= last; k++) {
+#ifdef STATS
+    node->num_steps++;
+#endif
+    if (T[k] == first && T[k+M-1] == final && filter_verify(node, T, k))
+      return k;
+  }
+
+  return 0;
+}
+
+#ifdef FILTER_HAVE_X86
+__attribute__((target("sse2")))
+static int filter_sse2(FILTER_STRUCT *node, char *T, int k, int last)
+{
+  int M;
+  unsigned int mask;
+  __m128i first, final, x, y;
+
+  M = node->M;
+  first = _mm_set1_epi8(node->S[1]);
+  final = _mm_set1_epi8(node->S[M]);
+
+  for ( ; k + 15 <= last; k+=16) {
+#ifdef STATS
+    node->num_steps++;
+#endif
+    x = _mm_loadu_si128((__m128i *) &T[k]);
+    y = _mm_loadu_si128((__m128i *) &T[k+M-1]);
+    x = _mm_and_si128(_mm_cmpeq_epi8(x, first), _mm_cmpeq_epi8(y, final));
+    mask = (unsigned int) _mm_movemask_epi8(x);
+    for ( ; mask != 0; mask &= mask - 1)
+      if (filter_verify(node, T, k + __builtin_ctz(mask)))
+        return k + __builtin_ctz(mask);
+  }
+
+  return filter_scalar(node, T, k, last);
+}
+
+__attribute__((target("avx2")))
+static int filter_avx2(FILTER_STRUCT *node, char *T, int k, int last)
+{
+  int M;
+  unsigned int mask;
+  __m256i first, final, x, y;
+
+  M = node->M;
+  first = _mm256_set1_epi8(node->S[1]);
+  final = _mm256_set1_epi8(node->S[M]);
+
+  for ( ; k + 31 <= last; k+=32) {
+#ifdef STATS
+    node->num_steps++;
+#endif
+    x = _mm256_loadu_si256((__m256i *) &T[k]);
+    y = _mm256_loadu_si256((__m256i *) &T[k+M-1]);
+    x = _mm256_and_si256(_mm256_cmpeq_epi8(x, first),
+                         _mm256_cmpeq_epi8(y, final));
+    mask = (unsigned int) _mm256_movemask_epi8(x);
+    for ( ; mask != 0; mask &= mask - 1)
+      if (filter_verify(node, T, k + __builtin_ctz(mask)))
+        return k + __builtin_ctz(mask);
+  }
+
+  return filter_scalar(node, T, k, last);
+}
+#endif
+
+
+/*
+ * filter_search
+ *
+ * Search a sequence text using the filter search algorithm.
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *filter_search(FILTER_STRUCT *node, char *T, int N, int initmatch)
+{
+  int k, last;
+
+  T--;            /* Shift to make sequence be T[1],...,T[N] */
+
+  k = (!initmatch ? 1 : 2);
+  last = N - node->M + 1;
+  if (k > last)
+    return NULL;
+
+  switch (node->kernel) {
+#ifdef FILTER_HAVE_X86
+  case FILTER_SSE2:  k = filter_sse2(node, T, k, last);  break;
+  case FILTER_AVX2:  k = filter_avx2(node, T, k, last);  break;
+#endif
+  default:           k = filter_scalar(node, T, k, last);  break;
+  }
+
+  return (k != 0 ? &T[k] : NULL);
+}
+
+
+/*
+ * filter_free
+ *
+ * Free up the allocated FILTER_STRUCT structure.
+ *
+ * Parameters:   node  -  a FILTER_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
+void filter_free(FILTER_STRUCT *node)
+{
+  if (node == NULL)
+    return;
+
+  if (node->copyflag && node->S != NULL)
+    free(node->S);
+
+  free(node);
+}
@@ -0,0 +1,21 @@
+#ifndef _FILTER_H_
+#define _FILTER_H_
+
+typedef enum { FILTER_AUTO, FILTER_SCALAR, FILTER_SSE2,
+               FILTER_AVX2 } FILTER_KERNEL;
+
+typedef struct {
+  char *S;
+  int M, copyflag;
+  FILTER_KERNEL kernel;
+
+  int num_steps, num_candidates, num_compares;
+} FILTER_STRUCT;
+
+FILTER_STRUCT *filter_prep(char *S, int M, int copyflag);
+int filter_select(FILTER_STRUCT *node, FILTER_KERNEL kernel);
+char *filter_name(FILTER_STRUCT *node);
+char *filter_search(FILTER_STRUCT *node, char *T, int N, int initmatch);
+void filter_free(FILTER_STRUCT *node);
+
+#endif
@@ -462,7 +462,7 @@ KMP_STRUCT *kmp_spprime_orig_prep(char *P, int M, int copyflag)
   spprime[1] = 0;
   for (i=2; i <= M; i++) {
     v = sp[i];
-    if (P[v+1] != P[i+1])
+    if (i == M || P[v+1] != P[i+1])
       spprime[i] = v;
     else
       spprime[i] = spprime[v];
@@ -576,6 +576,101 @@ char *kmp_search(KMP_STRUCT *node, char *T, int N, int initmatch)
 }
 
 
+/*
+ * kmp_dfa_compile
+ *
+ * Compile the failure function F of a preprocessed pattern into the
+ * full matching automaton D, where D[q*256+c] is the number of pattern
+ * characters matched after reading character c with q of them matched.
+ * The mismatch transitions of state q are copied from the state that
+ * F falls back to (which is less than q), so the whole table is built
+ * in O(256 M) time.  Works for any of the four preprocessing variants.
+ *
+ * Parameters:   node  -  a preprocessed pattern
+ *
+ * Returns:  non-zero on success, zero if out of memory.
+ */
+int kmp_dfa_compile(KMP_STRUCT *node)
+{
+  int c, q, M, *D, *F, *row;
+  char *P;
+
+  if (node->D != NULL)
+    return 1;
+
+  P = node->P;
+  M = node->M;
+  F = node->F;
+
+  if ((D = malloc((M + 1) * 256 * sizeof(int))) == NULL)
+    return 0;
+
+  memset(D, 0, 256 * sizeof(int));
+  D[(unsigned char) P[1]] = 1;
+
+  for (q=1; q <= M; q++) {
+    row = D + (F[q+1] - 1) * 256;
+    for (c=0; c < 256; c++)
+      D[q*256+c] = row[c];
+    if (q < M)
+      D[q*256+(unsigned char) P[q+1]] = q + 1;
+  }
+
+  node->D = D;
+  return 1;
+}
+
+
+/*
+ * kmp_dfa_search
+ *
+ * Search a sequence text using the compiled automaton, which costs one
+ * table lookup per text character (counted as a compare in the STATS
+ * version).
+ *
+ * Parameters:   node      -  a preprocessed pattern
+ *               T         -  the sequence
+ *               N         -  the sequence length
+ *               initmatch -  does the text begin with a match?
+ *
+ * Returns:  The location of the first match to the pattern, or NULL.
+ */
+char *kmp_dfa_search(KMP_STRUCT *node, char *T, int N, int initmatch)
+{
+  int c, q, M, *D;
+
+  if (node->D == NULL && !kmp_dfa_compile(node))
+    return NULL;
+
+  T--;            /* Shift to make sequence be T[1],...,T[N] */
+
+  M = node->M;
+  D = node->D;
+
+  if (!initmatch) {
+    c = 1;
+    q = 0;
+  }
+  else {
+    c = M + 1;
+    q = M;
+  }
+
+  for ( ; c <= N; c++) {
+    q = D[q*256+(unsigned char) T[c]];
+
+#ifdef STATS
+    node->num_compares++;
+#endif
+
+    if (q == M)
+      return &T[c-M+1];
+  }
+
+  return NULL;
+}
+
+
 /*
  * kmp_free
  *
@@ -594,7 +689,157 @@ void kmp_free(KMP_STRUCT *node)
     free(node->P);
   if (node->F != NULL)
     free(node->F);
+  if (node->D != NULL)
+    free(node->D);
   free(node);
 }
 
 
+/*
+ * kmp_stream_open
+ *
+ * Start a streaming search with a preprocessed pattern, where the text
+ * is passed in as a sequence of buffers (so that files and pipes can
+ * be scanned without holding them in memory).  The only state kept
+ * between the buffers is the automaton state, so matches which cross
+ * the buffer boundaries are found without any copying.
+ *
+ * Parameters:   node  -  a preprocessed pattern
+ *
+ * Returns:  A KMP_STREAM structure, or NULL if out of memory.
+ */
+KMP_STREAM *kmp_stream_open(KMP_STRUCT *node)
+{
+  KMP_STREAM *ks;
+
+  if (node == NULL || !kmp_dfa_compile(node))
+    return NULL;
+
+  if ((ks = malloc(sizeof(KMP_STREAM))) == NULL)
+    return NULL;
+  memset(ks, 0, sizeof(KMP_STREAM));
+
+  ks->node = node;
+  return ks;
+}
+
+
+/*
+ * kmp_stream_feed
+ *
+ * Pass the next buffer of the text to a streaming search.  The matches
+ * ending in the buffer are then returned by kmp_stream_next.  The
+ * buffer must stay valid until the next call to kmp_stream_feed or
+ * kmp_stream_flush, and any of its matches not yet returned then are
+ * skipped.
+ *
+ * Parameters:   ks   -  a streaming search
+ *               buf  -  the buffer
+ *               len  -  the buffer length
+ *
+ * Returns:  nothing.
+ */
+void kmp_stream_feed(KMP_STREAM *ks, char *buf, int len)
+{
+  int q, *D;
+
+  /*
+   * Finish off the rest of the previous buffer.
+   */
+  if (ks->buf != NULL && ks->pos < ks->len) {
+    D = ks->node->D;
+    for (q=ks->state; ks->pos < ks->len; ks->pos++)
+      q = D[q*256+(unsigned char) ks->buf[ks->pos]];
+    ks->state = q;
+  }
+
+  ks->offset += ks->len;
+  ks->buf = buf;
+  ks->len = len;
+  ks->pos = 0;
+}
+
+
+/*
+ * kmp_stream_next
+ *
+ * Find the next match ending in the current buffer of a streaming
+ * search.
+ *
+ * Parameters:   ks  -  a streaming search
+ *
+ * Returns:  The position of the match in the whole stream (with the
+ *           first character at position 1), or 0 if the rest of the
+ *           buffer holds no match.
+ */
+long kmp_stream_next(KMP_STREAM *ks)
+{
+  int q, M, pos, len, *D;
+  char *buf;
+
+  M = ks->node->M;
+  D = ks->node->D;
+  buf = ks->buf;
+  len = ks->len;
+
+  for (q=ks->state,pos=ks->pos; pos < len; ) {
+    q = D[q*256+(unsigned char) buf[pos++]];
+
+#ifdef STATS
+    ks->node->num_compares++;
+#endif
+
+    if (q == M) {
+      ks->state = q;
+      ks->pos = pos;
+      ks->num_matches++;
+      return ks->offset + pos - M + 1;
+    }
+  }
+
+  ks->state = q;
+  ks->pos = pos;
+  return 0;
+}
+
+
+/*
+ * kmp_stream_flush
+ *
+ * Complete a streaming search (skipping any matches of the last buffer
+ * not yet returned), and reset it so that another stream can be fed.
+ * The match count is left in place for the caller.
+ *
+ * Parameters:   ks  -  a streaming search
+ *
+ * Returns:  The length of the stream.
+ */
+long kmp_stream_flush(KMP_STREAM *ks)
+{
+  long total;
+
+  kmp_stream_feed(ks, NULL, 0);
+  total = ks->offset;
+
+  ks->state = 0;
+  ks->offset = 0;
+  ks->buf = NULL;
+  ks->len = ks->pos = 0;
+  return total;
+}
+
+
+/*
+ * kmp_stream_close
+ *
+ * Free up a KMP_STREAM structure (but not its preprocessed pattern).
+ *
+ * Parameters:   ks  -  a streaming search
+ *
+ * Returns:  nothing.
+ */
+void kmp_stream_close(KMP_STREAM *ks)
+{
+  if (ks != NULL)
+    free(ks);
+}
@@ -5,18 +5,37 @@
 typedef struct {
   char *P;
   int M, copyflag;
-  int *F;
+  int *F, *D;
 
   int prep_compares, num_compares;
   int num_shifts, total_shifts, num_init_mismatch;
 } KMP_STRUCT;
 
+typedef struct {
+  KMP_STRUCT *node;
+  int state;                  /* the number of pattern characters matched */
+
+  char *buf;                  /* the buffer being scanned */
+  int len, pos;
+  long offset;                /* the stream length before buf */
+
+  long num_matches;           /* the matches returned */
+} KMP_STREAM;
+
 
 KMP_STRUCT *kmp_sp_z_prep(char *S, int M, int copyflag);
 KMP_STRUCT *kmp_spprime_z_prep(char *S, int M, int copyflag);
 KMP_STRUCT *kmp_sp_orig_prep(char *S, int M, int copyflag);
 KMP_STRUCT *kmp_spprime_orig_prep(char *S, int M, int copyflag);
 char *kmp_search(KMP_STRUCT *node, char *T, int N, int initmatch);
+int kmp_dfa_compile(KMP_STRUCT *node);
+char *kmp_dfa_search(KMP_STRUCT *node, char *T, int N, int initmatch);
 void kmp_free(KMP_STRUCT *node);
 
+KMP_STREAM *kmp_stream_open(KMP_STRUCT *node);
+void kmp_stream_feed(KMP_STREAM *ks, char *buf, int len);
+long kmp_stream_next(KMP_STREAM *ks);
+long kmp_stream_flush(KMP_STREAM *ks);
+void kmp_stream_close(KMP_STREAM *ks);
+
 #endif
@@ -0,0 +1,465 @@
+/*
+ * myers.c
+ *
+ * Approximate matching of a pattern to a text under the edit distance,
+ * finding every text position where an alignment of the pattern with
+ * at most k differences (mismatches, insertions and deletions) ends.
+ * The variants are 1) Myers' bit-vector algorithm, which computes each
+ * column of the dynamic programming table as vertical deltas packed 64
+ * to a word, in the block-based form of the algorithm for patterns
+ * longer than a word, and 2) Sellers' dynamic programming algorithm,
+ * computing the column one cell at a time (as a baseline).
+ *
+ * Each match is reported by its end position and its number of
+ * differences, along with the start of the shortest alignment ending
+ * there with that many differences, which is found by running the
+ * same algorithm backwards from the end with the pattern reversed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myers.h"
+
+#define MYERS_HIGH ((MYERS_WORD) 1 << (MYERS_BITS - 1))
+
+
+/*
+ * myers_alloc
+ *
+ * Allocate a MYERS_STRUCT, and build the masks of the pattern and the
+ * reversed pattern (bit i of word b of the mask of character c is one
+ * when character 64*b+i+1 of the pattern is c).
+ */
+static MYERS_STRUCT *myers_alloc(char *S, int M, int k, int copyflag,
+                                 MYERS_TYPE type)
+{
+  int i, W;
+  MYERS_STRUCT *node;
+
+  if (S == NULL || M <= 0 || k < 0)
+    return NULL;
+
+  if ((node = malloc(sizeof(MYERS_STRUCT))) == NULL)
+    return NULL;
+  memset(node, 0, sizeof(MYERS_STRUCT));
+
+  W = (M + MYERS_BITS - 1) / MYERS_BITS;
+
+  node->type = type;
+  node->M = M;
+  node->k = (k < M ? k : M - 1);
+  node->W = W;
+  node->copyflag = copyflag;
+
+  if (!copyflag)
+    node->P = S;
+  else {
+    if ((node->P = malloc(M+1)) == NULL) {
+      free(node);
+      return NULL;
+    }
+    memcpy(node->P, S, M);
+    node->P[M] = '\0';
+  }
+
+  if (type == MYERS_BITVEC) {
+    node->Peq = malloc(2 * 256 * W * sizeof(MYERS_WORD));
+    node->Pv = malloc(4 * W * sizeof(MYERS_WORD));
+    node->Score = malloc(W * sizeof(int));
+    if (node->Peq == NULL || node->Pv == NULL || node->Score == NULL) {
+      myers_free(node);
+      return NULL;
+    }
+    node->PeqR = node->Peq + 256 * W;
+    node->Mv = node->Pv + W;
+    node->Pv2 = node->Mv + W;
+    node->Mv2 = node->Pv2 + W;
+
+    memset(node->Peq, 0, 2 * 256 * W * sizeof(MYERS_WORD));
+    for (i=0; i < M; i++) {
+      node->Peq[(unsigned char) node->P[i] * W + i / MYERS_BITS] |=
+        (MYERS_WORD) 1 << (i % MYERS_BITS);
+      node->PeqR[(unsigned char) node->P[M-1-i] * W + i / MYERS_BITS] |=
+        (MYERS_WORD) 1 << (i % MYERS_BITS);
+    }
+  }
+  else {
+    if ((node->C = malloc(2 * (M + 1) * sizeof(int))) == NULL) {
+      myers_free(node);
+      return NULL;
+    }
+    node->C2 = node->C + M + 1;
+  }
+
+  return node;
+}
+
+
+/*
+ * myers_prep
+ *
+ * Preprocessing for Myers' bit-vector algorithm.
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               k         -  the number of differences allowed (at
+ *                            most M-1)
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized MYERS_STRUCT structure, or NULL.
+ */
+MYERS_STRUCT *myers_prep(char *S, int M, int k, int copyflag)
+{
+  return myers_alloc(S, M, k, copyflag, MYERS_BITVEC);
+}
+
+
+/*
+ * sellers_prep
+ *
+ * Preprocessing for Sellers' dynamic programming algorithm.
+ *
+ * Parameters:   S         -  the sequence
+ *               M         -  the sequence length
+ *               k         -  the number of differences allowed (at
+ *                            most M-1)
+ *               copyflag  -  make a copy of the sequence?
+ *
+ * Returns:  An initialized MYERS_STRUCT structure, or NULL.
+ */
+MYERS_STRUCT *sellers_prep(char *S, int M, int k, int copyflag)
+{
+  return myers_alloc(S, M, k, copyflag, MYERS_DP);
+}
+
+
+/*
+ * myers_block
+ *
+ * Advance the vertical deltas of block b over one text character,
+ * whose pattern masks are Eq.  The horizontal delta entering the top
+ * of the block is hin (for block 0, 0 when searching, where row 0 is
+ * all zeros, and 1 when aligning the whole text, where row 0 counts
+ * up).
+ *
+ * Returns:  the horizontal delta leaving the bottom row of the block.
+ */
+static int myers_block(MYERS_STRUCT *node, MYERS_WORD *Pv, MYERS_WORD *Mv,
+                       MYERS_WORD *Eq, int b, int hin)
+{
+  int hout;
+  MYERS_WORD pv, mv, eq, xv, xh, ph, mh, high;
+
+  pv = Pv[b];
+  mv = Mv[b];
+  eq = Eq[b];
+
+  xv = eq | mv;
+  if (hin < 0)
+    eq |= 1;
+  xh = (((eq & pv) + pv) ^ pv) | eq;
+  ph = mv | ~(xh | pv);
+  mh = pv & xh;
+
+  high = (b < node->W - 1 ? MYERS_HIGH
+                          : (MYERS_WORD) 1 << ((node->M - 1) % MYERS_BITS));
+  hout = ((ph & high) ? 1 : ((mh & high) ? -1 : 0));
+
+  ph <<= 1;
+  mh <<= 1;
+  if (hin < 0)
+    mh |= 1;
+  else if (hin > 0)
+    ph |= 1;
+
+  Pv[b] = mh | ~(xv | ph);
+  Mv[b] = ph & xv;
+
+#ifdef STATS
+  node->num_steps++;
+#endif
+
+  return hout;
+}
+
+
+/*
+ * myers_advance
+ *
+ * Advance the vertical deltas Pv/Mv of blocks 0 through last over one
+ * text character, each block passing on the delta leaving its bottom
+ * row to the next block.  If Score is not NULL, the delta leaving each
+ * block is also added to that block's bottom row score.
+ *
+ * Returns:  the horizontal delta leaving the bottom row of block last.
+ */
+static int myers_advance(MYERS_STRUCT *node, MYERS_WORD *Pv, MYERS_WORD *Mv,
+                         MYERS_WORD *Eq, int hin, int last, int *Score)
+{
+  int b;
+
+  for (b=0; b <= last; b++) {
+    hin = myers_block(node, Pv, Mv, Eq, b, hin);
+    if (Score != NULL)
+      Score[b] += hin;
+  }
+
+  return hin;
+}
+
+
+/*
+ * myers_height
+ *
+ * The number of pattern rows in block b (MYERS_BITS, except possibly
+ * for the last block).
+ */
+static int myers_height(MYERS_STRUCT *node, int b)
+{
+  return (b < node->W - 1 ? MYERS_BITS : node->M - b * MYERS_BITS);
+}
+
+
+/*
+ * myers_column
+ *
+ * Advance the search by one text character, computing only the blocks
+ * that can hold a score of k or less (Ukkonen's cutoff, in the block
+ * form of Myers' paper).  The cells below the last active block y all
+ * hold more than k, so a cell of block y+1 can only drop to k or less
+ * through its top cell, when the bottom row of block y held k and it
+ * either matched the character or decreased.  When that happens,
+ * block y+1 is started with its rows counting up from the bottom of
+ * block y.  When the bottom row of block y is at least k plus the
+ * block's height instead, every cell of the block holds more than k,
+ * and the block is dropped.  This makes the search O(kn/64) rather
+ * than O(Mn/64).
+ *
+ * Returns:  the score of row M, or k+1 if the last block is inactive.
+ */
+static int myers_column(MYERS_STRUCT *node, MYERS_WORD *Eq)
+{
+  int y, k, carry;
+  int *Score;
+
+  y = node->y;
+  k = node->k;
+  Score = node->Score;
+
+  carry = myers_advance(node, node->Pv, node->Mv, Eq, 0, y, Score);
+
+  if (y < node->W - 1 && Score[y] - carry <= k &&
+      ((Eq[y+1] & 1) || carry < 0)) {
+    y++;
+    node->Pv[y] = ~(MYERS_WORD) 0;
+    node->Mv[y] = 0;
+    Score[y] = Score[y-1] - carry + myers_height(node, y) +
+               myers_block(node, node->Pv, node->Mv, Eq, y, carry);
+  }
+  else {
+    while (y > 0 && Score[y] >= k + myers_height(node, y))
+      y--;
+  }
+
+  node->y = y;
+  return (y == node->W - 1 ? Score[y] : k + 1);
+}
+
+
+/*
+ * sellers_advance
+ *
+ * Advance the dynamic programming column C[0..M] over one text
+ * character c, where the pattern is read forwards or backwards.  Row 0
+ * is c0 (0 when searching, and the number of characters read when
+ * aligning the whole text).
+ *
+ * Returns:  the new value of C[M].
+ */
+static int sellers_advance(MYERS_STRUCT *node, int *C, char c, int c0,
+                           int reversed)
+{
+  int i, M, diag, temp, best;
+  char *P;
+
+  P = node->P;
+  M = node->M;
+
+  diag = C[0];
+  C[0] = c0;
+  for (i=1; i <= M; i++) {
+    best = diag + ((reversed ? P[M-i] : P[i-1]) != c);
+    if (C[i] + 1 < best)
+      best = C[i] + 1;
+    if (C[i-1] + 1 < best)
+      best = C[i-1] + 1;
+
+    temp = C[i];
+    C[i] = best;
+    diag = temp;
+  }
+
+#ifdef STATS
+  node->num_steps += M;
+#endif
+
+  return C[M];
+}
+
+
+/*
+ * myers_start
+ *
+ * Find the start of the shortest alignment of the pattern ending at
+ * text position end (0-based) with score differences, by aligning the
+ * reversed pattern against the text read backwards from there.
+ *
+ * Returns:  the start position (0-based).
+ */
+static int myers_start(MYERS_STRUCT *node, int end, int score)
+{
+  int t, w, i, sc, M, W, limit;
+  char c;
+
+  M = node->M;
+  W = node->W;
+
+  if (node->type == MYERS_BITVEC) {
+    for (w=0; w < W; w++) {
+      node->Pv2[w] = ~(MYERS_WORD) 0;
+      node->Mv2[w] = 0;
+    }
+  }
+  else {
+    for (i=0; i <= M; i++)
+      node->C2[i] = i;
+  }
+
+  limit = (end + 1 < M + node->k ? end + 1 : M + node->k);
+  for (t=1,sc=M; t <= limit; t++) {
+    c = node->T[end-t+1];
+    if (node->type == MYERS_BITVEC)
+      sc += myers_advance(node, node->Pv2, node->Mv2,
+                          node->PeqR + (unsigned char) c * W, 1, W - 1,
+                          NULL);
+    else
+      sc = sellers_advance(node, node->C2, c, t, 1);
+
+#ifdef STATS
+    node->num_start_columns++;
+#endif
+
+    if (sc == score)
+      return end - t + 1;
+  }
+
+  return end - limit + 1;
+}
+
+
+/*
+ * myers_first, myers_next
+ *
+ * Search a sequence text for the ends of the alignments of a pattern
+ * with at most k differences, returning the first match and then each
+ * of the rest in turn.
+ *
+ * Parameters:   node   -  a preprocessed pattern
+ *               T      -  the sequence
+ *               N      -  the sequence length
+ *               lend   -  where to store the start of the match
+ *               rend   -  where to store the end of the match
+ *               score  -  where to store its number of differences
+ *
+ * Returns:  non-zero if a match was found, zero at the end of the text.
+ */
+int myers_first(MYERS_STRUCT *node, char *T, int N, int *lend, int *rend,
+                int *score)
+{
+  int i;
+
+  node->T = T;
+  node->N = N;
+  node->j = 0;
+  node->score = node->M;
+
+  if (node->type == MYERS_BITVEC) {
+    for (i=0; i < node->W; i++) {
+      node->Pv[i] = ~(MYERS_WORD) 0;
+      node->Mv[i] = 0;
+      node->Score[i] = i * MYERS_BITS + myers_height(node, i);
+    }
+    node->y = (node->k > 0 ? (node->k - 1) / MYERS_BITS : 0);
+  }
+  else {
+    for (i=0; i <= node->M; i++)
+      node->C[i] = i;
+  }
+
+  return myers_next(node, lend, rend, score);
+}
+
+int myers_next(MYERS_STRUCT *node, int *lend, int *rend, int *score)
+{
+  int j, N, W, sc;
+  char *T;
+
+  T = node->T;
+  N = node->N;
+  W = node->W;
+  sc = node->score;
+
+  for (j=node->j; j < N; ) {
+    if (node->type == MYERS_BITVEC)
+      sc = myers_column(node, node->Peq + (unsigned char) T[j] * W);
+    else
+      sc = sellers_advance(node, node->C, T[j], 0, 0);
+    j++;
+
+#ifdef STATS
+    node->num_columns++;
+#endif
+
+    if (sc <= node->k) {
+      node->j = j;
+      node->score = sc;
+      *lend = myers_start(node, j - 1, sc) + 1;
+      *rend = j;
+      *score = sc;
+      return 1;
+    }
+  }
+
+  node->j = j;
+  node->score = sc;
+  return 0;
+}
+
+
+/*
+ * myers_free
+ *
+ * Free up the allocated MYERS_STRUCT structure (of either variant).
+ *
+ * Parameters:   node  -  a MYERS_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
+void myers_free(MYERS_STRUCT *node)
+{
+  if (node == NULL)
+    return;
+
+  if (node->copyflag && node->P != NULL)
+    free(node->P);
+  if (node->Peq != NULL)
+    free(node->Peq);
+  if (node->Pv != NULL)
+    free(node->Pv);
+  if (node->Score != NULL)
+    free(node->Score);
+  if (node->C != NULL)
+    free(node->C);
+  free(node);
+}
@@ -0,0 +1,38 @@
+
+#ifndef _MYERS_H_
+#define _MYERS_H_
+
+typedef unsigned long long MYERS_WORD;
+
+#define MYERS_BITS 64
+
+typedef enum {
+  MYERS_BITVEC, MYERS_DP
+} MYERS_TYPE;
+
+typedef struct {
+  MYERS_TYPE type;
+
+  char *P;
+  int M, copyflag, k, W;
+  MYERS_WORD *Peq, *PeqR;     /* the pattern and reversed pattern masks */
+  MYERS_WORD *Pv, *Mv;        /* the vertical deltas of the search */
+  MYERS_WORD *Pv2, *Mv2;      /* the vertical deltas of the start search */
+  int *Score, y;              /* the bottom row scores of the blocks and
+                                 the last active block of the search */
+  int *C, *C2;                /* the DP columns (for the baseline) */
+
+  char *T;                    /* the text and the position of the scan */
+  int N, j, score;
+
+  int num_columns, num_steps, num_start_columns;
+} MYERS_STRUCT;
+
+MYERS_STRUCT *myers_prep(char *S, int M, int k, int copyflag);
+MYERS_STRUCT *sellers_prep(char *S, int M, int k, int copyflag);
+int myers_first(MYERS_STRUCT *node, char *T, int N, int *lend, int *rend,
+                int *score);
+int myers_next(MYERS_STRUCT *node, int *lend, int *rend, int *score);
+void myers_free(MYERS_STRUCT *node);
+
+#endif
@@ -86,7 +86,7 @@ char *naive_search(NAIVE_STRUCT *node, char *T, int N, int initmatch)
    * Perform the matching.
    */
   k = (!initmatch ? 1 : 2);
-  for ( ; k + M <= N; k++) {
+  for ( ; k + M - 1 <= N; k++) {
 
 #ifdef STATS
     j = 0;
@@ -0,0 +1,406 @@
+/*
+ * pscan.c
+ *
+ * A multi-threaded driver for the single pattern exact matching
+ * algorithms (naive, Boyer-Moore, Knuth-Morris-Pratt and Z values).
+ * The text is cut into chunks of alignments, each chunk's piece of the
+ * text overlapping the next one by M-1 characters, and a pool of
+ * threads runs the chosen algorithm over the chunks.  Every alignment
+ * belongs to exactly one chunk, so no match is found twice, and the
+ * per-chunk match lists are concatenated in chunk order to give the
+ * matches in text order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "naive.h"
+#include "bm.h"
+#include "kmp.h"
+#include "z.h"
+#include "pscan.h"
+
+
+typedef struct {
+  int *list, num, size;
+} PSCAN_CHUNK;
+
+typedef struct {
+  PSCAN_STRUCT *ps;
+  char *P, *T;
+  int M, N, last;             /* last = N - M + 1, the last alignment */
+  PSCAN_CHUNK *chunks;
+
+  pthread_mutex_t lock;
+  int next_chunk;
+} PSCAN_SHARED;
+
+typedef struct {
+  PSCAN_SHARED *sh;
+  int status, num_compares;
+} PSCAN_WORKER;
+
+static void *pscan_worker(void *arg);
+static int pscan_next_chunk(PSCAN_SHARED *sh);
+static int pscan_add(PSCAN_CHUNK *chunk, int pos);
+static void *engine_prep(PSCAN_ALG alg, char *P, int M);
+static char *engine_search(PSCAN_ALG alg, void *engine, char *T, int N,
+                           int initmatch);
+static int engine_compares(PSCAN_ALG alg, void *engine);
+static void engine_free(PSCAN_ALG alg, void *engine);
+
+
+/*
+ * pscan_search
+ *
+ * Find all of the matches of a pattern in a text, running one of the
+ * single pattern algorithms over chunks of the text with a pool of
+ * threads.  Each thread preprocesses its own copy of the pattern (the
+ * algorithms' structures hold their statistics), and takes the next
+ * unclaimed chunk until none are left.
+ *
+ * Parameters:   P           -  the pattern
+ *               M           -  the pattern length
+ *               T           -  the text
+ *               N           -  the text length
+ *               alg         -  the algorithm to run on each chunk
+ *               nthreads    -  the number of threads to use
+ *               chunk_size  -  the number of alignments in each chunk,
+ *                              or 0 to pick one from the text length
+ *                              and the number of threads
+ *
+ * Returns:  a PSCAN_STRUCT holding the matches, or NULL on an error.
+ */
+PSCAN_STRUCT *pscan_search(char *P, int M, char *T, int N, PSCAN_ALG alg,
+                           int nthreads, int chunk_size)
+{
+  int c, t, pos, started, status;
+  pthread_t *threads;
+  PSCAN_STRUCT *ps;
+  PSCAN_SHARED sh;
+  PSCAN_WORKER *workers;
+
+  if (P == NULL || M <= 0 || T == NULL || N < 0)
+    return NULL;
+  if (nthreads < 1)
+    nthreads = 1;
+
+  if ((ps = malloc(sizeof(PSCAN_STRUCT))) == NULL)
+    return NULL;
+  memset(ps, 0, sizeof(PSCAN_STRUCT));
+
+  ps->alg = alg;
+  ps->nthreads = nthreads;
+
+  memset(&sh, 0, sizeof(PSCAN_SHARED));
+  sh.ps = ps;
+  sh.P = P;
+  sh.M = M;
+  sh.T = T;
+  sh.N = N;
+  sh.last = N - M + 1;
+
+  /*
+   * Cut the alignments 1..last into chunks, about four per thread unless
+   * that makes them too small or too big.
+   */
+  if (chunk_size <= 0) {
+    chunk_size = (sh.last > 0 ? (sh.last - 1) / (4 * nthreads) + 1 : 1);
+    if (chunk_size < PSCAN_MIN_CHUNK)
+      chunk_size = PSCAN_MIN_CHUNK;
+    if (chunk_size > PSCAN_MAX_CHUNK)
+      chunk_size = PSCAN_MAX_CHUNK;
+    if (sh.last > 0 && chunk_size > sh.last)
+      chunk_size = sh.last;
+  }
+  ps->chunk_size = chunk_size;
+  ps->num_chunks = (sh.last > 0 ? (sh.last - 1) / chunk_size + 1 : 0);
+
+  ps->matches = malloc(sizeof(int));
+  sh.chunks = malloc((ps->num_chunks + 1) * sizeof(PSCAN_CHUNK));
+  if (ps->matches == NULL || sh.chunks == NULL) {
+    if (sh.chunks != NULL)
+      free(sh.chunks);
+    pscan_free(ps);
+    return NULL;
+  }
+  memset(sh.chunks, 0, (ps->num_chunks + 1) * sizeof(PSCAN_CHUNK));
+  if (ps->num_chunks == 0) {
+    free(sh.chunks);
+    return ps;
+  }
+
+  if ((workers = malloc(nthreads * sizeof(PSCAN_WORKER))) == NULL) {
+    free(sh.chunks);
+    pscan_free(ps);
+    return NULL;
+  }
+  for (t=0; t < nthreads; t++) {
+    workers[t].sh = &sh;
+    workers[t].status = 1;
+    workers[t].num_compares = 0;
+  }
+
+  pthread_mutex_init(&sh.lock, NULL);
+  sh.next_chunk = 0;
+
+  /*
+   * Run the threads (or just the calling thread).  If a thread cannot be
+   * started, the ones that were drain the chunks between them.
+   */
+  started = 0;
+  if (nthreads > 1 &&
+      (threads = malloc(nthreads * sizeof(pthread_t))) != NULL) {
+    for (t=0; t < nthreads; t++) {
+      if (pthread_create(&threads[t], NULL, pscan_worker, &workers[t]) != 0)
+        break;
+      started++;
+    }
+    for (t=0; t < started; t++)
+      pthread_join(threads[t], NULL);
+    free(threads);
+  }
+  if (started == 0) {
+    pscan_worker(&workers[0]);
+    started = 1;
+  }
+
+  status = 1;
+  for (t=0; t < started; t++) {
+    if (!workers[t].status)
+      status = 0;
+#ifdef STATS
+    ps->num_compares += workers[t].num_compares;
+#endif
+  }
+
+  /*
+   * Concatenate the chunks' matches.
+   */
+  if (status) {
+    for (c=0; c < ps->num_chunks; c++)
+      ps->num_matches += sh.chunks[c].num;
+
+    if (ps->num_matches > 0) {
+      free(ps->matches);
+      if ((ps->matches = malloc(ps->num_matches * sizeof(int))) == NULL)
+        status = 0;
+    }
+
+    for (c=0,pos=0; status && c < ps->num_chunks; c++) {
+      if (sh.chunks[c].num > 0)
+        memcpy(ps->matches + pos, sh.chunks[c].list,
+               sh.chunks[c].num * sizeof(int));
+      pos += sh.chunks[c].num;
+    }
+  }
+
+  for (c=0; c < ps->num_chunks; c++)
+    if (sh.chunks[c].list != NULL)
+      free(sh.chunks[c].list);
+  free(sh.chunks);
+  free(workers);
+  pthread_mutex_destroy(&sh.lock);
+
+  if (!status) {
+    pscan_free(ps);
+    return NULL;
+  }
+
+  return ps;
+}
+
+
+/*
+ * pscan_worker
+ *
+ * The thread body:  preprocess the pattern, then search chunks until
+ * there are none left.  Chunk c holds the alignments start..end, where
+ * start = c * chunk_size + 1, so its piece of the text is
+ * T[start..end+M-1].
+ */
+static void *pscan_worker(void *arg)
+{
+  int c, start, end, len;
+  char *s, *slice;
+  void *engine;
+  PSCAN_WORKER *w;
+  PSCAN_SHARED *sh;
+  PSCAN_ALG alg;
+
+  w = (PSCAN_WORKER *) arg;
+  sh = w->sh;
+  alg = sh->ps->alg;
+
+  if ((engine = engine_prep(alg, sh->P, sh->M)) == NULL) {
+    w->status = 0;
+    return NULL;
+  }
+
+  while ((c = pscan_next_chunk(sh)) >= 0) {
+    start = c * sh->ps->chunk_size + 1;
+    end = start + sh->ps->chunk_size - 1;
+    if (sh->last - start < sh->ps->chunk_size)
+      end = sh->last;
+    slice = sh->T + start - 1;
+    len = end - start + sh->M;
+
+    for (s=engine_search(alg, engine, slice, len, 0); s != NULL;
+         s=engine_search(alg, engine, s, len - (s - slice), 1)) {
+      if (!pscan_add(&sh->chunks[c], s - sh->T + 1)) {
+        w->status = 0;
+        break;
+      }
+    }
+    if (!w->status)
+      break;
+  }
+
+  w->num_compares = engine_compares(alg, engine);
+  engine_free(alg, engine);
+
+  return NULL;
+}
+
+
+/*
+ * pscan_next_chunk
+ *
+ * Hand out the next unclaimed chunk.
+ *
+ * Returns:  the chunk index, or -1 when none are left.
+ */
+static int pscan_next_chunk(PSCAN_SHARED *sh)
+{
+  int c;
+
+  pthread_mutex_lock(&sh->lock);
+  c = (sh->next_chunk < sh->ps->num_chunks ? sh->next_chunk++ : -1);
+  pthread_mutex_unlock(&sh->lock);
+
+  return c;
+}
+
+
+/*
+ * pscan_add
+ *
+ * Append a match position to a chunk's list.
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int pscan_add(PSCAN_CHUNK *chunk, int pos)
+{
+  int size, *list;
+
+  if (chunk->num == chunk->size) {
+    size = (chunk->size == 0 ? 64 : 2 * chunk->size);
+    if ((list = realloc(chunk->list, size * sizeof(int))) == NULL)
+      return 0;
+    chunk->list = list;
+    chunk->size = size;
+  }
+
+  chunk->list[chunk->num++] = pos;
+  return 1;
+}
+
+
+/*
+ * engine_prep, engine_search, engine_compares, engine_free
+ *
+ * Call the preprocessing, search and free procedures of the chosen
+ * algorithm (Knuth-Morris-Pratt uses the original sp' preprocessing).
+ */
+static void *engine_prep(PSCAN_ALG alg, char *P, int M)
+{
+  switch (alg) {
+  case PSCAN_NAIVE:      return naive_prep(P, M, 0);
+  case PSCAN_BMBAD:      return bmbad_prep(P, M, 0);
+  case PSCAN_BMEXT:      return bmext_prep(P, M, 0);
+  case PSCAN_BMGOOD:     return bmgood_prep(P, M, 0);
+  case PSCAN_BMEXTGOOD:  return bmextgood_prep(P, M, 0);
+  case PSCAN_KMP:        return kmp_spprime_orig_prep(P, M, 0);
+  case PSCAN_Z:          return z_build(P, M, 0);
+  }
+  return NULL;
+}
+
+static char *engine_search(PSCAN_ALG alg, void *engine, char *T, int N,
+                           int initmatch)
+{
+  switch (alg) {
+  case PSCAN_NAIVE:      return naive_search(engine, T, N, initmatch);
+  case PSCAN_BMBAD:      return bmbad_search(engine, T, N, initmatch);
+  case PSCAN_BMEXT:      return bmext_search(engine, T, N, initmatch);
+  case PSCAN_BMGOOD:     return bmgood_search(engine, T, N, initmatch);
+  case PSCAN_BMEXTGOOD:  return bmextgood_search(engine, T, N, initmatch);
+  case PSCAN_KMP:        return kmp_search(engine, T, N, initmatch);
+  case PSCAN_Z:          return z_search(engine, T, N, initmatch);
+  }
+  return NULL;
+}
+
+static int engine_compares(PSCAN_ALG alg, void *engine)
+{
+  switch (alg) {
+  case PSCAN_NAIVE:      return ((NAIVE_STRUCT *) engine)->num_compares;
+  case PSCAN_BMBAD:
+  case PSCAN_BMEXT:
+  case PSCAN_BMGOOD:
+  case PSCAN_BMEXTGOOD:  return ((BM_STRUCT *) engine)->num_compares;
+  case PSCAN_KMP:        return ((KMP_STRUCT *) engine)->num_compares;
+  case PSCAN_Z:          return ((Z_STRUCT *) engine)->num_compares;
+  }
+  return 0;
+}
+
+static void engine_free(PSCAN_ALG alg, void *engine)
+{
+  switch (alg) {
+  case PSCAN_NAIVE:      naive_free(engine);  break;
+  case PSCAN_BMBAD:
+  case PSCAN_BMEXT:
+  case PSCAN_BMGOOD:
+  case PSCAN_BMEXTGOOD:  bm_free(engine);  break;
+  case PSCAN_KMP:        kmp_free(engine);  break;
+  case PSCAN_Z:          z_free(engine);  break;
+  }
+}
+
+
+/*
+ * pscan_name
+ *
+ * The name of an algorithm.
+ */
+char *pscan_name(PSCAN_ALG alg)
+{
+  switch (alg) {
+  case PSCAN_NAIVE:      return "Naive";
+  case PSCAN_BMBAD:      return "BM-bad";
+  case PSCAN_BMEXT:      return "BM-ext";
+  case PSCAN_BMGOOD:     return "BM-good";
+  case PSCAN_BMEXTGOOD:  return "BM-e+g";
+  case PSCAN_KMP:        return "KMP";
+  case PSCAN_Z:          return "Z";
+  }
+  return "none";
+}
+
+
+/*
+ * pscan_free
+ *
+ * Free up a PSCAN_STRUCT structure.
+ */
+void pscan_free(PSCAN_STRUCT *ps)
+{
+  if (ps == NULL)
+    return;
+
+  if (ps->matches != NULL)
+    free(ps->matches);
+  free(ps);
+}
@@ -0,0 +1,27 @@
+
+#ifndef _PSCAN_H_
+#define _PSCAN_H_
+
+#define PSCAN_MIN_CHUNK 65536
+#define PSCAN_MAX_CHUNK (1 << 22)
+
+typedef enum {
+  PSCAN_NAIVE, PSCAN_BMBAD, PSCAN_BMEXT, PSCAN_BMGOOD, PSCAN_BMEXTGOOD,
+  PSCAN_KMP, PSCAN_Z
+} PSCAN_ALG;
+
+typedef struct {
+  PSCAN_ALG alg;
+  int nthreads, chunk_size, num_chunks;
+
+  int *matches, num_matches;   /* the match positions, in text order */
+
+  int num_compares;
+} PSCAN_STRUCT;
+
+PSCAN_STRUCT *pscan_search(char *P, int M, char *T, int N, PSCAN_ALG alg,
+                           int nthreads, int chunk_size);
+char *pscan_name(PSCAN_ALG alg);
+void pscan_free(PSCAN_STRUCT *ps);
+
+#endif
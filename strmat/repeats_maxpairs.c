@@ -0,0 +1,246 @@
+/*
+ * repeats_maxpairs.c
+ *
+ * Finding all of the maximal pairs of a string (Gusfield, Section 7.12),
+ * with a bottom-up traversal of its enhanced suffix array instead of
+ * a suffix tree.
+ *
+ * A maximal pair is a pair of occurrences of a substring, at pos1 and
+ * pos2, which can be extended neither to the left nor to the right.
+ * The pairs of the repeat of an lcp-interval are the pairs of suffixes
+ * from two different children of the interval (so they are right
+ * maximal) with different left predecessors (so they are left maximal).
+ *
+ * As in Abouelhoda et al., each open interval keeps the positions of its
+ * suffixes in one linked list per left predecessor, and a child's lists
+ * are matched against the parent's (for the other left predecessors)
+ * before being appended to them.  So the time is O(M + z) for z pairs,
+ * and the working space is one link per position plus two list ends per
+ * left predecessor for each open interval.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sary_esa.h"
+#include "repeats_maxpairs.h"
+
+
+typedef struct {
+  int *next;
+  int code[257], num_codes;
+
+  int *ends, num_levels, levels_size, *pending;
+
+  int min_length, num_pairs, stopped;
+  MAXPAIRS_REPORT report;
+  void *data;
+} MAXPAIRS;
+
+#define MP_LEFT(mp,esa,pos) \
+  ((mp)->code[(pos) == 1 ? 256 : (unsigned char) (esa)->S[(pos) - 1]])
+#define MP_HEAD(mp,level,c) \
+  ((mp)->ends[(level) * 2 * (mp)->num_codes + 2*(c)])
+#define MP_TAIL(mp,level,c) \
+  ((mp)->ends[(level) * 2 * (mp)->num_codes + 2*(c) + 1])
+
+static int mp_open(SARY_ESA *esa, ESA_INTERVAL *node, void *data);
+static int mp_leaf(SARY_ESA *esa, ESA_INTERVAL *node, int row, void *data);
+static int mp_child(SARY_ESA *esa, ESA_INTERVAL *node, ESA_INTERVAL *child,
+                    void *data);
+static int mp_close(SARY_ESA *esa, ESA_INTERVAL *node, void *data);
+static int mp_merge(MAXPAIRS *mp, int lcp, int *lists);
+
+
+/*
+ * maxpairs_find
+ *
+ * Find the maximal pairs of a string.
+ *
+ * Parameters:  esa         -  the enhanced suffix array of the string
+ *              min_length  -  the minimum length of a reported pair
+ *              report      -  the function called with each pair
+ *                             (pos1 < pos2, 1-based, and the length);
+ *                             a zero return stops the search
+ *              data        -  passed through to report
+ *
+ * Returns:  the number of pairs reported, or -1 if memory ran out.
+ */
+int maxpairs_find(SARY_ESA *esa, int min_length, MAXPAIRS_REPORT report,
+                  void *data)
+{
+  int i, status;
+  MAXPAIRS mp;
+  ESA_VISITOR visitor;
+
+  if (esa == NULL)
+    return -1;
+
+  memset(&mp, 0, sizeof(MAXPAIRS));
+  mp.min_length = (min_length < 1 ? 1 : min_length);
+  mp.report = report;
+  mp.data = data;
+
+  /*
+   * Number the left predecessors occurring in the string.
+   */
+  for (i=0; i < 257; i++)
+    mp.code[i] = -1;
+  mp.code[256] = mp.num_codes++;
+  for (i=1; i <= esa->M; i++)
+    if (mp.code[(unsigned char) esa->S[i]] == -1)
+      mp.code[(unsigned char) esa->S[i]] = mp.num_codes++;
+
+  if ((mp.next = malloc((esa->M + 1) * sizeof(int))) == NULL ||
+      (mp.pending = malloc(2 * mp.num_codes * sizeof(int))) == NULL) {
+    if (mp.next != NULL)
+      free(mp.next);
+    return -1;
+  }
+
+  visitor.open = mp_open;
+  visitor.leaf = mp_leaf;
+  visitor.child = mp_child;
+  visitor.close = mp_close;
+
+  status = sary_esa_bottom_up(esa, &visitor, &mp);
+
+  free(mp.next);
+  free(mp.pending);
+  if (mp.ends != NULL)
+    free(mp.ends);
+
+  return (status || mp.stopped ? mp.num_pairs : -1);
+}
+
+
+/*
+ * mp_open
+ *
+ * Start the (empty) position lists of a new interval.
+ */
+static int mp_open(SARY_ESA *esa, ESA_INTERVAL *node, void *data)
+{
+  int c, *newends;
+  MAXPAIRS *mp;
+
+  mp = data;
+  if (mp->num_levels == mp->levels_size) {
+    mp->levels_size = (mp->levels_size == 0 ? 64 : mp->levels_size * 2);
+    newends = realloc(mp->ends,
+                      mp->levels_size * 2 * mp->num_codes * sizeof(int));
+    if (newends == NULL)
+      return 0;
+    mp->ends = newends;
+  }
+
+  for (c=0; c < mp->num_codes; c++)
+    MP_HEAD(mp, mp->num_levels, c) = MP_TAIL(mp, mp->num_levels, c) = 0;
+  mp->num_levels++;
+
+  return 1;
+}
+
+
+/*
+ * mp_leaf
+ *
+ * Merge the one position of a singleton child into its interval.
+ */
+static int mp_leaf(SARY_ESA *esa, ESA_INTERVAL *node, int row, void *data)
+{
+  int c, pos;
+  MAXPAIRS *mp;
+
+  mp = data;
+  pos = esa->Pos[row];
+  for (c=0; c < mp->num_codes; c++)
+    mp->pending[2*c] = mp->pending[2*c+1] = 0;
+
+  c = MP_LEFT(mp, esa, pos);
+  mp->pending[2*c] = mp->pending[2*c+1] = pos;
+  mp->next[pos] = 0;
+
+  return mp_merge(mp, node->lcp, mp->pending);
+}
+
+
+/*
+ * mp_close, mp_child
+ *
+ * Save the lists of a closed interval, then merge them into its parent.
+ */
+static int mp_close(SARY_ESA *esa, ESA_INTERVAL *node, void *data)
+{
+  MAXPAIRS *mp;
+
+  mp = data;
+  mp->num_levels--;
+  memcpy(mp->pending, &MP_HEAD(mp, mp->num_levels, 0),
+         2 * mp->num_codes * sizeof(int));
+
+  return 1;
+}
+
+static int mp_child(SARY_ESA *esa, ESA_INTERVAL *node, ESA_INTERVAL *child,
+                    void *data)
+{
+  MAXPAIRS *mp;
+
+  mp = data;
+  return mp_merge(mp, node->lcp, mp->pending);
+}
+
+
+/*
+ * mp_merge
+ *
+ * Report the pairs between a child's lists and those of the current
+ * interval (with an lcp of `lcp') having different left predecessors,
+ * then append the child's lists.
+ *
+ * Returns:  non-zero to continue, zero if the report function said stop.
+ */
+static int mp_merge(MAXPAIRS *mp, int lcp, int *lists)
+{
+  int a, b, p, q, level;
+
+  level = mp->num_levels - 1;
+
+  if (lcp >= mp->min_length) {
+    for (a=0; a < mp->num_codes; a++) {
+      if (lists[2*a] == 0)
+        continue;
+
+      for (b=0; b < mp->num_codes; b++) {
+        if (b == a || MP_HEAD(mp, level, b) == 0)
+          continue;
+
+        for (p=lists[2*a]; p != 0; p=mp->next[p]) {
+          for (q=MP_HEAD(mp, level, b); q != 0; q=mp->next[q]) {
+            mp->num_pairs++;
+            if (mp->report != NULL &&
+                !(p < q ? (*mp->report)(p, q, lcp, mp->data)
+                        : (*mp->report)(q, p, lcp, mp->data))) {
+              mp->stopped = 1;
+              return 0;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for (a=0; a < mp->num_codes; a++) {
+    if (lists[2*a] == 0)
+      continue;
+
+    if (MP_HEAD(mp, level, a) == 0)
+      MP_HEAD(mp, level, a) = lists[2*a];
+    else
+      mp->next[MP_TAIL(mp, level, a)] = lists[2*a];
+    MP_TAIL(mp, level, a) = lists[2*a+1];
+  }
+
+  return 1;
+}
@@ -0,0 +1,12 @@
+
+#ifndef _REPEATS_MAXPAIRS_H_
+#define _REPEATS_MAXPAIRS_H_
+
+#include "sary_esa.h"
+
+typedef int (*MAXPAIRS_REPORT)(int pos1, int pos2, int len, void *data);
+
+int maxpairs_find(SARY_ESA *esa, int min_length, MAXPAIRS_REPORT report,
+                  void *data);
+
+#endif
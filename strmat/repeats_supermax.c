@@ -7,6 +7,8 @@
  *    ?/95  -  Original Implementation  (James Knight)
  *    8/96  -  Modularized the code  (James Knight)
  *    2/99  -  Removed memory leak bug  (Jens Stoye)
+ *   10/26  -  Added supermax_find_esa, the same computation over an
+ *             enhanced suffix array, and made both honor min_length
  */
 
 #include <stdio.h>
@@ -288,8 +290,9 @@ static SUPERMAXIMALS compute_supermax(SUFFIX_TREE tree, STREE_NODE node,
    */
   percent = (int) (((float) witnesses) / ((float) num_leaves) * 100.0);
 
-  if (min_percent == 0 || (min_percent < 100 && percent >= min_percent) ||
-      (min_percent == 100 && witnesses == num_leaves)) {
+  if (stree_get_labellen(tree, node) >= min_length &&
+      (min_percent == 0 || (min_percent < 100 && percent >= min_percent) ||
+       (min_percent == 100 && witnesses == num_leaves))) {
 
     if ((newnode = malloc(sizeof(STRUCT_SUPERMAX))) == NULL) {
       errorflag = 1;
@@ -314,3 +317,247 @@ static SUPERMAXIMALS compute_supermax(SUFFIX_TREE tree, STREE_NODE node,
 
   return list;
 }
+
+
+
+/*
+ *
+ *
+ * The procedures for computing the supermaximals with an enhanced
+ * suffix array, as a bottom-up traversal of its lcp-intervals.
+ *
+ * In place of the lists of left predecessors kept for every tree node,
+ * each open interval keeps two bit sets over the left predecessors
+ * (the 256 characters, plus one for the start of the string):  those
+ * seen in the interval, and those seen more than once.  A singleton
+ * child (a leaf) is a witness if its left predecessor is not in the
+ * second set.  The singleton rows of the open intervals are kept on a
+ * stack, so the working space only depends on the depth of the
+ * intervals.
+ *
+ *
+ */
+
+#define SMAX_LEFT_START 256
+#define SMAX_LEFT_WORDS ((SMAX_LEFT_START + 1 + 31) / 32)
+
+typedef struct {
+  unsigned int seen[SMAX_LEFT_WORDS], twice[SMAX_LEFT_WORDS];
+  int first_leaf;
+} SMAX_LEFTSET;
+
+typedef struct {
+  SMAX_LEFTSET *sets, pending;
+  int num_sets, sets_size;
+
+  int *leaves, num_leaves, leaves_size;
+
+  int min_percent, min_length;
+  SUPERMAXIMALS list;
+} SMAX_ESA;
+
+#define SMAX_LEFT(esa,row) \
+  ((esa)->Pos[row] == 1 ? SMAX_LEFT_START \
+                        : (unsigned char) (esa)->S[(esa)->Pos[row] - 1])
+#define SMAX_HAS(set,c)  ((set)[(c) >> 5] & (1U << ((c) & 31)))
+
+static int smax_open(SARY_ESA *esa, ESA_INTERVAL *node, void *data);
+static int smax_leaf(SARY_ESA *esa, ESA_INTERVAL *node, int row, void *data);
+static int smax_child(SARY_ESA *esa, ESA_INTERVAL *node, ESA_INTERVAL *child,
+                      void *data);
+static int smax_close(SARY_ESA *esa, ESA_INTERVAL *node, void *data);
+
+
+/*
+ * supermax_find_esa
+ *
+ * Find the supermaximals for a string, given its enhanced suffix array.
+ * The list is the same as that of supermax_find.
+ *
+ * Parameters:  esa          -  the enhanced suffix array of the string
+ *              min_percent  -  the minimum percent for any supermaximal
+ *              min_length   -  the minimum length of any reported supermaximal
+ *
+ * Returns:  A list of the supermaximals, or NULL.
+ */
+SUPERMAXIMALS supermax_find_esa(SARY_ESA *esa, int min_percent,
+                                int min_length)
+{
+  SMAX_ESA smax;
+  ESA_VISITOR visitor;
+  SUPERMAXIMALS smnode, smnext;
+
+  if (esa == NULL)
+    return NULL;
+
+  memset(&smax, 0, sizeof(SMAX_ESA));
+  smax.min_percent = min_percent;
+  smax.min_length = min_length;
+
+  visitor.open = smax_open;
+  visitor.leaf = smax_leaf;
+  visitor.child = smax_child;
+  visitor.close = smax_close;
+
+  if (!sary_esa_bottom_up(esa, &visitor, &smax)) {
+    for (smnode=smax.list; smnode != NULL; smnode=smnext) {
+      smnext = smnode->next;
+      free(smnode);
+    }
+    smax.list = NULL;
+  }
+
+  if (smax.sets != NULL)
+    free(smax.sets);
+  if (smax.leaves != NULL)
+    free(smax.leaves);
+
+  return smax.list;
+}
+
+
+/*
+ * smax_open
+ *
+ * Start the (empty) sets of left predecessors of a new interval.
+ */
+static int smax_open(SARY_ESA *esa, ESA_INTERVAL *node, void *data)
+{
+  SMAX_ESA *smax;
+  SMAX_LEFTSET *newsets;
+
+  smax = data;
+  if (smax->num_sets == smax->sets_size) {
+    smax->sets_size = (smax->sets_size == 0 ? 64 : smax->sets_size * 2);
+    newsets = realloc(smax->sets, smax->sets_size * sizeof(SMAX_LEFTSET));
+    if (newsets == NULL)
+      return 0;
+    smax->sets = newsets;
+  }
+
+  memset(&smax->sets[smax->num_sets], 0, sizeof(SMAX_LEFTSET));
+  smax->sets[smax->num_sets++].first_leaf = smax->num_leaves;
+
+  return 1;
+}
+
+
+/*
+ * smax_leaf
+ *
+ * Add the left predecessor of a leaf to the current interval's sets,
+ * and save its row for the witness count.
+ */
+static int smax_leaf(SARY_ESA *esa, ESA_INTERVAL *node, int row, void *data)
+{
+  int c, *newleaves;
+  SMAX_ESA *smax;
+  SMAX_LEFTSET *set;
+
+  smax = data;
+  if (smax->num_leaves == smax->leaves_size) {
+    smax->leaves_size = (smax->leaves_size == 0 ? 64
+                                                : smax->leaves_size * 2);
+    newleaves = realloc(smax->leaves, smax->leaves_size * sizeof(int));
+    if (newleaves == NULL)
+      return 0;
+    smax->leaves = newleaves;
+  }
+  smax->leaves[smax->num_leaves++] = row;
+
+  set = &smax->sets[smax->num_sets-1];
+  c = SMAX_LEFT(esa, row);
+  if (SMAX_HAS(set->seen, c))
+    set->twice[c >> 5] |= 1U << (c & 31);
+  set->seen[c >> 5] |= 1U << (c & 31);
+
+  return 1;
+}
+
+
+/*
+ * smax_child
+ *
+ * Merge the sets of a closed child interval into its parent's.
+ */
+static int smax_child(SARY_ESA *esa, ESA_INTERVAL *node, ESA_INTERVAL *child,
+                      void *data)
+{
+  int i;
+  SMAX_ESA *smax;
+  SMAX_LEFTSET *set;
+
+  smax = data;
+  set = &smax->sets[smax->num_sets-1];
+  for (i=0; i < SMAX_LEFT_WORDS; i++) {
+    set->twice[i] |= smax->pending.twice[i] |
+                     (set->seen[i] & smax->pending.seen[i]);
+    set->seen[i] |= smax->pending.seen[i];
+  }
+
+  return 1;
+}
+
+
+/*
+ * smax_close
+ *
+ * Determine if a closed interval is a supermaximal or near supermaximal
+ * (see compute_supermax), and save its sets for the merge into the
+ * parent.
+ */
+static int smax_close(SARY_ESA *esa, ESA_INTERVAL *node, void *data)
+{
+  int i, c, diversity, num_leaves, witnesses, percent;
+  SMAX_ESA *smax;
+  SMAX_LEFTSET *set;
+  SUPERMAXIMALS newnode;
+
+  smax = data;
+  set = &smax->sets[--smax->num_sets];
+  smax->pending = *set;
+
+  if (node->lcp == 0) {
+    smax->num_leaves = set->first_leaf;
+    return 1;
+  }
+
+  diversity = 0;
+  for (i=0; i < SMAX_LEFT_WORDS && diversity < 2; i++)
+    if (set->seen[i] != 0)
+      diversity += ((set->seen[i] & (set->seen[i] - 1)) != 0 ? 2 : 1);
+
+  witnesses = 0;
+  if (diversity > 1) {
+    for (i=set->first_leaf; i < smax->num_leaves; i++) {
+      c = SMAX_LEFT(esa, smax->leaves[i]);
+      if (!SMAX_HAS(set->twice, c))
+        witnesses++;
+    }
+  }
+  smax->num_leaves = set->first_leaf;
+
+  if (witnesses == 0)
+    return 1;
+
+  num_leaves = node->rb - node->lb + 1;
+  percent = (int) (((float) witnesses) / ((float) num_leaves) * 100.0);
+
+  if (node->lcp >= smax->min_length &&
+      (smax->min_percent == 0 ||
+       (smax->min_percent < 100 && percent >= smax->min_percent) ||
+       (smax->min_percent == 100 && witnesses == num_leaves))) {
+    if ((newnode = malloc(sizeof(STRUCT_SUPERMAX))) == NULL)
+      return 0;
+
+    newnode->M = node->lcp;
+    newnode->S = &esa->S[esa->Pos[node->lb]];
+    newnode->num_leaves = num_leaves;
+    newnode->num_witness = witnesses;
+    newnode->percent = percent;
+    newnode->next = smax->list;
+    smax->list = newnode;
+  }
+
+  return 1;
+}
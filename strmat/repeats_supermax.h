@@ -2,6 +2,8 @@
 #ifndef _REPEATS_SUPERMAX_H_
 #define _REPEATS_SUPERMAX_H_
 
+#include "sary_esa.h"
+
 typedef struct supermax_node {
   char *S;
   int M, num_witness, num_leaves, percent;
@@ -9,5 +11,7 @@ typedef struct supermax_node {
 } STRUCT_SUPERMAX, *SUPERMAXIMALS;
 
 SUPERMAXIMALS supermax_find(char *S, int M, int min_percent, int min_length);
+SUPERMAXIMALS supermax_find_esa(SARY_ESA *esa, int min_percent,
+                                int min_length);
 
 #endif
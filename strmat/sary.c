@@ -2,8 +2,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
 #include "sary.h"
 #include "sary_zerkle.h"
+#include "sary_cmp.h"
 #ifdef STRMAT
 #include "stree_strmat.h"
 #include "stree_ukkonen.h"
@@ -15,7 +18,17 @@
 /*
  * sary_qsort_build
  *
- * Build a suffix array using a quick sort of the indices into the string.
+ * Build a suffix array by sorting the indices into the string.  The
+ * suffixes are sorted with a multikey (ternary) quicksort, which never
+ * rescans the characters two suffixes are already known to share.
+ * Groups of suffixes still tied after SARY_MKQS_DEPTH characters (i.e.,
+ * long repeats) are finished off by Larsson-Sadakane prefix doubling,
+ * so strings like the Fibonacci strings do not go quadratic.
+ *
+ * All of the sorting state lives in a SARY_SORT structure local to
+ * the call, so any number of suffix arrays can be built concurrently.
+ * The sort itself is sary_sort_entries, which also builds the packed
+ * suffix arrays of sary_pack.c.
  *
  * Parameters:  S         -  the input string
  *              M         -  the string's length
@@ -23,12 +36,79 @@
  *
  * Returns:  an initialized SARY_STRUCT structure
  */
-static SARY_STRUCT *sarystruct;
-static int sarycmp(int *a, int *b);
+#define SARY_MKQS_DEPTH 32
+
+/*
+ * The working memory of a build, shared by all of its threads.  Every
+ * buffer is added when it is allocated (or grown) and subtracted when
+ * it is freed, so peak is the largest amount in use at any one time.
+ */
+typedef struct {
+  long current, peak;
+  pthread_mutex_t lock;
+} SARY_MEMORY;
+
+/*
+ * Pos, the ranks and the (lo,n) pairs of the group lists hold entries
+ * of the given width (see sary_entry_get), which is 32 for the int
+ * arrays of SARY_STRUCT.
+ */
+typedef struct {
+  char *S;
+  long M;
+  int width;
+  void *Pos, *rank, *rank_out;
+
+  void *groups;
+  long num_groups, groups_size;
+
+  long num_compares;
+  SARY_MEMORY *mem;
+} SARY_SORT;
+
+/*
+ * Read and write entry i of one of those arrays, with the int case done
+ * inline.  The width is passed in a local variable (a store through an
+ * unsigned int pointer could change ctx->width as far as the compiler
+ * knows, which keeps the test inside the sorting loops).
+ */
+#define SORT_GET(width,a,i) \
+  ((width) == 32 ? (long) ((unsigned int *) (a))[i] \
+                 : entry_get((a), (width), (i)))
+
+#define SORT_SET(width,a,i,value) \
+  do { \
+    if ((width) == 32) \
+      ((unsigned int *) (a))[i] = (unsigned int) (value); \
+    else \
+      entry_set((a), (width), (i), (value)); \
+  } while (0)
+
+/*
+ * The sort key of suffix i at depth d:  0 once the suffix has ended,
+ * otherwise the character shifted into 1..256 (keeping the ordering
+ * of the char comparisons done by sary_match.c).
+ */
+#define SORT_KEY(ctx,i,d) \
+  ((i) + (d) <= (ctx)->M ? (int) (ctx)->S[(i)+(d)] - CHAR_MIN + 1 : 0)
+
+static long entry_get(void *a, int width, long i);
+static void entry_set(void *a, int width, long i, long value);
+static int sort_suffixes(SARY_SORT *ctx);
+static int sort_mkqs(SARY_SORT *ctx, int width, long lo, long n,
+                     long depth);
+static long sort_extend(SARY_SORT *ctx, long lo, long n, long depth);
+static int sort_doubling(SARY_SORT *ctx, int width);
+static int sort_split(SARY_SORT *ctx, int width, long lo, long n, long h,
+                      void **newgroups, long *num_new, long *new_size);
+static int push_group(SARY_SORT *ctx, void **list, long *num, long *size,
+                      long lo, long n);
+static void free_groups(SARY_SORT *ctx, void *list, long size);
+static void note_memory(SARY_SORT *ctx, long bytes);
 
 SARY_STRUCT *sary_qsort_build(char *S, int M, int copyflag)
 {
-  int i, *Pos;
+  long num_compares;
   char *buf;
   SARY_STRUCT *sary;
 
@@ -60,7 +140,7 @@ SARY_STRUCT *sary_qsort_build(char *S, int M, int copyflag)
     sary->S = buf;
   }
     
-  if ((Pos = sary->Pos = malloc((M + 1) * sizeof(int))) == NULL) {
+  if ((sary->Pos = malloc((M + 1) * sizeof(int))) == NULL) {
     sary_free(sary);
     return NULL;
   }
@@ -68,49 +148,1029 @@ SARY_STRUCT *sary_qsort_build(char *S, int M, int copyflag)
   /*
    * Compute the suffix array.
    */
-  for (i=1; i <= M; i++)
-    Pos[i] = i;
+  num_compares = 0;
+  if (!sary_sort_entries(sary->S, M, sary->Pos, 32, &num_compares,
+                         &sary->mem_peak)) {
+    sary_free(sary);
+    return NULL;
+  }
 
-  sarystruct = sary;
-  qsort(Pos+1, M, sizeof(int), (int (*)()) sarycmp);
+#ifdef STATS
+  sary->num_compares = (int) num_compares;
+#endif
 
   return sary;
 }
 
 
 /*
- * sarycmp
+ * sary_sort_entries
  *
- * Compare two suffixes to determine which is lexically smaller.
+ * Sort the suffixes of a string into an array of entries of the given
+ * width (32, 40 or 64 bits, see sary_entry_get).  This is the sort of
+ * sary_qsort_build, where the int array of a SARY_STRUCT is the 32 bit
+ * case, and of sary_packed_build.
  *
- * Parameters:  a  -  Address where the first index into the suffix is stored
- *              b  -  Address where the other index is stored
+ * Parameters:  S             -  the string, as S[1],...,S[M]
+ *              M             -  the string's length
+ *              Pos           -  the array (M+1 entries) to fill
+ *              width         -  its entry width
+ *              num_compares  -  where to add the character comparisons
+ *              mem_peak      -  where to store the peak memory used,
+ *                               counting Pos itself
  *
- * Returns:  -1,0,1 if the first suffix is less than, equal to or greater
- *           than the second suffix.
+ * Returns:  non-zero on success, zero if memory ran out.
  */
-static int sarycmp(int *a, int *b)
+int sary_sort_entries(char *S, long M, void *Pos, int width,
+                      long *num_compares, long *mem_peak)
 {
-  int i, j, k, M;
-  char *S;
+  int status;
+  long i;
+  SARY_SORT ctx;
+  SARY_MEMORY mem;
+
+  memset(&mem, 0, sizeof(SARY_MEMORY));
+  pthread_mutex_init(&mem.lock, NULL);
+
+  memset(&ctx, 0, sizeof(SARY_SORT));
+  ctx.S = S;
+  ctx.M = M;
+  ctx.width = width;
+  ctx.Pos = Pos;
+  ctx.mem = &mem;
+  note_memory(&ctx, (M + 1) * (long) (width / 8));
+
+  for (i=1; i <= M; i++)
+    SORT_SET(width, Pos, i, i);
+
+  status = sort_suffixes(&ctx);
+
+  *num_compares += ctx.num_compares;
+  *mem_peak = mem.peak;
+  pthread_mutex_destroy(&mem.lock);
+
+  return status;
+}
+
+
+/*
+ * sary_entry_get, sary_entry_set
+ *
+ * Read and write entry i of an array of the given width.  The 32 and
+ * 64 bit entries are unsigned ints and longs, and the 40 bit entries
+ * are stored as 5 little-endian bytes.
+ *
+ * NOTE:  positions are held in a long, so the 40 and 64 bit widths
+ *        assume a platform with 64 bit longs.
+ */
+long sary_entry_get(void *a, int width, long i)
+{
+  return entry_get(a, width, i);
+}
+
+void sary_entry_set(void *a, int width, long i, long value)
+{
+  entry_set(a, width, i, value);
+}
+
+static long entry_get(void *a, int width, long i)
+{
+  unsigned char *p;
+
+  switch (width) {
+  case 32:
+    return (long) ((unsigned int *) a)[i];
+
+  case 64:
+    return ((long *) a)[i];
+
+  default:
+    p = (unsigned char *) a + i * 5;
+    return (long) p[0] | ((long) p[1] << 8) | ((long) p[2] << 16) |
+           ((long) p[3] << 24) | ((long) p[4] << 32);
+  }
+}
+
+static void entry_set(void *a, int width, long i, long value)
+{
+  unsigned char *p;
+
+  switch (width) {
+  case 32:
+    ((unsigned int *) a)[i] = (unsigned int) value;
+    break;
+
+  case 64:
+    ((long *) a)[i] = value;
+    break;
+
+  default:
+    p = (unsigned char *) a + i * 5;
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
+    p[4] = (value >> 32) & 0xFF;
+    break;
+  }
+}
+
+
+/*
+ * sort_suffixes
+ *
+ * Sort ctx->Pos[1..M], first with the multikey quicksort and then,
+ * if any groups were left tied at the depth limit, with prefix doubling.
+ *
+ * Parameters:  ctx  -  the sorting context
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int sort_suffixes(SARY_SORT *ctx)
+{
+  int status;
+
+  /*
+   * The width is passed down as a constant, so that the compiler can
+   * make a copy of the sort for each width instead of testing it on
+   * every access.
+   */
+  if (ctx->width == 32)
+    status = sort_mkqs(ctx, 32, 1, ctx->M, 0);
+  else if (ctx->width == 40)
+    status = sort_mkqs(ctx, 40, 1, ctx->M, 0);
+  else
+    status = sort_mkqs(ctx, 64, 1, ctx->M, 0);
+
+  if (status && ctx->num_groups > 0) {
+    if (ctx->width == 32)
+      status = sort_doubling(ctx, 32);
+    else if (ctx->width == 40)
+      status = sort_doubling(ctx, 40);
+    else
+      status = sort_doubling(ctx, 64);
+  }
+
+  free_groups(ctx, ctx->groups, ctx->groups_size);
+  if (ctx->rank != NULL) {
+    free(ctx->rank);
+    note_memory(ctx, -(ctx->M + 2) * (long) (ctx->width / 8));
+  }
+  ctx->groups = NULL;
+  ctx->rank = ctx->rank_out = NULL;
+  ctx->num_groups = ctx->groups_size = 0;
+
+  return status;
+}
+
+
+/*
+ * sort_mkqs
+ *
+ * Multikey quicksort of Pos[lo..lo+n-1], whose suffixes are known to
+ * share their first `depth' characters.  The partition is three-way on
+ * the character at `depth', and only the "equal" part goes on to the
+ * next character, so the known common prefix is never compared again.
+ *
+ * Groups still unsorted at depth SARY_MKQS_DEPTH are recorded in
+ * ctx->groups for sort_doubling.
+ *
+ * Parameters:  ctx    -  the sorting context
+ *              width  -  ctx->width
+ *              lo, n  -  the range of Pos to sort
+ *              depth  -  the length of the common prefix of the range
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int sort_mkqs(SARY_SORT *ctx, int width, long lo, long n,
+                     long depth)
+{
+  int key, v, a, b, c;
+  long i, lt, gt, x, y;
+  void *Pos;
+
+  Pos = ctx->Pos;
+  while (n > 1) {
+    if (depth >= SARY_MKQS_DEPTH)
+      return push_group(ctx, &ctx->groups, &ctx->num_groups,
+                        &ctx->groups_size, lo, n);
+
+    /*
+     * Median of three pivot.
+     */
+    a = SORT_KEY(ctx, SORT_GET(width, Pos, lo), depth);
+    b = SORT_KEY(ctx, SORT_GET(width, Pos, lo + n / 2), depth);
+    c = SORT_KEY(ctx, SORT_GET(width, Pos, lo + n - 1), depth);
+    if (a < b)
+      v = (b < c ? b : (a < c ? c : a));
+    else
+      v = (a < c ? a : (b < c ? c : b));
+
+    /*
+     * Three-way partition:  Pos[lo..lt-1] < v, Pos[lt..gt] == v
+     * and Pos[gt+1..lo+n-1] > v.
+     */
+    lt = i = lo;
+    gt = lo + n - 1;
+    while (i <= gt) {
+      x = SORT_GET(width, Pos, i);
+      key = SORT_KEY(ctx, x, depth);
+#ifdef STATS
+      ctx->num_compares++;
+#endif
+      if (key < v) {
+        y = SORT_GET(width, Pos, lt);
+        SORT_SET(width, Pos, lt, x);
+        SORT_SET(width, Pos, i, y);
+        lt++;
+        i++;
+      }
+      else if (key > v) {
+        y = SORT_GET(width, Pos, gt);
+        SORT_SET(width, Pos, gt, x);
+        SORT_SET(width, Pos, i, y);
+        gt--;
+      }
+      else
+        i++;
+    }
 
-  i = *a;
-  j = *b;
-  S = sarystruct->S;
-  M = sarystruct->M;
+    if (lt - lo > 1 && !sort_mkqs(ctx, width, lo, lt - lo, depth))
+      return 0;
+    if (lo + n - 1 - gt > 1 &&
+        !sort_mkqs(ctx, width, gt + 1, lo + n - 1 - gt, depth))
+      return 0;
+
+    /*
+     * A suffix which has ended is unique at this depth, so only continue
+     * down the equal part when v is a real character.
+     */
+    if (v == 0)
+      break;
+
+    lo = lt;
+    n = gt - lt + 1;
+    depth++;
+
+    if (n > 1 && depth < SARY_MKQS_DEPTH)
+      depth += sort_extend(ctx, lo, n, depth);
+  }
+
+  return 1;
+}
 
-  for (k=0; i + k <= M && j + k <= M && S[i+k] == S[j+k]; k++) ;
 
+/*
+ * sort_extend
+ *
+ * Find how many more characters (up to SARY_MKQS_DEPTH) all of the
+ * suffixes of a group share, comparing them a word at a time instead
+ * of partitioning on each of those characters in turn.
+ *
+ * Parameters:  ctx    -  the sorting context
+ *              lo, n  -  the group
+ *              depth  -  the length of the group's common prefix
+ *
+ * Returns:  the number of further characters the suffixes share.
+ */
+static long sort_extend(SARY_SORT *ctx, long lo, long n, long depth)
+{
+  int width;
+  long i, p, q, len, max;
+
+  width = ctx->width;
+  p = SORT_GET(width, ctx->Pos, lo);
+  max = SARY_MKQS_DEPTH - depth;
+  if (ctx->M - p + 1 - depth < max)
+    max = ctx->M - p + 1 - depth;
+
+  for (i=lo+1; i < lo + n && max > 0; i++) {
+    q = SORT_GET(width, ctx->Pos, i);
+    if (ctx->M - q + 1 - depth < max)
+      max = ctx->M - q + 1 - depth;
+
+    len = sary_cmp_length(&ctx->S[p+depth], &ctx->S[q+depth], (int) max);
 #ifdef STATS
-  sarystruct->num_compares += k + 1;
+    ctx->num_compares += len + 1;
 #endif
+    if (len < max)
+      max = len;
+  }
 
-  if (i + k > M)
-    return (j + k > M ? 0 : -1);
-  else if (j + k <= M && S[i+k] > S[j+k])
+  return (max > 0 ? max : 0);
+}
+
+
+/*
+ * sort_doubling
+ *
+ * Finish the groups left by sort_mkqs using Larsson-Sadakane prefix
+ * doubling.  Every suffix gets a rank, which is its index in Pos when
+ * it is sorted and the last index of its group otherwise.  A group
+ * sorted on its first h characters is then split on the ranks of the
+ * suffixes h further on, doubling h on each pass.  The ranks have the
+ * same width as Pos.
+ *
+ * Parameters:  ctx    -  the sorting context
+ *              width  -  ctx->width
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int sort_doubling(SARY_SORT *ctx, int width)
+{
+  long i, j, h, lo, n, M, num, size, num_new, new_size;
+  void *Pos, *rank, *list, *newlist;
+
+  M = ctx->M;
+  Pos = ctx->Pos;
+
+  if ((rank = ctx->rank = malloc((M + 2) * (width / 8))) == NULL)
+    return 0;
+  ctx->rank_out = rank;
+  note_memory(ctx, (M + 2) * (long) (width / 8));
+
+  for (i=1; i <= M; i++)
+    SORT_SET(width, rank, SORT_GET(width, Pos, i), i);
+  for (i=0; i < ctx->num_groups; i++) {
+    lo = SORT_GET(width, ctx->groups, 2 * i);
+    n = SORT_GET(width, ctx->groups, 2 * i + 1);
+    for (j=lo; j < lo + n; j++)
+      SORT_SET(width, rank, SORT_GET(width, Pos, j), lo + n - 1);
+  }
+
+  list = ctx->groups;
+  num = ctx->num_groups;
+  size = ctx->groups_size;
+  ctx->groups = NULL;
+  ctx->num_groups = ctx->groups_size = 0;
+
+  for (h=SARY_MKQS_DEPTH; num > 0; h*=2) {
+    newlist = NULL;
+    num_new = new_size = 0;
+    for (i=0; i < num; i++) {
+      if (!sort_split(ctx, width, SORT_GET(width, list, 2 * i),
+                      SORT_GET(width, list, 2 * i + 1), h,
+                      &newlist, &num_new, &new_size)) {
+        free_groups(ctx, list, size);
+        free_groups(ctx, newlist, new_size);
+        return 0;
+      }
+    }
+
+    free_groups(ctx, list, size);
+    list = newlist;
+    num = num_new;
+    size = new_size;
+  }
+  free_groups(ctx, list, size);
+
+  return 1;
+}
+
+
+/*
+ * sort_split
+ *
+ * Ternary quicksort of the group Pos[lo..lo+n-1] on the ranks of the
+ * suffixes h characters on, updating the ranks of each new subgroup.
+ * As in Larsson-Sadakane, the smaller part is finished (and its ranks
+ * updated) before the equal part, and the equal part before the larger.
+ *
+ * The ranks are read from ctx->rank and written to ctx->rank_out.  The
+ * serial sort updates in place (the two are the same array), while the
+ * parallel sort writes to a second copy so that no thread ever reads a
+ * rank another thread is changing.
+ *
+ * Parameters:  ctx       -  the sorting context
+ *              width     -  ctx->width
+ *              lo, n     -  the group
+ *              h         -  the length of the group's common prefix
+ *              newgroups -  the list receiving the still unsorted groups
+ *              num_new   -  the number of groups in that list
+ *              new_size  -  the allocated size of that list
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+#define RANK_KEY(ctx,width,i,h) \
+  ((i) + (h) <= (ctx)->M ? SORT_GET((width), (ctx)->rank, (i) + (h)) : 0)
+
+static int sort_split(SARY_SORT *ctx, int width, long lo, long n, long h,
+                      void **newgroups, long *num_new, long *new_size)
+{
+  long i, lt, gt, key, v, x, y;
+  void *Pos, *rank;
+
+  Pos = ctx->Pos;
+  rank = ctx->rank_out;
+
+  if (n == 1) {
+    SORT_SET(width, rank, SORT_GET(width, Pos, lo), lo);
     return 1;
-  else
-    return -1;
+  }
+
+  v = RANK_KEY(ctx, width, SORT_GET(width, Pos, lo + n / 2), h);
+  lt = i = lo;
+  gt = lo + n - 1;
+  while (i <= gt) {
+    x = SORT_GET(width, Pos, i);
+    key = RANK_KEY(ctx, width, x, h);
+#ifdef STATS
+    ctx->num_compares++;
+#endif
+    if (key < v) {
+      y = SORT_GET(width, Pos, lt);
+      SORT_SET(width, Pos, lt, x);
+      SORT_SET(width, Pos, i, y);
+      lt++;
+      i++;
+    }
+    else if (key > v) {
+      y = SORT_GET(width, Pos, gt);
+      SORT_SET(width, Pos, gt, x);
+      SORT_SET(width, Pos, i, y);
+      gt--;
+    }
+    else
+      i++;
+  }
+
+  if (lt > lo &&
+      !sort_split(ctx, width, lo, lt - lo, h, newgroups, num_new, new_size))
+    return 0;
+
+  for (i=lt; i <= gt; i++)
+    SORT_SET(width, rank, SORT_GET(width, Pos, i), gt);
+  if (gt > lt &&
+      !push_group(ctx, newgroups, num_new, new_size, lt, gt - lt + 1))
+    return 0;
+
+  if (gt < lo + n - 1 &&
+      !sort_split(ctx, width, gt + 1, lo + n - 1 - gt, h,
+                  newgroups, num_new, new_size))
+    return 0;
+
+  return 1;
+}
+
+
+/*
+ * push_group
+ *
+ * Append the group (lo,n) to a growable list of groups.
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int push_group(SARY_SORT *ctx, void **list, long *num, long *size,
+                      long lo, long n)
+{
+  int width;
+  long newsize;
+  void *newlist;
+
+  width = ctx->width;
+  if (*num == *size) {
+    newsize = (*size == 0 ? 64 : *size * 2);
+    if ((newlist = realloc(*list, newsize * 2 * (width / 8))) == NULL)
+      return 0;
+    note_memory(ctx, (newsize - *size) * 2 * (long) (width / 8));
+    *list = newlist;
+    *size = newsize;
+  }
+
+  SORT_SET(width, *list, 2 * *num, lo);
+  SORT_SET(width, *list, 2 * *num + 1, n);
+  (*num)++;
+
+  return 1;
+}
+
+
+/*
+ * free_groups
+ *
+ * Free a list of groups built by push_group (size being its allocated
+ * number of groups).
+ */
+static void free_groups(SARY_SORT *ctx, void *list, long size)
+{
+  if (list == NULL)
+    return;
+
+  free(list);
+  note_memory(ctx, -size * 2 * (long) (ctx->width / 8));
+}
+
+
+/*
+ * note_memory
+ *
+ * Keep track of the working memory of a build (for the statistics
+ * and the benchmarks), adding the bytes allocated or, when negative,
+ * subtracting the bytes freed.
+ */
+static void note_memory(SARY_SORT *ctx, long bytes)
+{
+  SARY_MEMORY *mem = ctx->mem;
+
+  pthread_mutex_lock(&mem->lock);
+  mem->current += bytes;
+  if (mem->current > mem->peak)
+    mem->peak = mem->current;
+  pthread_mutex_unlock(&mem->lock);
+}
+
+
+/*
+ * sary_parallel_build
+ *
+ * Build a suffix array using several threads.  The suffixes are first
+ * distributed into buckets on their first k characters (a parallel
+ * counting sort, where k is chosen from the number of distinct
+ * characters so there are at most SARY_PAR_BUCKETS buckets).  The
+ * buckets are then handed out to the threads, largest first, and each
+ * is sorted by the multikey quicksort of sary_qsort_build.  Any groups
+ * left tied by that sort are finished by parallel prefix doubling, with
+ * the ranks double-buffered between passes.
+ *
+ * Parameters:  S         -  the input string
+ *              M         -  the string's length
+ *              nthreads  -  the number of threads to use
+ *
+ * Returns:  an initialized SARY_STRUCT structure
+ */
+#define SARY_PAR_BUCKETS 65536
+
+typedef struct {
+  char *S;
+  int M, *Pos, nthreads;
+
+  int sigma, k, num_buckets, code[UCHAR_MAX+1];
+  int *counts;            /* per thread bucket counts, then offsets */
+
+  int *tasks, num_tasks;  /* (lo,n) pairs handed out to the threads */
+  int tasks_size, h;
+
+  pthread_mutex_t lock;
+  int next_task;
+} SARY_PARALLEL;
+
+typedef struct {
+  SARY_PARALLEL *par;
+  int id, status;
+  SARY_SORT ctx;
+} SARY_WORKER;
+
+static int run_workers(SARY_PARALLEL *par, SARY_WORKER *workers,
+                       void *(*fn)(void *));
+static int next_task(SARY_PARALLEL *par);
+static int bucket_code(SARY_PARALLEL *par, int i);
+static void *worker_count(void *arg);
+static void *worker_scatter(void *arg);
+static void *worker_sort(void *arg);
+static void *worker_split(void *arg);
+static void *worker_copyback(void *arg);
+static int par_doubling(SARY_PARALLEL *par, SARY_WORKER *workers,
+                        SARY_SORT *ctx);
+static int collect_groups(SARY_PARALLEL *par, SARY_WORKER *workers,
+                          SARY_SORT *ctx);
+static int cmp_tasks(const void *a, const void *b);
+
+SARY_STRUCT *sary_parallel_build(char *S, int M, int nthreads)
+{
+  int i, t, c, b, sum, status, *Pos;
+  SARY_STRUCT *sary;
+  SARY_PARALLEL par;
+  SARY_WORKER *workers;
+  SARY_SORT ctx;
+  SARY_MEMORY mem;
+
+  if (S == NULL || M <= 0)
+    return NULL;
+  if (nthreads < 1)
+    nthreads = 1;
+
+  S--;            /* Shift to make sequence be S[1],...,S[M] */
+
+  /*
+   * Allocate everything.
+   */
+  if ((sary = malloc(sizeof(SARY_STRUCT))) == NULL)
+    return NULL;
+  memset(sary, 0, sizeof(SARY_STRUCT));
+
+  sary->M = M;
+  sary->copyflag = 0;
+  sary->S = S;
+
+  if ((Pos = sary->Pos = malloc((M + 1) * sizeof(int))) == NULL) {
+    sary_free(sary);
+    return NULL;
+  }
+
+  memset(&par, 0, sizeof(SARY_PARALLEL));
+  par.S = S;
+  par.M = M;
+  par.Pos = Pos;
+  par.nthreads = nthreads;
+  pthread_mutex_init(&par.lock, NULL);
+
+  memset(&mem, 0, sizeof(SARY_MEMORY));
+  pthread_mutex_init(&mem.lock, NULL);
+
+  memset(&ctx, 0, sizeof(SARY_SORT));
+  ctx.S = S;
+  ctx.M = M;
+  ctx.width = 32;
+  ctx.Pos = Pos;
+  ctx.mem = &mem;
+  note_memory(&ctx, (M + 1) * (long) sizeof(int));
+
+  if ((workers = malloc(nthreads * sizeof(SARY_WORKER))) == NULL) {
+    pthread_mutex_destroy(&mem.lock);
+    pthread_mutex_destroy(&par.lock);
+    sary_free(sary);
+    return NULL;
+  }
+  note_memory(&ctx, nthreads * (long) sizeof(SARY_WORKER));
+  for (t=0; t < nthreads; t++) {
+    workers[t].par = &par;
+    workers[t].id = t;
+    workers[t].status = 1;
+    workers[t].ctx = ctx;
+  }
+
+  /*
+   * Map the characters that occur onto 1..sigma (in the char order used
+   * by the matching code, 0 being the end of the string), and pick the
+   * bucket prefix length k.
+   */
+  for (c=0; c <= UCHAR_MAX; c++)
+    par.code[c] = 0;
+  for (i=1; i <= M; i++)
+    par.code[(unsigned char) S[i]] = 1;
+  par.sigma = 0;
+  for (c=CHAR_MIN; c <= CHAR_MAX; c++)
+    if (par.code[(unsigned char) c])
+      par.code[(unsigned char) c] = ++par.sigma;
+
+  par.k = 1;
+  par.num_buckets = par.sigma + 1;
+  while (par.k < M && par.num_buckets * (par.sigma + 1) <= SARY_PAR_BUCKETS) {
+    par.k++;
+    par.num_buckets *= par.sigma + 1;
+  }
+
+  status = 0;
+  par.counts = malloc(nthreads * (long) par.num_buckets * sizeof(int));
+  par.tasks = malloc(2 * (long) par.num_buckets * sizeof(int));
+  if (par.counts == NULL || par.tasks == NULL)
+    goto FINISH;
+  par.tasks_size = par.num_buckets;
+  note_memory(&ctx, (nthreads + 2) * (long) par.num_buckets * sizeof(int));
+
+  /*
+   * The bucket sort.  Each thread counts the bucket sizes for its slice
+   * of the string, the counts are turned into per thread offsets, and
+   * each thread then places its own suffixes.
+   */
+  if (!run_workers(&par, workers, worker_count))
+    goto FINISH;
+
+  sum = 1;
+  par.num_tasks = 0;
+  for (b=0; b < par.num_buckets; b++) {
+    c = 0;
+    for (t=0; t < nthreads; t++)
+      c += par.counts[t * par.num_buckets + b];
+    if (c > 1) {
+      par.tasks[2*par.num_tasks] = sum;
+      par.tasks[2*par.num_tasks+1] = c;
+      par.num_tasks++;
+    }
+    for (t=0; t < nthreads; t++) {
+      i = par.counts[t * par.num_buckets + b];
+      par.counts[t * par.num_buckets + b] = sum;
+      sum += i;
+    }
+  }
+
+  if (!run_workers(&par, workers, worker_scatter))
+    goto FINISH;
+
+  /*
+   * Sort the buckets, biggest first so the threads finish together.
+   */
+  qsort(par.tasks, par.num_tasks, 2 * sizeof(int), cmp_tasks);
+  if (!run_workers(&par, workers, worker_sort))
+    goto FINISH;
+
+  if (!collect_groups(&par, workers, &ctx))
+    goto FINISH;
+  if (ctx.num_groups > 0 && !par_doubling(&par, workers, &ctx))
+    goto FINISH;
+
+  status = 1;
+
+FINISH:
+#ifdef STATS
+  for (t=0; t < nthreads; t++)
+    sary->num_compares += (int) workers[t].ctx.num_compares;
+#endif
+  sary->mem_peak = mem.peak;
+
+  for (t=0; t < nthreads; t++)
+    if (workers[t].ctx.groups != NULL)
+      free(workers[t].ctx.groups);
+  if (ctx.groups != NULL)
+    free(ctx.groups);
+  if (ctx.rank != NULL)
+    free(ctx.rank);
+  if (ctx.rank_out != NULL)
+    free(ctx.rank_out);
+  if (par.counts != NULL)
+    free(par.counts);
+  if (par.tasks != NULL)
+    free(par.tasks);
+  free(workers);
+  pthread_mutex_destroy(&mem.lock);
+  pthread_mutex_destroy(&par.lock);
+
+  if (!status) {
+    sary_free(sary);
+    return NULL;
+  }
+
+  return sary;
+}
+
+
+/*
+ * run_workers
+ *
+ * Run one phase of the parallel build, calling fn on each worker
+ * (in the calling thread when only one thread was asked for).
+ *
+ * Returns:  non-zero if every worker succeeded, zero otherwise.
+ */
+static int run_workers(SARY_PARALLEL *par, SARY_WORKER *workers,
+                       void *(*fn)(void *))
+{
+  int t, status, started;
+  pthread_t *threads;
+
+  par->next_task = 0;
+
+  if (par->nthreads == 1) {
+    fn(&workers[0]);
+    return workers[0].status;
+  }
+
+  if ((threads = malloc(par->nthreads * sizeof(pthread_t))) == NULL)
+    return 0;
+
+  /*
+   * If a thread cannot be started, the ones that were still drain the
+   * shared task list, so only the per-slice phases need to fail.
+   */
+  started = 0;
+  for (t=0; t < par->nthreads; t++) {
+    if (pthread_create(&threads[t], NULL, fn, &workers[t]) != 0)
+      break;
+    started++;
+  }
+  for (t=0; t < started; t++)
+    pthread_join(threads[t], NULL);
+  free(threads);
+
+  status = (started == par->nthreads);
+  for (t=0; t < started; t++)
+    if (!workers[t].status)
+      status = 0;
+
+  return status;
+}
+
+
+/*
+ * next_task
+ *
+ * Hand out the next unclaimed entry of par->tasks.
+ *
+ * Returns:  the task index, or -1 when none are left.
+ */
+static int next_task(SARY_PARALLEL *par)
+{
+  int task;
+
+  pthread_mutex_lock(&par->lock);
+  task = (par->next_task < par->num_tasks ? par->next_task++ : -1);
+  pthread_mutex_unlock(&par->lock);
+
+  return task;
+}
+
+
+/*
+ * bucket_code
+ *
+ * The bucket of suffix i, i.e., its first k characters read as a
+ * number in base sigma+1.
+ */
+static int bucket_code(SARY_PARALLEL *par, int i)
+{
+  int d, code;
+
+  code = 0;
+  for (d=0; d < par->k; d++)
+    code = code * (par->sigma + 1) +
+           (i + d <= par->M ? par->code[(unsigned char) par->S[i+d]] : 0);
+
+  return code;
+}
+
+
+/*
+ * The worker procedures, one per phase of sary_parallel_build.
+ * worker_count and worker_scatter each take a fixed slice of the string,
+ * the others pull tasks from the shared list.
+ */
+static void *worker_count(void *arg)
+{
+  int i, lo, hi, *counts;
+  SARY_WORKER *w = arg;
+  SARY_PARALLEL *par = w->par;
+
+  counts = par->counts + w->id * (long) par->num_buckets;
+  for (i=0; i < par->num_buckets; i++)
+    counts[i] = 0;
+
+  lo = 1 + (int) ((long) par->M * w->id / par->nthreads);
+  hi = (int) ((long) par->M * (w->id + 1) / par->nthreads);
+  for (i=lo; i <= hi; i++)
+    counts[bucket_code(par, i)]++;
+
+  return NULL;
+}
+
+static void *worker_scatter(void *arg)
+{
+  int i, lo, hi, *offsets;
+  SARY_WORKER *w = arg;
+  SARY_PARALLEL *par = w->par;
+
+  offsets = par->counts + w->id * (long) par->num_buckets;
+
+  lo = 1 + (int) ((long) par->M * w->id / par->nthreads);
+  hi = (int) ((long) par->M * (w->id + 1) / par->nthreads);
+  for (i=lo; i <= hi; i++)
+    par->Pos[offsets[bucket_code(par, i)]++] = i;
+
+  return NULL;
+}
+
+static void *worker_sort(void *arg)
+{
+  int task;
+  SARY_WORKER *w = arg;
+  SARY_PARALLEL *par = w->par;
+
+  while (w->status && (task = next_task(par)) != -1)
+    w->status = sort_mkqs(&w->ctx, 32, par->tasks[2*task],
+                          par->tasks[2*task+1], par->k);
+
+  return NULL;
+}
+
+static void *worker_split(void *arg)
+{
+  int task;
+  SARY_WORKER *w = arg;
+  SARY_PARALLEL *par = w->par;
+
+  while (w->status && (task = next_task(par)) != -1)
+    w->status = sort_split(&w->ctx, 32, par->tasks[2*task],
+                           par->tasks[2*task+1],
+                           par->h, &w->ctx.groups, &w->ctx.num_groups,
+                           &w->ctx.groups_size);
+
+  return NULL;
+}
+
+static void *worker_copyback(void *arg)
+{
+  int i, task, *Pos, *rank, *rank_out;
+  SARY_WORKER *w = arg;
+  SARY_PARALLEL *par = w->par;
+
+  Pos = par->Pos;
+  rank = w->ctx.rank;
+  rank_out = w->ctx.rank_out;
+  while ((task = next_task(par)) != -1)
+    for (i=par->tasks[2*task]; i < par->tasks[2*task] + par->tasks[2*task+1];
+         i++)
+      rank[Pos[i]] = rank_out[Pos[i]];
+
+  return NULL;
+}
+
+
+/*
+ * collect_groups
+ *
+ * Gather the unsorted groups left by the workers into ctx->groups.
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int collect_groups(SARY_PARALLEL *par, SARY_WORKER *workers,
+                          SARY_SORT *ctx)
+{
+  int t, width;
+  long i;
+  SARY_SORT *wctx;
+
+  width = ctx->width;
+  for (t=0; t < par->nthreads; t++) {
+    wctx = &workers[t].ctx;
+    for (i=0; i < wctx->num_groups; i++)
+      if (!push_group(ctx, &ctx->groups, &ctx->num_groups, &ctx->groups_size,
+                      SORT_GET(width, wctx->groups, 2 * i),
+                      SORT_GET(width, wctx->groups, 2 * i + 1)))
+        return 0;
+
+    free_groups(wctx, wctx->groups, wctx->groups_size);
+    wctx->groups = NULL;
+    wctx->num_groups = wctx->groups_size = 0;
+  }
+
+  return 1;
+}
+
+
+/*
+ * par_doubling
+ *
+ * The parallel version of sort_doubling.  Each pass splits the groups
+ * reading ranks from rank and writing them to rank_out, then copies the
+ * new ranks of the groups' suffixes back into rank.
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int par_doubling(SARY_PARALLEL *par, SARY_WORKER *workers,
+                        SARY_SORT *ctx)
+{
+  int i, j, t, lo, n, M, *Pos, *rank, *groups;
+
+  M = (int) ctx->M;
+  Pos = ctx->Pos;
+
+  ctx->rank = malloc((M + 2) * sizeof(int));
+  ctx->rank_out = malloc((M + 2) * sizeof(int));
+  if (ctx->rank == NULL || ctx->rank_out == NULL)
+    return 0;
+  note_memory(ctx, 2 * (M + 2) * (long) sizeof(int));
+
+  rank = ctx->rank;
+  groups = ctx->groups;
+  for (i=1; i <= M; i++)
+    rank[Pos[i]] = i;
+  for (i=0; i < ctx->num_groups; i++) {
+    lo = groups[2*i];
+    n = groups[2*i+1];
+    for (j=lo; j < lo + n; j++)
+      rank[Pos[j]] = lo + n - 1;
+  }
+
+  for (t=0; t < par->nthreads; t++) {
+    workers[t].ctx.rank = ctx->rank;
+    workers[t].ctx.rank_out = ctx->rank_out;
+  }
+
+  for (par->h=SARY_MKQS_DEPTH; ctx->num_groups > 0; par->h*=2) {
+    free_groups(ctx, par->tasks, par->tasks_size);
+    par->tasks = ctx->groups;
+    par->num_tasks = ctx->num_groups;
+    par->tasks_size = ctx->groups_size;
+    ctx->groups = NULL;
+    ctx->num_groups = ctx->groups_size = 0;
+
+    if (!run_workers(par, workers, worker_split) ||
+        !run_workers(par, workers, worker_copyback) ||
+        !collect_groups(par, workers, ctx))
+      return 0;
+  }
+
+  return 1;
+}
+
+
+/*
+ * cmp_tasks
+ *
+ * Order (lo,n) tasks by decreasing size.
+ */
+static int cmp_tasks(const void *a, const void *b)
+{
+  return ((const int *) b)[1] - ((const int *) a)[1];
 }
 
 
@@ -126,13 +1186,39 @@ static int sarycmp(int *a, int *b)
  *
  * Returns:  an initialized SARY_STRUCT structure
  */
+static SARY_STRUCT *zerkle_build(char *S, int M, int copyflag, int nthreads);
+
 SARY_STRUCT *sary_zerkle_build(char *S, int M, int copyflag)
+{
+  return zerkle_build(S, M, copyflag, 1);
+}
+
+
+/*
+ * sary_zerkle_parallel_build
+ *
+ * Build a suffix array using the Zerkle code, with the classes refined
+ * in each pass spread across several threads.
+ *
+ * Parameters:  S         -  the input string
+ *              M         -  the string's length
+ *              nthreads  -  the number of threads to use
+ *
+ * Returns:  an initialized SARY_STRUCT structure
+ */
+SARY_STRUCT *sary_zerkle_parallel_build(char *S, int M, int nthreads)
+{
+  return zerkle_build(S, M, 0, nthreads);
+}
+
+
+static SARY_STRUCT *zerkle_build(char *S, int M, int copyflag, int nthreads)
 {
   int *Pos;
   char *buf;
   SARY_STRUCT *sary;
 
-  if (S == NULL)
+  if (S == NULL || M <= 0)
     return NULL;
 
   S--;            /* Shift to make sequence be S[1],...,S[M] */
@@ -168,7 +1254,10 @@ SARY_STRUCT *sary_zerkle_build(char *S, int M, int copyflag)
   /*
    * Compute the suffix array.
    */
-  zerkle(S + 1, M, Pos);
+  if (!zerkle_parallel(S + 1, M, Pos, nthreads)) {
+    sary_free(sary);
+    return NULL;
+  }
 
   return sary;
 }
@@ -242,7 +1331,7 @@ SARY_STRUCT *sary_stree_build(char *S, int M, int copyflag)
   for (i=0; i < lcp_size; i++)
     lcp[i] = -1;
 
-  if ((leaves = sary->lcp_leaves = malloc(M * sizeof(int))) == NULL) {
+  if ((leaves = sary->lcp_leaves = malloc((M + 1) * sizeof(int))) == NULL) {
     sary_free(sary);
     return NULL;
   }
@@ -287,9 +1376,11 @@ SARY_STRUCT *sary_stree_build(char *S, int M, int copyflag)
    */
   compute_arrays(sary, tree, stree_get_root(tree), 0);
 
-  midpoint = (1 + M) / 2;
-  compute_lcp_values(sary, 1, midpoint, 2);
-  compute_lcp_values(sary, midpoint, M, 3);
+  if (M > 2) {
+    midpoint = (1 + M) / 2;
+    compute_lcp_values(sary, 1, midpoint, 2);
+    compute_lcp_values(sary, midpoint, M, 3);
+  }
 
   stree_delete_tree(tree);
 
@@ -375,6 +1466,124 @@ static int compute_lcp_values(SARY_STRUCT *sary, int min, int max, int index)
 }
 
 
+/*
+ * sary_kasai
+ *
+ * Compute the lcp of each suffix of a suffix array with the one before
+ * it in the array, in linear time using Kasai et al.'s algorithm:  if
+ * the suffix at position i has an lcp of h with its predecessor in the
+ * array, the suffix at i+1 has an lcp of at least h-1 with its own
+ * predecessor, so walking the suffixes in string order never compares
+ * more than 2M characters.
+ *
+ * Parameters:   S     -  the string (S[1],...,S[M])
+ *               M     -  the string length
+ *               Pos   -  the suffix array (Pos[1],...,Pos[M])
+ *               rank  -  where to store the inverse suffix array
+ *                        (M+1 entries, rank[0] is set to 0)
+ *               lcp   -  where to store the lcp values (M+1 entries,
+ *                        lcp[r] for the suffix at Pos[r], and lcp[0]
+ *                        and lcp[1] are 0)
+ *
+ * Returns:  the number of character compares made.
+ */
+int sary_kasai(char *S, int M, int *Pos, int *rank, int *lcp)
+{
+  int i, j, r, h, len, num_compares;
+
+  for (r=1; r <= M; r++)
+    rank[Pos[r]] = r;
+  rank[0] = 0;
+
+  lcp[0] = lcp[1] = 0;
+  num_compares = 0;
+  h = 0;
+  for (i=1; i <= M; i++) {
+    r = rank[i];
+    if (r == 1) {
+      h = 0;
+      continue;
+    }
+
+    j = Pos[r-1];
+    len = sary_cmp_length(&S[i+h], &S[j+h], M - (i > j ? i : j) + 1 - h);
+    h += len;
+    num_compares += len + 1;
+
+    lcp[r] = h;
+    if (h > 0)
+      h--;
+  }
+
+  return num_compares;
+}
+
+
+/*
+ * sary_compute_lcp
+ *
+ * Compute the lcp values of a suffix array built by any of the methods
+ * above, i.e., fill in lcp_leaves (the lcp of each suffix with the one
+ * before it in the array, computed by sary_kasai) and the lcp tree used
+ * by the lcp super-accelerant, without building a suffix tree.
+ *
+ * Parameters:  sary  -  a suffix array
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+int sary_compute_lcp(SARY_STRUCT *sary)
+{
+  int i, M, lcp_size, midpoint, num_compares, *Pos, *rank, *leaves;
+  char *S;
+
+  if (sary == NULL || sary->Pos == NULL)
+    return 0;
+
+  S = sary->S;
+  M = sary->M;
+  Pos = sary->Pos;
+
+  if (sary->lcp != NULL)
+    free(sary->lcp);
+  if (sary->lcp_leaves != NULL)
+    free(sary->lcp_leaves);
+  sary->lcp = sary->lcp_leaves = NULL;
+
+  for (lcp_size=1; lcp_size < M - 1; lcp_size*=2) ;
+  lcp_size = lcp_size * 2 + 1;
+
+  if ((sary->lcp = malloc(lcp_size * sizeof(int))) == NULL)
+    return 0;
+  for (i=0; i < lcp_size; i++)
+    sary->lcp[i] = -1;
+
+  if ((leaves = sary->lcp_leaves = malloc((M + 1) * sizeof(int))) == NULL ||
+      (rank = malloc((M + 1) * sizeof(int))) == NULL) {
+    free(sary->lcp);
+    if (sary->lcp_leaves != NULL)
+      free(sary->lcp_leaves);
+    sary->lcp = sary->lcp_leaves = NULL;
+    return 0;
+  }
+
+  num_compares = sary_kasai(S, M, Pos, rank, leaves);
+#ifdef STATS
+  sary->num_compares += num_compares;
+  sary->num_lcp_ops += M - 1;
+#endif
+
+  free(rank);
+
+  if (M > 2) {
+    midpoint = (1 + M) / 2;
+    compute_lcp_values(sary, 1, midpoint, 2);
+    compute_lcp_values(sary, midpoint, M, 3);
+  }
+
+  return 1;
+}
+
+
 void sary_free(SARY_STRUCT *sary)
 {
   if (sary->lcp_leaves != NULL)
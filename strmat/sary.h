@@ -9,11 +9,20 @@ typedef struct {
   int *Pos, *lcp, *lcp_leaves;
 
   int num_compares, num_tree_ops, num_lcp_ops;
+  long mem_peak;
 } SARY_STRUCT;
 
 SARY_STRUCT *sary_qsort_build(char *S, int M, int copyflag);
 SARY_STRUCT *sary_zerkle_build(char *S, int M, int copyflag);
 SARY_STRUCT *sary_stree_build(char *S, int M, int copyflag);
+SARY_STRUCT *sary_parallel_build(char *S, int M, int nthreads);
+SARY_STRUCT *sary_zerkle_parallel_build(char *S, int M, int nthreads);
+int sary_sort_entries(char *S, long M, void *Pos, int width,
+                      long *num_compares, long *mem_peak);
+long sary_entry_get(void *a, int width, long i);
+void sary_entry_set(void *a, int width, long i, long value);
+int sary_kasai(char *S, int M, int *Pos, int *rank, int *lcp);
+int sary_compute_lcp(SARY_STRUCT *sary);
 void sary_free(SARY_STRUCT *sary);
 
 #endif
@@ -0,0 +1,218 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sary_cmp.h"
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CMP_HAVE_WORD
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CMP_HAVE_X86
+#include <immintrin.h>
+#endif
+
+
+/*
+ * The comparison kernels
+ *
+ * Each kernel returns the length of the longest common prefix of
+ * a[0..n-1] and b[0..n-1], i.e., the number of characters a character
+ * by character loop would find equal before its first mismatch.  The
+ * suffix array code counts that as length + 1 character compares, so
+ * the STATS counts are the same whichever kernel is used.
+ *
+ * The word kernel compares 8 bytes at a time, finding the first
+ * mismatch from the trailing zeros of the XOR of the two words (on a
+ * little-endian machine, the lowest differing byte is the first one).
+ * The SSE2 and AVX2 kernels compare 16 and 32 bytes at a time, finding
+ * it from the trailing ones of the byte equality mask.  All of them
+ * finish off the last few characters one at a time.
+ */
+static int cmp_byte(char *a, char *b, int n)
+{
+  int k;
+
+  for (k=0; k < n && a[k] == b[k]; k++) ;
+  return k;
+}
+
+#ifdef CMP_HAVE_WORD
+static int cmp_word(char *a, char *b, int n)
+{
+  int k;
+  unsigned long long x, y;
+
+  for (k=0; k + 8 <= n; k+=8) {
+    memcpy(&x, a + k, 8);
+    memcpy(&y, b + k, 8);
+    if (x != y)
+      return k + (__builtin_ctzll(x ^ y) >> 3);
+  }
+  for ( ; k < n && a[k] == b[k]; k++) ;
+  return k;
+}
+#endif
+
+#ifdef CMP_HAVE_X86
+__attribute__((target("sse2")))
+static int cmp_sse2(char *a, char *b, int n)
+{
+  int k;
+  unsigned int mask;
+  __m128i x, y;
+
+  for (k=0; k + 16 <= n; k+=16) {
+    x = _mm_loadu_si128((__m128i *) (a + k));
+    y = _mm_loadu_si128((__m128i *) (b + k));
+    mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (mask != 0xffff)
+      return k + __builtin_ctz(~mask);
+  }
+  for ( ; k < n && a[k] == b[k]; k++) ;
+  return k;
+}
+
+__attribute__((target("avx2")))
+static int cmp_avx2(char *a, char *b, int n)
+{
+  int k;
+  unsigned int mask;
+  __m256i x, y;
+
+  for (k=0; k + 32 <= n; k+=32) {
+    x = _mm256_loadu_si256((__m256i *) (a + k));
+    y = _mm256_loadu_si256((__m256i *) (b + k));
+    mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+    if (mask != 0xffffffffU)
+      return k + __builtin_ctz(~mask);
+  }
+  for ( ; k < n && a[k] == b[k]; k++) ;
+  return k;
+}
+#endif
+
+
+/*
+ * The kernel in use, picked the first time one is needed (the widest
+ * one the processor supports) unless sary_cmp_select has set it.
+ */
+static int (*cmp_kernel)(char *, char *, int) = NULL;
+static SARY_CMP_KERNEL cmp_current = SARY_CMP_AUTO;
+static pthread_once_t cmp_once = PTHREAD_ONCE_INIT;
+
+static void cmp_init(void)
+{
+  if (cmp_kernel == NULL)
+    sary_cmp_select(SARY_CMP_AUTO);
+}
+
+
+/*
+ * sary_cmp_length
+ *
+ * Compute the length of the longest common prefix of two strings,
+ * looking at no more than n characters.
+ *
+ * Parameters:  a, b  -  the two strings
+ *              n     -  the maximum number of characters to compare
+ *
+ * Returns:  the number of leading characters the two strings share.
+ */
+int sary_cmp_length(char *a, char *b, int n)
+{
+  if (n <= 0)
+    return 0;
+
+  pthread_once(&cmp_once, cmp_init);
+  return (*cmp_kernel)(a, b, n);
+}
+
+
+/*
+ * sary_cmp_select
+ *
+ * Choose the comparison kernel (for benchmarking them against each
+ * other).  SARY_CMP_AUTO picks the widest kernel the processor
+ * supports.  This must not be called while other threads are using
+ * the kernels.
+ *
+ * Parameters:  kernel  -  the kernel to use
+ *
+ * Returns:  non-zero if the kernel is available, zero otherwise (and
+ *           the current kernel is left in place).
+ */
+int sary_cmp_select(SARY_CMP_KERNEL kernel)
+{
+  if (kernel == SARY_CMP_AUTO) {
+#ifdef CMP_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      kernel = SARY_CMP_AVX2;
+    else if (__builtin_cpu_supports("sse2"))
+      kernel = SARY_CMP_SSE2;
+    else
+      kernel = SARY_CMP_WORD;
+#elif defined(CMP_HAVE_WORD)
+    kernel = SARY_CMP_WORD;
+#else
+    kernel = SARY_CMP_BYTE;
+#endif
+  }
+
+  switch (kernel) {
+  case SARY_CMP_BYTE:
+    cmp_kernel = cmp_byte;
+    break;
+
+#ifdef CMP_HAVE_WORD
+  case SARY_CMP_WORD:
+    cmp_kernel = cmp_word;
+    break;
+#endif
+
+#ifdef CMP_HAVE_X86
+  case SARY_CMP_SSE2:
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse2"))
+      return 0;
+    cmp_kernel = cmp_sse2;
+    break;
+
+  case SARY_CMP_AVX2:
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2"))
+      return 0;
+    cmp_kernel = cmp_avx2;
+    break;
+#endif
+
+  default:
+    return 0;
+  }
+
+  cmp_current = kernel;
+  return 1;
+}
+
+
+/*
+ * sary_cmp_name
+ *
+ * The name of the comparison kernel in use.
+ */
+char *sary_cmp_name(void)
+{
+  pthread_once(&cmp_once, cmp_init);
+
+  switch (cmp_current) {
+  case SARY_CMP_BYTE:  return "byte";
+  case SARY_CMP_WORD:  return "64-bit word";
+  case SARY_CMP_SSE2:  return "SSE2";
+  case SARY_CMP_AVX2:  return "AVX2";
+  default:             return "none";
+  }
+}
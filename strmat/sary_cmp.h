@@ -0,0 +1,12 @@
+
+#ifndef _SARY_CMP_H_
+#define _SARY_CMP_H_
+
+typedef enum { SARY_CMP_AUTO, SARY_CMP_BYTE, SARY_CMP_WORD,
+               SARY_CMP_SSE2, SARY_CMP_AVX2 } SARY_CMP_KERNEL;
+
+int sary_cmp_length(char *a, char *b, int n);
+int sary_cmp_select(SARY_CMP_KERNEL kernel);
+char *sary_cmp_name(void);
+
+#endif
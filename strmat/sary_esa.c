@@ -0,0 +1,596 @@
+/*
+ * sary_esa.c
+ *
+ * The enhanced suffix array of Abouelhoda, Kurtz and Ohlebusch
+ * ("Replacing suffix trees with enhanced suffix arrays", 2004):  the
+ * suffix array, its lcp values and the child table, which together
+ * support the bottom-up and top-down traversals of the suffix tree
+ * (with lcp-intervals standing in for the tree nodes) at about 9 bytes
+ * per character, against the 20-40 bytes per character of SUFFIX_TREE.
+ *
+ * The lcp values are stored one byte each, with the (rare) values of
+ * 255 or more kept in a sorted exception table.  The child table holds
+ * the up, down and next l-index values of the paper in a single integer
+ * per row, told apart by the lcp values as described there.
+ *
+ * Row r of the suffix array has lcp value lcp(Pos[r-1], Pos[r]), with
+ * rows 1 and M+1 taken to be -1 when building the child table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sary.h"
+#include "sary_esa.h"
+#include "sary_cmp.h"
+
+
+#define ESA_BIG_LCP 255
+
+static int esa_compute_lcp(SARY_ESA *esa);
+static int esa_compute_child(SARY_ESA *esa);
+static int esa_lv(SARY_ESA *esa, int row);
+static int esa_lindex(SARY_ESA *esa, int lb, int rb);
+static void esa_set_lcp(SARY_ESA *esa, ESA_INTERVAL *node);
+static int esa_push(int **stack, int *num, int *size, int value);
+
+
+/*
+ * sary_esa_build
+ *
+ * Build the enhanced suffix array of a string.
+ *
+ * Parameters:  S         -  the input string
+ *              M         -  the string's length
+ *              copyflag  -  whether to copy the input string
+ *
+ * Returns:  an initialized SARY_ESA structure, or NULL on an error.
+ */
+SARY_ESA *sary_esa_build(char *S, int M, int copyflag)
+{
+  SARY_ESA *esa;
+
+  if (S == NULL || M <= 0)
+    return NULL;
+
+  if ((esa = malloc(sizeof(SARY_ESA))) == NULL)
+    return NULL;
+  memset(esa, 0, sizeof(SARY_ESA));
+
+  if ((esa->sary = sary_qsort_build(S, M, copyflag)) == NULL) {
+    free(esa);
+    return NULL;
+  }
+
+  esa->S = esa->sary->S;
+  esa->M = M;
+  esa->Pos = esa->sary->Pos;
+#ifdef STATS
+  esa->num_compares = esa->sary->num_compares;
+#endif
+
+  if ((esa->lcp = malloc(M + 2)) == NULL ||
+      (esa->child = malloc((M + 2) * sizeof(int))) == NULL ||
+      !esa_compute_lcp(esa) || !esa_compute_child(esa)) {
+    sary_esa_free(esa);
+    return NULL;
+  }
+
+  esa->mem_bytes = (M + 1) * sizeof(int) + (M + 2) +
+                   esa->num_big * 2 * sizeof(int) + (M + 2) * sizeof(int);
+
+  return esa;
+}
+
+
+/*
+ * esa_compute_lcp
+ *
+ * Compute the lcp values in linear time (with sary_kasai, using the
+ * child table's space for the inverse suffix array), and store them
+ * a byte each, with the values of ESA_BIG_LCP or more kept aside in
+ * row order.
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int esa_compute_lcp(SARY_ESA *esa)
+{
+  int r, h, M, size, *lcp, *big, num_compares;
+
+  M = esa->M;
+
+  if ((lcp = malloc((M + 1) * sizeof(int))) == NULL)
+    return 0;
+
+  num_compares = sary_kasai(esa->S, M, esa->Pos, esa->child, lcp);
+#ifdef STATS
+  esa->num_compares += num_compares;
+#endif
+
+  esa->lcp[0] = esa->lcp[1] = esa->lcp[M+1] = 0;
+  size = 0;
+  for (r=2; r <= M; r++) {
+    h = lcp[r];
+    if (h < ESA_BIG_LCP)
+      esa->lcp[r] = h;
+    else {
+      esa->lcp[r] = ESA_BIG_LCP;
+      if (esa->num_big == size) {
+        size = (size == 0 ? 64 : size * 2);
+        if ((big = realloc(esa->lcp_big, size * 2 * sizeof(int))) == NULL) {
+          free(lcp);
+          return 0;
+        }
+        esa->lcp_big = big;
+      }
+      esa->lcp_big[2*esa->num_big] = r;
+      esa->lcp_big[2*esa->num_big+1] = h;
+      esa->num_big++;
+    }
+  }
+
+  free(lcp);
+
+  return 1;
+}
+
+
+/*
+ * sary_esa_lcp
+ *
+ * Returns:  the lcp of the suffixes at rows row-1 and row (2..M).
+ */
+int sary_esa_lcp(SARY_ESA *esa, int row)
+{
+  int lo, hi, mid;
+
+  if (esa->lcp[row] < ESA_BIG_LCP)
+    return esa->lcp[row];
+
+  lo = 0;
+  hi = esa->num_big - 1;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (esa->lcp_big[2*mid] < row)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return esa->lcp_big[2*lo+1];
+}
+
+
+/*
+ * esa_lv
+ *
+ * The lcp value of a row, with the rows 1 and M+1 set to -1.
+ */
+static int esa_lv(SARY_ESA *esa, int row)
+{
+  if (row <= 1 || row > esa->M)
+    return -1;
+
+  return sary_esa_lcp(esa, row);
+}
+
+
+/*
+ * esa_compute_child
+ *
+ * Compute the child table.  Up(i) is stored at child[i-1], and down(i)
+ * or the next l-index of i (which is kept if both exist) at child[i].
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int esa_compute_child(SARY_ESA *esa)
+{
+  int i, l, t, M, last, *child, *stack, num, size;
+
+  M = esa->M;
+  child = esa->child;
+  memset(child, 0, (M + 2) * sizeof(int));
+
+  stack = NULL;
+  num = size = 0;
+
+  /*
+   * The up and down values.
+   */
+  if (!esa_push(&stack, &num, &size, 1))
+    return 0;
+
+  last = 0;
+  for (i=2; i <= M + 1; i++) {
+    l = esa_lv(esa, i);
+    while (l < esa_lv(esa, stack[num-1])) {
+      last = stack[--num];
+      t = stack[num-1];
+      if (l <= esa_lv(esa, t) && esa_lv(esa, t) != esa_lv(esa, last))
+        child[t] = last;
+    }
+    if (last != 0) {
+      child[i-1] = last;
+      last = 0;
+    }
+    if (!esa_push(&stack, &num, &size, i)) {
+      free(stack);
+      return 0;
+    }
+  }
+
+  /*
+   * The next l-index values.
+   */
+  num = 0;
+  esa_push(&stack, &num, &size, 1);
+  for (i=2; i <= M; i++) {
+    l = esa_lv(esa, i);
+    while (l < esa_lv(esa, stack[num-1]))
+      num--;
+    if (l == esa_lv(esa, stack[num-1]))
+      child[stack[--num]] = i;
+    esa_push(&stack, &num, &size, i);
+  }
+
+  free(stack);
+
+  return 1;
+}
+
+
+/*
+ * esa_push
+ *
+ * Push a value onto a growable stack of integers.
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int esa_push(int **stack, int *num, int *size, int value)
+{
+  int *newstack;
+
+  if (*num == *size) {
+    *size = (*size == 0 ? 64 : *size * 2);
+    if ((newstack = realloc(*stack, *size * sizeof(int))) == NULL)
+      return 0;
+    *stack = newstack;
+  }
+
+  (*stack)[(*num)++] = value;
+
+  return 1;
+}
+
+
+/*
+ * esa_lindex
+ *
+ * The first l-index of the interval lb..rb (lb < rb), i.e., the row
+ * where its first child interval ends and its second one begins.
+ */
+static int esa_lindex(SARY_ESA *esa, int lb, int rb)
+{
+  int up;
+
+  up = esa->child[rb];
+  if (lb < up && up <= rb)
+    return up;
+  else
+    return esa->child[lb];
+}
+
+
+/*
+ * esa_set_lcp
+ *
+ * Fill in the lcp value of an interval (or the suffix length of a
+ * singleton interval).
+ */
+static void esa_set_lcp(SARY_ESA *esa, ESA_INTERVAL *node)
+{
+  if (node->lb == node->rb)
+    node->lcp = esa->M - esa->Pos[node->lb] + 1;
+  else
+    node->lcp = esa_lv(esa, esa_lindex(esa, node->lb, node->rb));
+}
+
+
+/*
+ * sary_esa_root
+ *
+ * The root interval 0-[1..M].  (If all of the suffixes begin with the
+ * same character, the root has a single child, as in the suffix tree.)
+ *
+ * Parameters:  esa   -  an enhanced suffix array
+ *              root  -  where to put the root interval
+ *
+ * Returns:  nothing.
+ */
+void sary_esa_root(SARY_ESA *esa, ESA_INTERVAL *root)
+{
+  root->lcp = 0;
+  root->lb = 1;
+  root->rb = esa->M;
+  root->next = 0;
+}
+
+
+/*
+ * sary_esa_first_child, sary_esa_next_child
+ *
+ * Iterate over the child intervals of an interval, in suffix array
+ * order (as stree_get_children and stree_get_next do over a node's
+ * children in a SORTED_LIST tree).
+ *
+ * Parameters:  esa    -  an enhanced suffix array
+ *              node   -  an interval
+ *              child  -  the child interval (the previous child, for
+ *                        sary_esa_next_child)
+ *
+ * Returns:  non-zero if there is a first/next child, zero otherwise.
+ */
+int sary_esa_first_child(SARY_ESA *esa, ESA_INTERVAL *node,
+                         ESA_INTERVAL *child)
+{
+  int i1;
+
+  /*
+   * The root has the whole array as its only child when all of the
+   * suffixes begin with the same character (or M is 1).
+   */
+  *child = *node;
+  esa_set_lcp(esa, child);
+  if (node->lcp < child->lcp) {
+    child->next = node->rb + 1;
+    return 1;
+  }
+
+  if (node->lb == node->rb)
+    return 0;
+
+  i1 = esa_lindex(esa, node->lb, node->rb);
+  child->lb = node->lb;
+  child->rb = i1 - 1;
+  child->next = i1;
+  esa_set_lcp(esa, child);
+
+  return 1;
+}
+
+int sary_esa_next_child(SARY_ESA *esa, ESA_INTERVAL *node,
+                        ESA_INTERVAL *child)
+{
+  int i1, i2;
+
+  i1 = child->next;
+  if (i1 > node->rb)
+    return 0;
+
+  i2 = esa->child[i1];
+  child->lb = i1;
+  if (i1 < i2 && i2 <= node->rb && esa_lv(esa, i2) == esa_lv(esa, i1)) {
+    child->rb = i2 - 1;
+    child->next = i2;
+  }
+  else {
+    child->rb = node->rb;
+    child->next = node->rb + 1;
+  }
+  esa_set_lcp(esa, child);
+
+  return 1;
+}
+
+
+/*
+ * sary_esa_find_child
+ *
+ * Find the child interval whose suffixes continue with a given
+ * character (as stree_find_child does for a suffix tree node).
+ *
+ * Parameters:  esa    -  an enhanced suffix array
+ *              node   -  an interval
+ *              ch     -  the character
+ *              child  -  where to put the child interval
+ *
+ * Returns:  non-zero if the child exists, zero otherwise.
+ */
+int sary_esa_find_child(SARY_ESA *esa, ESA_INTERVAL *node, char ch,
+                        ESA_INTERVAL *child)
+{
+  int pos, flag;
+
+  for (flag=sary_esa_first_child(esa, node, child); flag;
+       flag=sary_esa_next_child(esa, node, child)) {
+    pos = esa->Pos[child->lb] + node->lcp;
+    if (pos > esa->M)
+      continue;
+
+#ifdef STATS
+    esa->num_compares++;
+#endif
+    if (esa->S[pos] == ch)
+      return 1;
+    else if (esa->S[pos] > ch)
+      return 0;
+  }
+
+  return 0;
+}
+
+
+/*
+ * sary_esa_match
+ *
+ * Top-down search for the interval of the suffixes beginning with
+ * a pattern.
+ *
+ * Parameters:  esa   -  an enhanced suffix array
+ *              P     -  the pattern
+ *              N     -  the pattern length
+ *              node  -  where to put the interval of the matches
+ *
+ * Returns:  the number of occurrences of the pattern (the rows
+ *           node->lb..node->rb of the suffix array hold the positions).
+ */
+int sary_esa_match(SARY_ESA *esa, char *P, int N, ESA_INTERVAL *node)
+{
+  int len, depth, end;
+  ESA_INTERVAL child;
+
+  sary_esa_root(esa, node);
+  if (N <= 0)
+    return esa->M;
+
+  depth = 0;
+  while (1) {
+    end = (node->lcp < N ? node->lcp : N);
+    len = sary_cmp_length(&esa->S[esa->Pos[node->lb]+depth], &P[depth],
+                          end - depth);
+#ifdef STATS
+    esa->num_compares += (len < end - depth ? len + 1 : len);
+#endif
+    if (len < end - depth)
+      return 0;
+
+    if (end == N)
+      return node->rb - node->lb + 1;
+
+    depth = node->lcp;
+    if (!sary_esa_find_child(esa, node, P[depth], &child))
+      return 0;
+
+    *node = child;
+    depth++;
+  }
+}
+
+
+/*
+ * sary_esa_bottom_up
+ *
+ * Bottom-up traversal of the lcp-intervals (the post-order traversal
+ * of the suffix tree), using a stack of the open intervals.
+ *
+ * Parameters:  esa      -  an enhanced suffix array
+ *              visitor  -  the functions to call
+ *              data     -  passed through to the functions
+ *
+ * Returns:  non-zero if the traversal completed, zero if it was stopped
+ *           or memory ran out.
+ */
+#define ESA_CALL(fn,args) (visitor->fn == NULL || (*visitor->fn) args)
+
+int sary_esa_bottom_up(SARY_ESA *esa, ESA_VISITOR *visitor, void *data)
+{
+  int r, h, M, num, size, haslast, status;
+  ESA_INTERVAL *stack, *newstack, last;
+
+  M = esa->M;
+  size = 64;
+  if ((stack = malloc(size * sizeof(ESA_INTERVAL))) == NULL)
+    return 0;
+
+  num = 0;
+  stack[num].lcp = 0;
+  stack[num].lb = 1;
+  stack[num].rb = -1;
+  stack[num++].next = 0;
+
+  status = ESA_CALL(open, (esa, &stack[0], data));
+  for (r=1; status && r <= M; r++) {
+    /*
+     * Make sure that there is room for a new interval.
+     */
+    if (num == size) {
+      size *= 2;
+      if ((newstack = realloc(stack, size * sizeof(ESA_INTERVAL))) == NULL) {
+        status = 0;
+        break;
+      }
+      stack = newstack;
+    }
+
+    /*
+     * Open the interval of rows r and r+1, if it is deeper than the
+     * current one, and add the suffix at row r to the deepest open
+     * interval.
+     */
+    h = (r < M ? sary_esa_lcp(esa, r + 1) : 0);
+    if (h > stack[num-1].lcp) {
+      stack[num].lcp = h;
+      stack[num].lb = r;
+      stack[num].rb = -1;
+      stack[num++].next = 0;
+      if (!ESA_CALL(open, (esa, &stack[num-1], data)))
+        break;
+    }
+
+    if (!ESA_CALL(leaf, (esa, &stack[num-1], r, data)))
+      break;
+
+    /*
+     * Close the intervals ending at row r.
+     */
+    haslast = 0;
+    while (status && h < stack[num-1].lcp) {
+      stack[num-1].rb = r;
+      last = stack[--num];
+      haslast = 1;
+      status = ESA_CALL(close, (esa, &last, data));
+
+      if (status && h <= stack[num-1].lcp) {
+        status = ESA_CALL(child, (esa, &stack[num-1], &last, data));
+        haslast = 0;
+      }
+    }
+
+    if (status && haslast) {
+      stack[num].lcp = h;
+      stack[num].lb = last.lb;
+      stack[num].rb = -1;
+      stack[num++].next = 0;
+      status = (ESA_CALL(open, (esa, &stack[num-1], data)) &&
+                ESA_CALL(child, (esa, &stack[num-1], &last, data)));
+    }
+  }
+
+  if (r <= M)
+    status = 0;
+  if (status) {
+    stack[0].rb = M;
+    status = ESA_CALL(close, (esa, &stack[0], data));
+  }
+
+  free(stack);
+
+  return status;
+}
+
+
+/*
+ * sary_esa_free
+ *
+ * Free up a SARY_ESA structure.
+ *
+ * Parameters:  esa  -  a SARY_ESA structure
+ *
+ * Returns:  nothing.
+ */
+void sary_esa_free(SARY_ESA *esa)
+{
+  if (esa == NULL)
+    return;
+
+  if (esa->sary != NULL)
+    sary_free(esa->sary);
+  if (esa->lcp != NULL)
+    free(esa->lcp);
+  if (esa->lcp_big != NULL)
+    free(esa->lcp_big);
+  if (esa->child != NULL)
+    free(esa->child);
+
+  free(esa);
+}
@@ -0,0 +1,63 @@
+
+#ifndef _SARY_ESA_H_
+#define _SARY_ESA_H_
+
+#include "sary.h"
+
+typedef struct {
+  SARY_STRUCT *sary;
+
+  char *S;
+  int M, *Pos;
+
+  unsigned char *lcp;
+  int *lcp_big, num_big;
+
+  int *child;
+
+  long mem_bytes;
+  int num_compares;
+} SARY_ESA;
+
+/*
+ * An lcp-interval lcp-[lb..rb] (rows of the suffix array), playing the
+ * part of a suffix tree node.  Singleton intervals (lb == rb) are the
+ * leaves, with lcp set to the suffix length.  `next' is used while
+ * iterating over the children of an interval.
+ */
+typedef struct {
+  int lcp, lb, rb, next;
+} ESA_INTERVAL;
+
+/*
+ * The functions called by the bottom-up traversal.  open and close are
+ * called for each interval in the order of a depth-first traversal,
+ * leaf for each singleton child of an interval and child for each
+ * child interval (just after the child's close).  A zero return stops
+ * the traversal.  Any function may be NULL.
+ */
+typedef struct {
+  int (*open)(SARY_ESA *esa, ESA_INTERVAL *node, void *data);
+  int (*leaf)(SARY_ESA *esa, ESA_INTERVAL *node, int row, void *data);
+  int (*child)(SARY_ESA *esa, ESA_INTERVAL *node, ESA_INTERVAL *child,
+               void *data);
+  int (*close)(SARY_ESA *esa, ESA_INTERVAL *node, void *data);
+} ESA_VISITOR;
+
+SARY_ESA *sary_esa_build(char *S, int M, int copyflag);
+int sary_esa_lcp(SARY_ESA *esa, int row);
+
+void sary_esa_root(SARY_ESA *esa, ESA_INTERVAL *root);
+int sary_esa_first_child(SARY_ESA *esa, ESA_INTERVAL *node,
+                         ESA_INTERVAL *child);
+int sary_esa_next_child(SARY_ESA *esa, ESA_INTERVAL *node,
+                        ESA_INTERVAL *child);
+int sary_esa_find_child(SARY_ESA *esa, ESA_INTERVAL *node, char ch,
+                        ESA_INTERVAL *child);
+int sary_esa_match(SARY_ESA *esa, char *P, int N, ESA_INTERVAL *node);
+
+int sary_esa_bottom_up(SARY_ESA *esa, ESA_VISITOR *visitor, void *data);
+
+void sary_esa_free(SARY_ESA *esa);
+
+#endif
@@ -0,0 +1,1488 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "sary.h"
+#include "sary_pack.h"
+#include "sary_ext.h"
+#include "sary_file.h"
+#include "sary_cmp.h"
+
+#ifndef P_tmpdir
+#define P_tmpdir "/tmp"
+#endif
+
+
+/*
+ * sary_ext_build
+ *
+ * Build a suffix array index file for a text that is too large for the
+ * in-memory builders (which need 5 or more bytes per character), using
+ * at most mem_budget bytes of working memory and temporary files for
+ * everything else.  The result is the index file written by
+ * sary_packed_save, with the narrowest entries that hold the text's
+ * positions (see sary_packed_width), so it can be searched with
+ * sary_packed_open.  With 32 bit entries the file also holds the lcp
+ * values, as written by sary_match_save, and can be searched with
+ * sary_match_open as well.  The values in the temporary files have the
+ * same width as the entries.
+ *
+ * The suffix array is computed by prefix doubling, as in the tied
+ * groups of sary_qsort_build, but with every step either a sequential
+ * scan or an external merge sort:
+ *
+ *    1.  The name of each suffix starts as its first k characters, as
+ *        many as an entry holds (3 with 32 bit entries), so the first
+ *        round already sorts on 2k characters.
+ *    2.  Each round pairs the name of suffix i with the name of suffix
+ *        i+h (two scans of the names file, h entries apart), sorts the
+ *        pairs and names each suffix by the rank of the first pair equal
+ *        to its own.  Once all of the names differ, the sorted order is
+ *        the suffix array.
+ *    3.  Otherwise the new names are sorted back into text order, h is
+ *        doubled and the next round starts.
+ *
+ * The lcp values are computed with the Phi form of Kasai et al.'s
+ * algorithm, without reading the text out of order.  The pairs
+ * (Pos[r], Pos[r-1]) are sorted into text order, where lcp(i) is
+ * lcp(i-1) - 1 whenever Phi[i] = Phi[i-1] + 1 and lcp(i-1) > 0 (which
+ * the character counts tell).  Only the remaining, irreducible, values
+ * are computed from the text, and they add up to O(M log M) (Karkkainen,
+ * Manzini and Puglisi).  Their pairs are sorted by the block of the
+ * text holding Phi[i] and then by i, so that each block is read once
+ * and the text at i by a scan moving forward through the text.  The
+ * lcps are then sorted back into suffix array order, and the lcp tree
+ * is filled in by one in-order pass over them, which meets the nodes
+ * at each depth of the tree in the order they are stored.
+ *
+ * The external sort spills runs from a buffer of a quarter of the
+ * budget into one temporary file per sort, and merges them with a
+ * fan-in limited only by the memory for the merge buffers (another
+ * quarter of the budget, in blocks of at least EXT_MIN_BLOCK bytes), so
+ * that most sorts need no more than their final merge.  The temporary
+ * files are unlinked as soon as they are created, so nothing is left
+ * behind if the build fails.
+ *
+ * Parameters:  text_path   -  the file holding the text
+ *              index_path  -  the index file to write
+ *              tmp_dir     -  the directory for the temporary files
+ *                             (NULL for the system's default)
+ *              mem_budget  -  the working memory budget, in bytes
+ *              stats       -  where to store the statistics (or NULL)
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+#define EXT_MIN_BLOCK 1024
+#define EXT_MAX_FANIN 4096
+#define EXT_MAX_BUFFER (1 << 30)
+
+enum { PHI_ZERO, PHI_REDUCIBLE, PHI_IRREDUCIBLE };
+
+typedef struct {
+  long key, key2, value;
+} EXT_REC;
+
+typedef struct {
+  FILE *fp;
+  void *buf;
+  int width, size, num, next;
+  long pos, left;
+} EXT_STREAM;
+
+typedef struct {
+  long pos, num;
+} EXT_RUN;
+
+typedef struct {
+  int num_fields;
+  EXT_REC *recs;
+  int num_recs, next;
+
+  FILE *fp;
+  long end;
+  EXT_RUN *runs;
+  int num_runs, max_runs;
+
+  EXT_STREAM *in;
+  EXT_REC *cur;
+  int *heap, num_in, num_merged, heap_size;
+} EXT_SORT;
+
+typedef struct {
+  char *buf;
+  long start, end;
+  int size;
+} EXT_WINDOW;
+
+typedef struct {
+  char *dir;
+  long budget, mem_current;
+  int width, name_chars, rec_max, block_bytes, merge_bytes, text_block;
+  int fanin, error;
+
+  FILE *text;
+  long M, counts[257];
+
+  FILE *out;
+  long out_pos;
+  SARY_FILE_HEADER header;
+
+  EXT_SORT *leaves;
+  EXT_STREAM *out_ints, *levels;
+  long *level_next;
+
+  SARY_EXT_STATS *stats;
+} EXT_BUILD;
+
+static FILE *ext_names(EXT_BUILD *b);
+static FILE *ext_doubling(EXT_BUILD *b, FILE *names);
+static void ext_positions(EXT_BUILD *b, FILE *sa);
+static void ext_lcp(EXT_BUILD *b, FILE *sa);
+static FILE *lcp_phi(EXT_BUILD *b, FILE *sa, EXT_SORT *pairs);
+static void lcp_irreducible(EXT_BUILD *b, EXT_SORT *pairs, EXT_SORT *lcps);
+static void lcp_values(EXT_BUILD *b, FILE *phi, EXT_SORT *lcps,
+                       EXT_SORT *leaves);
+static void lcp_tree(EXT_BUILD *b, EXT_SORT *leaves);
+static long tree_values(EXT_BUILD *b, long min, long max, long index);
+static void tree_put(EXT_BUILD *b, long index, long value);
+static int next_leaf(EXT_BUILD *b, long *value);
+
+static long pair_lcp(EXT_BUILD *b, EXT_WINDOW *win, long i, long j);
+static EXT_WINDOW *window_find(EXT_BUILD *b, EXT_WINDOW *w, EXT_WINDOW *more,
+                               long pos);
+static int window_load(EXT_BUILD *b, EXT_WINDOW *w, long pos);
+
+static void out_start(EXT_BUILD *b, int sec);
+static void out_write(EXT_BUILD *b, void *data, long size);
+static int out_open(EXT_BUILD *b, EXT_STREAM *st, int width);
+static void out_close(EXT_BUILD *b, EXT_STREAM *st, int sec);
+
+static void sort_init(EXT_BUILD *b, EXT_SORT *s, int num_fields);
+static int sort_add(EXT_BUILD *b, EXT_SORT *s, long key, long key2,
+                    long value);
+static int sort_finish(EXT_BUILD *b, EXT_SORT *s);
+static int sort_next(EXT_BUILD *b, EXT_SORT *s, EXT_REC *rec);
+static void sort_free(EXT_BUILD *b, EXT_SORT *s);
+static int sort_spill(EXT_BUILD *b, EXT_SORT *s);
+static int sort_merge_runs(EXT_BUILD *b, EXT_SORT *s, int k);
+static int merge_start(EXT_BUILD *b, EXT_SORT *s, int k);
+static int merge_next(EXT_BUILD *b, EXT_SORT *s, EXT_REC *rec);
+static void merge_end(EXT_BUILD *b, EXT_SORT *s);
+static void merge_down(EXT_SORT *s, int i);
+static int rec_get(EXT_BUILD *b, EXT_SORT *s, EXT_STREAM *st, EXT_REC *rec);
+static int rec_put(EXT_BUILD *b, EXT_SORT *s, EXT_STREAM *st, EXT_REC *rec);
+static int cmp_recs(const void *a, const void *b);
+
+static int stream_open(EXT_BUILD *b, EXT_STREAM *st, FILE *fp, int width,
+                       long pos, long left, int bytes);
+static int stream_get(EXT_BUILD *b, EXT_STREAM *st, long *value);
+static int stream_put(EXT_BUILD *b, EXT_STREAM *st, long value);
+static int stream_flush(EXT_BUILD *b, EXT_STREAM *st);
+static void stream_close(EXT_BUILD *b, EXT_STREAM *st);
+
+static FILE *ext_tmpfile(EXT_BUILD *b);
+static int ext_buffer(long bytes);
+static void *ext_alloc(EXT_BUILD *b, long bytes);
+static void ext_free(EXT_BUILD *b, void *p, long bytes);
+
+#define REC_LESS(a,b) \
+  ((a)->key < (b)->key || ((a)->key == (b)->key && (a)->key2 < (b)->key2))
+
+int sary_ext_build(char *text_path, char *index_path, char *tmp_dir,
+                   long mem_budget, SARY_EXT_STATS *stats)
+{
+  long M, fanin;
+  FILE *text, *names, *sa;
+  struct stat st;
+  EXT_BUILD b;
+  SARY_EXT_STATS local;
+
+  if (text_path == NULL || index_path == NULL ||
+      mem_budget < SARY_EXT_MIN_BUDGET)
+    return 0;
+
+  if (stats == NULL)
+    stats = &local;
+  memset(stats, 0, sizeof(SARY_EXT_STATS));
+  stats->mem_budget = mem_budget;
+
+  if ((text = fopen(text_path, "rb")) == NULL)
+    return 0;
+
+  if (fstat(fileno(text), &st) == -1 || st.st_size < 1) {
+    fclose(text);
+    return 0;
+  }
+  M = (long) st.st_size;
+  setvbuf(text, NULL, _IONBF, 0);
+
+  /*
+   * Set up the build.  At most two sorts are active at once (one
+   * being read while the next is filled), so the budget is split
+   * between their run buffers (1/4 each), the merge buffers (1/4) and
+   * the stream buffers and text windows (1/32 each, at most three at
+   * once).  The irreducible lcp values also need a block of the text,
+   * which takes the last quarter.
+   */
+  memset(&b, 0, sizeof(EXT_BUILD));
+  b.dir = (tmp_dir != NULL && tmp_dir[0] != '\0' ? tmp_dir : P_tmpdir);
+  b.budget = mem_budget;
+  b.stats = stats;
+  b.text = text;
+  b.M = M;
+  b.width = sary_packed_width(M);
+
+  b.rec_max = ext_buffer(mem_budget / 4 / sizeof(EXT_REC));
+  b.block_bytes = ext_buffer(mem_budget / 32);
+  b.text_block = ext_buffer(mem_budget / 4);
+
+  fanin = mem_budget / 4 / EXT_MIN_BLOCK - 1;
+  b.fanin = (int) (fanin < EXT_MAX_FANIN ? fanin : EXT_MAX_FANIN);
+  b.merge_bytes = ext_buffer(mem_budget / 4 / (b.fanin + 1));
+
+  memcpy(b.header.magic, SARY_FILE_MAGIC, 8);
+  b.header.version = SARY_FILE_VERSION;
+  b.header.byte_order = SARY_FILE_BYTE_ORDER;
+  b.header.int_size = sizeof(int);
+  b.header.long_size = sizeof(long);
+  b.header.width = b.width;
+  b.header.M = M;
+  b.header.lcp_size = (b.width == 32 ? sary_file_lcp_size(M) : 0);
+
+  if ((b.out = fopen(index_path, "wb")) == NULL) {
+    fclose(text);
+    return 0;
+  }
+
+  /*
+   * Write a placeholder header, then the sections in order, then the
+   * real header.
+   */
+  out_write(&b, &b.header, sizeof(SARY_FILE_HEADER));
+
+  names = ext_names(&b);
+  sa = (names != NULL ? ext_doubling(&b, names) : NULL);
+
+  if (sa != NULL) {
+    ext_positions(&b, sa);
+    if (!b.error && b.header.lcp_size != 0)
+      ext_lcp(&b, sa);
+    fclose(sa);
+  }
+  fclose(text);
+
+  if (!b.error &&
+      (fseek(b.out, 0L, SEEK_SET) != 0 ||
+       fwrite(&b.header, sizeof(SARY_FILE_HEADER), 1, b.out) != 1))
+    b.error = 1;
+
+  if (fclose(b.out) != 0)
+    b.error = 1;
+
+  stats->bytes_written += sizeof(SARY_FILE_HEADER);
+  return !b.error;
+}
+
+
+/*
+ * ext_names
+ *
+ * Read the text, copying it into the text section of the index file,
+ * counting its characters and writing the initial name of each suffix
+ * to a temporary file.  The name packs the suffix's first name_chars
+ * characters in base 257, with each character shifted into 1..256 as
+ * in sary.c and 0 for the positions past the end of the text.
+ *
+ * Returns:  the names file, or NULL on an error.
+ */
+static FILE *ext_names(EXT_BUILD *b)
+{
+  int c, j, k, n;
+  long i, p, M, max, top, name;
+  char *buf;
+  FILE *fp;
+  EXT_STREAM names;
+
+  M = b->M;
+  max = (b->width < 64 ? (1L << b->width) - 1 : LONG_MAX);
+  for (k=1,top=1; top <= max / 257 / 257; k++)
+    top *= 257;
+  b->name_chars = k;
+
+  if ((fp = ext_tmpfile(b)) == NULL)
+    return NULL;
+
+  if ((buf = ext_alloc(b, b->block_bytes)) == NULL) {
+    fclose(fp);
+    return NULL;
+  }
+
+  if (!stream_open(b, &names, fp, b->width, 0, 0, b->block_bytes)) {
+    ext_free(b, buf, b->block_bytes);
+    fclose(fp);
+    return NULL;
+  }
+
+  /*
+   * The name of suffix i is complete once character i+k-1 is read.
+   */
+  name = 0;
+  out_start(b, SF_TEXT);
+  out_write(b, "", 1);
+  for (p=0; p < M && !b->error; p+=n) {
+    n = (M - p < b->block_bytes ? (int) (M - p) : b->block_bytes);
+    if (fread(buf, 1, n, b->text) != (size_t) n) {
+      b->error = 1;
+      break;
+    }
+    b->stats->bytes_read += n;
+
+    out_write(b, buf, n);
+    for (j=0; j < n; j++) {
+      c = (int) buf[j] - CHAR_MIN + 1;
+      b->counts[c]++;
+      name = name % top * 257 + c;
+      if (p + j >= k - 1)
+        stream_put(b, &names, name);
+    }
+  }
+  for (i=M; i < M + k - 1; i++) {
+    name = name % top * 257;
+    if (i >= k - 1)
+      stream_put(b, &names, name);
+  }
+  out_write(b, "", 1);
+  b->header.size[SF_TEXT] = b->out_pos - b->header.offset[SF_TEXT];
+
+  stream_flush(b, &names);
+  stream_close(b, &names);
+  ext_free(b, buf, b->block_bytes);
+
+  if (b->error) {
+    fclose(fp);
+    return NULL;
+  }
+
+  return fp;
+}
+
+
+/*
+ * ext_doubling
+ *
+ * The prefix doubling rounds.  The names file is closed.
+ *
+ * Returns:  a temporary file holding Pos[1..M], or NULL on an error.
+ */
+static FILE *ext_doubling(EXT_BUILD *b, FILE *names)
+{
+  int done;
+  long i, h, j, M, r1, r2, name, groups;
+  FILE *sa;
+  EXT_REC rec, prev;
+  EXT_STREAM first, second, out;
+  EXT_SORT pairs, byi;
+
+  M = b->M;
+  sa = NULL;
+  for (h=b->name_chars; names != NULL; h*=2) {
+    b->stats->num_rounds++;
+
+    /*
+     * Sort the pairs of names h apart.
+     */
+    sort_init(b, &pairs, 3);
+    if (stream_open(b, &first, names, b->width, 0, M, b->block_bytes)) {
+      if (stream_open(b, &second, names, b->width,
+                      (h < M ? h : M) * (b->width / 8), (h < M ? M - h : 0),
+                      b->block_bytes)) {
+        for (i=1; i <= M && !b->error; i++) {
+          stream_get(b, &first, &r1);
+          r2 = 0;
+          if (i + h <= M)
+            stream_get(b, &second, &r2);
+          sort_add(b, &pairs, r1, r2, i);
+        }
+        stream_close(b, &second);
+      }
+      stream_close(b, &first);
+    }
+    fclose(names);
+    names = NULL;
+
+    if (b->error || !sort_finish(b, &pairs)) {
+      sort_free(b, &pairs);
+      return NULL;
+    }
+
+    /*
+     * Name the suffixes by their rank, writing the sorted order out in
+     * case this is the last round.
+     */
+    if ((sa = ext_tmpfile(b)) == NULL ||
+        !stream_open(b, &out, sa, b->width, 0, 0, b->block_bytes)) {
+      if (sa != NULL)
+        fclose(sa);
+      sort_free(b, &pairs);
+      return NULL;
+    }
+
+    sort_init(b, &byi, 2);
+    j = groups = name = 0;
+    prev.key = prev.key2 = -1;
+    while (sort_next(b, &pairs, &rec)) {
+      j++;
+      if (rec.key != prev.key || rec.key2 != prev.key2) {
+        name = j;
+        groups++;
+      }
+      prev = rec;
+
+      stream_put(b, &out, rec.value);
+      sort_add(b, &byi, rec.value, 0, name);
+    }
+    stream_flush(b, &out);
+    stream_close(b, &out);
+    sort_free(b, &pairs);
+
+    done = (groups == M);
+    if (b->error || done || !sort_finish(b, &byi)) {
+      sort_free(b, &byi);
+      if (b->error) {
+        fclose(sa);
+        return NULL;
+      }
+      return sa;
+    }
+    fclose(sa);
+    sa = NULL;
+
+    /*
+     * Write the new names in text order.
+     */
+    if ((names = ext_tmpfile(b)) != NULL) {
+      if (stream_open(b, &out, names, b->width, 0, 0, b->block_bytes)) {
+        while (sort_next(b, &byi, &rec))
+          stream_put(b, &out, rec.value);
+        stream_flush(b, &out);
+        stream_close(b, &out);
+      }
+
+      if (b->error) {
+        fclose(names);
+        names = NULL;
+      }
+    }
+    sort_free(b, &byi);
+  }
+
+  return NULL;
+}
+
+
+/*
+ * ext_positions
+ *
+ * Copy the suffix array into the Pos section of the index file.
+ */
+static void ext_positions(EXT_BUILD *b, FILE *sa)
+{
+  long r, value;
+  EXT_STREAM in, out;
+
+  out_start(b, SF_POS);
+  if (!out_open(b, &out, b->width))
+    return;
+
+  if (stream_open(b, &in, sa, b->width, 0, b->M, b->block_bytes)) {
+    stream_put(b, &out, 0);
+    for (r=1; r <= b->M && stream_get(b, &in, &value); r++)
+      stream_put(b, &out, value);
+    stream_close(b, &in);
+  }
+
+  out_close(b, &out, SF_POS);
+}
+
+
+/*
+ * ext_lcp
+ *
+ * Compute the lcp values of the suffix array, writing the leaves and
+ * lcp tree sections of the index file.
+ */
+static void ext_lcp(EXT_BUILD *b, FILE *sa)
+{
+  FILE *phi;
+  EXT_SORT pairs, lcps, leaves;
+
+  if ((phi = lcp_phi(b, sa, &pairs)) == NULL)
+    return;
+
+  if (!sort_finish(b, &pairs)) {
+    sort_free(b, &pairs);
+    fclose(phi);
+    return;
+  }
+
+  sort_init(b, &lcps, 2);
+  lcp_irreducible(b, &pairs, &lcps);
+  sort_free(b, &pairs);
+
+  if (b->error || !sort_finish(b, &lcps)) {
+    sort_free(b, &lcps);
+    fclose(phi);
+    return;
+  }
+
+  sort_init(b, &leaves, 2);
+  lcp_values(b, phi, &lcps, &leaves);
+  sort_free(b, &lcps);
+  fclose(phi);
+
+  if (b->error || !sort_finish(b, &leaves)) {
+    sort_free(b, &leaves);
+    return;
+  }
+
+  lcp_tree(b, &leaves);
+}
+
+
+/*
+ * lcp_phi
+ *
+ * Sort (Pos[r], r, Pos[r-1]) into text order, and scan it to sort out
+ * how each suffix's lcp with its predecessor is found.  Pos[r-1] is
+ * replaced by 0 when suffix r is the first suffix starting with its
+ * character (and so has an lcp of 0).  The pairs of the irreducible
+ * values are added to the pairs sort, keyed by the block of the text
+ * holding Phi[i] and then by i.
+ *
+ * Returns:  a temporary file holding 4r + PHI_ZERO, PHI_REDUCIBLE or
+ *           PHI_IRREDUCIBLE for each suffix, in text order (the lcps
+ *           are only computed for texts short enough for that to fit
+ *           a 32 bit entry, see sary_file_lcp_size), or NULL on an
+ *           error.
+ */
+static FILE *lcp_phi(EXT_BUILD *b, FILE *sa, EXT_SORT *pairs)
+{
+  int c;
+  long r, j, prev, bound, value;
+  FILE *fp;
+  EXT_REC rec;
+  EXT_STREAM in, out;
+  EXT_SORT phi;
+
+  sort_init(b, &phi, 3);
+  if (stream_open(b, &in, sa, b->width, 0, b->M, b->block_bytes)) {
+    prev = 0;
+    c = 0;
+    bound = 1;
+    for (r=1; r <= b->M && stream_get(b, &in, &value); r++) {
+      if (r == bound) {
+        prev = 0;
+        while (bound <= r)
+          bound += b->counts[++c];
+      }
+      sort_add(b, &phi, value, r, prev);
+      prev = value;
+    }
+    stream_close(b, &in);
+  }
+
+  if (b->error || !sort_finish(b, &phi) ||
+      (fp = ext_tmpfile(b)) == NULL) {
+    sort_free(b, &phi);
+    return NULL;
+  }
+
+  if (!stream_open(b, &out, fp, b->width, 0, 0, b->block_bytes)) {
+    sort_free(b, &phi);
+    fclose(fp);
+    return NULL;
+  }
+
+  /*
+   * lcp(i) = lcp(i-1) - 1 when Phi[i] = Phi[i-1] + 1 and lcp(i-1) > 0,
+   * since suffix Phi[i-1]+1 then precedes suffix i and shares all but
+   * the first of the characters that suffix Phi[i-1] shared with i-1.
+   */
+  sort_init(b, pairs, 3);
+  prev = 0;
+  while (sort_next(b, &phi, &rec)) {
+    j = rec.value;
+    if (j == 0)
+      stream_put(b, &out, 4 * rec.key2 + PHI_ZERO);
+    else if (prev != 0 && j == prev + 1)
+      stream_put(b, &out, 4 * rec.key2 + PHI_REDUCIBLE);
+    else {
+      stream_put(b, &out, 4 * rec.key2 + PHI_IRREDUCIBLE);
+      sort_add(b, pairs, (j - 1) / b->text_block, rec.key, j);
+    }
+    prev = j;
+  }
+  stream_flush(b, &out);
+  stream_close(b, &out);
+  sort_free(b, &phi);
+
+  if (b->error) {
+    sort_free(b, pairs);
+    fclose(fp);
+    return NULL;
+  }
+
+  return fp;
+}
+
+
+/*
+ * lcp_irreducible
+ *
+ * Compute the irreducible lcp values, adding (i, lcp(i)) to the lcps
+ * sort.  Each block of the text is read in turn, and its pairs come in
+ * order of i.
+ */
+static void lcp_irreducible(EXT_BUILD *b, EXT_SORT *pairs, EXT_SORT *lcps)
+{
+  int k;
+  long block;
+  EXT_REC rec;
+  EXT_WINDOW win[4];
+
+  memset(win, 0, sizeof(win));
+  for (k=0; k < 4; k++) {
+    win[k].size = (k == 1 ? b->text_block : b->block_bytes);
+    if ((win[k].buf = ext_alloc(b, win[k].size)) == NULL)
+      b->error = 1;
+  }
+
+  block = -1;
+  while (sort_next(b, pairs, &rec)) {
+    if (rec.key != block) {
+      block = rec.key;
+      window_load(b, &win[1], block * b->text_block + 1);
+    }
+
+    sort_add(b, lcps, rec.key2, 0, pair_lcp(b, win, rec.key2, rec.value));
+  }
+
+  for (k=0; k < 4; k++)
+    if (win[k].buf != NULL)
+      ext_free(b, win[k].buf, win[k].size);
+}
+
+
+/*
+ * lcp_values
+ *
+ * Scan the suffixes in text order, taking the irreducible lcps from the
+ * lcps sort and working out the others, and add (r, lcp) for each to
+ * the leaves sort.
+ */
+static void lcp_values(EXT_BUILD *b, FILE *phi, EXT_SORT *lcps,
+                       EXT_SORT *leaves)
+{
+  long i, h, code;
+  EXT_REC rec;
+  EXT_STREAM in;
+
+  if (!stream_open(b, &in, phi, b->width, 0, b->M, b->block_bytes))
+    return;
+
+  h = 0;
+  for (i=1; i <= b->M && !b->error; i++) {
+    if (!stream_get(b, &in, &code))
+      break;
+
+    if (code % 4 == PHI_ZERO)
+      h = 0;
+    else if (code % 4 == PHI_REDUCIBLE)
+      h--;
+    else if (sort_next(b, lcps, &rec) && rec.key == i)
+      h = rec.value;
+    else
+      b->error = 1;
+
+    sort_add(b, leaves, code / 4, 0, h);
+  }
+  stream_close(b, &in);
+}
+
+
+/*
+ * lcp_tree
+ *
+ * Write the leaves, computing the lcp tree in the same in-order pass
+ * that sary_compute_lcp makes over them.  The pass meets the nodes at
+ * each depth of the tree in the order they are stored, so the lcp tree
+ * section is written at the same time, by one stream per depth (level
+ * d holding indexes 2^d to 2^(d+1)-1, and level 0 indexes 0 and 1).
+ */
+static void lcp_tree(EXT_BUILD *b, EXT_SORT *leaves)
+{
+  int d, num_levels, bytes;
+  long midpoint, end, offset, value;
+  long *level_next;
+  EXT_STREAM out, *levels;
+
+  out_start(b, SF_LEAVES);
+  if (!out_open(b, &out, 32)) {
+    sort_free(b, leaves);
+    return;
+  }
+
+  offset = b->out_pos + (b->M + 1) * (long) sizeof(int);
+  offset += (SARY_FILE_ALIGN - offset % SARY_FILE_ALIGN) % SARY_FILE_ALIGN;
+
+  for (num_levels=1; (1L << num_levels) < b->header.lcp_size; num_levels++) ;
+  bytes = ext_buffer(b->budget / 4 / num_levels);
+
+  levels = malloc(num_levels * sizeof(EXT_STREAM));
+  level_next = malloc(num_levels * sizeof(long));
+  if (levels == NULL || level_next == NULL)
+    b->error = 1;
+  else
+    memset(levels, 0, num_levels * sizeof(EXT_STREAM));
+  for (d=0; d < num_levels && !b->error; d++) {
+    level_next[d] = (d == 0 ? 0 : 1L << d);
+    stream_open(b, &levels[d], b->out, 32,
+                offset + level_next[d] * (long) sizeof(int), 0, bytes);
+  }
+
+  b->leaves = leaves;
+  b->out_ints = &out;
+  b->levels = levels;
+  b->level_next = level_next;
+
+  stream_put(b, &out, 0);
+  next_leaf(b, &value);
+  if (b->M > 2) {
+    midpoint = (1 + b->M) / 2;
+    tree_values(b, 1, midpoint, 2);
+    tree_values(b, midpoint, b->M, 3);
+  }
+  while (next_leaf(b, &value)) ;
+
+  out_close(b, &out, SF_LEAVES);
+  sort_free(b, leaves);
+
+  out_start(b, SF_LCP);
+  if (b->header.offset[SF_LCP] != offset)
+    b->error = 1;
+
+  /*
+   * Fill in the unused entries at the end of each level.
+   */
+  for (d=0; levels != NULL && level_next != NULL && d < num_levels; d++) {
+    if (levels[d].buf == NULL)
+      continue;
+
+    end = (2L << d < b->header.lcp_size ? 2L << d : b->header.lcp_size);
+    for ( ; level_next[d] < end && !b->error; level_next[d]++)
+      stream_put(b, &levels[d], -1);
+    stream_flush(b, &levels[d]);
+    stream_close(b, &levels[d]);
+  }
+  if (levels != NULL)
+    free(levels);
+  if (level_next != NULL)
+    free(level_next);
+
+  b->out_pos += b->header.lcp_size * (long) sizeof(int);
+  b->header.size[SF_LCP] = b->out_pos - b->header.offset[SF_LCP];
+  if (!b->error && fseek(b->out, b->out_pos, SEEK_SET) != 0)
+    b->error = 1;
+}
+
+
+/*
+ * tree_values
+ *
+ * The external version of compute_lcp_values in sary.c:  the leaves
+ * are read in order as the recursion reaches them, and each node's
+ * value is written to its level of the lcp tree.
+ *
+ * Returns:  the minimum lcp in the range.
+ */
+static long tree_values(EXT_BUILD *b, long min, long max, long index)
+{
+  long midpoint, value, value2;
+
+  if (max - min == 1) {
+    if (!next_leaf(b, &value))
+      b->error = 1;
+  }
+  else {
+    midpoint = (min + max) / 2;
+    value = tree_values(b, min, midpoint, index * 2);
+    value2 = tree_values(b, midpoint, max, index * 2 + 1);
+    if (value2 < value)
+      value = value2;
+  }
+
+  tree_put(b, index, value);
+  return value;
+}
+
+
+/*
+ * tree_put
+ *
+ * Write an lcp tree entry to its level, with -1 for the unused entries
+ * before it.
+ */
+static void tree_put(EXT_BUILD *b, long index, long value)
+{
+  int d;
+
+  if (b->error)
+    return;
+
+  for (d=0; 2L << d <= index; d++) ;
+  for ( ; b->level_next[d] < index; b->level_next[d]++)
+    stream_put(b, &b->levels[d], -1);
+
+  stream_put(b, &b->levels[d], value);
+  b->level_next[d] = index + 1;
+}
+
+
+/*
+ * next_leaf
+ *
+ * Read the next lcp_leaves value, and write it to the index file.
+ *
+ * Returns:  non-zero if there was one, zero at the end.
+ */
+static int next_leaf(EXT_BUILD *b, long *value)
+{
+  EXT_REC rec;
+
+  *value = 0;
+  if (!sort_next(b, b->leaves, &rec))
+    return 0;
+
+  *value = rec.value;
+  stream_put(b, b->out_ints, rec.value);
+  return 1;
+}
+
+
+/*
+ * pair_lcp
+ *
+ * Compute the lcp of suffixes i and j, reading the text through the
+ * windows:  win[0] holds the text at i (and moves forward with i),
+ * win[1] the block holding j, and win[2] and win[3] whatever else the
+ * comparison reaches on the two sides.
+ *
+ * Returns:  the lcp.
+ */
+static long pair_lcp(EXT_BUILD *b, EXT_WINDOW *win, long i, long j)
+{
+  int n, len;
+  long h;
+  EXT_WINDOW *wi, *wj;
+
+  if ((i < win[0].start || i >= win[0].end) && !window_load(b, &win[0], i))
+    return 0;
+
+  h = 0;
+  while (i + h <= b->M && j + h <= b->M) {
+    if ((wi = window_find(b, &win[0], &win[2], i + h)) == NULL ||
+        (wj = window_find(b, &win[1], &win[3], j + h)) == NULL)
+      break;
+
+    n = (int) (wi->end - (i + h) < wj->end - (j + h)
+                 ? wi->end - (i + h) : wj->end - (j + h));
+    len = sary_cmp_length(&wi->buf[i + h - wi->start],
+                          &wj->buf[j + h - wj->start], n);
+    h += len;
+    if (len < n)
+      break;
+  }
+
+  return h;
+}
+
+
+/*
+ * window_find, window_load
+ *
+ * Find the window holding a text position, either w or, loading it if
+ * need be, more.  window_load reads the text from a position into a
+ * window.
+ *
+ * Returns:  the window (or non-zero), or NULL (zero) on an error.
+ */
+static EXT_WINDOW *window_find(EXT_BUILD *b, EXT_WINDOW *w, EXT_WINDOW *more,
+                               long pos)
+{
+  if (pos >= w->start && pos < w->end)
+    return w;
+
+  if ((pos < more->start || pos >= more->end) && !window_load(b, more, pos))
+    return NULL;
+
+  return more;
+}
+
+static int window_load(EXT_BUILD *b, EXT_WINDOW *w, long pos)
+{
+  int n;
+
+  if (b->error)
+    return 0;
+
+  n = (b->M - pos + 1 < w->size ? (int) (b->M - pos + 1) : w->size);
+  if (fseek(b->text, pos - 1, SEEK_SET) != 0 ||
+      fread(w->buf, 1, n, b->text) != (size_t) n) {
+    b->error = 1;
+    return 0;
+  }
+  b->stats->bytes_read += n;
+
+  w->start = pos;
+  w->end = pos + n;
+  return 1;
+}
+
+
+/*
+ * out_start, out_write, out_open, out_close
+ *
+ * Write the sections of the index file, as file_start and file_write
+ * do in sary_match.c.  The suffix array and lcp sections are written
+ * through a stream of the given width.
+ */
+static void out_start(EXT_BUILD *b, int sec)
+{
+  static char zeros[SARY_FILE_ALIGN];
+
+  out_write(b, zeros, (SARY_FILE_ALIGN - b->out_pos % SARY_FILE_ALIGN) %
+                      SARY_FILE_ALIGN);
+  b->header.offset[sec] = b->out_pos;
+}
+
+static void out_write(EXT_BUILD *b, void *data, long size)
+{
+  if (b->error || size == 0)
+    return;
+
+  if (fwrite(data, 1, size, b->out) != (size_t) size) {
+    b->error = 1;
+    return;
+  }
+
+  b->out_pos += size;
+  b->stats->bytes_written += size;
+}
+
+static int out_open(EXT_BUILD *b, EXT_STREAM *st, int width)
+{
+  if (b->error || fflush(b->out) != 0) {
+    b->error = 1;
+    return 0;
+  }
+
+  return stream_open(b, st, b->out, width, b->out_pos, 0, b->block_bytes);
+}
+
+static void out_close(EXT_BUILD *b, EXT_STREAM *st, int sec)
+{
+  stream_flush(b, st);
+  b->out_pos = st->pos;
+  b->header.size[sec] = b->out_pos - b->header.offset[sec];
+  stream_close(b, st);
+
+  if (!b->error && fseek(b->out, b->out_pos, SEEK_SET) != 0)
+    b->error = 1;
+}
+
+
+/*
+ * sort_init, sort_add, sort_finish, sort_next, sort_free
+ *
+ * The external merge sort of (key, key2, value) records, of which only
+ * num_fields (2 or 3, without key2) are stored.  Records are added to
+ * a run buffer, which is sorted and spilled to the sort's temporary
+ * file whenever it fills.  When the sort is finished, the records are
+ * read back either straight from the buffer (if nothing was spilled)
+ * or from a merge of the runs, after merging the first runs into one
+ * if there are more than b->fanin of them.
+ */
+static void sort_init(EXT_BUILD *b, EXT_SORT *s, int num_fields)
+{
+  memset(s, 0, sizeof(EXT_SORT));
+  s->num_fields = num_fields;
+  if ((s->recs = ext_alloc(b, b->rec_max * (long) sizeof(EXT_REC))) == NULL)
+    b->error = 1;
+}
+
+static int sort_add(EXT_BUILD *b, EXT_SORT *s, long key, long key2,
+                    long value)
+{
+  EXT_REC *rec;
+
+  if (b->error || s->recs == NULL)
+    return 0;
+
+  if (s->num_recs == b->rec_max && !sort_spill(b, s))
+    return 0;
+
+  rec = &s->recs[s->num_recs++];
+  rec->key = key;
+  rec->key2 = key2;
+  rec->value = value;
+  return 1;
+}
+
+static int sort_finish(EXT_BUILD *b, EXT_SORT *s)
+{
+  int k;
+
+  if (b->error || s->recs == NULL)
+    return 0;
+
+  if (s->num_runs == 0) {
+    qsort(s->recs, s->num_recs, sizeof(EXT_REC), cmp_recs);
+    s->next = 0;
+    return 1;
+  }
+
+  if (s->num_recs > 0 && !sort_spill(b, s))
+    return 0;
+
+  ext_free(b, s->recs, b->rec_max * (long) sizeof(EXT_REC));
+  s->recs = NULL;
+
+  /*
+   * Merge just enough runs to leave b->fanin for the final merge.
+   */
+  while (s->num_runs > b->fanin) {
+    k = s->num_runs - b->fanin + 1;
+    if (!sort_merge_runs(b, s, (k < b->fanin ? k : b->fanin)))
+      return 0;
+  }
+
+  return merge_start(b, s, s->num_runs);
+}
+
+static int sort_next(EXT_BUILD *b, EXT_SORT *s, EXT_REC *rec)
+{
+  if (b->error)
+    return 0;
+
+  if (s->recs != NULL) {
+    if (s->next == s->num_recs)
+      return 0;
+
+    *rec = s->recs[s->next++];
+    return 1;
+  }
+
+  return merge_next(b, s, rec);
+}
+
+static void sort_free(EXT_BUILD *b, EXT_SORT *s)
+{
+  if (s->recs != NULL)
+    ext_free(b, s->recs, b->rec_max * (long) sizeof(EXT_REC));
+  if (s->in != NULL)
+    merge_end(b, s);
+
+  if (s->runs != NULL)
+    free(s->runs);
+  if (s->fp != NULL)
+    fclose(s->fp);
+
+  memset(s, 0, sizeof(EXT_SORT));
+}
+
+
+/*
+ * sort_spill
+ *
+ * Sort the run buffer and append it to the sort's temporary file as a
+ * new run.
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int sort_spill(EXT_BUILD *b, EXT_SORT *s)
+{
+  int i;
+  EXT_RUN *runs;
+  EXT_STREAM out;
+
+  qsort(s->recs, s->num_recs, sizeof(EXT_REC), cmp_recs);
+
+  if (s->num_runs == s->max_runs) {
+    s->max_runs = (s->max_runs == 0 ? 16 : s->max_runs * 2);
+    if ((runs = realloc(s->runs, s->max_runs * sizeof(EXT_RUN))) == NULL) {
+      b->error = 1;
+      return 0;
+    }
+    s->runs = runs;
+  }
+
+  if (s->fp == NULL && (s->fp = ext_tmpfile(b)) == NULL)
+    return 0;
+
+  if (!stream_open(b, &out, s->fp, b->width, s->end, 0, b->block_bytes))
+    return 0;
+
+  for (i=0; i < s->num_recs; i++)
+    rec_put(b, s, &out, &s->recs[i]);
+  stream_flush(b, &out);
+  stream_close(b, &out);
+
+  if (b->error)
+    return 0;
+
+  s->runs[s->num_runs].pos = s->end;
+  s->runs[s->num_runs].num = s->num_recs;
+  s->num_runs++;
+  s->end = out.pos;
+  s->num_recs = 0;
+  b->stats->num_runs++;
+
+  return 1;
+}
+
+
+/*
+ * sort_merge_runs
+ *
+ * Merge the first k runs into one, appended to the sort's file.
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int sort_merge_runs(EXT_BUILD *b, EXT_SORT *s, int k)
+{
+  long num;
+  EXT_REC rec;
+  EXT_STREAM out;
+
+  if (!stream_open(b, &out, s->fp, b->width, s->end, 0, b->merge_bytes))
+    return 0;
+
+  num = 0;
+  if (merge_start(b, s, k)) {
+    while (merge_next(b, s, &rec)) {
+      rec_put(b, s, &out, &rec);
+      num++;
+    }
+  }
+  merge_end(b, s);
+  stream_flush(b, &out);
+  stream_close(b, &out);
+
+  if (b->error)
+    return 0;
+
+  s->runs[s->num_runs].pos = s->end;
+  s->runs[s->num_runs].num = num;
+  s->num_runs++;
+  s->end = out.pos;
+  b->stats->num_merges++;
+
+  return 1;
+}
+
+
+/*
+ * merge_start, merge_next, merge_end
+ *
+ * A k-way merge of the first k runs, using a heap of the runs ordered
+ * by their current records.  merge_end removes the runs from the list.
+ */
+static int merge_start(EXT_BUILD *b, EXT_SORT *s, int k)
+{
+  int i, j;
+  EXT_STREAM *st;
+
+  s->num_in = 0;
+  s->num_merged = k;
+  s->heap_size = 0;
+  if ((s->in = malloc(k * sizeof(EXT_STREAM))) == NULL ||
+      (s->cur = malloc(k * sizeof(EXT_REC))) == NULL ||
+      (s->heap = malloc(k * sizeof(int))) == NULL) {
+    b->error = 1;
+    return 0;
+  }
+
+  for (i=0; i < k; i++) {
+    st = &s->in[i];
+    if (!stream_open(b, st, s->fp, b->width, s->runs[i].pos,
+                     s->runs[i].num * s->num_fields, b->merge_bytes))
+      return 0;
+    s->num_in++;
+
+    if (rec_get(b, s, st, &s->cur[i]))
+      s->heap[s->heap_size++] = i;
+  }
+
+  for (j=s->heap_size / 2 - 1; j >= 0; j--)
+    merge_down(s, j);
+
+  return !b->error;
+}
+
+static int merge_next(EXT_BUILD *b, EXT_SORT *s, EXT_REC *rec)
+{
+  int top;
+
+  if (b->error || s->heap_size == 0)
+    return 0;
+
+  top = s->heap[0];
+  *rec = s->cur[top];
+
+  if (!rec_get(b, s, &s->in[top], &s->cur[top]))
+    s->heap[0] = s->heap[--s->heap_size];
+
+  if (s->heap_size > 0)
+    merge_down(s, 0);
+
+  return 1;
+}
+
+static void merge_end(EXT_BUILD *b, EXT_SORT *s)
+{
+  int i;
+
+  for (i=0; i < s->num_in; i++)
+    stream_close(b, &s->in[i]);
+
+  if (s->heap != NULL) {
+    s->num_runs -= s->num_merged;
+    memmove(s->runs, s->runs + s->num_merged, s->num_runs * sizeof(EXT_RUN));
+  }
+
+  if (s->in != NULL)
+    free(s->in);
+  if (s->cur != NULL)
+    free(s->cur);
+  if (s->heap != NULL)
+    free(s->heap);
+  s->in = NULL;
+  s->cur = NULL;
+  s->heap = NULL;
+  s->num_in = s->num_merged = s->heap_size = 0;
+}
+
+static void merge_down(EXT_SORT *s, int i)
+{
+  int child, top;
+
+  top = s->heap[i];
+  while ((child = 2 * i + 1) < s->heap_size) {
+    if (child + 1 < s->heap_size &&
+        REC_LESS(&s->cur[s->heap[child+1]], &s->cur[s->heap[child]]))
+      child++;
+    if (!REC_LESS(&s->cur[s->heap[child]], &s->cur[top]))
+      break;
+
+    s->heap[i] = s->heap[child];
+    i = child;
+  }
+  s->heap[i] = top;
+}
+
+
+/*
+ * rec_get, rec_put
+ *
+ * Read and write the stored fields of a record.
+ *
+ * Returns:  non-zero on success, zero at the end of a run or on an
+ *           error.
+ */
+static int rec_get(EXT_BUILD *b, EXT_SORT *s, EXT_STREAM *st, EXT_REC *rec)
+{
+  rec->key2 = 0;
+  return stream_get(b, st, &rec->key) &&
+         (s->num_fields == 2 || stream_get(b, st, &rec->key2)) &&
+         stream_get(b, st, &rec->value);
+}
+
+static int rec_put(EXT_BUILD *b, EXT_SORT *s, EXT_STREAM *st, EXT_REC *rec)
+{
+  return stream_put(b, st, rec->key) &&
+         (s->num_fields == 2 || stream_put(b, st, rec->key2)) &&
+         stream_put(b, st, rec->value);
+}
+
+static int cmp_recs(const void *a, const void *b)
+{
+  const EXT_REC *x = a, *y = b;
+
+  if (REC_LESS(x, y))
+    return -1;
+  else if (REC_LESS(y, x))
+    return 1;
+  else
+    return 0;
+}
+
+
+/*
+ * stream_open, stream_get, stream_put, stream_flush, stream_close
+ *
+ * Buffered reading or writing of values of the given width (as stored
+ * by sary_entry_set) at a byte position in a file.  Each stream keeps
+ * its own position, so several streams can read the same file (as the
+ * doubling rounds and the merges do).  The reads and writes are added
+ * to the I/O statistics.
+ */
+static int stream_open(EXT_BUILD *b, EXT_STREAM *st, FILE *fp, int width,
+                       long pos, long left, int bytes)
+{
+  memset(st, 0, sizeof(EXT_STREAM));
+  st->size = (bytes / (width / 8) > 0 ? bytes / (width / 8) : 1);
+  if (b->error ||
+      (st->buf = ext_alloc(b, st->size * (long) (width / 8))) == NULL) {
+    b->error = 1;
+    return 0;
+  }
+
+  st->fp = fp;
+  st->width = width;
+  st->pos = pos;
+  st->left = left;
+  return 1;
+}
+
+static int stream_get(EXT_BUILD *b, EXT_STREAM *st, long *value)
+{
+  int n;
+
+  if (st->next == st->num) {
+    if (b->error || st->left == 0)
+      return 0;
+
+    n = (st->left < st->size ? (int) st->left : st->size);
+    if (fseek(st->fp, st->pos, SEEK_SET) != 0 ||
+        fread(st->buf, st->width / 8, n, st->fp) != (size_t) n) {
+      b->error = 1;
+      return 0;
+    }
+    b->stats->bytes_read += n * (long) (st->width / 8);
+
+    st->pos += n * (long) (st->width / 8);
+    st->left -= n;
+    st->num = n;
+    st->next = 0;
+  }
+
+  *value = sary_entry_get(st->buf, st->width, st->next++);
+  return 1;
+}
+
+static int stream_put(EXT_BUILD *b, EXT_STREAM *st, long value)
+{
+  if (st->num == st->size && !stream_flush(b, st))
+    return 0;
+
+  sary_entry_set(st->buf, st->width, st->num++, value);
+  return 1;
+}
+
+static int stream_flush(EXT_BUILD *b, EXT_STREAM *st)
+{
+  if (b->error || st->num == 0)
+    return !b->error;
+
+  if (fseek(st->fp, st->pos, SEEK_SET) != 0 ||
+      fwrite(st->buf, st->width / 8, st->num, st->fp) != (size_t) st->num) {
+    b->error = 1;
+    return 0;
+  }
+  b->stats->bytes_written += st->num * (long) (st->width / 8);
+
+  st->pos += st->num * (long) (st->width / 8);
+  st->num = 0;
+  return 1;
+}
+
+static void stream_close(EXT_BUILD *b, EXT_STREAM *st)
+{
+  if (st->buf != NULL)
+    ext_free(b, st->buf, st->size * (long) (st->width / 8));
+  st->buf = NULL;
+}
+
+
+/*
+ * ext_tmpfile
+ *
+ * Create a temporary file in the build's directory.  The file is
+ * unlinked at once, so it disappears when it is closed.  It is left
+ * unbuffered, since the streams do their own buffering.
+ *
+ * Returns:  the open file, or NULL on an error.
+ */
+static FILE *ext_tmpfile(EXT_BUILD *b)
+{
+  int fd;
+  char *path;
+  FILE *fp;
+
+  if ((path = malloc(strlen(b->dir) + 32)) == NULL) {
+    b->error = 1;
+    return NULL;
+  }
+
+  sprintf(path, "%s/strmat_sary_XXXXXX", b->dir);
+  if ((fd = mkstemp(path)) != -1)
+    unlink(path);
+  free(path);
+
+  if (fd == -1 || (fp = fdopen(fd, "w+b")) == NULL) {
+    if (fd != -1)
+      close(fd);
+    b->error = 1;
+    return NULL;
+  }
+
+  setvbuf(fp, NULL, _IONBF, 0);
+  return fp;
+}
+
+
+/*
+ * ext_buffer, ext_alloc, ext_free
+ *
+ * Size the buffers (at most EXT_MAX_BUFFER bytes or records, so that
+ * the sizes fit in an int), and allocate and free them, keeping track
+ * of the working memory for the statistics.
+ */
+static int ext_buffer(long bytes)
+{
+  return (int) (bytes < EXT_MAX_BUFFER ? bytes : EXT_MAX_BUFFER);
+}
+
+static void *ext_alloc(EXT_BUILD *b, long bytes)
+{
+  void *p;
+
+  if ((p = malloc(bytes)) == NULL)
+    return NULL;
+
+  b->mem_current += bytes;
+  if (b->mem_current > b->stats->mem_peak)
+    b->stats->mem_peak = b->mem_current;
+
+  return p;
+}
+
+static void ext_free(EXT_BUILD *b, void *p, long bytes)
+{
+  free(p);
+  b->mem_current -= bytes;
+}
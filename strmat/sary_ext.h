@@ -0,0 +1,17 @@
+
+#ifndef _SARY_EXT_H_
+#define _SARY_EXT_H_
+
+#define SARY_EXT_MIN_BUDGET (64 * 1024L)
+
+typedef struct {
+  long mem_budget, mem_peak;
+
+  long bytes_read, bytes_written;   /* temporary and index file I/O */
+  int num_rounds, num_runs, num_merges;
+} SARY_EXT_STATS;
+
+int sary_ext_build(char *text_path, char *index_path, char *tmp_dir,
+                   long mem_budget, SARY_EXT_STATS *stats);
+
+#endif
@@ -0,0 +1,56 @@
+
+#ifndef _SARY_FILE_H_
+#define _SARY_FILE_H_
+
+/*
+ * The index file format written by sary_match_save, sary_packed_save
+ * and sary_ext_build.  The file starts with a SARY_FILE_HEADER, followed
+ * by the sections listed in its offset and size tables.  Each section
+ * starts on a SARY_FILE_ALIGN byte boundary, so that the FM-index blocks
+ * stay cache line aligned when mapped.  The values are stored in the
+ * byte order and sizes of the machine that wrote the file, and the
+ * files whose byte order mark or sizes do not match are rejected.
+ *
+ *    SF_TEXT        -  the text, as T[0..M+1] (T[0] and T[M+1] are '\0')
+ *    SF_POS         -  the suffix array, as Pos[0..M], with entries of
+ *                      header.width bits (see sary_entry_get)
+ *    SF_LEAVES      -  the lcp of each suffix with its predecessor
+ *    SF_LCP         -  the lcp tree used by the lcp super-accelerant
+ *    SF_FM_INFO     -  sigma, sample rate, block sizes, code[] and C[]
+ *    SF_FM_OCC      -  the FM-index blocks
+ *    SF_FM_MARKS    -  the sampled row bitvector
+ *    SF_FM_RANKS    -  the rank of each bitvector word
+ *    SF_FM_SAMPLES  -  the sampled suffix array values
+ *
+ * The lcp sections are empty (and lcp_size is 0) when no lcp values were
+ * saved, and the FM-index sections when no FM-index was saved.  Both
+ * hold ints, so they are only saved with 32 bit entries and texts
+ * shorter than INT_MAX (for the lcp tree, short enough that its size
+ * fits an int, see sary_file_lcp_size), which is also what
+ * sary_match_open requires; sary_packed_open reads any file.
+ *
+ * Version 1 files held int entries and an int M.
+ */
+#define SARY_FILE_MAGIC "STRMSARY"
+#define SARY_FILE_VERSION 2
+#define SARY_FILE_BYTE_ORDER 0x01020304
+#define SARY_FILE_ALIGN 64
+
+enum { SF_TEXT, SF_POS, SF_LEAVES, SF_LCP, SF_FM_INFO, SF_FM_OCC,
+       SF_FM_MARKS, SF_FM_RANKS, SF_FM_SAMPLES, SF_NUM_SECTIONS };
+
+#define SF_FM_INFO_INTS (5 + 256 + 257)
+
+typedef struct {
+  char magic[8];
+  int version, byte_order, int_size, long_size;
+
+  int width, lcp_size;
+  long M;
+
+  long offset[SF_NUM_SECTIONS], size[SF_NUM_SECTIONS];
+} SARY_FILE_HEADER;
+
+int sary_file_lcp_size(long M);
+
+#endif
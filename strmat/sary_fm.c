@@ -0,0 +1,396 @@
+/*
+ * sary_fm.c
+ *
+ * An FM-index:  the Burrows-Wheeler transform of the text (built from
+ * its suffix array), with occurrence counts for rank queries and a
+ * sampled suffix array for locating the matches.  Counting the matches
+ * of a pattern takes O(N) rank queries, independent of the text length,
+ * and locating each match takes at most sample_rate - 1 LF steps.
+ *
+ * The BWT is held one byte per character, as a code into the alphabet
+ * of the characters occurring in the text (code 0 is the end-of-text
+ * sentinel).  It is cut into blocks that each begin with the counts of
+ * the text characters before the block, followed by the block's
+ * characters, with the blocks aligned and sized to whole cache lines.
+ * So a rank query touches one cache line for small alphabets such as
+ * DNA (4 counts and 48 characters per 64 byte block).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "sary.h"
+#include "sary_pack.h"
+#include "sary_fm.h"
+
+
+#define FM_CACHE_LINE 64
+#define FM_MIN_BLOCK_CHARS 48
+
+#define FM_COUNTS(fm,b) \
+  ((unsigned int *) ((fm)->occ + (long) (b) * (fm)->block_bytes))
+#define FM_CHARS(fm,b) \
+  ((fm)->occ + (long) (b) * (fm)->block_bytes + \
+   ((fm)->sigma - 1) * sizeof(int))
+#define FM_BWT(fm,r) \
+  (FM_CHARS(fm, (r) / (fm)->block_chars)[(r) % (fm)->block_chars])
+#define FM_MARKED(fm,r) \
+  ((fm)->marks[(r) >> 5] & (1U << ((r) & 31)))
+
+static SARY_FM *fm_build(char *T, int M, int sample_rate, void *Pos,
+                         int width);
+static int fm_rank(SARY_FM *fm, int c, int r);
+static int fm_mark_rank(SARY_FM *fm, int r);
+static int fm_popcount(unsigned int x);
+
+
+/*
+ * sary_fm_prep
+ *
+ * Builds the FM-index of a text.  The suffix array is built with
+ * sary_qsort_build and freed once the BWT and the samples are taken.
+ * The text is not copied, and is only used to convert positions into
+ * pointers.
+ *
+ * Parameters:   T            -  the text
+ *               M            -  the text length
+ *               sample_rate  -  one suffix array entry is kept for every
+ *                               sample_rate text positions
+ *
+ * Returns:  An initialized SARY_FM structure, or NULL on an error.
+ */
+SARY_FM *sary_fm_prep(char *T, int M, int sample_rate)
+{
+  SARY_STRUCT *sary;
+  SARY_FM *fm;
+
+  if (T == NULL || M <= 0 || sample_rate < 1)
+    return NULL;
+
+  if ((sary = sary_qsort_build(T, M, 0)) == NULL)
+    return NULL;
+
+  fm = fm_build(T, M, sample_rate, sary->Pos, 32);
+  sary_free(sary);
+
+  return fm;
+}
+
+
+/*
+ * sary_fm_prep_packed
+ *
+ * Builds the FM-index of a text from its packed suffix array, instead
+ * of sorting the suffixes again.  The index uses the packed array's
+ * text (sa->S), so that must outlive it, but not the array itself.
+ *
+ * Parameters:   sa           -  the packed suffix array
+ *               sample_rate  -  one suffix array entry is kept for every
+ *                               sample_rate text positions
+ *
+ * Returns:  An initialized SARY_FM structure, or NULL on an error
+ *           (including a text too long for the int rows of the index).
+ */
+SARY_FM *sary_fm_prep_packed(SARY_PACKED *sa, int sample_rate)
+{
+  if (sa == NULL || sa->M > INT_MAX - 1 || sample_rate < 1)
+    return NULL;
+
+  return fm_build(sa->S + 1, (int) sa->M, sample_rate, sa->Pos, sa->width);
+}
+
+
+/*
+ * fm_build
+ *
+ * The construction of sary_fm_prep and sary_fm_prep_packed, from a
+ * suffix array whose entries have the given width (see sary_entry_get).
+ *
+ * Returns:  An initialized SARY_FM structure, or NULL on an error.
+ */
+static SARY_FM *fm_build(char *T, int M, int sample_rate, void *Pos,
+                         int width)
+{
+  int r, b, c, v, p, num_words, num_samples;
+  unsigned int *counts;
+  int freq[256];
+  SARY_FM *fm;
+
+  if ((fm = malloc(sizeof(SARY_FM))) == NULL)
+    return NULL;
+  memset(fm, 0, sizeof(SARY_FM));
+
+  fm->T = T;
+  fm->M = M;
+  fm->sample_rate = sample_rate;
+
+  /*
+   * Number the characters occurring in the text, in the order used by
+   * the suffix array (signed characters), leaving code 0 for the
+   * sentinel, and compute C[c], the number of characters less than c.
+   */
+  memset(freq, 0, 256 * sizeof(int));
+  for (p=0; p < M; p++)
+    freq[(unsigned char) T[p]]++;
+
+  fm->sigma = 1;
+  for (v=CHAR_MIN; v <= CHAR_MAX; v++) {
+    if (freq[(unsigned char) v] > 0)
+      fm->code[(unsigned char) v] = fm->sigma++;
+    else
+      fm->code[(unsigned char) v] = 0;
+  }
+
+  fm->C[0] = 0;
+  fm->C[1] = 1;
+  for (v=CHAR_MIN; v <= CHAR_MAX; v++)
+    if (freq[(unsigned char) v] > 0)
+      fm->C[fm->code[(unsigned char) v] + 1] =
+        fm->C[fm->code[(unsigned char) v]] + freq[(unsigned char) v];
+
+  /*
+   * Size the blocks to whole cache lines, holding the counts and
+   * at least FM_MIN_BLOCK_CHARS characters.
+   */
+  fm->block_bytes = (fm->sigma - 1) * sizeof(int) + FM_MIN_BLOCK_CHARS;
+  fm->block_bytes = (fm->block_bytes + FM_CACHE_LINE - 1) / FM_CACHE_LINE *
+                    FM_CACHE_LINE;
+  fm->block_chars = fm->block_bytes - (fm->sigma - 1) * sizeof(int);
+  fm->num_blocks = (M + 1) / fm->block_chars + 1;
+
+  num_words = (M + 1) / 32 + 1;
+  num_samples = M / sample_rate + 2;
+
+  fm->occ_raw = malloc((long) fm->num_blocks * fm->block_bytes +
+                       FM_CACHE_LINE);
+  fm->marks = malloc(num_words * sizeof(unsigned int));
+  fm->mark_ranks = malloc(num_words * sizeof(int));
+  fm->samples = malloc(num_samples * sizeof(int));
+  if (fm->occ_raw == NULL || fm->marks == NULL || fm->mark_ranks == NULL ||
+      fm->samples == NULL) {
+    sary_fm_free(fm);
+    return NULL;
+  }
+  fm->occ = fm->occ_raw + (FM_CACHE_LINE -
+                           (unsigned long) fm->occ_raw % FM_CACHE_LINE);
+
+  fm->mem_bytes = (long) fm->num_blocks * fm->block_bytes +
+                  num_words * (sizeof(unsigned int) + sizeof(int)) +
+                  num_samples * sizeof(int);
+
+  /*
+   * Fill in the BWT blocks.  Row 0 is the sentinel suffix (M+1), and
+   * row r > 0 is the suffix Pos[r].  The BWT character of a row is the
+   * one preceding its suffix, or the sentinel for the suffix at 1.
+   */
+  memset(fm->marks, 0, num_words * sizeof(unsigned int));
+  memset(freq, 0, 256 * sizeof(int));
+  for (r=0; r <= M; r++) {
+    b = r / fm->block_chars;
+    if (r % fm->block_chars == 0) {
+      counts = FM_COUNTS(fm, b);
+      for (c=1; c < fm->sigma; c++)
+        counts[c-1] = freq[c];
+    }
+
+    p = (r == 0 ? M + 1 : (int) sary_entry_get(Pos, width, r));
+    c = (p == 1 ? 0 : fm->code[(unsigned char) T[p-2]]);
+    FM_CHARS(fm, b)[r % fm->block_chars] = c;
+    freq[c]++;
+
+    if ((p - 1) % sample_rate == 0)
+      fm->marks[r >> 5] |= 1U << (r & 31);
+  }
+  if ((M + 1) % fm->block_chars == 0) {
+    counts = FM_COUNTS(fm, (M + 1) / fm->block_chars);
+    for (c=1; c < fm->sigma; c++)
+      counts[c-1] = freq[c];
+  }
+
+  /*
+   * Rank the marked rows and store their suffix array values.
+   */
+  for (v=0, r=0; r < num_words; r++) {
+    fm->mark_ranks[r] = v;
+    v += fm_popcount(fm->marks[r]);
+  }
+  for (r=0; r <= M; r++)
+    if (FM_MARKED(fm, r))
+      fm->samples[fm_mark_rank(fm, r)] =
+        (r == 0 ? M + 1 : (int) sary_entry_get(Pos, width, r));
+
+  return fm;
+}
+
+
+/*
+ * sary_fm_count
+ *
+ * Backward search for the rows of the suffixes beginning with the
+ * pattern.  The rows are left in fm->sp..fm->ep-1.
+ *
+ * Parameters:   fm  -  the FM-index
+ *               P   -  the pattern
+ *               N   -  the pattern length
+ *
+ * Returns:  the number of occurrences of the pattern in the text.
+ */
+int sary_fm_count(SARY_FM *fm, char *P, int N)
+{
+  int i, c, sp, ep;
+
+  sp = 0;
+  ep = fm->M + 1;
+  for (i=N-1; i >= 0 && sp < ep; i--) {
+    if ((c = fm->code[(unsigned char) P[i]]) == 0) {
+      sp = ep = 0;
+      break;
+    }
+
+    sp = fm->C[c] + fm_rank(fm, c, sp);
+    ep = fm->C[c] + fm_rank(fm, c, ep);
+  }
+
+  if (N <= 0)
+    sp = 1;             /* Skip the sentinel row */
+  else if (sp > ep)
+    sp = ep;
+
+  fm->sp = fm->i = sp;
+  fm->ep = ep;
+
+  return ep - sp;
+}
+
+
+/*
+ * sary_fm_locate
+ *
+ * Computes the suffix array value of a row, by LF-stepping backwards
+ * through the text to the nearest sampled position.
+ *
+ * Parameters:   fm   -  the FM-index
+ *               row  -  the row (0..M)
+ *
+ * Returns:  the text position (1..M+1) of the row's suffix.
+ */
+int sary_fm_locate(SARY_FM *fm, int row)
+{
+  int c, steps;
+
+  steps = 0;
+  while (!FM_MARKED(fm, row)) {
+    c = FM_BWT(fm, row);
+    row = fm->C[c] + fm_rank(fm, c, row);
+    steps++;
+  }
+#ifdef STATS
+  fm->num_lf_steps += steps;
+#endif
+
+  return fm->samples[fm_mark_rank(fm, row)] + steps;
+}
+
+
+/*
+ * sary_fm_first, sary_fm_next
+ *
+ * Find the matches of a pattern using the FM-index.  As with the other
+ * suffix array matchers, the matches come out in suffix array order.
+ *
+ * Parameters:   fm  -  the FM-index
+ *               P   -  the pattern
+ *               N   -  the pattern length
+ *
+ * Returns:  The location of a match in the text, or NULL.
+ */
+char *sary_fm_first(SARY_FM *fm, char *P, int N)
+{
+  sary_fm_count(fm, P, N);
+
+  return sary_fm_next(fm);
+}
+
+char *sary_fm_next(SARY_FM *fm)
+{
+  if (fm->i >= fm->ep)
+    return NULL;
+
+  return &fm->T[sary_fm_locate(fm, fm->i++) - 1];
+}
+
+
+/*
+ * sary_fm_free
+ *
+ * Free up a SARY_FM structure.
+ *
+ * Parameters:  fm  -  a SARY_FM structure
+ *
+ * Returns:  nothing.
+ */
+void sary_fm_free(SARY_FM *fm)
+{
+  if (fm == NULL)
+    return;
+
+  if (fm->occ_raw != NULL)
+    free(fm->occ_raw);
+  if (fm->marks != NULL)
+    free(fm->marks);
+  if (fm->mark_ranks != NULL)
+    free(fm->mark_ranks);
+  if (fm->samples != NULL)
+    free(fm->samples);
+
+  free(fm);
+}
+
+
+/*
+ * fm_rank
+ *
+ * The number of occurrences of code c (other than the sentinel) in the
+ * BWT rows 0..r-1.
+ */
+static int fm_rank(SARY_FM *fm, int c, int r)
+{
+  int b, k, n, count;
+  unsigned char *s;
+
+#ifdef STATS
+  fm->num_rank_ops++;
+#endif
+
+  b = r / fm->block_chars;
+  n = r % fm->block_chars;
+  count = FM_COUNTS(fm, b)[c-1];
+  s = FM_CHARS(fm, b);
+  for (k=0; k < n; k++)
+    count += (s[k] == c);
+
+  return count;
+}
+
+
+/*
+ * fm_mark_rank
+ *
+ * The number of marked rows before row r.
+ */
+static int fm_mark_rank(SARY_FM *fm, int r)
+{
+  return fm->mark_ranks[r >> 5] +
+         fm_popcount(fm->marks[r >> 5] & ((1U << (r & 31)) - 1));
+}
+
+static int fm_popcount(unsigned int x)
+{
+  int count;
+
+  for (count=0; x != 0; count++)
+    x &= x - 1;
+
+  return count;
+}
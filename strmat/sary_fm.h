@@ -0,0 +1,35 @@
+
+#ifndef _SARY_FM_H_
+#define _SARY_FM_H_
+
+#include "sary_pack.h"
+
+#define SARY_FM_SAMPLE_RATE 32
+
+typedef struct {
+  char *T;
+  int M, sigma, sample_rate;
+
+  int code[256], C[257];
+
+  unsigned char *occ, *occ_raw;
+  int block_chars, block_bytes, num_blocks;
+
+  unsigned int *marks;
+  int *mark_ranks, *samples;
+
+  int sp, ep, i;
+
+  long mem_bytes;
+  int num_rank_ops, num_lf_steps;
+} SARY_FM;
+
+SARY_FM *sary_fm_prep(char *T, int M, int sample_rate);
+SARY_FM *sary_fm_prep_packed(SARY_PACKED *sa, int sample_rate);
+int sary_fm_count(SARY_FM *fm, char *P, int N);
+int sary_fm_locate(SARY_FM *fm, int row);
+char *sary_fm_first(SARY_FM *fm, char *P, int N);
+char *sary_fm_next(SARY_FM *fm);
+void sary_fm_free(SARY_FM *fm);
+
+#endif
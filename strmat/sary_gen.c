@@ -0,0 +1,205 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strmat.h"
+#include "sary_match.h"
+#include "sary_gen.h"
+
+
+/*
+ * sary_gen_build
+ *
+ * Build a generalized suffix array over a set of strings.  The strings
+ * are concatenated, with a separator character (SARY_GEN_SEPARATOR)
+ * between each pair, and the suffix array and mlr search structures
+ * are built over that text.  Each row of the suffix array is then
+ * labelled with the identifier of the string holding its suffix, so
+ * that matches can be reported as (string, position) pairs.
+ *
+ * Since no pattern contains the separator, no match can span two
+ * strings, and the suffixes need not be ordered past a separator.
+ * That only holds if no string contains the separator either (raw
+ * text and binary sequences can), so such strings are rejected.
+ *
+ * Parameters:   strings      -  the strings
+ *               num_strings  -  the number of strings
+ *
+ * Returns:  the generalized suffix array, or NULL on an error or if
+ *           a string contains the separator.
+ */
+SARY_GEN *sary_gen_build(STRING **strings, int num_strings)
+{
+  int i, id, M, *owner;
+  char *S;
+  SARY_GEN *gen;
+
+  if (strings == NULL || num_strings <= 0)
+    return NULL;
+
+  M = num_strings - 1;
+  for (id=0; id < num_strings; id++) {
+    if (strings[id] == NULL || strings[id]->sequence == NULL ||
+        sary_gen_has_separator(strings[id]))
+      return NULL;
+    M += strings[id]->length;
+  }
+  if (M == 0)
+    return NULL;
+
+  if ((gen = malloc(sizeof(SARY_GEN))) == NULL)
+    return NULL;
+  memset(gen, 0, sizeof(SARY_GEN));
+
+  gen->M = M;
+  gen->num_strings = num_strings;
+
+  if ((gen->S = malloc(M + 2)) == NULL ||
+      (gen->starts = malloc((num_strings + 2) * sizeof(int))) == NULL ||
+      (gen->docs = malloc((M + 1) * sizeof(int))) == NULL ||
+      (owner = malloc((M + 1) * sizeof(int))) == NULL) {
+    sary_gen_free(gen);
+    return NULL;
+  }
+
+  /*
+   * Concatenate the strings as S[1],...,S[M], remembering where each
+   * one starts and which string holds each position (0 for the
+   * separators).
+   */
+  S = gen->S;
+  S[0] = S[M+1] = '\0';
+  for (i=1,id=1; id <= num_strings; id++) {
+    gen->starts[id] = i;
+    memcpy(S + i, strings[id-1]->sequence, strings[id-1]->length);
+    for ( ; i < gen->starts[id] + strings[id-1]->length; i++)
+      owner[i] = id;
+
+    if (id < num_strings) {
+      S[i] = SARY_GEN_SEPARATOR;
+      owner[i++] = 0;
+    }
+  }
+  gen->starts[num_strings+1] = M + 2;
+
+  if ((gen->smstruct = sary_match_mlr_prep(S + 1, M, 0)) == NULL) {
+    free(owner);
+    sary_gen_free(gen);
+    return NULL;
+  }
+
+  for (i=1; i <= M; i++)
+    gen->docs[i] = owner[gen->smstruct->sary->Pos[i]];
+  free(owner);
+
+  gen->i = M + 1;
+  gen->iprime = M;
+
+  return gen;
+}
+
+
+/*
+ * sary_gen_has_separator
+ *
+ * Check whether a string contains the separator character, and so
+ * cannot be put into a generalized suffix array.
+ *
+ * Parameters:   string  -  the string
+ *
+ * Returns:  non-zero if the string contains the separator.
+ */
+int sary_gen_has_separator(STRING *string)
+{
+  return (string->length > 0 &&
+          memchr(string->sequence, SARY_GEN_SEPARATOR,
+                 string->length) != NULL);
+}
+
+
+/*
+ * sary_gen_interval
+ *
+ * Find the rows of the generalized suffix array whose suffixes begin
+ * with the pattern.
+ *
+ * Parameters:   gen     -  the generalized suffix array
+ *               P       -  the pattern
+ *               N       -  the pattern's length
+ *               lo, hi  -  where to store the interval (lo > hi when
+ *                          there are no matches)
+ *
+ * Returns:  the number of matches.
+ */
+int sary_gen_interval(SARY_GEN *gen, char *P, int N, int *lo, int *hi)
+{
+  if (N <= 0 || memchr(P, SARY_GEN_SEPARATOR, N) != NULL) {
+    *lo = 1;
+    *hi = 0;
+    return 0;
+  }
+
+  return sary_match_interval(gen->smstruct, P, N, lo, hi);
+}
+
+
+/*
+ * sary_gen_first, sary_gen_next
+ *
+ * Return the matches of a pattern, one at a time, as the identifier
+ * of the string containing the match (1 to num_strings) and the
+ * match's position in that string (1 to its length).
+ *
+ * Note:  The matches are returned in suffix array order, not in the
+ *        order they appear in the strings.
+ *
+ * Parameters:   gen      -  the generalized suffix array
+ *               P        -  the pattern
+ *               N        -  the pattern's length
+ *               id, pos  -  where to store the match
+ *
+ * Returns:  non-zero if a match was found, zero otherwise.
+ */
+int sary_gen_first(SARY_GEN *gen, char *P, int N, int *id, int *pos)
+{
+  sary_gen_interval(gen, P, N, &gen->i, &gen->iprime);
+  return sary_gen_next(gen, id, pos);
+}
+
+int sary_gen_next(SARY_GEN *gen, int *id, int *pos)
+{
+  if (gen->i > gen->iprime)
+    return 0;
+
+  *id = gen->docs[gen->i];
+  *pos = gen->smstruct->sary->Pos[gen->i] - gen->starts[*id] + 1;
+  gen->i++;
+
+  return 1;
+}
+
+
+/*
+ * sary_gen_free
+ *
+ * Free a generalized suffix array.
+ *
+ * Parameters:   gen  -  the generalized suffix array
+ *
+ * Returns:  nothing.
+ */
+void sary_gen_free(SARY_GEN *gen)
+{
+  if (gen == NULL)
+    return;
+
+  if (gen->smstruct != NULL)
+    sary_match_free(gen->smstruct);
+  if (gen->S != NULL)
+    free(gen->S);
+  if (gen->starts != NULL)
+    free(gen->starts);
+  if (gen->docs != NULL)
+    free(gen->docs);
+  free(gen);
+}
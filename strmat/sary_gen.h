@@ -0,0 +1,27 @@
+
+#ifndef _SARY_GEN_H_
+#define _SARY_GEN_H_
+
+#include "strmat.h"
+#include "sary_match.h"
+
+#define SARY_GEN_SEPARATOR ((char) -1)
+
+typedef struct {
+  SARYMAT_STRUCT *smstruct;
+  char *S;
+  int M, num_strings;
+
+  int *starts, *docs;
+
+  int i, iprime;
+} SARY_GEN;
+
+SARY_GEN *sary_gen_build(STRING **strings, int num_strings);
+int sary_gen_has_separator(STRING *string);
+int sary_gen_interval(SARY_GEN *gen, char *P, int N, int *lo, int *hi);
+int sary_gen_first(SARY_GEN *gen, char *P, int N, int *id, int *pos);
+int sary_gen_next(SARY_GEN *gen, int *id, int *pos);
+void sary_gen_free(SARY_GEN *gen);
+
+#endif
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sary.h"
+#include "sary_lce.h"
+#include "sary_cmp.h"
+
+
+/*
+ * sary_lce_prep
+ *
+ * Preprocessing for longest common extension queries, i.e., the length
+ * of the longest common prefix of the suffixes starting at any two
+ * positions of the string, using the suffix array instead of the LCA
+ * of two leaves in a suffix tree.  The lce of positions i and j is the
+ * minimum of the lcp values between their ranks in the suffix array,
+ * so the preprocessing builds the suffix array, its inverse (rank) and
+ * the lcp of each suffix with its predecessor, and then a range minimum
+ * structure over the lcp values.  The suffix array itself is not needed
+ * for the queries and is freed.
+ *
+ * There are two modes:
+ *
+ *    SARY_LCE_FULL   -  a sparse table holding the minimum of every
+ *                       range of length 2^k, which answers every query
+ *                       with two lookups, using O(M log M) space.
+ *    SARY_LCE_SMALL  -  the first SARY_LCE_DIRECT characters are compared
+ *                       directly (which answers most queries on most
+ *                       strings), and longer extensions are found with
+ *                       a sparse table over the minima of blocks of
+ *                       SARY_LCE_BLOCK lcp values, plus scans of the
+ *                       partial blocks at the ends of the range.  The
+ *                       table then takes O(M) space.
+ *
+ * Parameters:   S         -  the string
+ *               M         -  the string's length
+ *               copyflag  -  make a copy of the string?
+ *               mode      -  SARY_LCE_FULL or SARY_LCE_SMALL
+ *
+ * Returns:  An initialized SARY_LCE structure, or NULL on an error.
+ */
+static int lce_log2(int n);
+static int lce_table(SARY_LCE *lce, int *base, int n);
+static int lce_scan(SARY_LCE *lce, int lo, int hi);
+
+SARY_LCE *sary_lce_prep(char *S, int M, int copyflag, SARY_LCE_MODE mode)
+{
+  int r, b, num_blocks, end, min, *Pos, *rank, *lcp, *bmin;
+  SARY_LCE *lce;
+  SARY_STRUCT *sary;
+
+  if (S == NULL || M <= 0)
+    return NULL;
+
+  if ((lce = malloc(sizeof(SARY_LCE))) == NULL)
+    return NULL;
+  memset(lce, 0, sizeof(SARY_LCE));
+
+  lce->mode = mode;
+  lce->M = M;
+
+  if ((sary = lce->sary = sary_qsort_build(S, M, copyflag)) == NULL) {
+    free(lce);
+    return NULL;
+  }
+  lce->S = S = sary->S;
+  Pos = sary->Pos;
+
+  if ((rank = lce->rank = malloc((M + 1) * sizeof(int))) == NULL ||
+      (lcp = lce->lcp = malloc((M + 1) * sizeof(int))) == NULL) {
+    sary_lce_free(lce);
+    return NULL;
+  }
+
+  /*
+   * Compute the ranks and the lcp values (as in sary_compute_lcp, but
+   * without the lcp tree).
+   */
+  sary_kasai(S, M, Pos, rank, lcp);
+
+  free(sary->Pos);
+  sary->Pos = NULL;
+
+  lce->mem_bytes = (copyflag ? M + 2 : 0) + 2 * (M + 1) * (long) sizeof(int);
+
+  /*
+   * Build the range minimum structure.
+   */
+  if (mode == SARY_LCE_FULL) {
+    if (!lce_table(lce, lcp, M + 1)) {
+      sary_lce_free(lce);
+      return NULL;
+    }
+  }
+  else {
+    num_blocks = M / SARY_LCE_BLOCK + 1;
+    if ((bmin = malloc(num_blocks * sizeof(int))) == NULL) {
+      sary_lce_free(lce);
+      return NULL;
+    }
+
+    for (b=0; b < num_blocks; b++) {
+      end = (b + 1) * SARY_LCE_BLOCK;
+      if (end > M + 1)
+        end = M + 1;
+
+      min = lcp[b * SARY_LCE_BLOCK];
+      for (r=b * SARY_LCE_BLOCK + 1; r < end; r++)
+        if (lcp[r] < min)
+          min = lcp[r];
+      bmin[b] = min;
+    }
+
+    if (!lce_table(lce, bmin, num_blocks)) {
+      if (lce->table == NULL)
+        free(bmin);
+      sary_lce_free(lce);
+      return NULL;
+    }
+  }
+
+  return lce;
+}
+
+
+/*
+ * lce_table
+ *
+ * Build the sparse table over base[0..n-1], where level k holds the
+ * minimum of base[x..x+2^k-1] in entry x.  Level 0 is the base array
+ * itself (which becomes owned by the table in the small mode).
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+static int lce_table(SARY_LCE *lce, int *base, int n)
+{
+  int k, x, half, size, *prev, *cur;
+
+  lce->levels = lce_log2(n) + 1;
+  if ((lce->table = malloc(lce->levels * sizeof(int *))) == NULL)
+    return 0;
+  memset(lce->table, 0, lce->levels * sizeof(int *));
+
+  lce->table[0] = base;
+  if (base != lce->lcp)
+    lce->mem_bytes += n * (long) sizeof(int);
+
+  for (k=1; k < lce->levels; k++) {
+    half = 1 << (k - 1);
+    size = n - 2 * half + 1;
+    if ((cur = lce->table[k] = malloc(size * sizeof(int))) == NULL)
+      return 0;
+    lce->mem_bytes += size * (long) sizeof(int);
+
+    prev = lce->table[k-1];
+    for (x=0; x + 2 * half <= n; x++)
+      cur[x] = (prev[x] <= prev[x+half] ? prev[x] : prev[x+half]);
+  }
+
+  return 1;
+}
+
+
+/*
+ * sary_lce
+ *
+ * Compute the longest common extension of two positions, i.e., the
+ * length of the longest common prefix of the suffixes S[i..M] and
+ * S[j..M].
+ *
+ * Parameters:   lce  -  a preprocessed string
+ *               i    -  the first position (1..M)
+ *               j    -  the second position (1..M)
+ *
+ * Returns:  the length of the extension, or 0 if i or j is out of range.
+ */
+int sary_lce(SARY_LCE *lce, int i, int j)
+{
+  int n, len, lo, hi, k, blo, bhi, min, value, **table;
+
+  if (lce == NULL || i < 1 || j < 1 || i > lce->M || j > lce->M)
+    return 0;
+
+#ifdef STATS
+  lce->num_queries++;
+#endif
+
+  if (i == j)
+    return lce->M - i + 1;
+
+  /*
+   * In the small footprint mode, try the direct comparison first.
+   */
+  if (lce->mode == SARY_LCE_SMALL) {
+    n = lce->M - (i > j ? i : j) + 1;
+    if (n > SARY_LCE_DIRECT)
+      n = SARY_LCE_DIRECT;
+
+    len = sary_cmp_length(&lce->S[i], &lce->S[j], n);
+#ifdef STATS
+    lce->num_compares += len + 1;
+#endif
+    if (len < SARY_LCE_DIRECT) {
+#ifdef STATS
+      lce->num_direct++;
+#endif
+      return len;
+    }
+  }
+
+  lo = lce->rank[i];
+  hi = lce->rank[j];
+  if (lo > hi) {
+    k = lo;
+    lo = hi;
+    hi = k;
+  }
+  lo++;
+
+  table = lce->table;
+  if (lce->mode == SARY_LCE_FULL) {
+    k = lce_log2(hi - lo + 1);
+    value = table[k][hi-(1<<k)+1];
+    return (table[k][lo] <= value ? table[k][lo] : value);
+  }
+
+  /*
+   * The small footprint mode:  scan the partial blocks at the ends of
+   * the range, and use the table for the blocks in between.
+   */
+  blo = lo / SARY_LCE_BLOCK;
+  bhi = hi / SARY_LCE_BLOCK;
+  if (bhi - blo <= 1)
+    return lce_scan(lce, lo, hi);
+
+  min = lce_scan(lce, lo, (blo + 1) * SARY_LCE_BLOCK - 1);
+  value = lce_scan(lce, bhi * SARY_LCE_BLOCK, hi);
+  if (value < min)
+    min = value;
+
+  blo++;
+  bhi--;
+  k = lce_log2(bhi - blo + 1);
+  value = table[k][blo];
+  if (table[k][bhi-(1<<k)+1] < value)
+    value = table[k][bhi-(1<<k)+1];
+
+  return (value < min ? value : min);
+}
+
+
+/*
+ * lce_scan
+ *
+ * The minimum of lcp[lo..hi], by a scan.
+ */
+static int lce_scan(SARY_LCE *lce, int lo, int hi)
+{
+  int r, min, *lcp;
+
+  lcp = lce->lcp;
+  min = lcp[lo];
+  for (r=lo+1; r <= hi; r++)
+    if (lcp[r] < min)
+      min = lcp[r];
+
+#ifdef STATS
+  lce->num_compares += hi - lo + 1;
+#endif
+
+  return min;
+}
+
+
+/*
+ * lce_log2
+ *
+ * The floor of log2(n), for n > 0.
+ */
+static int lce_log2(int n)
+{
+#ifdef __GNUC__
+  return 31 - __builtin_clz((unsigned int) n);
+#else
+  int k;
+
+  for (k=0; n > 1; k++)
+    n >>= 1;
+  return k;
+#endif
+}
+
+
+/*
+ * sary_lce_free
+ *
+ * Free up a SARY_LCE structure.
+ */
+void sary_lce_free(SARY_LCE *lce)
+{
+  int k;
+
+  if (lce->table != NULL) {
+    for (k=(lce->mode == SARY_LCE_FULL ? 1 : 0); k < lce->levels; k++)
+      if (lce->table[k] != NULL)
+        free(lce->table[k]);
+    free(lce->table);
+  }
+  if (lce->lcp != NULL)
+    free(lce->lcp);
+  if (lce->rank != NULL)
+    free(lce->rank);
+  if (lce->sary != NULL)
+    sary_free(lce->sary);
+
+  free(lce);
+}
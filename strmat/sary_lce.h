@@ -0,0 +1,31 @@
+
+#ifndef _SARY_LCE_H_
+#define _SARY_LCE_H_
+
+#include "sary.h"
+
+#define SARY_LCE_BLOCK 32
+#define SARY_LCE_DIRECT 32
+
+typedef enum { SARY_LCE_FULL, SARY_LCE_SMALL } SARY_LCE_MODE;
+
+typedef struct {
+  SARY_LCE_MODE mode;
+
+  SARY_STRUCT *sary;
+  char *S;
+  int M;
+
+  int *rank, *lcp;      /* the inverse suffix array and the lcp values */
+  int **table, levels;  /* the sparse table (over the block minima in the
+                           small footprint mode) */
+  long mem_bytes;
+
+  int num_queries, num_direct, num_compares;
+} SARY_LCE;
+
+SARY_LCE *sary_lce_prep(char *S, int M, int copyflag, SARY_LCE_MODE mode);
+int sary_lce(SARY_LCE *lce, int i, int j);
+void sary_lce_free(SARY_LCE *lce);
+
+#endif
@@ -2,7 +2,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "sary_match.h"
+#include "sary_file.h"
+#include "sary_cmp.h"
 
 
 /*
@@ -19,6 +27,14 @@
  */
 static SARYMAT_STRUCT *int_sary_match_prep(char *T, int M, int copyflag,
                                            SARY_MATCH_TYPE type);
+static char *mlr_search(SARYMAT_STRUCT *smstruct, char *P, int N,
+                        int lo, int hi, int start, int last);
+static int match_extend(SARYMAT_STRUCT *smstruct, char *P, int N, int pos,
+                        int k);
+static int kmer_range(SARYMAT_STRUCT *smstruct, char *P, int N,
+                      int *lo, int *hi);
+static int kmer_matches(SARYMAT_STRUCT *smstruct, char *P, int N, int row);
+static char *kmer_result(SARYMAT_STRUCT *smstruct, int lo, int hi);
 
 SARYMAT_STRUCT *sary_match_naive_prep(char *T, int M, int copyflag)
 {  return int_sary_match_prep(T, M, copyflag, NAIVE_MATCH);  }
@@ -62,21 +78,18 @@ static SARYMAT_STRUCT *int_sary_match_prep(char *T, int M, int copyflag,
   /*
    * Create the suffix array.
    */
-  switch (type) {
-  case NAIVE_MATCH:
-  case MLR_MATCH:
-    if ((node->sary = sary_qsort_build(T+1, M, 0)) == NULL) {
-      sary_match_free(node);
-      return NULL;
-    }
-    break;
+  if ((node->sary = sary_qsort_build(T+1, M, 0)) == NULL) {
+    sary_match_free(node);
+    return NULL;
+  }
 
-  case LCP_MATCH:
-    if ((node->sary = sary_stree_build(T+1, M, 0)) == NULL) {
-      sary_match_free(node);
-      return NULL;
-    }
-    break;
+  /*
+   * The lcp super-accelerant also needs the lcp values, which are
+   * computed directly from the suffix array (no suffix tree needed).
+   */
+  if (type == LCP_MATCH && !sary_compute_lcp(node->sary)) {
+    sary_match_free(node);
+    return NULL;
   }
 
   return node;
@@ -100,7 +113,7 @@ static SARYMAT_STRUCT *int_sary_match_prep(char *T, int M, int copyflag,
  */
 char *sary_match_naive_first(SARYMAT_STRUCT *smstruct, char *P, int N)
 {
-  int k, L, R, midpoint, matchpos, pos, M, *Pos;
+  int k, L, R, lo, hi, start, midpoint, matchpos, pos, M, *Pos;
   char *T;
 
   P--;            /* Shift to make sequence be P[1],...,P[N] */
@@ -109,6 +122,20 @@ char *sary_match_naive_first(SARYMAT_STRUCT *smstruct, char *P, int N)
   M = smstruct->M;
   Pos = smstruct->sary->Pos;
 
+  /*
+   * Narrow the search to the suffixes starting with the pattern's first
+   * k characters, if there is a k-mer table (or just look up the
+   * matches, for patterns of length k or less).
+   */
+  lo = 1;
+  hi = M;
+  start = 0;
+  if (kmer_range(smstruct, P, N, &lo, &hi)) {
+    if (N <= smstruct->kmer_k || lo > hi)
+      return kmer_result(smstruct, lo, hi);
+    start = smstruct->kmer_k;
+  }
+
   /*
    * Perform a binary search to find the smallest position of a match
    * in the suffix array.
@@ -118,22 +145,18 @@ char *sary_match_naive_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    * is strictly less than the pattern and everything from R+1 up is 
    * greater than or equal to the pattern).
    */
-  L = 1;
-  R = M;
+  L = lo;
+  R = hi;
   while (L <= R) {
     midpoint = (L + R) / 2;
     pos = Pos[midpoint];
 
 #ifdef STATS
     smstruct->search_depth++;
-
-    for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-      smstruct->num_compares++;
-    smstruct->num_compares++;
-#else
-    for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
 #endif
 
+    k = match_extend(smstruct, P, N, pos, start);
+
     if (1 + k > N && pos + k > M)
       R = midpoint - 1;
     else if (1 + k > N && pos + k <= M)
@@ -152,20 +175,14 @@ char *sary_match_naive_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    */
   smstruct->i = R+1;
 
-  if (R == M) {
+  if (R == hi) {
     smstruct->iprime = R;
     return NULL;
   }
 
   pos = Pos[R+1];
 
-#ifdef STATS
-  for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, pos, start);
 
   if (k < N) {
     smstruct->iprime = R;
@@ -186,19 +203,13 @@ char *sary_match_naive_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    *        (regardless of what comes after).  That's why this search
    *        is not symmetrical with the search above.
    */
-  L = 1;
-  R = M;
+  L = lo;
+  R = hi;
   while (L <= R) {
     midpoint = (L + R) / 2;
     pos = Pos[midpoint];
 
-#ifdef STATS
-    for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-      smstruct->num_compares++;
-    smstruct->num_compares++;
-#else
-    for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
-#endif
+    k = match_extend(smstruct, P, N, pos, start);
 
     if (1 + k > N && pos + k > M)
       L = midpoint + 1;
@@ -261,31 +272,65 @@ char *sary_match_naive_next(SARYMAT_STRUCT *smstruct)
  * Returns:  The location of a match to the pattern, or NULL.
  */
 char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
+{
+  int lo, hi, start;
+
+  P--;            /* Shift to make sequence be P[1],...,P[N] */
+
+  /*
+   * Narrow the search to the suffixes starting with the pattern's first
+   * k characters, if there is a k-mer table (or just look up the
+   * matches, for patterns of length k or less).
+   */
+  lo = 1;
+  hi = smstruct->M;
+  start = 0;
+  if (kmer_range(smstruct, P, N, &lo, &hi)) {
+    if (N <= smstruct->kmer_k || lo > hi)
+      return kmer_result(smstruct, lo, hi);
+    start = smstruct->kmer_k;
+  }
+
+  return mlr_search(smstruct, P, N, lo, hi, start, 1);
+}
+
+
+/*
+ * mlr_search
+ *
+ * The binary searches of sary_match_mlr_first, over the suffix array
+ * rows lo..hi, whose suffixes are known to match the first start
+ * characters of the pattern.  When last is zero, only the first match
+ * is searched for.
+ *
+ * Parameters:   smstruct  -  the preprocessed text
+ *               P         -  the pattern (as P[1],...,P[N])
+ *               N         -  the pattern's length
+ *               lo, hi    -  the rows to search
+ *               start     -  the known common prefix length
+ *               last      -  whether to find the last match as well
+ *
+ * Returns:  The location of a match to the pattern, or NULL.
+ */
+static char *mlr_search(SARYMAT_STRUCT *smstruct, char *P, int N,
+                        int lo, int hi, int start, int last)
 {
   int k, L, R, l, r, mlr, l_init, r_init, midpoint, matchpos, pos, M, *Pos;
   char *T;
 
-  P--;            /* Shift to make sequence be P[1],...,P[N] */
-  
   T = smstruct->T;
   M = smstruct->M;
   Pos = smstruct->sary->Pos;
 
   /*
    * Compute the initial value of l (by finding the longest common
-   * prefix between the pattern and Pos[1]).
+   * prefix between the pattern and Pos[lo]).
    *
    * And check to see if the pattern is smaller than all of the suffixes.
    */
-#ifdef STATS
-  for (k=0; 1 + k <= N && Pos[1] + k <= M && P[1+k] == T[Pos[1]+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && Pos[1] + k <= M && P[1+k] == T[Pos[1]+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, Pos[lo], start);
 
-  if (1 + k <= N && Pos[1] + k <= M && P[1+k] < T[Pos[1]+k]) {
+  if (1 + k <= N && Pos[lo] + k <= M && P[1+k] < T[Pos[lo]+k]) {
     smstruct->i = 1;
     smstruct->iprime = 0;
     return NULL;
@@ -295,19 +340,13 @@ char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
 
   /*
    * Compute the initial value of r (by finding the longest common
-   * prefix between the pattern and Pos[M]).
+   * prefix between the pattern and Pos[hi]).
    *
    * And check to see if the pattern is larger than all of the suffixes.
    */
-#ifdef STATS
-  for (k=0; 1 + k <= N && Pos[M] + k <= M && P[1+k] == T[Pos[M]+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && Pos[M] + k <= M && P[1+k] == T[Pos[M]+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, Pos[hi], start);
 
-  if (1 + k <= N && (Pos[M] + k > M || P[1+k] > T[Pos[M]+k])) {
+  if (1 + k <= N && (Pos[hi] + k > M || P[1+k] > T[Pos[hi]+k])) {
     smstruct->i = 1;
     smstruct->iprime = 0;
     return NULL;
@@ -323,13 +362,13 @@ char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    * Otherwise, initialize L, R, l and r for the binary search.
    */
   if (1 + l_init > N) {
-    L = 0;
-    R = 1;
+    L = lo - 1;
+    R = lo;
     l = r = 0;
   }
   else {
-    L = 1;
-    R = M;
+    L = lo;
+    R = hi;
     l = l_init;
     r = r_init;
   }
@@ -351,14 +390,10 @@ char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
 
 #ifdef STATS
     smstruct->search_depth++;
-
-    for (k=mlr; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-      smstruct->num_compares++;
-    smstruct->num_compares++;
-#else
-    for (k=mlr; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
 #endif
 
+    k = match_extend(smstruct, P, N, pos, mlr);
+
     if (1 + k > N && pos + k > M)
       R = midpoint;
     else if (1 + k > N && pos + k <= M)
@@ -382,18 +417,17 @@ char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
   smstruct->i = R;
   pos = Pos[R];
 
-#ifdef STATS
-  for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, pos, start);
 
   if (k < N) {
     smstruct->iprime = R - 1;
     return NULL;
   }
+  else if (!last) {
+    smstruct->iprime = M;
+    matchpos = Pos[smstruct->i++];
+    return &T[matchpos];
+  }
 
   /*
    * Now that we know that matches exist, perform a second binary search
@@ -410,14 +444,14 @@ char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    *        is not symmetrical with the search above.
    */
   if (1 + r_init > N) {
-    L = M;
-    R = M + 1;
+    L = hi;
+    R = hi + 1;
     l = r = 0;
   }
   else {
-    L = 1;
+    L = lo;
     l = l_init;
-    R = M;
+    R = hi;
     r = r_init;
   }
 
@@ -427,13 +461,7 @@ char *sary_match_mlr_first(SARYMAT_STRUCT *smstruct, char *P, int N)
 
     mlr = (l < r ? l : r);
 
-#ifdef STATS
-    for (k=mlr; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-      smstruct->num_compares++;
-    smstruct->num_compares++;
-#else
-    for (k=mlr; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
-#endif
+    k = match_extend(smstruct, P, N, pos, mlr);
 
     if (1 + k > N && pos + k > M)
       L = midpoint;
@@ -503,7 +531,7 @@ char *sary_match_mlr_next(SARYMAT_STRUCT *smstruct)
 char *sary_match_lcp_first(SARYMAT_STRUCT *smstruct, char *P, int N)
 {
   int k, L, R, l, r, mlr, l_init, r_init, midpoint;
-  int M, L_to_M, M_to_R, *Lcp, pos, *Pos, matchpos;
+  int M, L_to_M, M_to_R, *Lcp, pos, *Pos, matchpos, lo, hi;
   char *T;
 
   P--;            /* Shift to make sequence be P[1],...,P[N] */
@@ -518,19 +546,28 @@ char *sary_match_lcp_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    */
   smstruct->N = N;
 
+  /*
+   * With a k-mer table, just look up the matches for patterns of length
+   * k or less.  Otherwise, search the rows starting with the pattern's
+   * first k characters.  The lcp tree is laid out for the search of the
+   * whole array, so that search uses the mlr accelerant (the rows are
+   * few, and sary_match_lcp_next still finds the remaining matches).
+   */
+  lo = 1;
+  hi = M;
+  if (kmer_range(smstruct, P, N, &lo, &hi)) {
+    if (N <= smstruct->kmer_k || lo > hi)
+      return kmer_result(smstruct, lo, hi);
+    return mlr_search(smstruct, P, N, lo, hi, smstruct->kmer_k, 0);
+  }
+
   /*
    * Compute the initial value of l (by finding the longest common
    * prefix between the pattern and Pos[1]).
    *
    * And check to see if the pattern is smaller than all of the suffixes.
    */
-#ifdef STATS
-  for (k=0; 1 + k <= N && Pos[1] + k <= M && P[1+k] == T[Pos[1]+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && Pos[1] + k <= M && P[1+k] == T[Pos[1]+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, Pos[1], 0);
 
   if (1 + k > N) {
     smstruct->i = 2;
@@ -551,13 +588,7 @@ char *sary_match_lcp_first(SARYMAT_STRUCT *smstruct, char *P, int N)
    *
    * And check to see if the pattern is larger than all of the suffixes.
    */
-#ifdef STATS
-  for (k=0; 1 + k <= N && Pos[M] + k <= M && P[1+k] == T[Pos[M]+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && Pos[M] + k <= M && P[1+k] == T[Pos[M]+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, Pos[M], 0);
 
   if (1 + k <= N && (Pos[M] + k > M || P[1+k] > T[Pos[M]+k])) {
     smstruct->i = 1;
@@ -616,13 +647,7 @@ char *sary_match_lcp_first(SARYMAT_STRUCT *smstruct, char *P, int N)
        */
       mlr = (l >= r ? l : r);
 
-#ifdef STATS
-      for (k=mlr; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-        smstruct->num_compares++;
-      smstruct->num_compares++;
-#else
-      for (k=mlr; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
-#endif
+      k = match_extend(smstruct, P, N, pos, mlr);
 
       if (1 + k > N && pos + k > M)
         R = midpoint;
@@ -665,13 +690,7 @@ char *sary_match_lcp_first(SARYMAT_STRUCT *smstruct, char *P, int N)
   smstruct->i = R;
   pos = Pos[R];
 
-#ifdef STATS
-  for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++)
-    smstruct->num_compares++;
-  smstruct->num_compares++;
-#else
-  for (k=0; 1 + k <= N && pos + k <= M && P[1+k] == T[pos+k]; k++) ;
-#endif
+  k = match_extend(smstruct, P, N, pos, 0);
 
   if (k < N) {
     smstruct->iprime = R - 1;
@@ -722,6 +741,987 @@ char *sary_match_lcp_next(SARYMAT_STRUCT *smstruct)
 }
 
 
+/*
+ * sary_match_interval
+ *
+ * Find the rows of the suffix array whose suffixes begin with the
+ * pattern, without walking through the matches.  The number of
+ * matches is just the width of that interval.
+ *
+ * The naive binary search is used for a text preprocessed for the naive
+ * algorithm, and the mlr accelerated search is used otherwise (the lcp
+ * super-accelerant only finds the first row of the interval).
+ *
+ * Note:  The sary_match_*_next procedures return NULL after this call.
+ *
+ * Parameters:   smstruct  -  the preprocessed text
+ *               P         -  the pattern
+ *               N         -  the pattern's length
+ *               lo, hi    -  where to store the interval (lo > hi
+ *                            when there are no matches)
+ *
+ * Returns:  the number of matches.
+ */
+int sary_match_interval(SARYMAT_STRUCT *smstruct, char *P, int N,
+                        int *lo, int *hi)
+{
+  char *s;
+
+  if (smstruct->type == NAIVE_MATCH)
+    s = sary_match_naive_first(smstruct, P, N);
+  else
+    s = sary_match_mlr_first(smstruct, P, N);
+
+  if (s == NULL) {
+    *lo = 1;
+    *hi = 0;
+  }
+  else {
+    *lo = smstruct->i - 1;
+    *hi = smstruct->iprime;
+  }
+
+  smstruct->i = smstruct->M + 1;
+  smstruct->iprime = smstruct->M;
+
+  return *hi - *lo + 1;
+}
+
+
+/*
+ * sary_match_locate
+ *
+ * Copy the text positions of the suffixes in an interval of the suffix
+ * array into an array, either in suffix array order or sorted by their
+ * position in the text.
+ *
+ * Parameters:   smstruct   -  the preprocessed text
+ *               lo, hi     -  the interval (from sary_match_interval)
+ *               positions  -  where to store the hi-lo+1 positions
+ *               sorted     -  sort the positions?
+ *
+ * Returns:  non-zero on success, zero if memory ran out while sorting.
+ */
+int sary_match_locate(SARYMAT_STRUCT *smstruct, int lo, int hi,
+                      int *positions, int sorted)
+{
+  int i, *Pos;
+
+  Pos = smstruct->sary->Pos;
+  for (i=lo; i <= hi; i++)
+    positions[i-lo] = Pos[i];
+
+  if (sorted && hi > lo)
+    return sary_match_sort_positions(positions, hi - lo + 1, smstruct->M);
+
+  return 1;
+}
+
+
+/*
+ * sary_match_leftmost
+ *
+ * Find the leftmost text position among the suffixes in an interval of
+ * the suffix array, without copying out or sorting the interval.
+ *
+ * Parameters:   smstruct  -  the preprocessed text
+ *               lo, hi    -  the interval (from sary_match_interval)
+ *
+ * Returns:  the smallest position, or 0 if the interval is empty.
+ */
+int sary_match_leftmost(SARYMAT_STRUCT *smstruct, int lo, int hi)
+{
+  int i, first, *Pos;
+
+  Pos = smstruct->sary->Pos;
+  first = 0;
+  for (i=lo; i <= hi; i++)
+    if (first == 0 || Pos[i] < first)
+      first = Pos[i];
+
+  return first;
+}
+
+
+/*
+ * sary_match_sort_positions
+ *
+ * Sort an array of text positions, using a least significant digit
+ * radix sort with 8-bit digits (only as many passes as the text length
+ * needs) or, for short arrays, an insertion sort.
+ *
+ * Parameters:   positions  -  the positions (between 1 and M)
+ *               num        -  the number of positions
+ *               M          -  the text length
+ *
+ * Returns:  non-zero on success, zero if memory ran out.
+ */
+int sary_match_sort_positions(int *positions, int num, int M)
+{
+  int i, j, value, shift, *buf, *src, *dst, *tmp, count[257];
+
+  if (num < SARY_SORT_CUTOFF) {
+    for (i=1; i < num; i++) {
+      value = positions[i];
+      for (j=i; j > 0 && positions[j-1] > value; j--)
+        positions[j] = positions[j-1];
+      positions[j] = value;
+    }
+    return 1;
+  }
+
+  if ((buf = malloc(num * sizeof(int))) == NULL)
+    return 0;
+
+  src = positions;
+  dst = buf;
+  for (shift=0; shift < 32 && (M >> shift) != 0; shift+=8) {
+    memset(count, 0, 257 * sizeof(int));
+    for (i=0; i < num; i++)
+      count[((src[i] >> shift) & 0xff) + 1]++;
+    for (i=1; i < 257; i++)
+      count[i] += count[i-1];
+    for (i=0; i < num; i++)
+      dst[count[(src[i] >> shift) & 0xff]++] = src[i];
+
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  if (src != positions)
+    memcpy(positions, src, num * sizeof(int));
+  free(buf);
+
+  return 1;
+}
+
+
+/*
+ * match_extend
+ *
+ * Compare the pattern against the suffix starting at a text position,
+ * given that their first k characters match.  The comparison is done
+ * by the word-at-a-time kernels of sary_cmp.c, and counted as the
+ * same number of compares as the character-by-character loop.
+ *
+ * Parameters:   smstruct  -  the preprocessed text
+ *               P         -  the pattern (as P[1],...,P[N])
+ *               N         -  the pattern's length
+ *               pos       -  the suffix's text position
+ *               k         -  the length of the known match
+ *
+ * Returns:  the length of the match between the pattern and suffix.
+ */
+static int match_extend(SARYMAT_STRUCT *smstruct, char *P, int N, int pos,
+                        int k)
+{
+  int n, len;
+
+  n = N - k;
+  if (smstruct->M - pos + 1 - k < n)
+    n = smstruct->M - pos + 1 - k;
+
+  len = sary_cmp_length(&P[1+k], &smstruct->T[pos+k], n);
+
+#ifdef STATS
+  smstruct->num_compares += len + 1;
+#endif
+
+  return k + len;
+}
+
+
+/*
+ * sary_match_kmer_prep
+ *
+ * Add a k-mer table to a preprocessed text, so that the searches start
+ * from the suffix array rows whose suffixes begin with the pattern's
+ * first k characters (instead of the whole array), and patterns of
+ * length k or less are looked up directly.
+ *
+ * The text must be mapped onto the characters 0..alpha_size-1 (as done
+ * by strmat_alpha.c).  The table has alpha_size^k + 1 entries, where
+ * entry c is the first row whose suffix is greater than or equal to
+ * the k-mer numbered c (reading the k-mer as a number in base
+ * alpha_size).  The only suffixes that fall between the k-mer buckets
+ * are the k-1 suffixes shorter than k, which kmer_range checks by hand.
+ *
+ * Parameters:   smstruct    -  the preprocessed text
+ *               alpha_size  -  the size of the text's alphabet
+ *               k           -  the k-mer length, or 0 to use the
+ *                              largest k with alpha_size^k entries at
+ *                              most min(M, SARY_KMER_MAX_ENTRIES)
+ *
+ * Returns:  non-zero on success, zero if the text is not mapped onto
+ *           0..alpha_size-1, the table would be too large, or memory
+ *           ran out.
+ */
+int sary_match_kmer_prep(SARYMAT_STRUCT *smstruct, int alpha_size, int k)
+{
+  int i, r, c, next, pos, size, limit, M, *Pos, *kmer;
+  char *T;
+
+  if (smstruct == NULL || alpha_size < 1 || k < 0)
+    return 0;
+
+  T = smstruct->T;
+  M = smstruct->M;
+  Pos = smstruct->sary->Pos;
+
+  for (i=1; i <= M; i++)
+    if (T[i] < 0 || T[i] >= alpha_size)
+      return 0;
+
+  /*
+   * Pick k, or check that the table will fit.
+   */
+  if (k == 0) {
+    limit = (M < SARY_KMER_MAX_ENTRIES ? M : SARY_KMER_MAX_ENTRIES);
+    k = 1;
+    size = alpha_size;
+    while (alpha_size > 1 && size <= limit / alpha_size) {
+      size *= alpha_size;
+      k++;
+    }
+  }
+  else {
+    for (i=1,size=alpha_size; i < k; i++) {
+      if (size > SARY_KMER_MAX_ENTRIES / alpha_size)
+        return 0;
+      size *= alpha_size;
+    }
+  }
+
+  if ((kmer = malloc((size + 1) * sizeof(int))) == NULL)
+    return 0;
+
+  /*
+   * The codes of the suffixes of length k or more never decrease down
+   * the suffix array, so each entry is filled in as the rows pass it.
+   */
+  next = 0;
+  for (r=1; r <= M; r++) {
+    pos = Pos[r];
+    if (pos + k - 1 > M)
+      continue;
+
+    for (i=0,c=0; i < k; i++)
+      c = c * alpha_size + T[pos+i];
+    while (next <= c)
+      kmer[next++] = r;
+  }
+  while (next <= size)
+    kmer[next++] = M + 1;
+
+  if (smstruct->kmer != NULL)
+    free(smstruct->kmer);
+  smstruct->kmer = kmer;
+  smstruct->kmer_k = k;
+  smstruct->kmer_alpha = alpha_size;
+  smstruct->kmer_size = size;
+
+  return 1;
+}
+
+
+/*
+ * kmer_range
+ *
+ * Use the k-mer table to find the rows of the suffix array whose
+ * suffixes begin with the pattern's first min(N,k) characters.
+ *
+ * The suffixes shorter than k are not in any bucket, so the range is
+ * widened to take in the ones sorted just below it (some may match a
+ * pattern shorter than k), and then the short suffixes at either end
+ * of the range that do not match the pattern are trimmed off.  Since
+ * there are only k-1 short suffixes, this costs at most 2k compares.
+ *
+ * Parameters:   smstruct  -  the preprocessed text
+ *               P         -  the pattern (as P[1],...,P[N])
+ *               N         -  the pattern's length
+ *               lo, hi    -  where to store the range
+ *
+ * Returns:  non-zero if there is a k-mer table, zero otherwise.
+ */
+static int kmer_range(SARYMAT_STRUCT *smstruct, char *P, int N,
+                      int *lo, int *hi)
+{
+  int i, k, alpha, clo, chi, M, *Pos;
+
+  if (smstruct->kmer == NULL)
+    return 0;
+
+  k = smstruct->kmer_k;
+  alpha = smstruct->kmer_alpha;
+  M = smstruct->M;
+  Pos = smstruct->sary->Pos;
+
+  for (i=0,clo=chi=0; i < k; i++) {
+    if (i < N && (P[1+i] < 0 || P[1+i] >= alpha)) {
+      *lo = 1;
+      *hi = 0;
+      return 1;
+    }
+    clo = clo * alpha + (i < N ? P[1+i] : 0);
+    chi = chi * alpha + (i < N ? P[1+i] : alpha - 1);
+  }
+
+  *lo = smstruct->kmer[clo];
+  *hi = smstruct->kmer[chi+1] - 1;
+
+  while (*lo > 1 && Pos[*lo-1] + k - 1 > M)
+    (*lo)--;
+  while (*lo <= *hi && Pos[*lo] + k - 1 > M &&
+         !kmer_matches(smstruct, P, N, *lo))
+    (*lo)++;
+  while (*hi >= *lo && Pos[*hi] + k - 1 > M &&
+         !kmer_matches(smstruct, P, N, *hi))
+    (*hi)--;
+
+  return 1;
+}
+
+
+/*
+ * kmer_matches
+ *
+ * Does the suffix at a row of the suffix array begin with the pattern?
+ */
+static int kmer_matches(SARYMAT_STRUCT *smstruct, char *P, int N, int row)
+{
+  int pos;
+
+  pos = smstruct->sary->Pos[row];
+  if (pos + N - 1 > smstruct->M)
+    return 0;
+
+  return (match_extend(smstruct, P, N, pos, 0) == N);
+}
+
+
+/*
+ * kmer_result
+ *
+ * Return the first of the matches found by kmer_range, setting up
+ * the *_next procedures to return the rest.
+ */
+static char *kmer_result(SARYMAT_STRUCT *smstruct, int lo, int hi)
+{
+  if (lo > hi) {
+    smstruct->i = smstruct->M + 1;
+    smstruct->iprime = smstruct->M;
+    return NULL;
+  }
+
+  smstruct->i = lo + 1;
+  smstruct->iprime = hi;
+  return &smstruct->T[smstruct->sary->Pos[lo]];
+}
+
+
+static int file_save(char *path, char *T, long M, void *Pos, int width,
+                     SARY_STRUCT *sary, SARY_FM *fm);
+static char *file_map(char *path, long *map_size);
+static int file_check(SARY_FILE_HEADER *header, char *map);
+static int file_write(FILE *fp, void *data, long size, long *pos);
+static int file_start(FILE *fp, SARY_FILE_HEADER *header, int sec,
+                      long *pos);
+
+
+/*
+ * sary_match_save
+ *
+ * Write a suffix array, its lcp values and (optionally) an FM-index of
+ * the same text to an index file, which can later be memory-mapped by
+ * sary_match_open.  The lcp values are computed if the suffix array
+ * does not yet have them.
+ *
+ * Parameters:   smstruct  -  the preprocessed text
+ *               fm        -  an FM-index of the text, or NULL
+ *               path      -  the name of the file to write
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int sary_match_save(SARYMAT_STRUCT *smstruct, SARY_FM *fm, char *path)
+{
+  SARY_STRUCT *sary;
+
+  if (smstruct == NULL || smstruct->sary == NULL || path == NULL)
+    return 0;
+
+  sary = smstruct->sary;
+  if (fm != NULL && fm->M != smstruct->M)
+    return 0;
+
+  if (sary->lcp == NULL && !sary_compute_lcp(sary))
+    return 0;
+
+  return file_save(path, smstruct->T + 1, smstruct->M, sary->Pos, 32, sary,
+                   fm);
+}
+
+
+/*
+ * sary_packed_save
+ *
+ * Write a packed suffix array and (optionally) an FM-index of the same
+ * text to an index file, with the array's entry width.  There are no
+ * lcp values, and the FM-index can only be saved with 32 bit entries
+ * (see sary_file.h).  A 32 bit file can be opened by sary_match_open,
+ * and any file by sary_packed_open.
+ *
+ * Parameters:   sa    -  the packed suffix array
+ *               fm    -  an FM-index of the text, or NULL
+ *               path  -  the name of the file to write
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int sary_packed_save(SARY_PACKED *sa, SARY_FM *fm, char *path)
+{
+  if (sa == NULL || path == NULL)
+    return 0;
+
+  if (fm != NULL && (sa->width != 32 || fm->M != sa->M))
+    return 0;
+
+  return file_save(path, sa->S + 1, sa->M, sa->Pos, sa->width, NULL, fm);
+}
+
+
+/*
+ * file_save
+ *
+ * Write an index file, for sary_match_save and sary_packed_save.
+ *
+ * Parameters:   path   -  the name of the file to write
+ *               T      -  the text
+ *               M      -  the text length
+ *               Pos    -  the suffix array, as Pos[1..M]
+ *               width  -  the width of its entries
+ *               sary   -  the suffix array holding the lcp values to
+ *                         save, or NULL
+ *               fm     -  an FM-index of the text, or NULL
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int file_save(char *path, char *T, long M, void *Pos, int width,
+                     SARY_STRUCT *sary, SARY_FM *fm)
+{
+  int i, num_words, num_samples, info[SF_FM_INFO_INTS];
+  long pos, zero;
+  char nul;
+  FILE *fp;
+  SARY_FILE_HEADER header;
+
+  if ((fp = fopen(path, "wb")) == NULL)
+    return 0;
+
+  memset(&header, 0, sizeof(SARY_FILE_HEADER));
+  memcpy(header.magic, SARY_FILE_MAGIC, 8);
+  header.version = SARY_FILE_VERSION;
+  header.byte_order = SARY_FILE_BYTE_ORDER;
+  header.int_size = sizeof(int);
+  header.long_size = sizeof(long);
+  header.width = width;
+  header.M = M;
+  header.lcp_size = (sary != NULL ? sary_file_lcp_size(M) : 0);
+
+  /*
+   * Write a placeholder header, then the sections (recording where
+   * each one goes), then the real header.
+   */
+  nul = '\0';
+  zero = 0;
+  pos = 0;
+  if (!file_write(fp, &header, sizeof(SARY_FILE_HEADER), &pos))
+    goto ERROR;
+
+  if (!file_start(fp, &header, SF_TEXT, &pos) ||
+      !file_write(fp, &nul, 1, &pos) ||
+      !file_write(fp, T, M, &pos) ||
+      !file_write(fp, &nul, 1, &pos))
+    goto ERROR;
+  header.size[SF_TEXT] = pos - header.offset[SF_TEXT];
+
+  if (!file_start(fp, &header, SF_POS, &pos) ||
+      !file_write(fp, &zero, width / 8, &pos) ||
+      !file_write(fp, (char *) Pos + width / 8, M * (width / 8), &pos))
+    goto ERROR;
+  header.size[SF_POS] = pos - header.offset[SF_POS];
+
+  if (header.lcp_size != 0) {
+    if (!file_start(fp, &header, SF_LEAVES, &pos) ||
+        !file_write(fp, sary->lcp_leaves, (M + 1) * (long) sizeof(int), &pos))
+      goto ERROR;
+    header.size[SF_LEAVES] = pos - header.offset[SF_LEAVES];
+
+    if (!file_start(fp, &header, SF_LCP, &pos) ||
+        !file_write(fp, sary->lcp, header.lcp_size * (long) sizeof(int),
+                    &pos))
+      goto ERROR;
+    header.size[SF_LCP] = pos - header.offset[SF_LCP];
+  }
+
+  if (fm != NULL) {
+    num_words = (fm->M + 1) / 32 + 1;
+    num_samples = fm->M / fm->sample_rate + 2;
+
+    info[0] = fm->sigma;
+    info[1] = fm->sample_rate;
+    info[2] = fm->block_chars;
+    info[3] = fm->block_bytes;
+    info[4] = fm->num_blocks;
+    for (i=0; i < 256; i++)
+      info[5+i] = fm->code[i];
+    for (i=0; i < 257; i++)
+      info[5+256+i] = fm->C[i];
+
+    if (!file_start(fp, &header, SF_FM_INFO, &pos) ||
+        !file_write(fp, info, sizeof(info), &pos))
+      goto ERROR;
+    header.size[SF_FM_INFO] = pos - header.offset[SF_FM_INFO];
+
+    if (!file_start(fp, &header, SF_FM_OCC, &pos) ||
+        !file_write(fp, fm->occ, (long) fm->num_blocks * fm->block_bytes,
+                    &pos))
+      goto ERROR;
+    header.size[SF_FM_OCC] = pos - header.offset[SF_FM_OCC];
+
+    if (!file_start(fp, &header, SF_FM_MARKS, &pos) ||
+        !file_write(fp, fm->marks, num_words * (long) sizeof(unsigned int),
+                    &pos))
+      goto ERROR;
+    header.size[SF_FM_MARKS] = pos - header.offset[SF_FM_MARKS];
+
+    if (!file_start(fp, &header, SF_FM_RANKS, &pos) ||
+        !file_write(fp, fm->mark_ranks, num_words * (long) sizeof(int), &pos))
+      goto ERROR;
+    header.size[SF_FM_RANKS] = pos - header.offset[SF_FM_RANKS];
+
+    if (!file_start(fp, &header, SF_FM_SAMPLES, &pos) ||
+        !file_write(fp, fm->samples, num_samples * (long) sizeof(int), &pos))
+      goto ERROR;
+    header.size[SF_FM_SAMPLES] = pos - header.offset[SF_FM_SAMPLES];
+  }
+
+  if (fseek(fp, 0L, SEEK_SET) != 0 ||
+      fwrite(&header, sizeof(SARY_FILE_HEADER), 1, fp) != 1)
+    goto ERROR;
+
+  if (fclose(fp) != 0)
+    return 0;
+
+  return 1;
+
+ERROR:
+  fclose(fp);
+  return 0;
+}
+
+
+/*
+ * sary_match_open
+ *
+ * Memory-map an index file written by sary_match_save (or any index
+ * file with 32 bit entries).  The suffix array, lcp values and text
+ * are used in place, so opening the file costs only the mapping and a
+ * pass checking the values that the searches use as indexes (see
+ * file_check), and processes searching the same file share one copy
+ * of it in the page cache.  The returned structure can be searched by
+ * the sary_match_naive_first and sary_match_mlr_first procedures, and
+ * by sary_match_lcp_first when the file holds lcp values.  If the file
+ * holds one, smstruct->fm is an FM-index of the text.
+ *
+ * Parameters:   path  -  the name of the index file
+ *
+ * Returns:  An initialized SARYMAT_STRUCT structure, or NULL if the
+ *           file cannot be mapped, is not a valid index file or has
+ *           entries wider than an int.
+ */
+SARYMAT_STRUCT *sary_match_open(char *path)
+{
+  int i, M, *info;
+  long map_size;
+  char *map;
+  SARY_FILE_HEADER *header;
+  SARYMAT_STRUCT *node;
+  SARY_STRUCT *sary;
+  SARY_FM *fm;
+
+  if ((map = file_map(path, &map_size)) == NULL)
+    return NULL;
+
+  header = (SARY_FILE_HEADER *) map;
+  if (header->width != 32 || header->M >= INT_MAX)
+    goto ERROR;
+  M = (int) header->M;
+
+  /*
+   * Point the structures at the mapped sections.
+   */
+  if ((node = malloc(sizeof(SARYMAT_STRUCT))) == NULL)
+    goto ERROR;
+  memset(node, 0, sizeof(SARYMAT_STRUCT));
+
+  if ((sary = node->sary = malloc(sizeof(SARY_STRUCT))) == NULL) {
+    free(node);
+    goto ERROR;
+  }
+  memset(sary, 0, sizeof(SARY_STRUCT));
+
+  node->type = (header->lcp_size != 0 ? LCP_MATCH : MLR_MATCH);
+  node->copyflag = 0;
+  node->M = M;
+  node->T = map + header->offset[SF_TEXT];
+  node->map = map;
+  node->map_size = map_size;
+
+  sary->S = node->T;
+  sary->M = M;
+  sary->Pos = (int *) (map + header->offset[SF_POS]);
+  if (header->lcp_size != 0) {
+    sary->lcp_leaves = (int *) (map + header->offset[SF_LEAVES]);
+    sary->lcp = (int *) (map + header->offset[SF_LCP]);
+  }
+
+  if (header->size[SF_FM_INFO] != 0) {
+    if ((fm = node->fm = malloc(sizeof(SARY_FM))) == NULL) {
+      free(sary);
+      free(node);
+      goto ERROR;
+    }
+    memset(fm, 0, sizeof(SARY_FM));
+
+    info = (int *) (map + header->offset[SF_FM_INFO]);
+    fm->T = node->T + 1;
+    fm->M = M;
+    fm->sigma = info[0];
+    fm->sample_rate = info[1];
+    fm->block_chars = info[2];
+    fm->block_bytes = info[3];
+    fm->num_blocks = info[4];
+    for (i=0; i < 256; i++)
+      fm->code[i] = info[5+i];
+    for (i=0; i < 257; i++)
+      fm->C[i] = info[5+256+i];
+
+    fm->occ = (unsigned char *) (map + header->offset[SF_FM_OCC]);
+    fm->marks = (unsigned int *) (map + header->offset[SF_FM_MARKS]);
+    fm->mark_ranks = (int *) (map + header->offset[SF_FM_RANKS]);
+    fm->samples = (int *) (map + header->offset[SF_FM_SAMPLES]);
+    fm->mem_bytes = header->size[SF_FM_OCC] + header->size[SF_FM_MARKS] +
+                    header->size[SF_FM_RANKS] + header->size[SF_FM_SAMPLES];
+  }
+
+  return node;
+
+ERROR:
+  munmap(map, map_size);
+  return NULL;
+}
+
+
+/*
+ * sary_packed_open
+ *
+ * Memory-map any index file as a packed suffix array, for texts too
+ * long (or files with entries too wide) for sary_match_open.  Only the
+ * text and the suffix array are used, in place, so the returned array
+ * can be searched by sary_packed_match_first and sary_packed_interval.
+ *
+ * Parameters:   path  -  the name of the index file
+ *
+ * Returns:  An initialized SARY_PACKED structure, or NULL if the file
+ *           cannot be mapped or is not a valid index file.
+ */
+SARY_PACKED *sary_packed_open(char *path)
+{
+  long map_size;
+  char *map;
+  SARY_FILE_HEADER *header;
+  SARY_PACKED *sa;
+
+  if ((map = file_map(path, &map_size)) == NULL)
+    return NULL;
+
+  if ((sa = malloc(sizeof(SARY_PACKED))) == NULL) {
+    munmap(map, map_size);
+    return NULL;
+  }
+  memset(sa, 0, sizeof(SARY_PACKED));
+
+  header = (SARY_FILE_HEADER *) map;
+  sa->S = map + header->offset[SF_TEXT];
+  sa->M = header->M;
+  sa->copyflag = 0;
+  sa->width = header->width;
+  sa->Pos = (unsigned char *) (map + header->offset[SF_POS]);
+  sa->map = map;
+  sa->map_size = map_size;
+
+  return sa;
+}
+
+
+/*
+ * file_map
+ *
+ * Map an index file and check its header, its section table and (with
+ * file_check) its values, for sary_match_open and sary_packed_open.
+ *
+ * Parameters:   path      -  the name of the index file
+ *               map_size  -  where to store the size of the mapping
+ *
+ * Returns:  the mapped file, or NULL if the file cannot be mapped or
+ *           is not a valid index file.
+ */
+static char *file_map(char *path, long *map_size)
+{
+  int i, fd, width, num_words, num_samples, *info;
+  long M, expect[SF_NUM_SECTIONS];
+  char *map;
+  struct stat st;
+  SARY_FILE_HEADER *header;
+
+  if (path == NULL || (fd = open(path, O_RDONLY)) == -1)
+    return NULL;
+
+  if (fstat(fd, &st) == -1 || st.st_size < (off_t) sizeof(SARY_FILE_HEADER)) {
+    close(fd);
+    return NULL;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  /*
+   * Check the header and the section table.  The lcp and FM-index
+   * sections hold ints, so they need 32 bit entries and a text shorter
+   * than INT_MAX.
+   */
+  header = (SARY_FILE_HEADER *) map;
+  M = header->M;
+  width = header->width;
+  if (memcmp(header->magic, SARY_FILE_MAGIC, 8) != 0 ||
+      header->version != SARY_FILE_VERSION ||
+      header->byte_order != SARY_FILE_BYTE_ORDER ||
+      header->int_size != sizeof(int) || header->long_size != sizeof(long) ||
+      M <= 0 || (width != 32 && width != 40 && width != 64) ||
+      width < sary_packed_width(M))
+    goto ERROR;
+
+  if ((header->lcp_size != 0 || header->size[SF_FM_INFO] != 0) &&
+      (width != 32 || M >= INT_MAX))
+    goto ERROR;
+  if (header->lcp_size != 0 && header->lcp_size != sary_file_lcp_size(M))
+    goto ERROR;
+
+  for (i=0; i < SF_NUM_SECTIONS; i++)
+    if (header->offset[i] < 0 || header->size[i] < 0 ||
+        header->offset[i] % SARY_FILE_ALIGN != 0 ||
+        header->offset[i] + header->size[i] > (long) st.st_size)
+      goto ERROR;
+
+  expect[SF_TEXT] = M + 2;
+  expect[SF_POS] = (M + 1) * (width / 8);
+  expect[SF_LEAVES] = (header->lcp_size != 0 ? (M + 1) * sizeof(int) : 0);
+  expect[SF_LCP] = header->lcp_size * (long) sizeof(int);
+  for (i=SF_FM_INFO; i < SF_NUM_SECTIONS; i++)
+    expect[i] = 0;
+
+  info = (int *) (map + header->offset[SF_FM_INFO]);
+  if (header->size[SF_FM_INFO] != 0) {
+    if (header->size[SF_FM_INFO] != SF_FM_INFO_INTS * (long) sizeof(int) ||
+        info[1] < 1 || info[3] <= 0 || info[4] <= 0)
+      goto ERROR;
+
+    num_words = (int) (M + 1) / 32 + 1;
+    num_samples = (int) M / info[1] + 2;
+
+    expect[SF_FM_INFO] = header->size[SF_FM_INFO];
+    expect[SF_FM_OCC] = (long) info[4] * info[3];
+    expect[SF_FM_MARKS] = num_words * (long) sizeof(unsigned int);
+    expect[SF_FM_RANKS] = num_words * (long) sizeof(int);
+    expect[SF_FM_SAMPLES] = num_samples * (long) sizeof(int);
+  }
+
+  for (i=0; i < SF_NUM_SECTIONS; i++)
+    if (header->size[i] != expect[i])
+      goto ERROR;
+
+  if (!file_check(header, map))
+    goto ERROR;
+
+  *map_size = st.st_size;
+  return map;
+
+ERROR:
+  munmap(map, st.st_size);
+  return NULL;
+}
+
+
+/*
+ * file_check
+ *
+ * Check the values of an index file that the searches use to index
+ * the text and the other arrays, so that a damaged file is rejected
+ * rather than read out of bounds:  every suffix array entry must be a
+ * text position (1 to M), and the FM-index's character codes, C[]
+ * (which must rise to M+1, the number of rows), block layout, BWT
+ * characters and counts, marked row ranks and sampled positions must
+ * be consistent with each other.  The section sizes have already been
+ * checked.
+ *
+ * Returns:  non-zero if the values are valid, zero otherwise.
+ */
+static int file_check(SARY_FILE_HEADER *header, char *map)
+{
+  int i, r, c, M, sigma, rank, num_words, num_samples, block_chars;
+  int *info, *C, *counts, *ranks, *samples, freq[256];
+  long j, p;
+  unsigned int *marks, x;
+  unsigned char *block;
+  void *Pos;
+
+  Pos = map + header->offset[SF_POS];
+  for (j=1; j <= header->M; j++) {
+    p = sary_entry_get(Pos, header->width, j);
+    if (p < 1 || p > header->M)
+      return 0;
+  }
+
+  if (header->size[SF_FM_INFO] == 0)
+    return 1;
+
+  M = (int) header->M;
+  info = (int *) (map + header->offset[SF_FM_INFO]);
+  sigma = info[0];
+  if (sigma < 1 || sigma > 256 ||
+      info[2] != info[3] - (sigma - 1) * (int) sizeof(int) || info[2] <= 0 ||
+      info[4] != (M + 1) / info[2] + 1)
+    return 0;
+
+  for (i=0; i < 256; i++)
+    if (info[5+i] < 0 || info[5+i] >= sigma)
+      return 0;
+
+  C = info + 5 + 256;
+  if (C[0] != 0 || C[1] != 1 || C[sigma] != M + 1)
+    return 0;
+  for (i=1; i < sigma; i++)
+    if (C[i+1] < C[i])
+      return 0;
+
+  /*
+   * Each block's counts must be the number of each character in the
+   * blocks before it, and the characters must add up to C[].
+   */
+  block_chars = info[2];
+  memset(freq, 0, sigma * sizeof(int));
+  for (r=0; r <= M + 1; r++) {
+    block = (unsigned char *) map + header->offset[SF_FM_OCC] +
+            (long) (r / block_chars) * info[3];
+    if (r % block_chars == 0) {
+      counts = (int *) block;
+      for (c=1; c < sigma; c++)
+        if (counts[c-1] != freq[c])
+          return 0;
+    }
+    if (r > M)
+      break;
+
+    c = block[(sigma - 1) * sizeof(int) + r % block_chars];
+    if (c >= sigma)
+      return 0;
+    freq[c]++;
+  }
+  if (freq[0] != 1)
+    return 0;
+  for (c=1; c < sigma; c++)
+    if (freq[c] != C[c+1] - C[c])
+      return 0;
+
+  num_words = (M + 1) / 32 + 1;
+  num_samples = M / info[1] + 2;
+  marks = (unsigned int *) (map + header->offset[SF_FM_MARKS]);
+  ranks = (int *) (map + header->offset[SF_FM_RANKS]);
+  samples = (int *) (map + header->offset[SF_FM_SAMPLES]);
+  for (rank=0,i=0; i < num_words; i++) {
+    if (ranks[i] != rank)
+      return 0;
+    for (x=marks[i]; x != 0; x&=x-1)
+      rank++;
+  }
+  if (rank > num_samples)
+    return 0;
+
+  for (i=0; i < rank; i++)
+    if (samples[i] < 1 || samples[i] > M + 1)
+      return 0;
+
+  return 1;
+}
+
+
+/*
+ * file_write
+ *
+ * Write size bytes to an index file, adding them to the file position.
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int file_write(FILE *fp, void *data, long size, long *pos)
+{
+  if (size > 0 && fwrite(data, 1, size, fp) != (size_t) size)
+    return 0;
+
+  *pos += size;
+  return 1;
+}
+
+
+/*
+ * file_start
+ *
+ * Start a section of an index file, padding the file with zeros to
+ * the next SARY_FILE_ALIGN boundary and recording the section offset.
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int file_start(FILE *fp, SARY_FILE_HEADER *header, int sec,
+                      long *pos)
+{
+  static char zeros[SARY_FILE_ALIGN];
+
+  if (!file_write(fp, zeros, (SARY_FILE_ALIGN - *pos % SARY_FILE_ALIGN) %
+                             SARY_FILE_ALIGN, pos))
+    return 0;
+
+  header->offset[sec] = *pos;
+  return 1;
+}
+
+
+/*
+ * sary_file_lcp_size
+ *
+ * The size of the lcp tree of a text of length M (as allocated by
+ * sary_compute_lcp), or 0 if the tree is too large for int indexes, in
+ * which case no lcp values are saved.
+ */
+int sary_file_lcp_size(long M)
+{
+  long lcp_size;
+
+  for (lcp_size=1; lcp_size < M - 1; lcp_size*=2) ;
+  return (lcp_size < INT_MAX / 2 ? (int) lcp_size * 2 + 1 : 0);
+}
+
+
 /*
  * sary_match_free
  *
@@ -736,6 +1736,21 @@ void sary_match_free(SARYMAT_STRUCT *smstruct)
   if (smstruct == NULL)
     return;
 
+  if (smstruct->kmer != NULL)
+    free(smstruct->kmer);
+
+  /*
+   * An opened index file only owns the structures, not their arrays.
+   */
+  if (smstruct->map != NULL) {
+    if (smstruct->fm != NULL)
+      free(smstruct->fm);
+    free(smstruct->sary);
+    munmap(smstruct->map, smstruct->map_size);
+    free(smstruct);
+    return;
+  }
+
   if (smstruct->sary != NULL)
     sary_free(smstruct->sary);
   if (smstruct->copyflag && smstruct->T)
@@ -3,6 +3,10 @@
 #define _SARY_MATCH_H_
 
 #include "sary.h"
+#include "sary_fm.h"
+
+#define SARY_KMER_MAX_ENTRIES (1 << 24)
+#define SARY_SORT_CUTOFF 32
 
 typedef enum { NAIVE_MATCH, MLR_MATCH, LCP_MATCH } SARY_MATCH_TYPE;
 typedef struct {
@@ -16,6 +20,12 @@ typedef struct {
   int i, iprime, N;
 
   int num_compares, search_depth;
+
+  int *kmer, kmer_k, kmer_alpha, kmer_size;   /* the optional k-mer table */
+
+  SARY_FM *fm;          /* the FM-index of an opened index file, or NULL */
+  char *map;            /* the mapped index file, or NULL */
+  long map_size;
 } SARYMAT_STRUCT;
 
 SARYMAT_STRUCT *sary_match_naive_prep(char *T, int M, int copyflag);
@@ -30,6 +40,19 @@ SARYMAT_STRUCT *sary_match_lcp_prep(char *T, int M, int copyflag);
 char *sary_match_lcp_first(SARYMAT_STRUCT *smstruct, char *P, int N);
 char *sary_match_lcp_next(SARYMAT_STRUCT *smstruct);
 
+int sary_match_interval(SARYMAT_STRUCT *smstruct, char *P, int N,
+                        int *lo, int *hi);
+int sary_match_locate(SARYMAT_STRUCT *smstruct, int lo, int hi,
+                      int *positions, int sorted);
+int sary_match_leftmost(SARYMAT_STRUCT *smstruct, int lo, int hi);
+int sary_match_sort_positions(int *positions, int num, int M);
+
+int sary_match_kmer_prep(SARYMAT_STRUCT *smstruct, int alpha_size, int k);
+
+int sary_match_save(SARYMAT_STRUCT *smstruct, SARY_FM *fm, char *path);
+SARYMAT_STRUCT *sary_match_open(char *path);
+int sary_packed_save(SARY_PACKED *sa, SARY_FM *fm, char *path);
+SARY_PACKED *sary_packed_open(char *path);
 
 void sary_match_free(SARYMAT_STRUCT *smstruct);
 
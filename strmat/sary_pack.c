@@ -0,0 +1,302 @@
+/*
+ * sary_pack.c
+ *
+ * Suffix arrays whose entries are stored with a selectable width:
+ * 32 bits (texts up to 4 GB), 40 bits packed into 5 bytes (up to
+ * 1 TB) or 64 bits.  The width is normally chosen from the text length,
+ * so the memory used by the array follows the size of the text rather
+ * than the fixed 4 bytes per character of SARY_STRUCT (whose int
+ * entries also cap the text at 2 GB).
+ *
+ * The construction is sary_sort_entries, the sort of sary_qsort_build
+ * in sary.c, run over the packed entries (see sary_entry_get).  The
+ * matching is the mlr binary search of sary_match.c, over long
+ * positions (the int search there also drives the k-mer table and
+ * the SARYMAT_STRUCT statistics).  The arrays are written to and
+ * mapped from index files by sary_packed_save and sary_packed_open
+ * in sary_match.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include "sary.h"
+#include "sary_pack.h"
+#include "sary_cmp.h"
+
+
+/*
+ * sary_packed_width
+ *
+ * The narrowest entry width able to hold the positions 1..M.
+ *
+ * Parameters:  M  -  the text length
+ *
+ * Returns:  32, 40 or 64.
+ */
+int sary_packed_width(long M)
+{
+  if (M <= 0xFFFFFFFFL)
+    return 32;
+  else if (M <= 0xFFFFFFFFFFL)
+    return 40;
+  else
+    return 64;
+}
+
+
+/*
+ * sary_packed_build
+ *
+ * Build a packed suffix array.
+ *
+ * Parameters:  S         -  the input string
+ *              M         -  the string's length
+ *              width     -  32, 40, 64 or SARY_WIDTH_AUTO (to choose
+ *                           the narrowest width that holds M)
+ *              copyflag  -  whether to copy the input string
+ *
+ * Returns:  an initialized SARY_PACKED structure, or NULL if the width
+ *           is invalid (or too narrow for M) or memory ran out.
+ */
+SARY_PACKED *sary_packed_build(char *S, long M, int width, int copyflag)
+{
+  long num_compares;
+  char *buf;
+  SARY_PACKED *sa;
+
+  if (S == NULL || M <= 0)
+    return NULL;
+
+  if (width == SARY_WIDTH_AUTO)
+    width = sary_packed_width(M);
+  else if ((width != 32 && width != 40 && width != 64) ||
+           width < sary_packed_width(M))
+    return NULL;
+
+  S--;            /* Shift to make sequence be S[1],...,S[M] */
+
+  /*
+   * Allocate everything.
+   */
+  if ((sa = malloc(sizeof(SARY_PACKED))) == NULL)
+    return NULL;
+  memset(sa, 0, sizeof(SARY_PACKED));
+
+  sa->M = M;
+  sa->width = width;
+  sa->copyflag = copyflag;
+  num_compares = 0;
+
+  if (!copyflag)
+    sa->S = S;
+  else {
+    if ((buf = malloc(M + 2)) == NULL) {
+      free(sa);
+      return NULL;
+    }
+
+    buf[0] = buf[M+1] = '\0';
+    memcpy(buf + 1, S + 1, M);
+    sa->S = buf;
+  }
+
+  if ((sa->Pos = malloc((M + 1) * (width / 8))) == NULL) {
+    sary_packed_free(sa);
+    return NULL;
+  }
+
+  /*
+   * Compute the suffix array.
+   */
+  if (!sary_sort_entries(sa->S, M, sa->Pos, width, &num_compares,
+                         &sa->mem_bytes)) {
+    sary_packed_free(sa);
+    return NULL;
+  }
+
+#ifdef STATS
+  sa->num_compares = num_compares;
+#endif
+
+  return sa;
+}
+
+
+/*
+ * sary_packed_get
+ *
+ * Returns:  the i-th entry (1..M) of the suffix array.
+ */
+long sary_packed_get(SARY_PACKED *sa, long i)
+{
+  return sary_entry_get(sa->Pos, sa->width, i);
+}
+
+
+/*
+ * sary_packed_match_first
+ *
+ * Find the first match of a pattern using the packed suffix array
+ * (the mlr accelerated binary search of sary_match_mlr_first).  As
+ * with the other suffix array matchers, the matches are returned in
+ * suffix array order, not text order.
+ *
+ * Parameters:   sa  -  the packed suffix array
+ *               P   -  the pattern
+ *               N   -  the pattern's length
+ *
+ * Returns:  The location of a match to the pattern, or NULL.
+ */
+char *sary_packed_match_first(SARY_PACKED *sa, char *P, long N)
+{
+  int pass;
+  int len;
+  long k, n, L, R, l, r, mlr, mid, pos, M;
+  char *T;
+
+  P--;            /* Shift to make sequence be P[1],...,P[N] */
+
+  T = sa->S;
+  M = sa->M;
+
+  /*
+   * Two binary searches, one for the first suffix that is not less than
+   * the pattern and one for the first suffix that is greater than the
+   * pattern (where a suffix beginning with the pattern is "equal").
+   * In each, everything at L and below is on the low side and everything
+   * at R and above is on the high side, with l and r the lcp's of the
+   * pattern with suffixes L and R.
+   */
+  sa->i = sa->iprime = 0;
+  for (pass=0; pass < 2; pass++) {
+    L = 0;
+    R = M + 1;
+    l = r = 0;
+    while (L + 1 < R) {
+      mid = L + (R - L) / 2;
+      pos = sary_entry_get(sa->Pos, sa->width, mid);
+
+      mlr = (l < r ? l : r);
+      k = mlr;
+      do {
+        n = (N - k < M - pos + 1 - k ? N - k : M - pos + 1 - k);
+        len = sary_cmp_length(&P[1+k], &T[pos+k],
+                              (int) (n < INT_MAX ? n : INT_MAX));
+        k += len;
+      } while (len == INT_MAX);
+#ifdef STATS
+      sa->search_compares += k - mlr + 1;
+#endif
+
+      if (1 + k > N) {
+        if (pass == 0)
+          R = mid;
+        else
+          L = mid;
+      }
+      else if (pos + k > M || P[1+k] > T[pos+k])
+        L = mid;
+      else
+        R = mid;
+
+      if (L == mid)
+        l = k;
+      else
+        r = k;
+    }
+
+    if (pass == 0)
+      sa->i = R;
+    else
+      sa->iprime = L;
+  }
+
+  return sary_packed_match_next(sa);
+}
+
+
+/*
+ * sary_packed_interval
+ *
+ * Find the interval of the packed suffix array holding the suffixes
+ * that begin with a pattern, as sary_match_interval does.
+ *
+ * Parameters:   sa      -  the packed suffix array
+ *               P       -  the pattern
+ *               N       -  the pattern's length
+ *               lo, hi  -  where to store the interval's ends
+ *
+ * Returns:  the number of matches (hi - lo + 1).
+ */
+long sary_packed_interval(SARY_PACKED *sa, char *P, long N, long *lo,
+                          long *hi)
+{
+  if (sary_packed_match_first(sa, P, N) == NULL) {
+    *lo = 1;
+    *hi = 0;
+  }
+  else {
+    *lo = sa->i - 1;
+    *hi = sa->iprime;
+  }
+
+  sa->i = sa->M + 1;
+  sa->iprime = sa->M;
+
+  return *hi - *lo + 1;
+}
+
+
+/*
+ * sary_packed_match_next
+ *
+ * Return the next match of the pattern, if another match exists.
+ *
+ * Parameters:  sa  -  the packed suffix array after a call to
+ *                     sary_packed_match_first
+ *
+ * Returns:  the location of a match in the text, or NULL.
+ */
+char *sary_packed_match_next(SARY_PACKED *sa)
+{
+  if (sa->i > sa->iprime)
+    return NULL;
+
+  return &sa->S[sary_entry_get(sa->Pos, sa->width, sa->i++)];
+}
+
+
+/*
+ * sary_packed_free
+ *
+ * Free up a SARY_PACKED structure.
+ *
+ * Parameters:  sa  -  a SARY_PACKED structure
+ *
+ * Returns:  nothing.
+ */
+void sary_packed_free(SARY_PACKED *sa)
+{
+  if (sa == NULL)
+    return;
+
+  /*
+   * An opened index file only owns the structure, not its arrays.
+   */
+  if (sa->map != NULL) {
+    munmap(sa->map, sa->map_size);
+    free(sa);
+    return;
+  }
+
+  if (sa->Pos != NULL)
+    free(sa->Pos);
+  if (sa->copyflag && sa->S != NULL)
+    free(sa->S);
+
+  free(sa);
+}
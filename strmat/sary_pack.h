@@ -0,0 +1,31 @@
+#ifndef _SARY_PACK_H_
+#define _SARY_PACK_H_
+
+#define SARY_WIDTH_AUTO 0
+
+typedef struct {
+  char *S;
+  long M;
+  int copyflag, width;
+
+  unsigned char *Pos;
+
+  long i, iprime;
+
+  long num_compares, search_compares;
+  long mem_bytes;
+
+  char *map;            /* the mapped index file, or NULL */
+  long map_size;
+} SARY_PACKED;
+
+int sary_packed_width(long M);
+SARY_PACKED *sary_packed_build(char *S, long M, int width, int copyflag);
+long sary_packed_get(SARY_PACKED *sa, long i);
+char *sary_packed_match_first(SARY_PACKED *sa, char *P, long N);
+char *sary_packed_match_next(SARY_PACKED *sa);
+long sary_packed_interval(SARY_PACKED *sa, char *P, long N, long *lo,
+                          long *hi);
+void sary_packed_free(SARY_PACKED *sa);
+
+#endif
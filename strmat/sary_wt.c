@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sary_wt.h"
+
+
+/*
+ * sary_wt_build
+ *
+ * Build a wavelet matrix over the suffix array, so that the number of
+ * rows of an interval of the suffix array whose suffixes start inside
+ * a window of the text can be counted in O(log M) time, and those
+ * starting positions listed in O(log M) time each, without touching
+ * the other rows of the interval.
+ *
+ * The matrix has one level per bit of the positions, highest bit first.
+ * Level k holds bit k of each position, in the order the positions have
+ * after being stably sorted on their higher bits (all of the values
+ * with a 0 bit at the previous level first, then those with a 1 bit).
+ * Each level is a bitvector with the number of ones before each word,
+ * so the rows of an interval can be followed from level to level by
+ * rank operations.
+ *
+ * Parameters:   Pos  -  the suffix array, Pos[1..M]
+ *               M    -  the text length
+ *
+ * Returns:  the wavelet matrix, or NULL on an error.
+ */
+#define WT_BIT(wt,k,x)  ((wt)->bits[k][(x) >> 5] & (1U << ((x) & 31)))
+
+static int wt_rank(SARY_WT *wt, int k, int x);
+static int wt_less(SARY_WT *wt, int s, int e, long value);
+static int wt_list(SARY_WT *wt, int k, int s, int e, long value, int l, int r,
+                   int *positions, int num);
+static int wt_popcount(unsigned int x);
+
+SARY_WT *sary_wt_build(int *Pos, int M)
+{
+  int k, x, bit, z, o, num_words, ones, *cur, *next, *temp;
+  SARY_WT *wt;
+
+  if (Pos == NULL || M <= 0)
+    return NULL;
+
+  if ((wt = malloc(sizeof(SARY_WT))) == NULL)
+    return NULL;
+  memset(wt, 0, sizeof(SARY_WT));
+
+  wt->M = M;
+  for (wt->levels=1; wt->levels < 31 && (1 << wt->levels) <= M; wt->levels++)
+    ;
+
+  num_words = M / 32 + 1;
+  if ((wt->bits = malloc(wt->levels * sizeof(unsigned int *))) == NULL ||
+      (wt->ranks = malloc(wt->levels * sizeof(int *))) == NULL ||
+      (wt->zeros = malloc(wt->levels * sizeof(int))) == NULL) {
+    sary_wt_free(wt);
+    return NULL;
+  }
+  memset(wt->bits, 0, wt->levels * sizeof(unsigned int *));
+  memset(wt->ranks, 0, wt->levels * sizeof(int *));
+
+  if ((cur = malloc(M * sizeof(int))) == NULL) {
+    sary_wt_free(wt);
+    return NULL;
+  }
+  if ((next = malloc(M * sizeof(int))) == NULL) {
+    free(cur);
+    sary_wt_free(wt);
+    return NULL;
+  }
+  memcpy(cur, Pos + 1, M * sizeof(int));
+
+  wt->mem_bytes = wt->levels * (num_words * (long) sizeof(unsigned int) +
+                                num_words * (long) sizeof(int));
+
+  for (k=0; k < wt->levels; k++) {
+    bit = wt->levels - 1 - k;
+
+    if ((wt->bits[k] = malloc(num_words * sizeof(unsigned int))) == NULL ||
+        (wt->ranks[k] = malloc(num_words * sizeof(int))) == NULL) {
+      free(cur);
+      free(next);
+      sary_wt_free(wt);
+      return NULL;
+    }
+    memset(wt->bits[k], 0, num_words * sizeof(unsigned int));
+
+    /*
+     * Set the bits, then stably partition the values on them.
+     */
+    for (x=0,z=0; x < M; x++) {
+      if ((cur[x] >> bit) & 1)
+        wt->bits[k][x >> 5] |= 1U << (x & 31);
+      else
+        z++;
+    }
+    wt->zeros[k] = z;
+
+    for (x=0,ones=0; x < num_words; x++) {
+      wt->ranks[k][x] = ones;
+      ones += wt_popcount(wt->bits[k][x]);
+    }
+
+    for (x=0,o=z,z=0; x < M; x++) {
+      if (WT_BIT(wt, k, x))
+        next[o++] = cur[x];
+      else
+        next[z++] = cur[x];
+    }
+
+    temp = cur;
+    cur = next;
+    next = temp;
+  }
+
+  free(cur);
+  free(next);
+
+  return wt;
+}
+
+
+/*
+ * sary_wt_count
+ *
+ * Count the rows lo..hi of the suffix array whose suffixes start at a
+ * position between l and r.
+ *
+ * Parameters:   wt      -  the wavelet matrix
+ *               lo, hi  -  the suffix array interval (as returned by
+ *                          sary_match_interval)
+ *               l, r    -  the range of text positions
+ *
+ * Returns:  the number of rows.
+ */
+int sary_wt_count(SARY_WT *wt, int lo, int hi, int l, int r)
+{
+  if (wt == NULL)
+    return 0;
+
+  if (lo < 1)
+    lo = 1;
+  if (hi > wt->M)
+    hi = wt->M;
+  if (lo > hi || l > r)
+    return 0;
+
+  return wt_less(wt, lo - 1, hi, (long) r + 1) - wt_less(wt, lo - 1, hi, l);
+}
+
+
+/*
+ * sary_wt_list
+ *
+ * List the starting positions, between l and r, of the suffixes in
+ * rows lo..hi of the suffix array.  The matrix is walked depth first,
+ * taking the 0 branch before the 1 branch and skipping any branch
+ * whose range of values misses l..r, so the positions come out in
+ * increasing order.
+ *
+ * Parameters:   wt         -  the wavelet matrix
+ *               lo, hi     -  the suffix array interval
+ *               l, r       -  the range of text positions
+ *               positions  -  where to store the positions (there must
+ *                             be room for sary_wt_count of them)
+ *
+ * Returns:  the number of positions.
+ */
+int sary_wt_list(SARY_WT *wt, int lo, int hi, int l, int r, int *positions)
+{
+  if (wt == NULL || positions == NULL)
+    return 0;
+
+  if (lo < 1)
+    lo = 1;
+  if (hi > wt->M)
+    hi = wt->M;
+  if (lo > hi || l > r)
+    return 0;
+
+  return wt_list(wt, 0, lo - 1, hi, 0, l, r, positions, 0);
+}
+
+
+/*
+ * wt_less
+ *
+ * Count the values less than value in positions s..e-1 of the first
+ * level.
+ */
+static int wt_less(SARY_WT *wt, int s, int e, long value)
+{
+  int k, count, s1, e1;
+
+  if (value <= 0)
+    return 0;
+  if (value >= (1L << wt->levels))
+    return e - s;
+
+  count = 0;
+  for (k=0; k < wt->levels && s < e; k++) {
+    s1 = wt_rank(wt, k, s);
+    e1 = wt_rank(wt, k, e);
+
+    if ((value >> (wt->levels - 1 - k)) & 1) {
+      count += (e - s) - (e1 - s1);
+      s = wt->zeros[k] + s1;
+      e = wt->zeros[k] + e1;
+    }
+    else {
+      s -= s1;
+      e -= e1;
+    }
+  }
+
+  return count;
+}
+
+
+/*
+ * wt_list
+ *
+ * The recursive walk of sary_wt_list, where positions s..e-1 of level
+ * k hold the values whose higher bits are value.
+ */
+static int wt_list(SARY_WT *wt, int k, int s, int e, long value, int l, int r,
+                   int *positions, int num)
+{
+  int s1, e1;
+  long low, high;
+
+  if (s >= e)
+    return num;
+
+  low = value << (wt->levels - k);
+  high = low + (1L << (wt->levels - k)) - 1;
+  if (high < l || low > r)
+    return num;
+
+  if (k == wt->levels) {
+    for ( ; s < e; s++)
+      positions[num++] = (int) value;
+    return num;
+  }
+
+  s1 = wt_rank(wt, k, s);
+  e1 = wt_rank(wt, k, e);
+  num = wt_list(wt, k + 1, s - s1, e - e1, value * 2, l, r, positions, num);
+  num = wt_list(wt, k + 1, wt->zeros[k] + s1, wt->zeros[k] + e1,
+                value * 2 + 1, l, r, positions, num);
+
+  return num;
+}
+
+
+/*
+ * wt_rank
+ *
+ * The number of ones before position x of level k.
+ */
+static int wt_rank(SARY_WT *wt, int k, int x)
+{
+#ifdef STATS
+  wt->num_rank_ops++;
+#endif
+
+  return wt->ranks[k][x >> 5] +
+         wt_popcount(wt->bits[k][x >> 5] & ((1U << (x & 31)) - 1));
+}
+
+static int wt_popcount(unsigned int x)
+{
+#ifdef __GNUC__
+  return __builtin_popcount(x);
+#else
+  int count;
+
+  for (count=0; x != 0; count++)
+    x &= x - 1;
+
+  return count;
+#endif
+}
+
+
+/*
+ * sary_wt_free
+ *
+ * Free up a SARY_WT structure.
+ */
+void sary_wt_free(SARY_WT *wt)
+{
+  int k;
+
+  for (k=0; k < wt->levels; k++) {
+    if (wt->bits != NULL && wt->bits[k] != NULL)
+      free(wt->bits[k]);
+    if (wt->ranks != NULL && wt->ranks[k] != NULL)
+      free(wt->ranks[k]);
+  }
+  if (wt->bits != NULL)
+    free(wt->bits);
+  if (wt->ranks != NULL)
+    free(wt->ranks);
+  if (wt->zeros != NULL)
+    free(wt->zeros);
+
+  free(wt);
+}
@@ -0,0 +1,21 @@
+
+#ifndef _SARY_WT_H_
+#define _SARY_WT_H_
+
+typedef struct {
+  int M, levels;
+
+  unsigned int **bits;  /* the bitvector of each level */
+  int **ranks;          /* the number of ones before each bitvector word */
+  int *zeros;           /* the number of zeros in each level */
+
+  long mem_bytes;
+  int num_rank_ops;
+} SARY_WT;
+
+SARY_WT *sary_wt_build(int *Pos, int M);
+int sary_wt_count(SARY_WT *wt, int lo, int hi, int l, int r);
+int sary_wt_list(SARY_WT *wt, int lo, int hi, int l, int r, int *positions);
+void sary_wt_free(SARY_WT *wt);
+
+#endif
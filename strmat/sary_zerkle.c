@@ -14,9 +14,10 @@
  *
  * Basically, it functions as follows:
  *
- * setup()       reads the input and sets up the various lists and arrays
+ * startup()     copies the input and sets up the various lists and arrays
  *
- * main()        repeatedly calles make_pass() until the suffix array has
+ * zerkle_parallel()
+ *               repeatedly calles make_pass() until the suffix array has
  *               been properly generated
  *
  * make_pass()   completes a pass (as described in the paper) by processing
@@ -31,29 +32,34 @@
  * proc_back()   process a child that is after its largest sibling class
  *
  *
+ * All of the state of one run lives in a ZERKLE_CTX structure, so any
+ * number of suffix arrays can be built at once.  The suffixes whose
+ * successors lie in one parent class always form whole classes, so the
+ * parents of a pass touch disjoint sets of classes and can be processed
+ * by several threads (see zerkle_parallel()).  Each thread then only
+ * needs its own "acted on by this class" list; the "acted on this pass"
+ * list and the next class name are shared and guarded by a mutex.
+ *
  * This program can be compiled to generate debugging information.  If
  * so, a great deal of output will be generated, detailing every single
  * action of the algorithm and reporting the state after each pass.
- * Simply compile with the DEBUG macro set.  If using gcc, this would
- * be "gcc -DDEBUG -O -o suf suf.c".  Otherwise, the only output is
- * the suffix array.
+ * Simply compile with the DEBUG macro set (and use a single thread).
  *
- * The input string is taken on stdin (keyboard or redirection), and
- * must consist only of alphabetical characters.  The puncutation mark
- * "!" is added as an "end of string" character.  This extra suffix is
- * always in position 0 and can be ignored.
+ * The input may contain any characters, which are ordered as signed
+ * chars (as by the rest of the suffix array code).  An "end of string"
+ * suffix, smaller than all others, is added.  This extra suffix is
+ * always in position 0 and is dropped from the result.
  *
  * Each character of input requires 58 bytes of storage (assuming that
- * characters use one byte and integers use 4).  This can be reduced
- * to 57 by compiling with debugging turned off.
- *
- * MAX is the size of the largest possible input.  Raise this number if
- * you want to work with bigger strings.
+ * characters use one byte and integers use 4), plus 4 bytes for each
+ * extra thread.
  **********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
 #include "sary_zerkle.h"
 
 #ifndef TRUE
@@ -61,6 +67,14 @@
 #define FALSE 0
 #endif
 
+/*
+ * A pass is only spread across the threads when it has at least
+ * ZERKLE_PAR_MIN parents, and the threads claim ZERKLE_CHUNK parents
+ * at a time.
+ */
+#define ZERKLE_PAR_MIN 1024
+#define ZERKLE_CHUNK 64
+
 
 /**********************************************************************
  **********************************************************************
@@ -73,7 +87,7 @@
 struct in_struct
   {
     int sufnum;
-    char data;
+    int key;		/* the character, or 0 for the end of string */
   };
 
 /* This structure holds the info needed for any particular class */
@@ -96,73 +110,92 @@ struct parent_struct
     int size;		/* Size of the class */
   };
 
+typedef struct zerkle_worker ZERKLE_WORKER;
 
-/**********************************************************************
- **********************************************************************
- **********                                                  **********
- **********              Function Prototypes                 **********
- **********                                                  **********
- **********************************************************************
- **********************************************************************/
+/* This structure holds the state of one run of the algorithm */
+typedef struct
+  {
+    int pass;		/* pass number through the data */
+
+    int N;		/* size of input */
 
-static void startup(char *s, int n, int *posarray);
-static int cmp_str(struct in_struct *first,struct in_struct *second);
-static void proc_fwd(int classnum);
-static void allocspace(void);
-static void make_pass(void);
-static void proc_parent(int parentnum);
-static void setupclasses(void);
+    int *Hgt;		/* Hgt array as in paper */
+
+    int *Pos;		/* Pos array as in paper */
 
 #ifdef DEBUG
-static void debugoutput();
-static void pclass(int classnum);
+    char *originput;	/* original input */
 #endif
 
+    int *which;		/* which class each suffix belongs to */
 
-/**********************************************************************
- **********************************************************************
- **********                                                  **********
- **********                Global Variables                  **********
- **********                                                  **********
- **********************************************************************
- **********************************************************************/
+    int *where;		/* Where in Pos[] each suffix is */
 
-static int pass;		/* pass number through the data */
+    struct class_struct *classes;	/* start & size of each class */
 
-static int N;			/* size of input */
+    /* active parents (acted on last pass) */
+    struct parent_struct *parentsd;	/* data */
+    int *parents;			/* list of names of parents */
+    int numparents;			/* number of them */
 
-static int *Hgt;		/* Hgt array as in paper */
+    /* list of classes acted on this pass, (parents in next pass) */
+    int *actedon;			/* list of names */
+    int numactedon;			/* number of them */
 
-static int *Pos;		/* Pos array as in paper */
-
-#ifdef DEBUG
-static char *originput;	/* original input */
-#endif
+    /* name of the next class that will be created */
+    int nextname;
 
-static int *which;		/* which class each suffix belongs to */
+    /* This indicates what a class should look like as it is acted upon */
+    int *move;
 
-static int *where;		/* Where in Pos[] each suffix is */
+    /* The threads, and whether the current pass is using them */
+    int nthreads, threaded;
+    ZERKLE_WORKER *workers;
+    pthread_mutex_t lock;
+    int next_parent;	/* next parent to be handed out to a thread */
+    int firstnew;	/* name of the first class created by this pass */
+  } ZERKLE_CTX;
 
-static struct class_struct *classes;	/* start & size of each class */
+/* This structure holds the state of one thread */
+struct zerkle_worker
+  {
+    ZERKLE_CTX *z;
+    int id;
 
-/* active parents (acted on last pass) */
-static struct parent_struct *parentsd;	/* data */
-static int *parents;			/* list of names of parents */
-static int numparents;			/* number of them */
+    /* list of classes acted by this class, */
+    int *cl_actedon;		/* list of names */
+    int numcl_actedon;		/* number of them */
+  };
 
-/* list of classes acted on this pass, (parents in next pass) */
-static int *actedon;			/* list of names */
-static int numactedon;			/* number of them */
 
-/* list of classes acted by this class, */
-static int *cl_actedon;		/* list of names */
-static int numcl_actedon;		/* number of them */
+/**********************************************************************
+ **********************************************************************
+ **********                                                  **********
+ **********              Function Prototypes                 **********
+ **********                                                  **********
+ **********************************************************************
+ **********************************************************************/
 
-/* name of the next class that will be created */
-static int nextname;
+static int startup(ZERKLE_CTX *z, char *s, int n, int *posarray);
+static int cmp_str(const void *first, const void *second);
+static int allocspace(ZERKLE_CTX *z);
+static void freespace(ZERKLE_CTX *z);
+static void setupclasses(ZERKLE_CTX *z);
+static void make_pass(ZERKLE_CTX *z);
+static void run_phase(ZERKLE_CTX *z, void *(*fn)(void *));
+static void *pass_parents(void *arg);
+static void *pass_moves(void *arg);
+static void *pass_which(void *arg);
+static void proc_parent(ZERKLE_WORKER *w, int parentnum);
+static void proc_fwd(ZERKLE_WORKER *w, int classnum);
+static void proc_back(ZERKLE_WORKER *w, int classnum);
+static void act_on(ZERKLE_WORKER *w, int affclass);
+static int new_name(ZERKLE_CTX *z);
 
-/* This indicates what a class should look like as it is acted upon */
-static int *move;
+#ifdef DEBUG
+static void debugoutput(ZERKLE_CTX *z);
+static void pclass(ZERKLE_CTX *z, int classnum);
+#endif
 
 
 /**********************************************************************
@@ -178,58 +211,60 @@ static int *move;
  *
  * This function gets the sequence, allocates memory, and sets up all the
  * arrays to the condition they need to be before the first pass.
+ *
+ * Returns non-zero on success, zero if memory ran out.
  **********************************************************************/
-void startup(char *s, int n, int *posarray)
+static int startup(ZERKLE_CTX *z, char *s, int n, int *posarray)
 {
   struct in_struct *input; /* input data */
-  int i;
+  int i, N, *Pos, *Hgt;
 
-  N = n;
-  Pos = posarray;
+  N = z->N = n;
+  Pos = z->Pos = posarray;
 
   /* Allocate space for input */
   if ((input=(struct in_struct *)
              calloc((size_t)(N+1),sizeof(struct in_struct)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for input array\n");
-      exit(1);
-    } /* if */
+    return 0;
 
 #ifdef DEBUG
   puts("Reading input...");
 #endif
 
-  /* Get Sequence */
-  i=0;
+  /* Get Sequence, with the keys ordered as signed chars */
   for (i=0; i < N; i++) {
     input[i].sufnum = i;
-    input[i].data = *s++;
+    input[i].key = (int) *s++ - CHAR_MIN + 1;
   }
 
-  /* Stick on an end-of-string character */
+  /* Stick on an end-of-string character, smaller than all the others */
   input[N].sufnum=N;  /* attach the suffix number to this item */
-  input[N].data='\0';
-  N++;
+  input[N].key=0;
+  N = ++z->N;
 
 #ifdef DEBUG
   puts("Allocating space...");
 #endif
 
   /* Allocate space for the wide variety of arrays needed for this mess */
-  allocspace();
+  if (!allocspace(z))
+    {
+      free(input);
+      return 0;
+    } /* if */
+  Hgt = z->Hgt;
 
 #ifdef DEBUG
   puts("Setting up originput, Pos, Hgt, and where...");
-#endif
 
-#ifdef DEBUG
   /* Copy original data over */
   for(i=0;i<N;i++)
-    originput[i]=input[i].data;
+    z->originput[i]=(input[i].key ? (char) (input[i].key + CHAR_MIN - 1)
+                                  : '!');
 #endif
 
   /* Sort input */
-  qsort(input, (size_t)N, sizeof(struct in_struct), (int (*)())cmp_str);
+  qsort(input, (size_t)N, sizeof(struct in_struct), cmp_str);
 
   /* copy input into Pos array and record divisions in Hgt array */
   for(i=0;i<N;i++)
@@ -238,20 +273,20 @@ void startup(char *s, int n, int *posarray)
   /* Set up Hgt array */
   Hgt[0]=0;
   for(i=1;i<N;i++)
-    if (input[i].data==input[i-1].data)
+    if (input[i].key==input[i-1].key)
       Hgt[i]=(-1);
     else
       Hgt[i]=0;  /* Start of new class */
 
   /* Set up "where" array */
   for (i=0;i<N;i++)
-    where[Pos[i]]=i;
+    z->where[Pos[i]]=i;
 
 #ifdef DEBUG
   puts("Setting up classes...");
 #endif
 
-  setupclasses();
+  setupclasses(z);
 
   /* Free input array */
   free(input);
@@ -260,6 +295,7 @@ void startup(char *s, int n, int *posarray)
   puts("Done setting up");
 #endif
 
+  return 1;
 } /* startup() */
 
 
@@ -268,28 +304,32 @@ void startup(char *s, int n, int *posarray)
  *
  * This sets up the various lists to contain the regular and parent classes.
  *************************************************************************/
-void setupclasses(void)
+static void setupclasses(ZERKLE_CTX *z)
 {
-  int i;
+  int i, N, nextname;
+  struct class_struct *classes;
+
+  N=z->N;
+  classes=z->classes;
 
   /* Set up original parent class (all the suffixes) */
   /* Give it the name "0" and make it the whole Pos array */
-  parentsd[0].start=0;
-  parentsd[0].size=N;
+  z->parentsd[0].start=0;
+  z->parentsd[0].size=N;
 
   /* Put said parent class in the list */
-  parents[0]=0;
-  numparents=1;
+  z->parents[0]=0;
+  z->numparents=1;
 
-  /* Start up the first (regular) class */
+  /* Start up the first (regular) class, holding just the end of string */
   classes[0].start=classes[0].newstart=0;
   nextname=0;
-  which[N]=0;
+  z->which[z->Pos[0]]=0;
 
   /* Set up the rest of the classes */
   for (i=1;i<N;i++)
     {
-      if (Hgt[i]==0)
+      if (z->Hgt[i]==0)
         {
 	  /* Finish up the previous class ... */
           classes[nextname].size=i-classes[nextname].start;
@@ -305,10 +345,10 @@ void setupclasses(void)
         } /* if */
 
       /* Indicate which class this suffix is in */
-      which[Pos[i]]=nextname;
+      z->which[z->Pos[i]]=nextname;
 
 #ifdef DEBUG
-      printf("%d gets %d\n",Pos[i],nextname);
+      printf("%d gets %d\n",z->Pos[i],nextname);
 #endif
 
     } /* for */
@@ -322,101 +362,97 @@ void setupclasses(void)
   classes[nextname].actedclass=FALSE;
   classes[nextname].actedpass=FALSE;
   nextname++;
+
+  z->nextname=nextname;
 } /* setupclasses() */
 
 /*************************************************************************
  * ALLOCSPACE()
  *
- * This allocates all the arrays that will be needed for this stunt.
+ * This allocates all the arrays that will be needed for this stunt,
+ * including a "class acted on" list for each thread.
+ *
+ * Returns non-zero on success, zero if memory ran out (anything that
+ * was allocated is left for freespace()).
  *************************************************************************/
-void allocspace(void)
+static int allocspace(ZERKLE_CTX *z)
 {
-  /* Allocate space for Hgt array */
-  if ((Hgt=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for Hgt array\n");
-      exit(1);
-    } /* if */
+  int t;
+  size_t N;
 
+  N=(size_t) z->N;
+
+  z->Hgt=(int *) calloc(N,sizeof(int));
 #ifdef DEBUG
-  /* Allocate space for data array (to contain input in original order) */
-  if ((originput=(char *) calloc((size_t)N,sizeof(char)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for original data array\n");
-      exit(1);
-    } /* if */
+  z->originput=(char *) calloc(N,sizeof(char));
+  if (z->originput==NULL)
+    return 0;
 #endif
-
-  /* Allocate space for "where" array */
-  if ((where=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for where array\n");
-      exit(1);
-    } /* if */
-
-  /* Allocate space for "which" array */
-  if ((which=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for where array\n");
-      exit(1);
-    } /* if */
-
-  /* Allocate space for parent data */
-  if ((parentsd=(struct parent_struct *)
-             calloc((size_t)N,sizeof(struct parent_struct)))==NULL)
+  z->where=(int *) calloc(N,sizeof(int));
+  z->which=(int *) calloc(N,sizeof(int));
+  z->parentsd=(struct parent_struct *) calloc(N,sizeof(struct parent_struct));
+  z->parents=(int *) calloc(N,sizeof(int));
+  z->actedon=(int *) calloc(N,sizeof(int));
+  z->move=(int *) calloc(N,sizeof(int));
+  z->classes=(struct class_struct *) calloc(N,sizeof(struct class_struct));
+  z->workers=(ZERKLE_WORKER *) calloc((size_t) z->nthreads,
+                                      sizeof(ZERKLE_WORKER));
+
+  if (z->Hgt==NULL || z->where==NULL || z->which==NULL ||
+      z->parentsd==NULL || z->parents==NULL || z->actedon==NULL ||
+      z->move==NULL || z->classes==NULL || z->workers==NULL)
+    return 0;
+
+  for (t=0;t<z->nthreads;t++)
     {
-      fprintf(stderr,"Not enough memory for parent data\n");
-      exit(1);
-    } /* if */
-
-  /* Allocate space for parent list */
-  if ((parents=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for parents list\n");
-      exit(1);
-    } /* if */
-
-  /* Allocate space for "acted on by this pass" list */
-  if ((actedon=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for acted on list\n");
-      exit(1);
-    } /* if */
+      z->workers[t].z=z;
+      z->workers[t].id=t;
+      if ((z->workers[t].cl_actedon=(int *) calloc(N,sizeof(int)))==NULL)
+        return 0;
+    } /* for */
 
-  /* Allocate space for "acted on by this class" list */
-  if ((cl_actedon=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for class acted on list\n");
-      exit(1);
-    } /* if */
+  return 1;
+} /* allocspace() */
 
-  /* Allocate space for the move array */
-  if ((move=(int *) calloc((size_t)N,sizeof(int)))==NULL)
-    {
-      fprintf(stderr,"Not enough memory for class acted on list\n");
-      exit(1);
-    } /* if */
+/*************************************************************************
+ * FREESPACE()
+ *
+ * This frees whatever allocspace() managed to allocate.
+ *************************************************************************/
+static void freespace(ZERKLE_CTX *z)
+{
+  int t;
 
-  /* Allocate space for classes data */
-  if ((classes=(struct class_struct *)
-             calloc((size_t)N,sizeof(struct class_struct)))==NULL)
+  if (z->workers!=NULL)
     {
-      fprintf(stderr,"Not enough memory for classes array\n");
-      exit(1);
+      for (t=0;t<z->nthreads;t++)
+        free(z->workers[t].cl_actedon);
+      free(z->workers);
     } /* if */
 
-
-} /* allocspace() */
+  free(z->Hgt);
+#ifdef DEBUG
+  free(z->originput);
+#endif
+  free(z->where);
+  free(z->which);
+  free(z->parentsd);
+  free(z->parents);
+  free(z->actedon);
+  free(z->move);
+  free(z->classes);
+} /* freespace() */
 
 /*************************************************************************
  * CMP_STR()
  *
  * This compares two structs and indicates which is greater.
- * Used by the qsort() function in setup().
+ * Used by the qsort() function in startup().
  *************************************************************************/
-int cmp_str(struct in_struct *first,struct in_struct *second)
+static int cmp_str(const void *first, const void *second)
 {
-  return first->data - second->data;
+  return ((const struct in_struct *) first)->key -
+         ((const struct in_struct *) second)->key;
 } /* cmp_str() */
 
 
@@ -430,6 +466,68 @@ int cmp_str(struct in_struct *first,struct in_struct *second)
  **********************************************************************/
 
 
+/*************************************************************************
+ * NEW_NAME()
+ *
+ * This hands out the name of the next class to be created.
+ *************************************************************************/
+static int new_name(ZERKLE_CTX *z)
+{
+  int name;
+
+  if (!z->threaded)
+    return z->nextname++;
+
+  pthread_mutex_lock(&z->lock);
+  name=z->nextname++;
+  pthread_mutex_unlock(&z->lock);
+
+  return name;
+} /* new_name() */
+
+
+/*************************************************************************
+ * ACT_ON()
+ *
+ * This records that a class has been "acted on" by the class being
+ * processed, and so also in this pass.
+ *************************************************************************/
+static void act_on(ZERKLE_WORKER *w, int affclass)
+{
+  ZERKLE_CTX *z;
+
+  z=w->z;
+
+  /* ...this processed class */
+  if (!z->classes[affclass].actedclass)
+    {
+      /* Set the "acted on" flag */
+      z->classes[affclass].actedclass=TRUE;
+
+      /* put it in the list */
+      w->cl_actedon[w->numcl_actedon]=affclass;
+      w->numcl_actedon++;
+
+      /* ...and acted on in this pass */
+      if (!z->classes[affclass].actedpass)
+        {
+          /* Set the "acted on" flag */
+          z->classes[affclass].actedpass=TRUE;
+
+          /* put it in the list */
+          if (z->threaded)
+            pthread_mutex_lock(&z->lock);
+          z->actedon[z->numactedon]=affclass;
+          z->numactedon++;
+          if (z->threaded)
+            pthread_mutex_unlock(&z->lock);
+
+        } /* if (not yet acted on by this pass) */
+
+    } /* if (not yet acted on by this class) */
+} /* act_on() */
+
+
 /*************************************************************************
  * PROC_FWD()
  *
@@ -437,17 +535,25 @@ int cmp_str(struct in_struct *first,struct in_struct *second)
  * NAL of the acted upon class.  This is used on the children of a parent
  * class before the largest child.  After that, PROC_BACK() is used.
  *************************************************************************/
-void proc_fwd(int classnum)
+static void proc_fwd(ZERKLE_WORKER *w, int classnum)
 {
   int j;	/* to step through the elements of the class */
   int start;	/* start of class is Pos */
   int size;	/* size of class in Pos */
   int affsuf;	/* the suffix affected by this suffix */
   int affclass; /* the class affected by this suffix */
+  int name;	/* name of a newly created class */
+  int *Pos;
+  ZERKLE_CTX *z;
+  struct class_struct *classes;
 
   /* Abbreviations for this affected class and newly created class */
   struct class_struct *thisclass, *newclass;
 
+  z=w->z;
+  Pos=z->Pos;
+  classes=z->classes;
+
 #ifdef DEBUG
   printf("Processing class %d forward\n",classnum);
 #endif
@@ -457,7 +563,7 @@ void proc_fwd(int classnum)
   size=classes[classnum].size;
 
   /* Clear the list of classes acted upon by this class to empty */
-  numcl_actedon=0;
+  w->numcl_actedon=0;
 
   /* Go through each element of this class */
   for (j=start;j<size+start;j++)
@@ -473,7 +579,7 @@ void proc_fwd(int classnum)
         affsuf=Pos[j]-1;
 
         /* Figure out which class it is in */
-        affclass=which[affsuf];
+        affclass=z->which[affsuf];
 
         /* Don't do anything if it is a singleton class */
         if (classes[affclass].size!=1)
@@ -482,42 +588,19 @@ void proc_fwd(int classnum)
             /* Record the needed swap */
 	    /* In the next pass, the affected suffix will go in the */
 	    /* position it is here placed in the move[] array */
-	    move[classes[affclass].NAL]=affsuf;
+	    z->move[classes[affclass].NAL]=affsuf;
 
 #ifdef DEBUG
             printf("Affected suffix %d moves to %d in\n",
 	           affsuf, classes[affclass].NAL);
-            pclass(affclass);
+            pclass(z,affclass);
 #endif
 
 	    /* Point NAL to the next location in the class */
 	    classes[affclass].NAL++;
 
-	    /* Indicate that this class has been "acted on" by... */
-	    /* ...this processed class */
-	    if (!classes[affclass].actedclass)
-	      {
-	        /* Set the "acted on" flag */
-		classes[affclass].actedclass=TRUE;
-
-		/* put it in the list */
-                cl_actedon[numcl_actedon]=affclass;
-                numcl_actedon++;
-
-	        /* ...and acted on in this pass */
-	        if (!classes[affclass].actedpass)
-	          {
-	            /* Set the "acted on" flag */
-		    classes[affclass].actedpass=TRUE;
-
-		    /* put it in the list */
-                    actedon[numactedon]=affclass;
-                    numactedon++;
-
-	            /* ...and acted on in this pass */
-	          } /* if (not yet acted on by this pass) */
-
-	      } /* if (not yet acted on by this class) */
+	    /* Indicate that this class has been "acted on" */
+	    act_on(w,affclass);
 
 	  } /* if (it's not a singleton class) */
 
@@ -543,14 +626,14 @@ void proc_fwd(int classnum)
   /* members of the structure.  These will be changed again if the class */
   /* is split again. */
 
-  for (j=0;j<numcl_actedon;j++)
+  for (j=0;j<w->numcl_actedon;j++)
     {
 
-      thisclass=&(classes[cl_actedon[j]]);
+      thisclass=&(classes[w->cl_actedon[j]]);
 
 #ifdef DEBUG
       printf("Considering splitting class %d, NAL %d, LAL %d\n",
-             cl_actedon[j],thisclass->NAL,thisclass->LAL);
+             w->cl_actedon[j],thisclass->NAL,thisclass->LAL);
 #endif
 
       /* Do the rest only if splitting to make a class with a new name */
@@ -558,15 +641,17 @@ void proc_fwd(int classnum)
 
         {
 
+	  name=new_name(z);
+
 #ifdef DEBUG
           printf("Actually splitting class %d at %d to make class %d\n",
-	         cl_actedon[j],thisclass->NAL,nextname);
+	         w->cl_actedon[j],thisclass->NAL,name);
 #endif
 
-          Hgt[thisclass->newstart]=pass;
+          z->Hgt[thisclass->newstart]=z->pass;
 
 	  /* Create the new class */
-	  newclass=&(classes[nextname]);
+	  newclass=&(classes[name]);
 
 	  newclass->start=newclass->newstart=thisclass->newstart;
 	  newclass->NAL=newclass->newstart;
@@ -580,11 +665,10 @@ void proc_fwd(int classnum)
 	  thisclass->newsize=thisclass->LAL-thisclass->NAL+1;
 
 #ifdef DEBUG
-	  pclass(cl_actedon[j]);
-	  pclass(nextname);
+	  pclass(z,w->cl_actedon[j]);
+	  pclass(z,name);
 #endif
 
-	  nextname++;
         } /* if */
 
       /* Get it ready to be possibly acted on by the next class */
@@ -608,17 +692,25 @@ void proc_fwd(int classnum)
  * matter in processing a class).  However, the acted-on classes will
  * have suffixes swapped towards the right (LAL), instead of left (NAL).
  *************************************************************************/
-void proc_back(int classnum)
+static void proc_back(ZERKLE_WORKER *w, int classnum)
 {
   int j;	/* to step through the elements of the class */
   int start;	/* start of class is Pos */
   int size;	/* size of class in Pos */
   int affsuf;	/* the suffix affected by this suffix */
   int affclass; /* the class affected by this suffix */
+  int name;	/* name of a newly created class */
+  int *Pos;
+  ZERKLE_CTX *z;
+  struct class_struct *classes;
 
   /* Abbreviations for this affected class and newly created class */
   struct class_struct *thisclass, *newclass;
 
+  z=w->z;
+  Pos=z->Pos;
+  classes=z->classes;
+
 #ifdef DEBUG
   printf("Processing class %d backward\n",classnum);
 #endif
@@ -628,7 +720,7 @@ void proc_back(int classnum)
   size=classes[classnum].size;
 
   /* Clear the list of classes acted upon by this class to empty */
-  numcl_actedon=0;
+  w->numcl_actedon=0;
 
   /* Go through each element of this class */
   for (j=start;j<size+start;j++)
@@ -644,7 +736,7 @@ void proc_back(int classnum)
         affsuf=Pos[j]-1;
 
         /* Figure out which class it is in */
-        affclass=which[affsuf];
+        affclass=z->which[affsuf];
 
         /* Don't do anything if it is a singleton class */
         if (classes[affclass].size!=1)
@@ -653,42 +745,19 @@ void proc_back(int classnum)
             /* Record the needed swap */
 	    /* In the next pass, the affected suffix will go in the */
 	    /* Position indicated by the move[] array */
-	    move[classes[affclass].LAL]=affsuf;
+	    z->move[classes[affclass].LAL]=affsuf;
 
 #ifdef DEBUG
             printf("Affected suffix %d moves to %d in\n",
 	           affsuf, classes[affclass].LAL);
-            pclass(affclass);
+            pclass(z,affclass);
 #endif
 
 	    /* Point LAL to the next location in the class */
 	    classes[affclass].LAL--;
 
-	    /* Indicate that this class has been "acted on" by... */
-	    /* ...this processed class */
-	    if (!classes[affclass].actedclass)
-	      {
-	        /* Set the "acted on" flag */
-		classes[affclass].actedclass=TRUE;
-
-		/* put it in the list */
-                cl_actedon[numcl_actedon]=affclass;
-                numcl_actedon++;
-
-	        /* ...and acted on in this pass */
-	        if (!classes[affclass].actedpass)
-	          {
-	            /* Set the "acted on" flag */
-		    classes[affclass].actedpass=TRUE;
-
-		    /* put it in the list */
-                    actedon[numactedon]=affclass;
-                    numactedon++;
-
-	            /* ...and acted on in this pass */
-	          } /* if (not yet acted on by this pass) */
-
-	      } /* if (not yet acted on by this class) */
+	    /* Indicate that this class has been "acted on" */
+	    act_on(w,affclass);
 
 	  } /* if (it's not a singleton class) */
 
@@ -714,14 +783,14 @@ void proc_back(int classnum)
   /* members of the structure.  These will be changed again if the class */
   /* is split again. */
 
-  for (j=0;j<numcl_actedon;j++)
+  for (j=0;j<w->numcl_actedon;j++)
     {
 
-      thisclass=&(classes[cl_actedon[j]]);
+      thisclass=&(classes[w->cl_actedon[j]]);
 
 #ifdef DEBUG
       printf("Considering splitting class %d, NAL %d, LAL %d\n",
-             cl_actedon[j],thisclass->NAL,thisclass->LAL);
+             w->cl_actedon[j],thisclass->NAL,thisclass->LAL);
 #endif
 
       /* Do the rest only if splitting to make a class with a new name */
@@ -729,18 +798,20 @@ void proc_back(int classnum)
 
         {
 
+	  name=new_name(z);
+
 #ifdef DEBUG
           printf("Actually splitting class %d at %d to make class %d\n",
-	         cl_actedon[j],thisclass->LAL+1,nextname);
+	         w->cl_actedon[j],thisclass->LAL+1,name);
           puts("Before: ");
-	  pclass(cl_actedon[j]);
+	  pclass(z,w->cl_actedon[j]);
 	  puts("After:");
 #endif
 
-          Hgt[thisclass->LAL+1]=pass;
+          z->Hgt[thisclass->LAL+1]=z->pass;
 
 	  /* Create the new class */
-	  newclass=&(classes[nextname]);
+	  newclass=&(classes[name]);
 
 	  newclass->start=newclass->newstart=thisclass->LAL+1;
 	  newclass->NAL=newclass->newstart;
@@ -754,11 +825,10 @@ void proc_back(int classnum)
 	  thisclass->newsize=thisclass->LAL-thisclass->NAL+1;
 
 #ifdef DEBUG
-	  pclass(cl_actedon[j]);
-	  pclass(nextname);
+	  pclass(z,w->cl_actedon[j]);
+	  pclass(z,name);
 #endif
 
-	  nextname++;
         } /* if */
 
       /* Get it ready to be possibly acted on by the next class */
@@ -768,7 +838,7 @@ void proc_back(int classnum)
     } /* for */
 
 
-} /* proc_fwd() */
+} /* proc_back() */
 
 
 /*************************************************************************
@@ -778,37 +848,168 @@ void proc_back(int classnum)
  * initializes some lists, processes all the parents who were acted on
  * in the last pass, then swaps the suffixes around in the Pos[], where[]
  * and which[] arrays.
+ *
+ * Each of those three steps only touches classes that no other parent
+ * (or acted on class, or new class) touches, so when the pass is big
+ * enough each step is spread across the threads.
  *************************************************************************/
-void make_pass(void)
+static void make_pass(ZERKLE_CTX *z)
 {
-  int i;
-  int j;
-  int classstart,classend,classsize,classNAL,classLAL;
-  int firstnew;
   int *listtmp;
-  struct class_struct *thisclass;
 
 #ifdef DEBUG
-  printf("Making pass %d\n",pass);
+  printf("Making pass %d\n",z->pass);
 #endif
 
+  z->threaded=(z->nthreads > 1 && z->numparents >= ZERKLE_PAR_MIN);
+
   /* Get the name of what the next new class will be */
-  firstnew=nextname;
+  z->firstnew=z->nextname;
 
   /* Initialize list of "acted upon" classes to empty */
-  numactedon=0;
+  z->numactedon=0;
 
   /* Run through all the parents that were acted on in the last pass */
-  for (i=0;i<numparents;i++)
-    proc_parent(parents[i]);  /* Process all children but largest */
+  z->next_parent=0;
+  run_phase(z, pass_parents);
+
+  /* Move all the suffixes into their new positions, then update all */
+  /* the "acted on" classes, and record them as parent classes */
+  run_phase(z, pass_moves);
+
+  /* Update which[] for all suffixes that are elements of new classes */
+  run_phase(z, pass_which);
+
+#ifdef DEBUG
+  printf("Total %d classes acted on in this pass\n",z->numactedon);
+#endif
+
+  /* make "acted on" list into parent list for next pass */
+  listtmp=z->actedon;
+  z->actedon=z->parents;
+  z->parents=listtmp;
+  z->numparents=z->numactedon;
+} /* make_pass() */
+
+
+/*************************************************************************
+ * RUN_PHASE()
+ *
+ * This calls fn for each thread's worker, or just for the first worker
+ * if the pass is not using the threads.  A worker whose thread cannot
+ * be started is run in the calling thread instead.
+ *************************************************************************/
+static void run_phase(ZERKLE_CTX *z, void *(*fn)(void *))
+{
+  int t, *started;
+  pthread_t *threads;
+
+  if (!z->threaded)
+    {
+      fn(&z->workers[0]);
+      return;
+    } /* if */
+
+  threads=(pthread_t *) malloc(z->nthreads * sizeof(pthread_t));
+  started=(int *) calloc((size_t) z->nthreads, sizeof(int));
+
+  for (t=1;t<z->nthreads;t++)
+    if (threads!=NULL && started!=NULL &&
+        pthread_create(&threads[t],NULL,fn,&z->workers[t])==0)
+      started[t]=TRUE;
+
+  fn(&z->workers[0]);
+
+  for (t=1;t<z->nthreads;t++)
+    if (started!=NULL && started[t])
+      pthread_join(threads[t],NULL);
+    else
+      fn(&z->workers[t]);
+
+  free(threads);
+  free(started);
+} /* run_phase() */
+
+
+/*************************************************************************
+ * PASS_PARENTS()
+ *
+ * This processes the parents, claiming ZERKLE_CHUNK of them at a time.
+ *************************************************************************/
+static void *pass_parents(void *arg)
+{
+  int i, lo, hi;
+  ZERKLE_WORKER *w;
+  ZERKLE_CTX *z;
+
+  w=(ZERKLE_WORKER *) arg;
+  z=w->z;
+
+  if (!z->threaded)
+    {
+      for (i=0;i<z->numparents;i++)
+        proc_parent(w,z->parents[i]);  /* Process all children but largest */
+      return NULL;
+    } /* if */
+
+  while (1)
+    {
+      pthread_mutex_lock(&z->lock);
+      lo=z->next_parent;
+      hi=lo+ZERKLE_CHUNK;
+      if (hi>z->numparents)
+        hi=z->numparents;
+      z->next_parent=hi;
+      pthread_mutex_unlock(&z->lock);
+
+      if (lo>=hi)
+        break;
+
+      for (i=lo;i<hi;i++)
+        proc_parent(w,z->parents[i]);
+    } /* while */
+
+  return NULL;
+} /* pass_parents() */
+
+
+/*************************************************************************
+ * PASS_MOVES()
+ *
+ * This moves the suffixes of this thread's share of the acted on classes
+ * into their new positions, and then updates those classes.
+ *************************************************************************/
+static void *pass_moves(void *arg)
+{
+  int i, j, lo, hi;
+  int classstart,classend,classsize,classNAL,classLAL;
+  int *Pos, *where, *move;
+  ZERKLE_WORKER *w;
+  ZERKLE_CTX *z;
+  struct class_struct *thisclass;
+
+  w=(ZERKLE_WORKER *) arg;
+  z=w->z;
+  Pos=z->Pos;
+  where=z->where;
+  move=z->move;
+
+  lo=0;
+  hi=z->numactedon;
+  if (z->threaded)
+    {
+      lo=(int) ((long) z->numactedon * w->id / z->nthreads);
+      hi=(int) ((long) z->numactedon * (w->id + 1) / z->nthreads);
+    } /* if */
 
-  /* Move all the suffixes into their new positions */
-  for (i=0;i<numactedon;i++)  /* for each acted-on class */
+  for (i=lo;i<hi;i++)  /* for each acted-on class */
     {
-      classstart=classes[actedon[i]].start;
-      classsize=classes[actedon[i]].size;
-      classNAL=classes[actedon[i]].NAL;
-      classLAL=classes[actedon[i]].LAL;
+      thisclass=&z->classes[z->actedon[i]];
+
+      classstart=thisclass->start;
+      classsize=thisclass->size;
+      classNAL=thisclass->NAL;
+      classLAL=thisclass->LAL;
       classend=classstart+classsize-1;
 
       /* Move suffixes swapped with NAL to the beginning of the class */
@@ -835,37 +1036,50 @@ void make_pass(void)
 	  where[Pos[j]]=j;
 	} /* for */
 
+      /* Record it as a parent class, and set up its remainder */
+      z->parentsd[z->actedon[i]].start=thisclass->start;
+      z->parentsd[z->actedon[i]].size=thisclass->size;
+
+      thisclass->start=thisclass->NAL=thisclass->newstart;
+      thisclass->size=thisclass->newsize;
+      thisclass->LAL=thisclass->start+thisclass->size-1;
+      thisclass->actedpass=FALSE;
     } /* for */
 
-  /* Update which[] for all suffixes that are elements of new classes */
-  for (i=firstnew;i<nextname;i++)
-    for (j=classes[i].start;j<classes[i].start+classes[i].size;j++)
-      which[Pos[j]]=i;
+  return NULL;
+} /* pass_moves() */
 
-#ifdef DEBUG
-  printf("Total %d classes acted on in this pass\n",numactedon);
-#endif
 
-  /* Update all the "acted on" classes, and record them as parent classes */
-  for (i=0;i<numactedon;i++)
+/*************************************************************************
+ * PASS_WHICH()
+ *
+ * This updates which[] for this thread's share of the new classes.
+ *************************************************************************/
+static void *pass_which(void *arg)
+{
+  int i, j, lo, hi, num;
+  ZERKLE_WORKER *w;
+  ZERKLE_CTX *z;
+
+  w=(ZERKLE_WORKER *) arg;
+  z=w->z;
+
+  num=z->nextname-z->firstnew;
+  lo=0;
+  hi=num;
+  if (z->threaded)
     {
-      thisclass=&classes[actedon[i]];
+      lo=(int) ((long) num * w->id / z->nthreads);
+      hi=(int) ((long) num * (w->id + 1) / z->nthreads);
+    } /* if */
 
-      parentsd[actedon[i]].start=thisclass->start;
-      parentsd[actedon[i]].size=thisclass->size;
+  for (i=z->firstnew+lo;i<z->firstnew+hi;i++)
+    for (j=z->classes[i].start;j<z->classes[i].start+z->classes[i].size;j++)
+      z->which[z->Pos[j]]=i;
 
-      thisclass->start=thisclass->NAL=thisclass->newstart;
-      thisclass->size=thisclass->newsize;
-      thisclass->LAL=thisclass->start+thisclass->size-1;
-      thisclass->actedpass=FALSE;
-    } /* for */
+  return NULL;
+} /* pass_which() */
 
-  /* make "acted on" list into parent list for next pass */
-  listtmp=actedon;
-  actedon=parents;
-  parents=listtmp;
-  numparents=numactedon;
-} /* make_pass() */
 
 /*************************************************************************
  * PROC_PARENT()
@@ -874,17 +1088,25 @@ void make_pass(void)
  * one.  It goes left->right until the largest one, then right->left
  * (from the other side) until the largest.
  *************************************************************************/
-void proc_parent(int parentnum)
+static void proc_parent(ZERKLE_WORKER *w, int parentnum)
 {
   int largechild;	/* Largest child of this parent */
   int largesize;	/* size of said child */
   int pstart, psize;	/* copies of this parent's start and size */
   int cclass;		/* name of a child class */
   int p;		/* Position of a child's element in Pos */
+  int *Pos, *which;
+  ZERKLE_CTX *z;
+  struct class_struct *classes;
+
+  z=w->z;
+  Pos=z->Pos;
+  which=z->which;
+  classes=z->classes;
 
   /* Get copies, for convenience */
-  pstart=parentsd[parentnum].start;
-  psize=parentsd[parentnum].size;
+  pstart=z->parentsd[parentnum].start;
+  psize=z->parentsd[parentnum].size;
 
 #ifdef DEBUG
   printf("Processing parent %d, starts: %d, size %d\n",
@@ -927,7 +1149,7 @@ void proc_parent(int parentnum)
   while (which[Pos[p]]!=largechild)
     {
       /* process this class */
-      proc_fwd(which[Pos[p]]);
+      proc_fwd(w,which[Pos[p]]);
 
       /* skip to next class */
       p+=classes[which[Pos[p]]].size;
@@ -938,7 +1160,7 @@ void proc_parent(int parentnum)
   cclass=which[Pos[pstart+psize-1]];
   while (cclass!=largechild)
     {
-      proc_back(cclass);
+      proc_back(w,cclass);
 
       /* go to previous class */
       cclass=which[Pos[classes[cclass].start-1]];
@@ -956,100 +1178,117 @@ void proc_parent(int parentnum)
  *************************************************************************/
 
 
-int zerkle(char *seq, int n, int *posarray)
+/*************************************************************************
+ * ZERKLE_PARALLEL()
+ *
+ * This computes the suffix array of seq[0..n-1] into posarray[1..n]
+ * (as positions 1..n), using up to nthreads threads for each pass.
+ * posarray must have room for n+1 entries.
+ *
+ * Returns non-zero on success, zero if memory ran out.
+ *************************************************************************/
+int zerkle_parallel(char *seq, int n, int *posarray, int nthreads)
 {
   int i;
+  ZERKLE_CTX ctx, *z;
+
+  if (seq == NULL || n <= 0 || posarray == NULL)
+    return 0;
+
+  z=&ctx;
+  memset(z, 0, sizeof(ZERKLE_CTX));
+  z->nthreads=(nthreads < 1 ? 1 : nthreads);
 
-  startup(seq, n, posarray);
+  if (!startup(z, seq, n, posarray))
+    {
+      freespace(z);
+      return 0;
+    } /* if */
+
+  pthread_mutex_init(&z->lock, NULL);
 
 #ifdef DEBUG
   putchar('\n');
 
   puts("Original input");
-  for (i=0;i<N;i++)
-    printf("  %c",originput[i]);
+  for (i=0;i<z->N;i++)
+    printf("  %c",z->originput[i]);
 
   putchar('\n');
 
   puts("POS array");
-  for (i=0;i<N;i++)
-    printf("%3d",Pos[i]);
+  for (i=0;i<z->N;i++)
+    printf("%3d",z->Pos[i]);
 
   putchar('\n');
 
   puts("First character of suffixes indicated by Pos");
-  for (i=0;i<N;i++)
-    printf("%3c",originput[Pos[i]]);
+  for (i=0;i<z->N;i++)
+    printf("%3c",z->originput[z->Pos[i]]);
 
   putchar('\n');
 
   puts("Whichclass array:");
-  for (i=0;i<N;i++)
-    printf("%3d",which[i]);
+  for (i=0;i<z->N;i++)
+    printf("%3d",z->which[i]);
 
   putchar('\n');
 
   puts("Hgt array");
-  for (i=0;i<N;i++)
-    printf("%3d",Hgt[i]);
+  for (i=0;i<z->N;i++)
+    printf("%3d",z->Hgt[i]);
 
   putchar('\n');
   putchar('\n');
 
   puts("Class positions:");
-  for(i=0;i<N;i++)
-    printf("%3d",which[Pos[i]]);
+  for(i=0;i<z->N;i++)
+    printf("%3d",z->which[z->Pos[i]]);
 
   putchar('\n');
 
-  for (i=0;i<nextname;i++)
-	pclass(i);
+  for (i=0;i<z->nextname;i++)
+	pclass(z,i);
 #endif /* DEBUG */
 
   /* Find the suffix array */
-  pass=1;
-  while (nextname<N)
+  z->pass=1;
+  while (z->nextname<z->N)
     {
-      make_pass();
+      make_pass(z);
 #ifdef DEBUG
-      printf("Result of Pass %d:\n",pass);
-      debugoutput();
+      printf("Result of Pass %d:\n",z->pass);
+      debugoutput(z);
 #endif
-      pass++;
+      z->pass++;
     }
 
   /*
    * Pos[0] is the position of the end-of-string character, so
    * set the suffix_array to the array starting at Pos[1].
    *
-   * The suffices are computed as 0..N-1 (plus end-of-string N), so
-   * we must shift them to 1..N (and ignore the end-of-string).
+   * The suffices are computed as 0..N-2 (plus end-of-string N-1), so
+   * we must shift them to 1..N-1 (and ignore the end-of-string).
    */
-  for (i=1; i <= N; i++)
-    Pos[i]++;
+  for (i=1; i < z->N; i++)
+    z->Pos[i]++;
 
-  /* Output the Pos array 
-  for (i=0;i<N;i++)
-    printf(" %2d",Pos[i]);
+  pthread_mutex_destroy(&z->lock);
+  freespace(z);
 
-  putchar('\n');
-  */
+  return 1;
+} /* zerkle_parallel() */
 
-  free(Hgt);
-#ifdef DEBUG
-  free(originput);
-#endif
-  free(where);
-  free(which);
-  free(parentsd);
-  free(parents);
-  free(actedon);
-  free(cl_actedon);
-  free(move);
-  free(classes);
 
-  return 1;
-} /* sarray_zerkle_build() */
+/*************************************************************************
+ * ZERKLE()
+ *
+ * The single threaded version of zerkle_parallel().
+ *************************************************************************/
+int zerkle(char *seq, int n, int *posarray)
+{
+  return zerkle_parallel(seq, n, posarray, 1);
+} /* zerkle() */
 
 
 /*************************************************************************
@@ -1060,42 +1299,42 @@ int zerkle(char *seq, int n, int *posarray)
  *************************************************************************
  *************************************************************************/
 #ifdef DEBUG
-void debugoutput(void)
+static void debugoutput(ZERKLE_CTX *z)
 {
   int i;
 
   printf("     ");
-  for (i=0;i<N;i++)
+  for (i=0;i<z->N;i++)
     printf("%3d",i);
   putchar('\n');
 
   printf("INPUT");
-  for (i=0;i<N;i++)
-    printf("  %c",originput[i]);
+  for (i=0;i<z->N;i++)
+    printf("  %c",z->originput[i]);
   putchar('\n');
 
   printf("POS  ");
-  for (i=0;i<N;i++)
-    printf("%3d",Pos[i]);
+  for (i=0;i<z->N;i++)
+    printf("%3d",z->Pos[i]);
   putchar('\n');
 
   printf("WHICH");
-  for (i=0;i<N;i++)
-    printf("%3d",which[i]);
+  for (i=0;i<z->N;i++)
+    printf("%3d",z->which[i]);
   putchar('\n');
 
   printf("CLASS");
-  for(i=0;i<N;i++)
-    printf("%3d",which[Pos[i]]);
+  for(i=0;i<z->N;i++)
+    printf("%3d",z->which[z->Pos[i]]);
   putchar('\n');
 
 }
 
-void pclass(int classnum)
+static void pclass(ZERKLE_CTX *z, int classnum)
 {
   struct class_struct *clpt;
 
-  clpt=&classes[classnum];
+  clpt=&z->classes[classnum];
 
   printf("Class %d: st%d si%d NAL%d LAL%d nst %d nsi%d ac%d ap%d\n",
          classnum, clpt->start, clpt->size, clpt->NAL, clpt->LAL,
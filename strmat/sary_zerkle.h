@@ -3,5 +3,6 @@
 #define _SARY_ZERKLE_H_
 
 int zerkle(char *s, int n, int *posarray);
- 
+int zerkle_parallel(char *s, int n, int *posarray, int nthreads);
+
 #endif
@@ -0,0 +1,137 @@
+/*
+ * stree_kangaroo.c
+ *
+ * The "kangaroo" k-mismatches algorithm, finding every text position
+ * where the pattern occurs with at most k mismatches (substitutions)
+ * in O(kn) time.  At each alignment, a constant time longest common
+ * extension query on the generalized suffix tree of the text and the
+ * pattern jumps past the matching stretch up to the next mismatch, so
+ * at most k+1 queries are made per text position.
+ *
+ * The text and the pattern are given by their identifiers in the tree,
+ * so that one preprocessed tree holding a text and many patterns can
+ * serve the searches for all of the patterns.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stree_lce.h"
+#include "stree_kangaroo.h"
+
+
+/*
+ * kangaroo_prep
+ *
+ * Set up a k-mismatches search of a pattern in a text.
+ *
+ * Parameters:   lce  -  the LCE structure of a generalized suffix tree
+ *                       holding the text and the pattern
+ *               tid  -  the identifier of the text in the tree
+ *               pid  -  the identifier of the pattern in the tree
+ *               k    -  the number of mismatches allowed
+ *
+ * Returns:  An initialized KANGAROO_STRUCT structure, or NULL.
+ */
+KANGAROO_STRUCT *kangaroo_prep(STREE_LCE *lce, int tid, int pid, int k)
+{
+  KANGAROO_STRUCT *kg;
+
+  if (lce == NULL || tid < 1 || tid > lce->num_strings ||
+      pid < 1 || pid > lce->num_strings || k < 0)
+    return NULL;
+
+  if ((kg = malloc(sizeof(KANGAROO_STRUCT))) == NULL)
+    return NULL;
+  memset(kg, 0, sizeof(KANGAROO_STRUCT));
+
+  kg->lce = lce;
+  kg->tid = tid;
+  kg->pid = pid;
+  kg->N = lce->lengths[tid-1];
+  kg->M = lce->lengths[pid-1];
+  kg->k = (k < kg->M ? k : kg->M);
+
+  return kg;
+}
+
+
+/*
+ * kangaroo_first, kangaroo_next
+ *
+ * Search for the occurrences of the pattern with at most k mismatches,
+ * returning the first match and then each of the rest in turn.
+ *
+ * Parameters:   kg     -  a k-mismatches structure
+ *               lend   -  where to store the start of the match
+ *               rend   -  where to store the end of the match
+ *               score  -  where to store its number of mismatches
+ *
+ * Returns:  non-zero if a match was found, zero at the end of the text.
+ */
+int kangaroo_first(KANGAROO_STRUCT *kg, int *lend, int *rend, int *score)
+{
+  kg->next = 1;
+  return kangaroo_next(kg, lend, rend, score);
+}
+
+int kangaroo_next(KANGAROO_STRUCT *kg, int *lend, int *rend, int *score)
+{
+  int i, j, M, mis;
+
+  M = kg->M;
+  for (i=kg->next; i <= kg->N - M + 1; i++) {
+#ifdef STATS
+    kg->num_positions++;
+#endif
+
+    /*
+     * Jump along the alignment, one matching stretch and one mismatch
+     * at a time, until the pattern is used up or too many mismatches
+     * are found.
+     */
+    mis = 0;
+    j = 0;
+    while (1) {
+      j += stree_lce(kg->lce, kg->pid, j + 1, kg->tid, i + j);
+
+#ifdef STATS
+      kg->num_lces++;
+#endif
+
+      if (j >= M || ++mis > kg->k)
+        break;
+      j++;
+      if (j >= M)
+        break;
+    }
+
+    if (mis <= kg->k) {
+      *lend = i;
+      *rend = i + M - 1;
+      *score = mis;
+      kg->next = i + 1;
+      return 1;
+    }
+  }
+
+  kg->next = i;
+  return 0;
+}
+
+
+/*
+ * kangaroo_free
+ *
+ * Free up the allocated KANGAROO_STRUCT structure (but not its LCE
+ * structure).
+ *
+ * Parameters:   kg  -  a KANGAROO_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
+void kangaroo_free(KANGAROO_STRUCT *kg)
+{
+  if (kg != NULL)
+    free(kg);
+}
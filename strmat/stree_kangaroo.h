@@ -0,0 +1,21 @@
+#ifndef _STREE_KANGAROO_H_
+#define _STREE_KANGAROO_H_
+
+#include "stree_lce.h"
+
+typedef struct {
+  STREE_LCE *lce;             /* the LCE queries over the text and pattern */
+  int tid, pid;               /* their string identifiers in the tree */
+  int M, N, k;
+
+  int next;                   /* the next text position to check */
+
+  int num_positions, num_lces;
+} KANGAROO_STRUCT;
+
+KANGAROO_STRUCT *kangaroo_prep(STREE_LCE *lce, int tid, int pid, int k);
+int kangaroo_first(KANGAROO_STRUCT *kg, int *lend, int *rend, int *score);
+int kangaroo_next(KANGAROO_STRUCT *kg, int *lend, int *rend, int *score);
+void kangaroo_free(KANGAROO_STRUCT *kg);
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ * stree_kdiff.c
+ *
+ * The Landau-Vishkin k-differences algorithm, finding every text
+ * position where an alignment of the pattern with at most k
+ * differences (mismatches, insertions and deletions) ends, in O(kn)
+ * time.  For each number of differences e = 0..k, it computes the
+ * furthest reaching row of each diagonal of the dynamic programming
+ * table from the rows of e-1 differences, then slides down the
+ * diagonal past the matching characters with one constant time
+ * longest common extension query on the generalized suffix tree of
+ * the pattern and text.
+ *
+ * Each match is reported by its end position and its number of
+ * differences, along with the start of the shortest alignment ending
+ * there with that many differences (as in myers.c).  The start is
+ * found by running the same algorithm backwards from the end, with
+ * the slides done by comparing characters, since the suffix tree only
+ * answers extensions to the right.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stree_lce.h"
+#include "stree_kdiff.h"
+
+#define KDIFF_NONE -1
+
+
+/*
+ * kdiff_prep
+ *
+ * Allocate the structures for a k-differences search.
+ *
+ * Parameters:   lce  -  the LCE structure of a generalized suffix tree
+ *                       holding the pattern (string 1) and the text
+ *                       (string 2)
+ *               P    -  the pattern
+ *               M    -  the pattern length
+ *               T    -  the text
+ *               N    -  the text length
+ *               k    -  the number of differences allowed (at most M-1)
+ *
+ * Returns:  An initialized KDIFF_STRUCT structure, or NULL.
+ */
+KDIFF_STRUCT *kdiff_prep(STREE_LCE *lce, char *P, int M, char *T, int N,
+                         int k)
+{
+  int size;
+  KDIFF_STRUCT *kd;
+
+  if (lce == NULL || P == NULL || M <= 0 || T == NULL || N <= 0 || k < 0)
+    return NULL;
+
+  if ((kd = malloc(sizeof(KDIFF_STRUCT))) == NULL)
+    return NULL;
+  memset(kd, 0, sizeof(KDIFF_STRUCT));
+
+  kd->lce = lce;
+  kd->P = P;
+  kd->T = T;
+  kd->M = M;
+  kd->N = N;
+  kd->k = (k < M ? k : M - 1);
+
+  /*
+   * Diagonal d holds the cells (i, i+d).  A match ends on a diagonal
+   * from 1-M to N-M, and those depend on the diagonals up to k away.
+   */
+  kd->lo = -kd->k;
+  kd->hi = N - M + kd->k;
+  if (kd->hi < kd->lo)
+    kd->hi = kd->lo;
+  size = kd->hi - kd->lo + 1;
+
+  kd->row = malloc(2 * (size + 2) * sizeof(int));
+  kd->score = malloc(size * sizeof(int));
+  kd->back = malloc(2 * (2 * kd->k + 1) * sizeof(int));
+  if (kd->row == NULL || kd->score == NULL || kd->back == NULL) {
+    kdiff_free(kd);
+    return NULL;
+  }
+
+  return kd;
+}
+
+
+/*
+ * kdiff_compute
+ *
+ * Run the Landau-Vishkin algorithm, recording for each diagonal the
+ * fewest differences of an alignment ending at its last row.
+ */
+static void kdiff_compute(KDIFF_STRUCT *kd)
+{
+  int d, e, r, c, M, N, lo, hi, size;
+  int *cur, *prev;
+
+  M = kd->M;
+  N = kd->N;
+  lo = kd->lo;
+  hi = kd->hi;
+  size = hi - lo + 1;
+
+  for (d=0; d < size; d++)
+    kd->score[d] = -1;
+
+  cur = prev = NULL;
+  for (e=0; e <= kd->k; e++) {
+    cur = kd->row + (e & 1) * (size + 2) + 1 - lo;
+    cur[lo-1] = cur[hi+1] = KDIFF_NONE;
+
+    for (d=lo; d <= hi; d++) {
+      /*
+       * Find the furthest row reached with e differences before the
+       * slide:  the row 0 of the search (any text start, e = 0), or
+       * a mismatch, text insertion or pattern deletion after a path
+       * with e-1 differences.
+       */
+      r = KDIFF_NONE;
+      if (e == 0) {
+        if (d >= 0)
+          r = 0;
+      }
+      else {
+        if (prev[d] != KDIFF_NONE)
+          r = prev[d] + 1;
+        if (prev[d-1] != KDIFF_NONE && (c = prev[d-1]) > r)
+          r = c;
+        if (prev[d+1] != KDIFF_NONE && (c = prev[d+1] + 1) > r)
+          r = c;
+
+        if (r != KDIFF_NONE) {
+          if (r > M)
+            r = M;
+          if (r + d > N)
+            r = N - d;
+          if (r < 0 || r + d < 0)
+            r = KDIFF_NONE;
+        }
+      }
+
+      /*
+       * Slide down the diagonal.
+       */
+      if (r != KDIFF_NONE && r < M && r + d < N) {
+        r += stree_lce(kd->lce, 1, r + 1, 2, r + d + 1);
+
+#ifdef STATS
+        kd->num_lces++;
+#endif
+      }
+
+#ifdef STATS
+      kd->num_extends++;
+#endif
+
+      cur[d] = r;
+
+      if (r == M && kd->score[d-lo] == -1)
+        kd->score[d-lo] = e;
+    }
+
+    prev = cur;
+  }
+}
+
+
+/*
+ * kdiff_start
+ *
+ * Find the start of the shortest alignment of the pattern ending at
+ * text position end (1-based) with score differences.  This is the
+ * Landau-Vishkin algorithm run backwards from there, aligning the
+ * whole reversed pattern against the text read backwards, where
+ * diagonal d holds the cells (i, i+d) of i pattern characters against
+ * i+d text characters.  The shortest alignment with score differences
+ * ends on the leftmost diagonal reaching row M.
+ *
+ * Returns:  the start position (1-based).
+ */
+static int kdiff_start(KDIFF_STRUCT *kd, int end, int score)
+{
+  int d, e, r, c, M, *cur, *prev;
+  char *P, *T;
+
+  M = kd->M;
+  P = kd->P + M - 1;          /* P[-i] is the i'th character from the end */
+  T = kd->T + end - 1;        /* and T[-i] is for the text */
+
+  cur = prev = NULL;
+  for (e=0; e <= score; e++) {
+    cur = kd->back + (e & 1) * (2 * kd->k + 1) + kd->k;
+
+    for (d=-e; d <= e; d++) {
+      /*
+       * As in kdiff_compute, except that the search starts at the
+       * corner of the table, so only the diagonals within e of it
+       * can be reached (the ones within e-1 in prev).
+       */
+      r = KDIFF_NONE;
+      if (e == 0)
+        r = 0;
+      else {
+        if (d > -e && d < e && prev[d] != KDIFF_NONE)
+          r = prev[d] + 1;
+        if (d > 1 - e && prev[d-1] != KDIFF_NONE && (c = prev[d-1]) > r)
+          r = c;
+        if (d < e - 1 && prev[d+1] != KDIFF_NONE && (c = prev[d+1] + 1) > r)
+          r = c;
+
+        if (r != KDIFF_NONE) {
+          if (r > M)
+            r = M;
+          if (r + d > end)
+            r = end - d;
+          if (r < 0 || r + d < 0)
+            r = KDIFF_NONE;
+        }
+      }
+
+      if (r != KDIFF_NONE) {
+        while (r < M && r + d < end && P[-r] == T[-(r+d)]) {
+          r++;
+#ifdef STATS
+          kd->num_start_compares++;
+#endif
+        }
+#ifdef STATS
+        kd->num_start_compares++;
+#endif
+      }
+
+      cur[d] = r;
+    }
+
+    prev = cur;
+  }
+
+  for (d=-score; d <= score; d++)
+    if (cur[d] == M)
+      return end - (M + d) + 1;
+
+  return (end - M - score + 1 > 1 ? end - M - score + 1 : 1);
+}
+
+
+/*
+ * kdiff_first, kdiff_next
+ *
+ * Search for the ends of the alignments of the pattern with at most k
+ * differences, returning the first match (in text order) and then
+ * each of the rest in turn.
+ *
+ * Parameters:   kd     -  a k-differences structure
+ *               lend   -  where to store the start of the match
+ *               rend   -  where to store the end of the match
+ *               score  -  where to store its number of differences
+ *
+ * Returns:  non-zero if a match was found, zero at the end of the text.
+ */
+int kdiff_first(KDIFF_STRUCT *kd, int *lend, int *rend, int *score)
+{
+  kdiff_compute(kd);
+
+  kd->next = (1 - kd->M > kd->lo ? 1 - kd->M : kd->lo);
+  return kdiff_next(kd, lend, rend, score);
+}
+
+int kdiff_next(KDIFF_STRUCT *kd, int *lend, int *rend, int *score)
+{
+  int d, last;
+
+  last = (kd->N - kd->M < kd->hi ? kd->N - kd->M : kd->hi);
+  for (d=kd->next; d <= last; d++) {
+    if (kd->score[d-kd->lo] != -1) {
+      *rend = kd->M + d;
+      *score = kd->score[d-kd->lo];
+      *lend = kdiff_start(kd, *rend, *score);
+      kd->next = d + 1;
+      return 1;
+    }
+  }
+
+  kd->next = d;
+  return 0;
+}
+
+
+/*
+ * kdiff_free
+ *
+ * Free up the allocated KDIFF_STRUCT structure (but not its LCE
+ * structure).
+ *
+ * Parameters:   kd  -  a KDIFF_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
+void kdiff_free(KDIFF_STRUCT *kd)
+{
+  if (kd == NULL)
+    return;
+
+  if (kd->row != NULL)
+    free(kd->row);
+  if (kd->score != NULL)
+    free(kd->score);
+  if (kd->back != NULL)
+    free(kd->back);
+  free(kd);
+}
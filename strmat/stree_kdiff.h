@@ -0,0 +1,26 @@
+#ifndef _STREE_KDIFF_H_
+#define _STREE_KDIFF_H_
+
+#include "stree_lce.h"
+
+typedef struct {
+  STREE_LCE *lce;             /* the LCE queries over P (1) and T (2) */
+  char *P, *T;
+  int M, N, k;
+
+  int lo, hi;                 /* the range of diagonals */
+  int *row;                   /* the furthest reaching rows (two levels) */
+  int *score;                 /* the matches ending on each diagonal */
+  int *back;                  /* the rows of the backward search */
+  int next;
+
+  int num_extends, num_lces, num_start_compares;
+} KDIFF_STRUCT;
+
+KDIFF_STRUCT *kdiff_prep(STREE_LCE *lce, char *P, int M, char *T, int N,
+                         int k);
+int kdiff_first(KDIFF_STRUCT *kd, int *lend, int *rend, int *score);
+int kdiff_next(KDIFF_STRUCT *kd, int *lend, int *rend, int *score);
+void kdiff_free(KDIFF_STRUCT *kd);
+
+#endif
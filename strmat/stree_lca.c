@@ -47,6 +47,12 @@ static unsigned int MSB(unsigned int number);
  */
 
 static unsigned int msb_table[256], lsb_table[256];
+
+/*
+ * The mask of the bits from position n up to 31 (zero when n is 32,
+ * since shifting by the word size is undefined).
+ */
+#define HIGH_BITS(n)  ((n) >= 32 ? 0U : ~0U << (n))
 static int init_flag = 0;
 
 /*
@@ -123,11 +129,11 @@ static unsigned int MSB(unsigned int number)
   if (!init_flag)
     init_tables();
 
-  if (number & (0xff << 24))
+  if (number & (0xffU << 24))
     return 24 + msb_table[number >> 24];
-  if (number & (0xff << 16))
+  if (number & (0xffU << 16))
     return 16 + msb_table[number >> 16];
-  if (number & (0xff << 8))
+  if (number & (0xffU << 8))
     return 8 + msb_table[number >> 8];
   if (number & 0xff)
     return msb_table[number];
@@ -331,11 +337,14 @@ STREE_NODE lca_lookup(LCA_STRUCT *lca, STREE_NODE x, STREE_NODE y)
    * with 0), and then simply OR's the k+1..32 bits of I[xid] and the
    * number 2^k.
    */
-  k = MSB(I[xid] ^ I[yid]);
-  mask = ~0 << (k + 1);
-  b = (I[xid] & mask) | (1 << k);
+  if (I[xid] == I[yid])
+    b = I[xid];
+  else {
+    k = MSB(I[xid] ^ I[yid]);
+    b = (I[xid] & HIGH_BITS(k + 1)) | (1U << k);
+  }
 
-  mask = ~0 << h(b);
+  mask = HIGH_BITS(h(b));
   j = h( (A[xid] & A[yid]) & mask );
 
 #ifdef STATS
@@ -349,11 +358,10 @@ STREE_NODE lca_lookup(LCA_STRUCT *lca, STREE_NODE x, STREE_NODE y)
   if (l == j)
     xbar = x;
   else {
-    mask = ~(~0 << j);       /* The bit-complement of setting bits j..32 */
+    mask = ~HIGH_BITS(j);     /* The bit-complement of setting bits j..32 */
     k = MSB(A[xid] & mask);
 
-    mask = ~0 << (k + 1);
-    Iw = (I[xid] & mask) | (1 << k);
+    Iw = (I[xid] & HIGH_BITS(k + 1)) | (1U << k);
     w = L[Iw];
     xbar = stree_get_parent(tree, w);
   }
@@ -369,11 +377,10 @@ STREE_NODE lca_lookup(LCA_STRUCT *lca, STREE_NODE x, STREE_NODE y)
   if (l == j)
     ybar = y;
   else {
-    mask = ~(~0 << j);
+    mask = ~HIGH_BITS(j);
     k = MSB(A[yid] & mask);
 
-    mask = ~0 << (k + 1);
-    Iw = (I[yid] & mask) | (1 << k);
+    Iw = (I[yid] & HIGH_BITS(k + 1)) | (1U << k);
     w = L[Iw];
     ybar = stree_get_parent(tree, w);
   }
@@ -0,0 +1,181 @@
+/*
+ * stree_lce.c
+ *
+ * Longest common extension queries between suffixes of the strings of
+ * a generalized suffix tree, answered in constant time as the string
+ * depth of the least common ancestor of the two suffixes' nodes (using
+ * the linear time LCA preprocessing of stree_lca.c).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef STRMAT
+#include "stree_strmat.h"
+#else
+#include "stree.h"
+#endif
+#include "stree_lca.h"
+#include "stree_lce.h"
+
+
+/*
+ * stree_lce_prep
+ *
+ * Preprocess a generalized suffix tree for LCE queries, computing the
+ * string depth of every node, the node of every suffix and the LCA
+ * structure.  The tree must not be changed while the structure is in
+ * use (and is not freed by stree_lce_free).
+ *
+ * Parameters:   tree         -  a suffix tree
+ *               num_strings  -  the number of strings in the tree,
+ *                               with identifiers 1..num_strings
+ *               lengths      -  their lengths (lengths[0] is string 1)
+ *
+ * Returns:  An initialized STREE_LCE structure, or NULL.
+ */
+STREE_LCE *stree_lce_prep(SUFFIX_TREE tree, int num_strings, int *lengths)
+{
+  int i, top, num_nodes, pos, id;
+  char *str;
+  STREE_NODE node, child, *stack;
+  STREE_LCE *lce;
+
+  if (tree == NULL || num_strings <= 0 || lengths == NULL)
+    return NULL;
+
+  if ((lce = malloc(sizeof(STREE_LCE))) == NULL)
+    return NULL;
+  memset(lce, 0, sizeof(STREE_LCE));
+
+  lce->tree = tree;
+  lce->num_strings = num_strings;
+
+  num_nodes = stree_get_num_nodes(tree);
+  lce->lengths = malloc(num_strings * sizeof(int));
+  lce->leaves = malloc(num_strings * sizeof(STREE_NODE *));
+  lce->depth = malloc(num_nodes * sizeof(int));
+  stack = malloc(num_nodes * sizeof(STREE_NODE));
+  if (lce->lengths == NULL || lce->leaves == NULL || lce->depth == NULL ||
+      stack == NULL) {
+    if (stack != NULL)
+      free(stack);
+    stree_lce_free(lce);
+    return NULL;
+  }
+
+  memset(lce->leaves, 0, num_strings * sizeof(STREE_NODE *));
+  for (i=0; i < num_strings; i++) {
+    lce->lengths[i] = lengths[i];
+    lce->leaves[i] = malloc((lengths[i] + 1) * sizeof(STREE_NODE));
+    if (lce->leaves[i] == NULL) {
+      free(stack);
+      stree_lce_free(lce);
+      return NULL;
+    }
+    memset(lce->leaves[i], 0, (lengths[i] + 1) * sizeof(STREE_NODE));
+  }
+
+  /*
+   * Walk the tree (without recursion, since the tree of a repetitive
+   * string can be very deep), setting each child's depth from its
+   * parent's and recording the suffixes ending at each node.
+   */
+  node = stree_get_root(tree);
+  lce->depth[stree_get_ident(tree, node)] = 0;
+  stack[0] = node;
+  top = 1;
+  while (top > 0) {
+    node = stack[--top];
+
+    for (i=1; stree_get_leaf(tree, node, i, &str, &pos, &id); i++)
+      if (id >= 1 && id <= num_strings && pos >= 0 && pos < lengths[id-1])
+        lce->leaves[id-1][pos] = node;
+
+    child = stree_get_children(tree, node);
+    while (child != NULL) {
+      lce->depth[stree_get_ident(tree, child)] =
+        lce->depth[stree_get_ident(tree, node)] +
+        stree_get_edgelen(tree, child);
+      stack[top++] = child;
+      child = stree_get_next(tree, child);
+    }
+  }
+  free(stack);
+
+  if ((lce->lca = lca_prep(tree)) == NULL) {
+    stree_lce_free(lce);
+    return NULL;
+  }
+
+  return lce;
+}
+
+
+/*
+ * stree_lce
+ *
+ * The length of the longest common prefix of the suffix of string id1
+ * starting at pos1 and the suffix of string id2 starting at pos2.
+ *
+ * Parameters:   lce   -  a preprocessed suffix tree
+ *               id1   -  the first string (1..num_strings)
+ *               pos1  -  the first suffix position (1-based)
+ *               id2   -  the second string
+ *               pos2  -  the second suffix position
+ *
+ * Returns:  the length of the longest common extension (0 if either
+ *           position is past the end of its string).
+ */
+int stree_lce(STREE_LCE *lce, int id1, int pos1, int id2, int pos2)
+{
+  STREE_NODE x, y, z;
+
+  if (pos1 < 1 || pos1 > lce->lengths[id1-1] ||
+      pos2 < 1 || pos2 > lce->lengths[id2-1])
+    return 0;
+
+#ifdef STATS
+  lce->num_queries++;
+#endif
+
+  x = lce->leaves[id1-1][pos1-1];
+  y = lce->leaves[id2-1][pos2-1];
+  if (x == y)
+    return lce->depth[stree_get_ident(lce->tree, x)];
+
+  z = lca_lookup(lce->lca, x, y);
+  return lce->depth[stree_get_ident(lce->tree, z)];
+}
+
+
+/*
+ * stree_lce_free
+ *
+ * Free up the allocated STREE_LCE structure (but not its tree).
+ *
+ * Parameters:   lce  -  a STREE_LCE structure
+ *
+ * Returns:  nothing.
+ */
+void stree_lce_free(STREE_LCE *lce)
+{
+  int i;
+
+  if (lce == NULL)
+    return;
+
+  if (lce->leaves != NULL) {
+    for (i=0; i < lce->num_strings; i++)
+      if (lce->leaves[i] != NULL)
+        free(lce->leaves[i]);
+    free(lce->leaves);
+  }
+  if (lce->lengths != NULL)
+    free(lce->lengths);
+  if (lce->depth != NULL)
+    free(lce->depth);
+  if (lce->lca != NULL)
+    lca_free(lce->lca);
+  free(lce);
+}
@@ -0,0 +1,26 @@
+#ifndef _STREE_LCE_H_
+#define _STREE_LCE_H_
+
+#ifdef STRMAT
+#include "stree_strmat.h"
+#else
+#include "stree.h"
+#endif
+#include "stree_lca.h"
+
+typedef struct {
+  SUFFIX_TREE tree;
+  LCA_STRUCT *lca;
+
+  int num_strings, *lengths;
+  STREE_NODE **leaves;        /* the node of each suffix of each string */
+  int *depth;                 /* the string depth of each node */
+
+  int num_queries;
+} STREE_LCE;
+
+STREE_LCE *stree_lce_prep(SUFFIX_TREE tree, int num_strings, int *lengths);
+int stree_lce(STREE_LCE *lce, int id1, int pos1, int id2, int pos2);
+void stree_lce_free(STREE_LCE *lce);
+
+#endif
@@ -30,6 +30,7 @@
 #include <ctype.h>
 #include "strmat.h"
 #include "strmat_alpha.h"
+#include "strmat_match.h"
 #include "strmat_print.h"
 #include "strmat_seqary.h"
 #include "strmat_stubs.h"
@@ -39,6 +40,8 @@
 #include "strmat_util.h"
 
 #include "sary_match.h"
+#include "sary_pack.h"
+#include "sary_fm.h"
 #include "stree_ukkonen.h"
 
 
@@ -51,6 +54,7 @@ static int stree_build_policy = SORTED_LIST;
 static int stree_build_threshold = 10;
 static int stree_print_flag = ON;
 static int stats_flag = ON;
+static MATCH_MODE match_mode = { MATCH_ALL, NULL, NULL };
 
 // FILE *fpout = stdout;
 #define fpout stdout
@@ -67,6 +71,7 @@ void suf_tree_menu(void);
 void suf_ary_menu(void);
 void repeats_menu(void);
 void set_display_options(void);
+int print_match_callback(MATCH_NODE *match, void *arg);
 
 
 
@@ -233,12 +238,15 @@ void util_menu()
 void basic_alg_menu()
 {
   int i, status, num_lines, alpha_size, num_patterns;
-  char ch;
+  char ch, *path;
   STRING *text, *pattern, **patterns;
+  static int bench_length = 1000000;
+  static int pscan_threads = 4;
+  static int num_mismatches = 1;
 
   alpha_size = 0;
   while (1)  {
-    num_lines = 22;
+    num_lines = 48;
     printf("\n**   Basic Search Algorithm Menu    **\n\n");
     printf("1)  Naive Algorithm\n");
     printf("2)  Boyer-Moore Variations\n");
@@ -246,6 +254,10 @@ void basic_alg_menu()
     printf("     b) Extended bad character rule\n");
     printf("     c) Good suffix & bad character rules\n");
     printf("     d) Good suffix & extended bad character rules\n");
+    printf("     e) Tuned, with an unrolled skip loop (no statistics)\n");
+    printf("     f) Horspool's algorithm\n");
+    printf("     g) Sunday's quick search\n");
+    printf("     h) benchmark the Boyer-Moore variations\n");
     printf("3)  Knuth-Morris-Pratt (original preprocessing)\n");
     printf("     a) using sp values\n");
     printf("     b) using sp' values\n");
@@ -255,6 +267,28 @@ void basic_alg_menu()
     printf("     b) Good suffix rule using keyword and suffix trees\n");
     printf("     c) Good suffix rule using suffix tree only\n");
     printf("     d) using original Boyer-Moore (1c) on each pattern\n");
+    printf("6)  First/Last Character Filter (SSE2/AVX2)\n");
+    printf("     a) search a text\n");
+    printf("     b) benchmark against naive and Boyer-Moore\n");
+    printf("7)  Multi-threaded Chunked Scanning\n");
+    printf("     a) Naive algorithm\n");
+    printf("     b) Boyer-Moore (good suffix & extended bad character)\n");
+    printf("     c) Knuth-Morris-Pratt (sp' values)\n");
+    printf("     d) Z values algorithm\n");
+    printf("     e) benchmark the speedup against the number of threads\n");
+    printf("8)  Streaming Search of a File\n");
+    printf("     a) Knuth-Morris-Pratt automaton (sp' values)\n");
+    printf("     b) Boyer-Moore (good suffix & extended bad character)\n");
+    printf("9)  Bit-parallel and Approximate Matching\n");
+    printf("     a) Shift-Or\n");
+    printf("     b) BNDM\n");
+    printf("     c) Shift-Add (k mismatches)\n");
+    printf("     d) Myers' bit-vector algorithm (k differences)\n");
+    printf("     e) Sellers' dynamic programming (k differences)\n");
+    printf("     f) benchmark Myers against dynamic programming\n");
+    printf("     g) Landau-Vishkin with suffix tree LCE (k differences)\n");
+    printf("     h) Kangaroo jumps with suffix tree LCE (k mismatches)\n");
+    printf("     i) Kangaroo jumps for a batch of patterns\n");
     printf("*)  String Utilites\n");
     printf("0)  Exit\n");
     printf("\nEnter Selection: ");
@@ -278,7 +312,7 @@ void basic_alg_menu()
       status = map_sequences(text, pattern, NULL, 0);
       if (status != -1) {
         mprintf ("Executing naive search algorithm...\n\n");
-        strmat_naive_match(pattern, text, stats_flag);
+        strmat_naive_match(pattern, text, &match_mode, stats_flag);
         unmap_sequences(text, pattern, NULL, 0);
       }
       mend(num_lines);
@@ -286,14 +320,29 @@ void basic_alg_menu()
       break;
 
     case '2':
-      ch = choice[1];
-      if (toupper(ch) != 'A' && toupper(ch) != 'B' &&
-          toupper(ch) != 'C' && toupper(ch) != 'D') {
+      ch = toupper(choice[1]);
+      if (ch < 'A' || ch > 'H') {
         printf("\nYou must specify the Boyer-Moore variation"
                " (as in '2a' or '2c').\n");
         continue;
       }
 
+      if (ch == 'H') {
+        bench_length = get_bounded("Text Length", 1, 1000000000,
+                                   bench_length);
+        printf("\n");
+        if (bench_length == 0) {
+          bench_length = 1000000;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        strmat_bm_bench(bench_length);
+        mend(num_lines);
+        putchar('\n');
+        break;
+      }
+
       if (!(pattern = get_string("pattern")) || !(text = get_string("text")))
         continue;
 
@@ -308,10 +357,20 @@ void basic_alg_menu()
       if (status != -1) {
         mprintf("Executing Boyer-Moore algorithm...\n\n");
         switch (toupper(ch)) {
-        case 'A':  strmat_bmbad_match(pattern, text, stats_flag);  break;
-        case 'B':  strmat_bmext_match(pattern, text, stats_flag);  break;
-        case 'C':  strmat_bmgood_match(pattern, text, stats_flag);  break;
-        case 'D':  strmat_bmextgood_match(pattern, text, stats_flag);  break;
+        case 'A':  strmat_bmbad_match(pattern, text, &match_mode,
+                                      stats_flag);  break;
+        case 'B':  strmat_bmext_match(pattern, text, &match_mode,
+                                      stats_flag);  break;
+        case 'C':  strmat_bmgood_match(pattern, text, &match_mode,
+                                       stats_flag);  break;
+        case 'D':  strmat_bmextgood_match(pattern, text, &match_mode,
+                                          stats_flag);  break;
+        case 'E':  strmat_bmopt_match(pattern, text, &match_mode,
+                                      stats_flag);  break;
+        case 'F':  strmat_horspool_match(pattern, text, &match_mode,
+                                         stats_flag);  break;
+        case 'G':  strmat_sunday_match(pattern, text, &match_mode,
+                                       stats_flag);  break;
         }
         unmap_sequences(text, pattern, NULL, 0);
       }
@@ -340,11 +399,11 @@ void basic_alg_menu()
       if (status != -1) {
         if (toupper(ch) == 'A') {
           mprintf ("Executing KMP with sp values...\n\n");
-          strmat_kmp_sp_orig_match(pattern, text, stats_flag);
+          strmat_kmp_sp_orig_match(pattern, text, &match_mode, stats_flag);
         }
         else {
           mprintf ("Executing KMP with sp' values...\n\n");
-          strmat_kmp_spprime_orig_match(pattern, text, stats_flag);
+          strmat_kmp_spprime_orig_match(pattern, text, &match_mode, stats_flag);
         }
         unmap_sequences(text, pattern, NULL, 0);
       }
@@ -373,7 +432,7 @@ void basic_alg_menu()
       status = map_sequences(text, NULL, patterns, num_patterns);
       if (status != -1) {
         mprintf("Executing Aho-Corasick algorithm...\n\n");
-        strmat_ac_match(patterns, num_patterns, text, stats_flag);
+        strmat_ac_match(patterns, num_patterns, text, &match_mode, stats_flag);
         unmap_sequences(text, NULL, patterns, num_patterns);
       }
       mend(num_lines);
@@ -411,14 +470,14 @@ void basic_alg_menu()
       if (status != -1) {
         mprintf("Executing Boyer-Moore set matching algorithm...\n\n");
         switch (toupper(ch)) {
-        case 'A':  strmat_bmset_badonly_match(patterns, num_patterns,
-                                              text, stats_flag);       break;
-        case 'B':  strmat_bmset_2trees_match(patterns, num_patterns,
-                                             text, stats_flag);        break;
-        case 'C':  strmat_bmset_1tree_match(patterns, num_patterns,
-                                            text, stats_flag);         break;
-        case 'D':  strmat_bmset_naive_match(patterns, num_patterns,
-                                            text, stats_flag);         break;
+        case 'A':  strmat_bmset_badonly_match(patterns, num_patterns, text,
+                                              &match_mode, stats_flag);  break;
+        case 'B':  strmat_bmset_2trees_match(patterns, num_patterns, text,
+                                             &match_mode, stats_flag);  break;
+        case 'C':  strmat_bmset_1tree_match(patterns, num_patterns, text,
+                                            &match_mode, stats_flag);  break;
+        case 'D':  strmat_bmset_naive_match(patterns, num_patterns, text,
+                                            &match_mode, stats_flag);  break;
         }
         unmap_sequences(text, NULL, patterns, num_patterns);
       }
@@ -428,6 +487,300 @@ void basic_alg_menu()
       free(patterns);
       break;
 
+    case '6':
+      ch = toupper(choice[1]);
+      if (ch != 'A' && ch != 'B') {
+        printf("\nYou must specify which option to use (as in '6a').\n");
+        continue;
+      }
+
+      if (ch == 'A') {
+        if (!(pattern = get_string("pattern")) ||
+            !(text = get_string("text")))
+          continue;
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, pattern, NULL, 0);
+        if (status != -1) {
+          mprintf("Executing first/last character filter algorithm...\n\n");
+          strmat_filter_match(pattern, text, &match_mode, stats_flag);
+          unmap_sequences(text, pattern, NULL, 0);
+        }
+        mend(num_lines);
+        putchar('\n');
+      }
+      else {
+        bench_length = get_bounded("Text Length", 1, 1000000000,
+                                   bench_length);
+        printf("\n");
+        if (bench_length == 0) {
+          bench_length = 1000000;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        strmat_filter_bench(bench_length);
+        mend(num_lines);
+        putchar('\n');
+      }
+      break;
+
+    case '7':
+      ch = toupper(choice[1]);
+      if (ch < 'A' || ch > 'E') {
+        printf("\nYou must specify which option to use (as in '7a').\n");
+        continue;
+      }
+
+      if (ch == 'E') {
+        bench_length = get_bounded("Text Length", 1, 1000000000,
+                                   bench_length);
+        printf("\n");
+        if (bench_length == 0) {
+          bench_length = 1000000;
+          continue;
+        }
+
+        pscan_threads = get_bounded("Maximum Number of Threads", 1, 256,
+                                    pscan_threads);
+        printf("\n");
+        if (pscan_threads == 0) {
+          pscan_threads = 4;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        strmat_pscan_bench(bench_length, pscan_threads);
+        mend(num_lines);
+        putchar('\n');
+        break;
+      }
+
+      if (!(pattern = get_string("pattern")) || !(text = get_string("text")))
+        continue;
+
+      pscan_threads = get_bounded("Number of Threads", 1, 256, pscan_threads);
+      printf("\n");
+      if (pscan_threads == 0) {
+        pscan_threads = 4;
+        continue;
+      }
+
+      mstart(stdin, fpout, OK, OK, 5, NULL);
+      mprintf("\nThe pattern:\n");
+      terse_print_string(pattern);
+      mprintf("\nThe text:\n");
+      terse_print_string(text);
+      mputc('\n');
+
+      status = map_sequences(text, pattern, NULL, 0);
+      if (status != -1) {
+        mprintf("Executing chunked scanning with %d threads...\n\n",
+                pscan_threads);
+        switch (ch) {
+        case 'A':
+          strmat_pscan_naive_match(pattern, text, pscan_threads, &match_mode,
+                                   stats_flag);
+          break;
+        case 'B':
+          strmat_pscan_bm_match(pattern, text, pscan_threads, &match_mode,
+                                stats_flag);
+          break;
+        case 'C':
+          strmat_pscan_kmp_match(pattern, text, pscan_threads, &match_mode,
+                                 stats_flag);
+          break;
+        case 'D':
+          strmat_pscan_z_match(pattern, text, pscan_threads, &match_mode,
+                               stats_flag);
+          break;
+        }
+        unmap_sequences(text, pattern, NULL, 0);
+      }
+      mend(num_lines);
+      putchar('\n');
+      break;
+
+    case '8':
+      ch = toupper(choice[1]);
+      if (ch != 'A' && ch != 'B') {
+        printf("\nYou must specify which option to use (as in '8a').\n");
+        continue;
+      }
+
+      if (!(pattern = get_string("pattern")))
+        continue;
+
+      if (!(path = get_filename("file name")))
+        continue;
+
+      mstart(stdin, fpout, OK, OK, 5, NULL);
+      mprintf("\nThe pattern:\n");
+      terse_print_string(pattern);
+      mputc('\n');
+
+      mprintf("Executing streaming search of %s...\n\n", path);
+      if (ch == 'A')
+        strmat_kmp_stream_match(pattern, path, &match_mode, stats_flag);
+      else
+        strmat_bm_stream_match(pattern, path, &match_mode, stats_flag);
+      free(path);
+
+      mend(num_lines);
+      putchar('\n');
+      break;
+
+    case '9':
+      ch = toupper(choice[1]);
+      if (ch < 'A' || ch > 'I') {
+        printf("\nYou must specify which option to use (as in '9a').\n");
+        continue;
+      }
+
+      if (ch == 'I') {
+        if (!(patterns = get_string_ary("list of patterns", &num_patterns)))
+          continue;
+        if (!(text = get_string("text"))) {
+          free(patterns);
+          continue;
+        }
+
+        num_mismatches = get_bounded("Number of Mismatches", 0, 1000000,
+                                     num_mismatches);
+        printf("\n");
+        if (num_mismatches < 0) {
+          num_mismatches = 1;
+          free(patterns);
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe patterns:\n");
+        for (i=0; i < num_patterns; i++) {
+          mprintf("%2d)", i + 1);
+          terse_print_string(patterns[i]);
+        }
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, NULL, patterns, num_patterns);
+        if (status != -1) {
+          mprintf("Executing kangaroo jumps with %d mismatches...\n\n",
+                  num_mismatches);
+          strmat_kangaroo_batch(patterns, num_patterns, text, num_mismatches,
+                                stree_build_policy, stree_build_threshold,
+                                &match_mode, stats_flag);
+          unmap_sequences(text, NULL, patterns, num_patterns);
+        }
+        mend(num_lines);
+        putchar('\n');
+
+        free(patterns);
+        break;
+      }
+
+      if (ch == 'F') {
+        bench_length = get_bounded("Text Length", 1, 1000000000,
+                                   bench_length);
+        printf("\n");
+        if (bench_length == 0) {
+          bench_length = 1000000;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        strmat_myers_bench(bench_length);
+        mend(num_lines);
+        putchar('\n');
+        break;
+      }
+
+      if (!(pattern = get_string("pattern")) || !(text = get_string("text")))
+        continue;
+
+      if (ch == 'D' || ch == 'E' || ch == 'G') {
+        num_mismatches = get_bounded("Number of Differences", 0,
+                                     pattern->length - 1, num_mismatches);
+        printf("\n");
+        if (num_mismatches < 0) {
+          num_mismatches = 1;
+          continue;
+        }
+      }
+      else if (ch == 'C' || ch == 'H') {
+        num_mismatches = get_bounded("Number of Mismatches", 0,
+                                     pattern->length, num_mismatches);
+        printf("\n");
+        if (num_mismatches < 0) {
+          num_mismatches = 1;
+          continue;
+        }
+      }
+
+      mstart(stdin, fpout, OK, OK, 5, NULL);
+      mprintf("\nThe pattern:\n");
+      terse_print_string(pattern);
+      mprintf("\nThe text:\n");
+      terse_print_string(text);
+      mputc('\n');
+
+      status = map_sequences(text, pattern, NULL, 0);
+      if (status != -1) {
+        switch (ch) {
+        case 'A':
+          mprintf("Executing Shift-Or...\n\n");
+          strmat_shiftor_match(pattern, text, &match_mode, stats_flag);
+          break;
+        case 'B':
+          mprintf("Executing BNDM...\n\n");
+          strmat_bndm_match(pattern, text, &match_mode, stats_flag);
+          break;
+        case 'C':
+          mprintf("Executing Shift-Add with %d mismatches...\n\n",
+                  num_mismatches);
+          strmat_shiftadd_match(pattern, text, num_mismatches, &match_mode,
+                                stats_flag);
+          break;
+        case 'D':
+          mprintf("Executing Myers' algorithm with %d differences...\n\n",
+                  num_mismatches);
+          strmat_myers_match(pattern, text, num_mismatches, &match_mode,
+                             stats_flag);
+          break;
+        case 'E':
+          mprintf("Executing Sellers' algorithm with %d differences...\n\n",
+                  num_mismatches);
+          strmat_sellers_match(pattern, text, num_mismatches, &match_mode,
+                               stats_flag);
+          break;
+        case 'G':
+          mprintf("Executing Landau-Vishkin with %d differences...\n\n",
+                  num_mismatches);
+          strmat_kdiff_match(pattern, text, num_mismatches,
+                             stree_build_policy, stree_build_threshold,
+                             &match_mode, stats_flag);
+          break;
+        case 'H':
+          mprintf("Executing kangaroo jumps with %d mismatches...\n\n",
+                  num_mismatches);
+          strmat_kangaroo_match(pattern, text, num_mismatches,
+                                stree_build_policy, stree_build_threshold,
+                                &match_mode, stats_flag);
+          break;
+        }
+        unmap_sequences(text, pattern, NULL, 0);
+      }
+      mend(num_lines);
+      putchar('\n');
+      break;
+
     case '*':
       util_menu();
       break;
@@ -454,18 +807,20 @@ void basic_alg_menu()
  **********************************************************************/
 void z_alg_menu()
 {
-  int status, num_lines;
+  int i, status, num_lines, num_patterns;
   char ch;
-  STRING *text, *pattern;
+  STRING *text, *pattern, **patterns;
+  static int zbatch_threads = 4;
 
   while (1) {
-    num_lines = 12;
+    num_lines = 13;
     printf("\n**   Z-value Algorithm Menu    **\n\n");
     printf("1)  Build Z values for a sequence\n");
     printf("2)  Exact matching using Z values\n");
     printf("3)  Knuth-Morris-Pratt  (Z-values preprocessing)\n");
     printf("     a) using sp values\n");
     printf("     b) using sp' values\n");
+    printf("4)  Exact matching of a batch of patterns against one text\n");
     printf("*)  String Utilites\n");
     printf("0)  Exit\n");
     printf("\nEnter Selection: ");
@@ -507,7 +862,7 @@ void z_alg_menu()
       status = map_sequences(text, pattern, NULL, 0);
       if (status != -1) {
         mputs("Executing exact matching with Z values algorithm...\n\n");
-        strmat_z_match(pattern, text, stats_flag);
+        strmat_z_match(pattern, text, &match_mode, stats_flag);
         unmap_sequences(text, pattern, NULL, 0);
       }
       mend(num_lines);
@@ -535,11 +890,11 @@ void z_alg_menu()
       if (status != -1) {
         if (toupper(ch) == 'A') {
           mprintf ("Executing KMP with sp values...\n\n");
-          strmat_kmp_sp_z_match(pattern, text, stats_flag);
+          strmat_kmp_sp_z_match(pattern, text, &match_mode, stats_flag);
         }
         else {
           mprintf ("Executing KMP with sp' values...\n\n");
-          strmat_kmp_spprime_z_match(pattern, text, stats_flag);
+          strmat_kmp_spprime_z_match(pattern, text, &match_mode, stats_flag);
         }
         unmap_sequences(text, pattern, NULL, 0);
       }
@@ -547,6 +902,47 @@ void z_alg_menu()
       putchar('\n');
       break;
 
+    case '4':
+      if (!(patterns = get_string_ary("list of patterns", &num_patterns)))
+        continue;
+      if (!(text = get_string("text"))) {
+        free(patterns);
+        continue;
+      }
+
+      zbatch_threads = get_bounded("Number of Threads", 1, 256,
+                                   zbatch_threads);
+      printf("\n");
+      if (zbatch_threads == 0) {
+        zbatch_threads = 4;
+        free(patterns);
+        continue;
+      }
+
+      mstart(stdin, fpout, OK, OK, 5, NULL);
+      mprintf("\nThe patterns:\n");
+      for (i=0; i < num_patterns; i++) {
+        mprintf("%2d)", i + 1);
+        terse_print_string(patterns[i]);
+      }
+      mprintf("\nThe text:\n");
+      terse_print_string(text);
+      mputc('\n');
+
+      status = map_sequences(text, NULL, patterns, num_patterns);
+      if (status != -1) {
+        mprintf("Executing batch matching with Z values using %d threads..."
+                "\n\n", zbatch_threads);
+        strmat_z_batch(patterns, num_patterns, text, zbatch_threads,
+                       &match_mode, stats_flag);
+        unmap_sequences(text, NULL, patterns, num_patterns);
+      }
+      mend(num_lines);
+      putchar('\n');
+
+      free(patterns);
+      break;
+
     case '*':
       util_menu();
       break;
@@ -681,7 +1077,7 @@ void suf_tree_menu()
       if (status != -1) {
         mprintf("Executing exact matching with a suffix tree...\n\n");
         strmat_stree_match(pattern, strings, num_strings, stree_build_policy,
-                           stree_build_threshold, stats_flag);
+                           stree_build_threshold, &match_mode, stats_flag);
         unmap_sequences(NULL, pattern, strings, num_strings);
       }
       mend(num_lines);
@@ -832,11 +1228,21 @@ void suf_tree_menu()
  **********************************************************************/
 void suf_ary_menu()
 {
-  int status, num_lines;
-  STRING *spt, *pattern, *text;
+  static int sary_threads = 4;
+  static int bench_length = 1000000;
+  static int sary_width = SARY_WIDTH_AUTO;
+  static int sample_rate = SARY_FM_SAMPLE_RATE;
+  static int save_rate = SARY_FM_SAMPLE_RATE;
+  static int save_width = 0;
+  static int kmer_length = 0;
+  static int ext_budget = 65536;
+  static int window_start = 1;
+  int i, status, num_lines, num_strings, window_end;
+  char ch, *path, *tmp_dir;
+  STRING *spt, *pattern, *text, **strings;
 
   while (1)  {
-    num_lines = 13;
+    num_lines = 31;
     printf("\n**   Suffix Array Menu    **\n\n");
     printf("1)  Build suffix array using quick sort\n");
     printf("2)  Build suffix array (Zerkle's version)\n");
@@ -844,6 +1250,24 @@ void suf_ary_menu()
     printf("4)  Exact matching using suffix array and naive algorithm\n");
     printf("5)  Exact matching using suffix array and mlr accelerant\n");
     printf("6)  Exact matching using suffix array and lcp super-accelerant\n");
+    printf("7)  Suffix arrays for large texts\n");
+    printf("     a) build suffix array using multiple threads\n");
+    printf("     b) benchmark against the number of threads\n");
+    printf("     c) build suffix array with 32/40/64 bit entries\n");
+    printf("     d) exact matching using the 32/40/64 bit suffix array\n");
+    printf("     e) build suffix array (Zerkle's version) using threads\n");
+    printf("     f) benchmark the word-at-a-time suffix compares\n");
+    printf("8)  Exact matching using compressed or extended indexes\n");
+    printf("     a) FM-index (backward search over the BWT)\n");
+    printf("     b) save a suffix array index to a file\n");
+    printf("     c) exact matching using a saved index file\n");
+    printf("     d) exact matching using a k-mer lookup table\n");
+    printf("     e) save an index built in external memory\n");
+    printf("9)  Generalized suffix arrays and suffix queries\n");
+    printf("     a) exact matching over a set of texts\n");
+    printf("     b) longest common extensions (sparse table)\n");
+    printf("     c) longest common extensions (small footprint)\n");
+    printf("     d) exact matching inside a text window (wavelet matrix)\n");
     printf("*)  String Utilites\n");
     printf("0)  Exit\n");
     printf("\nEnter Selection: ");
@@ -924,7 +1348,7 @@ void suf_ary_menu()
       status = map_sequences(text, pattern, NULL, 0);
       if (status != -1) {
         mprintf("Executing exact matching using suffix array...\n\n");
-        strmat_sary_match_naive(pattern, text, stats_flag);
+        strmat_sary_match_naive(pattern, text, &match_mode, stats_flag);
         unmap_sequences(text, pattern, NULL, 0);
       }
       mend(num_lines);
@@ -945,7 +1369,7 @@ void suf_ary_menu()
       status = map_sequences(text, pattern, NULL, 0);
       if (status != -1) {
         mprintf("Executing exact matching using suffix array...\n\n");
-        strmat_sary_match_mlr(pattern, text, stats_flag);
+        strmat_sary_match_mlr(pattern, text, &match_mode, stats_flag);
         unmap_sequences(text, pattern, NULL, 0);
       }
       mend(num_lines);
@@ -966,13 +1390,383 @@ void suf_ary_menu()
       status = map_sequences(text, pattern, NULL, 0);
       if (status != -1) {
         mprintf("Executing exact matching using suffix array...\n\n");
-        strmat_sary_match_lcp(pattern, text, stats_flag);
+        strmat_sary_match_lcp(pattern, text, &match_mode, stats_flag);
         unmap_sequences(text, pattern, NULL, 0);
       }
       mend(num_lines);
       putchar('\n');
       break;  
 
+    case '7':
+      ch = toupper(choice[1]);
+      if (ch != 'A' && ch != 'B' && ch != 'C' && ch != 'D' && ch != 'E' &&
+          ch != 'F') {
+        printf("\nYou must specify which large text option to use"
+               " (as in '7a' or '7c').\n");
+        continue;
+      }
+
+      if (ch == 'A' || ch == 'E') {
+        if (!(spt = get_string("sequence")))
+          continue;
+
+        sary_threads = get_bounded("Number of Threads", 1, 256, sary_threads);
+        printf("\n");
+        if (sary_threads == 0) {
+          sary_threads = 1;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe sequence:\n");
+        terse_print_string(spt);
+        mputc('\n');
+
+        status = map_sequences(spt, NULL, NULL, 0);
+        if (status != -1 && ch == 'A') {
+          mprintf("Building suffix array using %d threads...\n\n",
+                  sary_threads);
+          strmat_sary_parallel(spt, sary_threads, stats_flag);
+          unmap_sequences(spt, NULL, NULL, 0);
+        }
+        else if (status != -1) {
+          mprintf("Executing Zerkle's algorithm using %d threads...\n\n",
+                  sary_threads);
+          strmat_sary_zerkle_parallel(spt, sary_threads, stats_flag);
+          unmap_sequences(spt, NULL, NULL, 0);
+        }
+      }
+      else if (ch == 'B') {
+        bench_length = get_bounded("Text Length", 1, 1000000000,
+                                   bench_length);
+        printf("\n");
+        if (bench_length == 0) {
+          bench_length = 1000000;
+          continue;
+        }
+
+        sary_threads = get_bounded("Maximum Number of Threads", 1, 256,
+                                   sary_threads);
+        printf("\n");
+        if (sary_threads == 0) {
+          sary_threads = 1;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        strmat_sary_parallel_bench(bench_length, sary_threads);
+      }
+      else if (ch == 'F') {
+        bench_length = get_bounded("Text Length", 1, 1000000000,
+                                   bench_length);
+        printf("\n");
+        if (bench_length == 0) {
+          bench_length = 1000000;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        strmat_sary_cmp_bench(bench_length);
+      }
+      else if (ch == 'C') {
+        if (!(spt = get_string("sequence")))
+          continue;
+
+        sary_width = get_bounded("Entry Width (32, 40, 64 or 0 for auto)",
+                                 0, 64, sary_width);
+        printf("\n");
+        if (sary_width == -1) {
+          sary_width = SARY_WIDTH_AUTO;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe sequence:\n");
+        terse_print_string(spt);
+        mputc('\n');
+
+        status = map_sequences(spt, NULL, NULL, 0);
+        if (status != -1) {
+          mprintf("Building packed suffix array...\n\n");
+          strmat_sary_packed(spt, sary_width, stats_flag);
+          unmap_sequences(spt, NULL, NULL, 0);
+        }
+      }
+      else {
+        if (!(pattern = get_string("pattern")) || !(text = get_string("text")))
+          continue;
+
+        sary_width = get_bounded("Entry Width (32, 40, 64 or 0 for auto)",
+                                 0, 64, sary_width);
+        printf("\n");
+        if (sary_width == -1) {
+          sary_width = SARY_WIDTH_AUTO;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, pattern, NULL, 0);
+        if (status != -1) {
+          mprintf("Executing exact matching using packed suffix array...\n\n");
+          strmat_sary_packed_match(pattern, text, sary_width, &match_mode,
+                                   stats_flag);
+          unmap_sequences(text, pattern, NULL, 0);
+        }
+      }
+      mend(num_lines);
+      putchar('\n');
+      break;
+
+    case '8':
+      ch = toupper(choice[1]);
+      if (ch != 'A' && ch != 'B' && ch != 'C' && ch != 'D' && ch != 'E') {
+        printf("\nYou must specify which index to use (as in '8a').\n");
+        continue;
+      }
+
+      if (ch == 'A') {
+        if (!(pattern = get_string("pattern")) ||
+            !(text = get_string("text")))
+          continue;
+
+        sample_rate = get_bounded("Suffix Array Sample Rate", 1, 1024,
+                                  sample_rate);
+        printf("\n");
+        if (sample_rate == 0) {
+          sample_rate = SARY_FM_SAMPLE_RATE;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, pattern, NULL, 0);
+        if (status != -1) {
+          mprintf("Executing exact matching using FM-index...\n\n");
+          strmat_sary_fm(pattern, text, sample_rate, &match_mode, stats_flag);
+          unmap_sequences(text, pattern, NULL, 0);
+        }
+      }
+      else if (ch == 'B') {
+        if (!(text = get_string("text")))
+          continue;
+
+        save_rate = get_bounded("FM-index Sample Rate (0 for none)", 0, 1024,
+                                save_rate);
+        printf("\n");
+        if (save_rate == -1) {
+          save_rate = SARY_FM_SAMPLE_RATE;
+          continue;
+        }
+
+        save_width = get_bounded("Entry Width (32, 40, 64 or 0 for lcp values)",
+                                 0, 64, save_width);
+        printf("\n");
+        if (save_width == -1) {
+          save_width = 0;
+          continue;
+        }
+
+        if (!(path = get_filename("index file name")))
+          continue;
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, NULL, NULL, 0);
+        if (status != -1) {
+          mprintf("Saving suffix array index...\n\n");
+          strmat_sary_save(text, path, save_rate, save_width, stats_flag);
+          unmap_sequences(text, NULL, NULL, 0);
+        }
+        free(path);
+      }
+      else if (ch == 'D') {
+        if (!(pattern = get_string("pattern")) ||
+            !(text = get_string("text")))
+          continue;
+
+        kmer_length = get_bounded("K-mer Length (0 for automatic)", 0, 24,
+                                  kmer_length);
+        printf("\n");
+        if (kmer_length == -1) {
+          kmer_length = 0;
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, pattern, NULL, 0);
+        if (status != -1) {
+          mprintf("Executing exact matching using a k-mer table...\n\n");
+          strmat_sary_match_kmer(pattern, text, kmer_length, &match_mode,
+                                 stats_flag);
+          unmap_sequences(text, pattern, NULL, 0);
+        }
+      }
+      else if (ch == 'E') {
+        if (!(text = get_string("text")))
+          continue;
+
+        ext_budget = get_bounded("Memory Budget (KB)", 64, 1 << 30,
+                                 ext_budget);
+        printf("\n");
+        if (ext_budget == 63) {
+          ext_budget = 65536;
+          continue;
+        }
+
+        if (!(path = get_filename("index file name")))
+          continue;
+
+        if (!(tmp_dir = get_filename("directory for the temporary files"))) {
+          free(path);
+          continue;
+        }
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, NULL, NULL, 0);
+        if (status != -1) {
+          mprintf("Building suffix array index in external memory...\n\n");
+          strmat_sary_ext_save(text, path, tmp_dir, ext_budget, stats_flag);
+          unmap_sequences(text, NULL, NULL, 0);
+        }
+        free(path);
+        free(tmp_dir);
+      }
+      else {
+        if (!(pattern = get_string("pattern")))
+          continue;
+
+        if (!(path = get_filename("index file name")))
+          continue;
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mputc('\n');
+
+        status = map_sequences(pattern, NULL, NULL, 0);
+        if (status != -1) {
+          mprintf("Executing exact matching using index file %s...\n\n",
+                  path);
+          strmat_sary_file_match(pattern, path, &match_mode, stats_flag);
+          unmap_sequences(pattern, NULL, NULL, 0);
+        }
+        free(path);
+      }
+      mend(num_lines);
+      putchar('\n');
+      break;
+
+    case '9':
+      ch = toupper(choice[1]);
+      if (ch != 'A' && ch != 'B' && ch != 'C' && ch != 'D') {
+        printf("\nYou must specify which option to use (as in '9a').\n");
+        continue;
+      }
+
+      if (ch == 'A') {
+        if (!(pattern = get_string("pattern")) ||
+            !(strings = get_string_ary("list of sequences", &num_strings)))
+          continue;
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mprintf("\nThe texts:\n");
+        for (i=0; i < num_strings; i++) {
+          mprintf("%2d)", i + 1);
+          terse_print_string(strings[i]);
+        }
+        mputc('\n');
+
+        status = map_sequences(NULL, pattern, strings, num_strings);
+        if (status != -1) {
+          mprintf("Executing exact matching with a generalized suffix "
+                  "array...\n\n");
+          strmat_sary_gen_match(pattern, strings, num_strings, &match_mode,
+                                stats_flag);
+          unmap_sequences(NULL, pattern, strings, num_strings);
+        }
+        mend(num_lines);
+        putchar('\n');
+
+        free(strings);
+      }
+      else if (ch == 'D') {
+        if (!(pattern = get_string("pattern")) ||
+            !(text = get_string("text")))
+          continue;
+
+        if (window_start > text->length)
+          window_start = 1;
+        window_start = get_bounded("Window Start", 1, text->length,
+                                   window_start);
+        printf("\n");
+        if (window_start == 0) {
+          window_start = 1;
+          continue;
+        }
+
+        window_end = get_bounded("Window End", window_start, text->length,
+                                 text->length);
+        printf("\n");
+        if (window_end == window_start - 1)
+          continue;
+
+        mstart(stdin, fpout, OK, OK, 5, NULL);
+        mprintf("\nThe pattern:\n");
+        terse_print_string(pattern);
+        mprintf("\nThe text:\n");
+        terse_print_string(text);
+        mputc('\n');
+
+        status = map_sequences(text, pattern, NULL, 0);
+        if (status != -1) {
+          mprintf("Executing exact matching inside positions %d-%d...\n\n",
+                  window_start, window_end);
+          strmat_sary_wt_match(pattern, text, window_start, window_end,
+                               &match_mode, stats_flag);
+          unmap_sequences(text, pattern, NULL, 0);
+        }
+        mend(num_lines);
+        putchar('\n');
+      }
+      else {
+        if (!(spt = get_string("sequence")))
+          continue;
+
+        status = map_sequences(spt, NULL, NULL, 0);
+        if (status != -1) {
+          strmat_sary_lce(spt, (ch == 'C'), stats_flag);
+          unmap_sequences(spt, NULL, NULL, 0);
+        }
+        putchar('\n');
+      }
+      break;
+
     case '*':
       util_menu();
       break;
@@ -999,12 +1793,13 @@ void repeats_menu()
 {
   static int smax_percent = 0;
   static int smax_minlen = 0;
+  static int pairs_minlen = 1;
   int status, num_lines;
   char ch;
   STRING *text;
 
   while (1) {
-    num_lines = 20;
+    num_lines = 23;
 
     printf("\n**   Repeats Menu    **\n\n");
     printf("1)  Find primitive tandem repeats (Crochemore's algorithm)\n");
@@ -1020,6 +1815,9 @@ void repeats_menu()
     printf("7)  Find occurrences in linear time (without suffix tree) using\n");
     printf("     a) Ziv-Lempel decomposition\n");
     printf("     b) nonoverlapping blocks decomposition (as in the book)\n");
+    printf("8)  Using the enhanced suffix array (without suffix tree), find\n");
+    printf("     a) supermaximals and near supermaximals of a string\n");
+    printf("     b) maximal pairs of a string\n");
     printf("*)  String Utilites\n");
     printf("0)  Exit\n");
     printf("\nEnter Selection: ");
@@ -1186,6 +1984,62 @@ void repeats_menu()
       putchar('\n');
       break;
 
+    case '8':
+      ch = toupper(choice[1]);
+      if (ch != 'A' && ch != 'B') {
+        printf("\nYou must specify which type of repeat to find"
+               " (as in '8a' or '8b').\n");
+        continue;
+      }
+
+      if (!(text = get_string("string")))
+        continue;
+
+      if (ch == 'A') {
+        smax_percent = get_bounded("Percent Supermaximal", 0, 100,
+                                   smax_percent);
+        printf("\n");
+        if (smax_percent == -1)
+          continue;
+
+        smax_minlen = get_bounded("Supermax. Minimum Length", 0, text->length,
+                                  smax_minlen);
+        printf("\n");
+        if (smax_minlen == -1)
+          continue;
+      }
+      else {
+        pairs_minlen = get_bounded("Maximal Pair Minimum Length", 1,
+                                   text->length, pairs_minlen);
+        printf("\n");
+        if (pairs_minlen == 0) {
+          pairs_minlen = 1;
+          continue;
+        }
+      }
+
+      mstart(stdin, fpout, OK, OK, 5, NULL);
+      mprintf("\nThe string:\n");
+      terse_print_string(text);
+      mputc('\n');
+
+      status = map_sequences(text, NULL, NULL, 0);
+      if (status != -1) {
+        if (ch == 'A') {
+          mprintf("Finding the supermaximals...\n\n");
+          strmat_repeats_supermax_esa(text, smax_percent, smax_minlen,
+                                      stats_flag);
+        }
+        else {
+          mprintf("Finding the maximal pairs...\n\n");
+          strmat_repeats_maxpairs_esa(text, pairs_minlen, stats_flag);
+        }
+        unmap_sequences(text, NULL, NULL, 0);
+      }
+      mend(num_lines);
+      putchar('\n');
+      break;
+
     case '*':
       util_menu();
       break;
@@ -1212,8 +2066,9 @@ void set_display_options(void)
 
   while (1) {
     printf("\nOptions (1 - redirect output to file, 2 - reset to screen,\n");
-    printf("         3 - turn stats %s, 0 - Exit)\n",
-           (stats_flag ? "off" : "on"));
+    printf("         3 - turn stats %s, 4 - report matches (%s),\n",
+           (stats_flag ? "off" : "on"), match_mode_name(match_mode.mode));
+    printf("         0 - Exit)\n");
     printf("Enter Selection: ");
 
     while ((choice = my_getline(stdin, &ch_len)) == NULL) ;
@@ -1257,6 +2112,18 @@ void set_display_options(void)
       putchar('\n');
       break;
 
+    case '4':
+      switch (match_mode.mode) {
+      case MATCH_ALL:    match_mode.mode = MATCH_COUNT;  break;
+      case MATCH_COUNT:  match_mode.mode = MATCH_FIRST;  break;
+      case MATCH_FIRST:  match_mode.mode = MATCH_CALLBACK;  break;
+      default:           match_mode.mode = MATCH_ALL;  break;
+      }
+      match_mode.callback = print_match_callback;
+      match_mode.arg = NULL;
+      putchar('\n');
+      break;
+
     default:
       printf("\nThat is not a choice.\n");
     }
@@ -1265,6 +2132,39 @@ void set_display_options(void)
 
 
 
+/*
+ * print_match_callback
+ *
+ * The callback of the MATCH_CALLBACK result mode, printing each match
+ * as soon as it is found (with no text around it).
+ *
+ * Parameters:   match  -  the match
+ *               arg    -  unused
+ *
+ * Returns:  non-zero to go on, zero when the output has been stopped
+ *           (which stops the search).
+ */
+int print_match_callback(MATCH_NODE *match, void *arg)
+{
+  switch (match->type) {
+  case ONESEQ_APPROX:
+  case SET_APPROX:
+    return mprintf("    %d-%d (%d)\n", match->lend, match->rend, match->score);
+
+  case SET_EXACT:
+    return mprintf("    %d-%d (pattern %d)\n", match->lend, match->rend,
+                   match->id);
+
+  case TEXT_SET_EXACT:
+    return mprintf("    %d:  %d-%d\n", match->textid, match->lend,
+                   match->rend);
+  }
+
+  return mprintf("    %d-%d\n", match->lend, match->rend);
+}
+
+
+
 
 int my_itoalen(int num)
 {
@@ -0,0 +1,94 @@
+/*
+ * strmat_bench.c
+ *
+ * Synthetic texts and a wall clock timer for the benchmark options
+ * of the strmat menus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "strmat_bench.h"
+
+
+char *bench_names[] = { "DNA", "Protein", "Repetitive" };
+
+
+/*
+ * bench_text
+ *
+ * Create a text for benchmarking:  uniformly random DNA or protein
+ * sequence (with a fixed seed, so runs can be compared), or a prefix
+ * of the Fibonacci string (the classic worst case for repeats).
+ *
+ * Parameters:  type    -  BENCH_DNA, BENCH_PROTEIN or BENCH_REPETITIVE
+ *              length  -  the length of the text
+ *
+ * Returns:  a malloc'ed, NUL-terminated text, or NULL.
+ */
+char *bench_text(int type, int length)
+{
+  int i, j, flen, plen;
+  char *T;
+  unsigned int seed;
+  static char *dna = "ACGT";
+  static char *protein = "ACDEFGHIKLMNPQRSTVWY";
+
+  if (length <= 0 || (T = malloc(length + 1)) == NULL)
+    return NULL;
+
+  seed = 12345;
+  switch (type) {
+  case BENCH_DNA:
+  case BENCH_PROTEIN:
+    for (i=0; i < length; i++) {
+      seed = seed * 1103515245 + 12345;
+      if (type == BENCH_DNA)
+        T[i] = dna[(seed >> 16) % 4];
+      else
+        T[i] = protein[(seed >> 16) % 20];
+    }
+    break;
+
+  case BENCH_REPETITIVE:
+    /*
+     * F(n) = F(n-1) F(n-2), built in place:  the string of length flen
+     * is extended by its own prefix of length plen.
+     */
+    T[0] = 'a';
+    if (length > 1)
+      T[1] = 'b';
+    flen = 2;
+    plen = 1;
+    while (flen < length) {
+      for (j=0; j < plen && flen + j < length; j++)
+        T[flen+j] = T[j];
+      j = flen;
+      flen += plen;
+      plen = j;
+    }
+    break;
+
+  default:
+    free(T);
+    return NULL;
+  }
+
+  T[length] = '\0';
+  return T;
+}
+
+
+/*
+ * bench_seconds
+ *
+ * Returns:  the wall clock time, in seconds.
+ */
+double bench_seconds(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
@@ -0,0 +1,14 @@
+#ifndef _STRMAT_BENCH_H_
+#define _STRMAT_BENCH_H_
+
+#define BENCH_DNA 0
+#define BENCH_PROTEIN 1
+#define BENCH_REPETITIVE 2
+#define NUM_BENCH_TEXTS 3
+
+extern char *bench_names[];
+
+char *bench_text(int type, int length);
+double bench_seconds(void);
+
+#endif
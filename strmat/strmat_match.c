@@ -44,8 +44,9 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
                   MATCHES list, int num_matches)
 {
   int i, j, N, count, matchdigs, minwidth, maxwidth;
-  int width, maxposdigs, maxiddigs, multistring_mode;
-  char *T, format[32];
+  int width, maxposdigs, maxiddigs, maxscoredigs, multistring_mode;
+  int approx_mode;
+  char *T, format[48];
   MATCHES ptr;
 
   if (num_matches == 0) {
@@ -54,18 +55,19 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
   }
 
   multistring_mode = (list->type == TEXT_SET_EXACT);
+  approx_mode = (list->type == ONESEQ_APPROX);
   if ((!multistring_mode && string == NULL) ||
       (multistring_mode && strings == NULL))
     return 0;
 
   /*
    * Compute the number of digits in the number of matches and the
-   * widest position (and possibly widest identifier) of any match.  Also,
-   * find the smallest and largest match length.
+   * widest position (and possibly widest identifier or score) of any
+   * match.  Also, find the smallest and largest match length.
    */
   matchdigs = my_itoalen(num_matches);
 
-  maxposdigs = maxiddigs = 0;
+  maxposdigs = maxiddigs = maxscoredigs = 0;
   minwidth = maxwidth = -1;
   for (count=0,ptr=list; count < num_matches; count++,ptr=ptr->next) {
     if (minwidth == -1 || ptr->rend - ptr->lend + 1 < minwidth)
@@ -82,6 +84,12 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
       if (width > maxiddigs)
         maxiddigs = width;
     }
+
+    if (approx_mode) {
+      width = my_itoalen(ptr->score);
+      if (width > maxscoredigs)
+        maxscoredigs = width;
+    }
   }
 
   /* 
@@ -90,6 +98,8 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
    */
   mprintf("Found %d matches:", num_matches);
   width = (17 + 2 * maxposdigs + maxiddigs) - (15 + matchdigs);
+  if (approx_mode)
+    width += 3 + maxscoredigs;
   for (i=0; i < width; i++)
     mputc(' ');
   for (i=0; i < minwidth && i < 43; i++)
@@ -101,10 +111,14 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
   mputc('\n');
 
   /*
-   * Build the format for printing the positions of the match, and 
-   * then loop through the matches, printing the information.
+   * Build the format for printing the positions of the match (and
+   * the score of an approximate match), and then loop through the
+   * matches, printing the information.
    */
-  if (multistring_mode && num_strings > 1)
+  if (approx_mode)
+    sprintf(format, "    %%%dd-%%%dd (%%%dd):    ", maxposdigs, maxposdigs,
+            maxscoredigs);
+  else if (multistring_mode && num_strings > 1)
     sprintf(format, " %%%dd:  %%%dd-%%%dd:    ", maxiddigs, maxposdigs,
             maxposdigs);
   else
@@ -127,6 +141,8 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
       T = strings[ptr->textid-1]->raw_seq;
       N = strings[ptr->textid-1]->length;
     }
+    else if (approx_mode)
+      mprintf(format, ptr->lend, ptr->rend, ptr->score);
     else
       mprintf(format, ptr->lend, ptr->rend);
 
@@ -154,3 +170,182 @@ int print_matches(STRING *string, STRING **strings, int num_strings,
 
   return 1;
 }
+
+
+/*
+ * match_mode_name
+ *
+ * The name of a result mode (for the menus).
+ *
+ * Parameters:   mode  -  MATCH_ALL, MATCH_COUNT, MATCH_FIRST or
+ *                        MATCH_CALLBACK
+ *
+ * Returns:  the mode's name.
+ */
+char *match_mode_name(int mode)
+{
+  switch (mode) {
+  case MATCH_ALL:       return "all matches";
+  case MATCH_COUNT:     return "count only";
+  case MATCH_FIRST:     return "first match";
+  case MATCH_CALLBACK:  return "each as found";
+  }
+  return "unknown";
+}
+
+
+/*
+ * init_results
+ *
+ * Start an empty set of results.  The stubs collect their matches
+ * through a MATCH_RESULTS structure, which does what the result mode
+ * asks:  MATCH_ALL keeps the list of every match, MATCH_COUNT only
+ * counts them (allocating nothing), MATCH_FIRST keeps the first match
+ * reported and then tells the search to stop, and MATCH_CALLBACK hands
+ * each match to a function, which can stop the search by returning
+ * zero.
+ *
+ * Parameters:   res        -  the MATCH_RESULTS structure
+ *               matchmode  -  the result mode (NULL for MATCH_ALL)
+ *
+ * Returns:  nothing.
+ */
+void init_results(MATCH_RESULTS *res, MATCH_MODE *matchmode)
+{
+  res->mode = MATCH_ALL;
+  res->callback = NULL;
+  res->arg = NULL;
+  if (matchmode != NULL &&
+      (matchmode->mode != MATCH_CALLBACK || matchmode->callback != NULL)) {
+    res->mode = matchmode->mode;
+    res->callback = matchmode->callback;
+    res->arg = matchmode->arg;
+  }
+
+  res->count = 0;
+  res->list = res->tail = NULL;
+}
+
+
+/*
+ * add_result
+ *
+ * Add a match to the results.
+ *
+ * Parameters:   res     -  the MATCH_RESULTS structure
+ *               type    -  the type of match (ONESEQ_EXACT, ...)
+ *               id      -  the identifier of the pattern matched
+ *               textid  -  the identifier of the text matched
+ *               lend    -  the left end of the match
+ *               rend    -  the right end of the match
+ *               score   -  the score of an approximate match
+ *
+ * Returns:  1 if the search should go on, 0 if it can stop, and -1
+ *           if memory ran out.
+ */
+int add_result(MATCH_RESULTS *res, int type, int id, int textid,
+               int lend, int rend, int score)
+{
+  MATCH_NODE node, *newmatch;
+
+  switch (res->mode) {
+  case MATCH_COUNT:
+    res->count++;
+    return 1;
+
+  case MATCH_CALLBACK:
+    memset(&node, 0, sizeof(MATCH_NODE));
+    node.type = type;
+    node.id = id;
+    node.textid = textid;
+    node.lend = lend;
+    node.rend = rend;
+    node.score = score;
+
+    res->count++;
+    return ((*res->callback)(&node, res->arg) ? 1 : 0);
+  }
+
+  if ((newmatch = alloc_match()) == NULL)
+    return -1;
+  newmatch->type = type;
+  newmatch->id = id;
+  newmatch->textid = textid;
+  newmatch->lend = lend;
+  newmatch->rend = rend;
+  newmatch->score = score;
+
+  if (res->list == NULL)
+    res->list = res->tail = newmatch;
+  else {
+    res->tail->next = newmatch;
+    res->tail = newmatch;
+  }
+  res->count++;
+
+  return (res->mode == MATCH_FIRST ? 0 : 1);
+}
+
+
+/*
+ * add_count
+ *
+ * Add matches that were counted but not located.  Only the count
+ * mode can take them, since every other mode needs each match.
+ *
+ * Parameters:   res    -  the MATCH_RESULTS structure (MATCH_COUNT)
+ *               count  -  the number of matches
+ *
+ * Returns:  nothing.
+ */
+void add_count(MATCH_RESULTS *res, int count)
+{
+  if (res->mode == MATCH_COUNT)
+    res->count += count;
+}
+
+
+/*
+ * print_results
+ *
+ * Print the results, as print_matches does when the matches were kept,
+ * and as their number otherwise.
+ *
+ * Parameters:   string       -  the text (one sequence matches)
+ *               strings      -  the texts (multi-sequence matches)
+ *               num_strings  -  the number of texts
+ *               res          -  the MATCH_RESULTS structure
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int print_results(STRING *string, STRING **strings, int num_strings,
+                  MATCH_RESULTS *res)
+{
+  switch (res->mode) {
+  case MATCH_COUNT:
+    mprintf("Found %d matches (count only).\n\n", res->count);
+    return 1;
+
+  case MATCH_CALLBACK:
+    mprintf("Passed %d matches to the callback.\n\n", res->count);
+    return 1;
+  }
+
+  return print_matches(string, strings, num_strings, res->list, res->count);
+}
+
+
+/*
+ * free_results
+ *
+ * Free the matches kept in the results.
+ *
+ * Parameters:   res  -  the MATCH_RESULTS structure
+ *
+ * Returns:  nothing.
+ */
+void free_results(MATCH_RESULTS *res)
+{
+  free_matches(res->list);
+  res->list = res->tail = NULL;
+}
@@ -8,15 +8,44 @@
 #define SET_APPROX 3
 #define TEXT_SET_EXACT 4
 
+#define MATCH_ALL 0
+#define MATCH_COUNT 1
+#define MATCH_FIRST 2
+#define MATCH_CALLBACK 3
+
 typedef struct matchnode {
   int type, id, textid;
   int lend, rend, score;
   struct matchnode *next;
 } MATCH_NODE, *MATCHES;
 
+typedef int (*MATCH_CALLBACK_FN)(MATCH_NODE *match, void *arg);
+
+typedef struct {
+  int mode;                   /* MATCH_ALL, MATCH_COUNT, ... */
+  MATCH_CALLBACK_FN callback; /* the function called (MATCH_CALLBACK) */
+  void *arg;
+} MATCH_MODE;
+
+typedef struct {
+  int mode, count;
+  MATCHES list, tail;         /* the matches kept (MATCH_ALL, MATCH_FIRST) */
+  MATCH_CALLBACK_FN callback;
+  void *arg;
+} MATCH_RESULTS;
+
 MATCH_NODE *alloc_match(void);
 void free_matches(MATCHES list);
 int print_matches(STRING *string, STRING **strings, int num_strings,
                   MATCHES list, int num_matches);
 
+char *match_mode_name(int mode);
+void init_results(MATCH_RESULTS *res, MATCH_MODE *matchmode);
+int add_result(MATCH_RESULTS *res, int type, int id, int textid,
+               int lend, int rend, int score);
+void add_count(MATCH_RESULTS *res, int count);
+int print_results(STRING *string, STRING **strings, int num_strings,
+                  MATCH_RESULTS *res);
+void free_results(MATCH_RESULTS *res);
+
 #endif
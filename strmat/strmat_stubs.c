@@ -6,11 +6,23 @@
 #include "strmat_match.h"
 #include "ac.h"
 #include "bm.h"
+#include "bmopt.h"
+#include "bitpar.h"
+#include "myers.h"
+#include "stree_strmat.h"
+#include "stree_ukkonen.h"
+#include "stree_lce.h"
+#include "stree_kdiff.h"
+#include "stree_kangaroo.h"
 #include "bmset_naive.h"
 #include "bmset.h"
 #include "kmp.h"
 #include "naive.h"
+#include "filter.h"
 #include "z.h"
+#include "zbatch.h"
+#include "pscan.h"
+#include "strmat_bench.h"
 
 /*
  * strmat_naive_match
@@ -18,17 +30,19 @@
  * Performs the exact matching algorithm for a pattern and text using
  * the naive search algorithm.
  *
- * Parameters:   pattern  -  the pattern sequence
- *               text     -  the text sequence
- *               stats    -  should stats be printed
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
-int strmat_naive_match(STRING *pattern, STRING *text, int stats)
+int strmat_naive_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats)
 {
-  int M, N, len, pos, flag, matchcount;
+  int M, N, len, pos, flag, status;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   NAIVE_STRUCT *nstruct;
 
   if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
@@ -49,8 +63,7 @@ int strmat_naive_match(STRING *pattern, STRING *text, int stats)
   /*
    * Perform the matching.
    */
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
 
   flag = 0;
   s = T;
@@ -58,33 +71,24 @@ int strmat_naive_match(STRING *pattern, STRING *text, int stats)
   while ((s = naive_search(nstruct, s, len, flag)) != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       naive_free(nstruct);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = ONESEQ_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + M - 1;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
 
-    len = N - pos;
+    len = N - pos + 1;
     flag = 1;
   }
 
   /*
    * Print the statistics and the matches.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -102,13 +106,106 @@ int strmat_naive_match(STRING *pattern, STRING *text, int stats)
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   naive_free(nstruct);
 
   return 1;
 }
 
 
+/*
+ * strmat_filter_match
+ *
+ * Performs the exact matching algorithm for a pattern and text using
+ * the first/last character filter (with the widest kernel the processor
+ * supports).
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_filter_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                        int stats)
+{
+  int M, N, len, pos, flag, status;
+  char *s, *P, *T;
+  MATCH_RESULTS results;
+  FILTER_STRUCT *fstruct;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  P = pattern->sequence;
+  M = pattern->length;
+  T = text->sequence;
+  N = text->length;
+
+  /*
+   * "Preprocess" the pattern.
+   */
+  if ((fstruct = filter_prep(P, M, 0)) == NULL)
+    return 0;
+
+  /*
+   * Perform the matching.
+   */
+  init_results(&results, matchmode);
+
+  flag = 0;
+  s = T;
+  len = N;
+  while ((s = filter_search(fstruct, s, len, flag)) != NULL) {
+    pos = s - T + 1;
+
+    status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
+      filter_free(fstruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+
+    len = N - pos + 1;
+    flag = 1;
+  }
+
+  /*
+   * Print the statistics and the matches.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Filter Kernel:              %s\n", filter_name(fstruct));
+#ifdef STATS
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Number of Filter Steps:     %d\n", fstruct->num_steps);
+    mprintf("   Number of Candidates:       %d\n", fstruct->num_candidates);
+    mprintf("   Number of Comparisons:      %d\n", fstruct->num_compares);
+    mprintf("   Avg. Compares per Position: %.2f\n",
+            (float) fstruct->num_compares / (float) N);
+#else
+    mputs("   No statistics available.\n");
+#endif
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  free_results(&results);
+  filter_free(fstruct);
+
+  return 1;
+}
+
+
 /*
  * strmat_bm*_match
  *
@@ -120,30 +217,35 @@ int strmat_naive_match(STRING *pattern, STRING *text, int stats)
  * the four functions called by the rest of strmat (i.e., the stubs
  * within the stubs).
  *
- * Parameters:   pattern  -  the pattern sequence
- *               text     -  the text sequence
- *               stats    -  should stats be printed
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
-static int internal_bm_match(STRING *pattern, STRING *text, int stats,
-                             BMALG_TYPE flag);
-
-int strmat_bmbad_match(STRING *pattern, STRING *text, int stats)
-{  return internal_bm_match(pattern, text, stats, BM_BAD);  }
-int strmat_bmext_match(STRING *pattern, STRING *text, int stats)
-{  return internal_bm_match(pattern, text, stats, BM_EXT);  }
-int strmat_bmgood_match(STRING *pattern, STRING *text, int stats)
-{  return internal_bm_match(pattern, text, stats, BM_GOOD);  }
-int strmat_bmextgood_match(STRING *pattern, STRING *text, int stats)
-{  return internal_bm_match(pattern, text, stats, BM_EXTGOOD);  }
-
-static int internal_bm_match(STRING *pattern, STRING *text, int stats,
-                             BMALG_TYPE flag)
+static int internal_bm_match(STRING *pattern, STRING *text,
+                             MATCH_MODE *matchmode, int stats, BMALG_TYPE flag);
+
+int strmat_bmbad_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats)
+{  return internal_bm_match(pattern, text, matchmode, stats, BM_BAD);  }
+int strmat_bmext_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats)
+{  return internal_bm_match(pattern, text, matchmode, stats, BM_EXT);  }
+int strmat_bmgood_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                        int stats)
+{  return internal_bm_match(pattern, text, matchmode, stats, BM_GOOD);  }
+int strmat_bmextgood_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                           int stats)
+{  return internal_bm_match(pattern, text, matchmode, stats, BM_EXTGOOD);  }
+
+static int internal_bm_match(STRING *pattern, STRING *text,
+                             MATCH_MODE *matchmode, int stats, BMALG_TYPE flag)
 {
-  int M, N, len, pos, matchcount;
+  int M, N, len, pos, status;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   BM_STRUCT *bmstruct;
 
   if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
@@ -155,8 +257,7 @@ static int internal_bm_match(STRING *pattern, STRING *text, int stats,
   T = text->sequence;
   N = text->length;
 
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
 
   /*
    * Do the preprocessing.
@@ -188,26 +289,17 @@ static int internal_bm_match(STRING *pattern, STRING *text, int stats,
   while (s != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       bm_free(bmstruct);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = ONESEQ_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + M - 1;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
 
-    len = N - pos;
+    len = N - pos + 1;
     switch (flag) {
     case BM_BAD:     s = bmbad_search(bmstruct, s, len, 1);  break;
     case BM_EXT:     s = bmext_search(bmstruct, s, len, 1);  break;
@@ -219,7 +311,7 @@ static int internal_bm_match(STRING *pattern, STRING *text, int stats,
   /*
    * Print the matches and the statistics.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -236,7 +328,7 @@ static int internal_bm_match(STRING *pattern, STRING *text, int stats,
     if (bmstruct->num_shifts > bmstruct->num_init_mismatch)
       mprintf("   Average Length of Matches:  %.2f\n",
               (float) (bmstruct->num_compares - 
-                       bmstruct->num_shifts + matchcount) / 
+                       bmstruct->num_shifts + results.count) / 
               (float) (bmstruct->num_shifts - bmstruct->num_init_mismatch));
     mprintf("   Number of Shifts:           %d\n", bmstruct->num_shifts);
     if (bmstruct->num_shifts != bmstruct->shift_cost)
@@ -253,13 +345,148 @@ static int internal_bm_match(STRING *pattern, STRING *text, int stats,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   bm_free(bmstruct);
 
   return 1;
 }
 
 
+/*
+ * strmat_bmopt_match, strmat_horspool_match, strmat_sunday_match
+ *
+ * Performs the exact matching algorithm for a pattern and text using
+ * one of the tuned Boyer-Moore family algorithms (the tuned
+ * Boyer-Moore, Horspool's algorithm or Sunday's quick search).
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int internal_bmopt_match(STRING *pattern, STRING *text,
+                                MATCH_MODE *matchmode, int stats,
+                                BMOPT_TYPE flag);
+static BMOPT_STRUCT *internal_bmopt_prep(char *P, int M, BMOPT_TYPE flag);
+static char *internal_bmopt_search(BMOPT_STRUCT *bostruct, char *T, int N,
+                                   int initmatch);
+
+int strmat_bmopt_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats)
+{  return internal_bmopt_match(pattern, text, matchmode, stats, BMOPT_TUNED);  }
+int strmat_horspool_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats)
+{  return internal_bmopt_match(pattern, text, matchmode, stats,
+                               BMOPT_HORSPOOL);  }
+int strmat_sunday_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                        int stats)
+{  return internal_bmopt_match(pattern, text, matchmode, stats,
+                               BMOPT_SUNDAY);  }
+
+static int internal_bmopt_match(STRING *pattern, STRING *text,
+                                MATCH_MODE *matchmode, int stats,
+                                BMOPT_TYPE flag)
+{
+  int M, N, len, pos, flag2, status;
+  char *s, *P, *T;
+  MATCH_RESULTS results;
+  BMOPT_STRUCT *bostruct;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  P = pattern->sequence;
+  M = pattern->length;
+  T = text->sequence;
+  N = text->length;
+
+  /*
+   * Do the preprocessing.
+   */
+  if ((bostruct = internal_bmopt_prep(P, M, flag)) == NULL) {
+    fprintf(stderr, "Error in Boyer-Moore preprocessing.  Stopping search.\n");
+    return 0;
+  }
+
+  /*
+   * Perform the matching.
+   */
+  init_results(&results, matchmode);
+
+  flag2 = 0;
+  s = T;
+  len = N;
+  while ((s = internal_bmopt_search(bostruct, s, len, flag2)) != NULL) {
+    pos = s - T + 1;
+
+    status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
+      bmopt_free(bostruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+
+    len = N - pos + 1;
+    flag2 = 1;
+  }
+
+  /*
+   * Print the matches and the statistics.  The skip loops are not
+   * instrumented, so only the verified alignments are counted.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+#ifdef STATS
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Alignments Verified:        %d\n", bostruct->num_verify);
+    mprintf("   Number of Comparisons:      %d\n", bostruct->num_compares);
+    mprintf("   Avg. Compares per Position: %.2f\n",
+            (float) bostruct->num_compares / (float) N);
+#else
+    mprintf("   No statistics available.\n");
+#endif
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  free_results(&results);
+  bmopt_free(bostruct);
+
+  return 1;
+}
+
+static BMOPT_STRUCT *internal_bmopt_prep(char *P, int M, BMOPT_TYPE flag)
+{
+  switch (flag) {
+  case BMOPT_TUNED:     return bmopt_prep(P, M, 0);
+  case BMOPT_HORSPOOL:  return horspool_prep(P, M, 0);
+  case BMOPT_SUNDAY:    return sunday_prep(P, M, 0);
+  }
+  return NULL;
+}
+
+static char *internal_bmopt_search(BMOPT_STRUCT *bostruct, char *T, int N,
+                                   int initmatch)
+{
+  switch (bostruct->type) {
+  case BMOPT_TUNED:     return bmopt_search(bostruct, T, N, initmatch);
+  case BMOPT_HORSPOOL:  return horspool_search(bostruct, T, N, initmatch);
+  case BMOPT_SUNDAY:    return sunday_search(bostruct, T, N, initmatch);
+  }
+  return NULL;
+}
+
+
 /*
  * strmat_kmp*_match
  *
@@ -271,31 +498,36 @@ static int internal_bm_match(STRING *pattern, STRING *text, int stats,
  * the four functions called by the rest of strmat (i.e., the stubs
  * within the stubs).
  *
- * Parameters:   pattern  -  the pattern sequence
- *               text     -  the text sequence
- *               stats    -  should stats be printed
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
 typedef enum { SP_Z, SPPRIME_Z, SP_ORIG, SPPRIME_ORIG } kmp_types;
 static int internal_kmp_match(STRING *pattern, STRING *text,
-                              int stats, kmp_types flag);
-
-int strmat_kmp_sp_z_match(STRING *pattern, STRING *text, int stats)
-{  return internal_kmp_match(pattern, text, stats, SP_Z);  }
-int strmat_kmp_spprime_z_match(STRING *pattern, STRING *text, int stats)
-{  return internal_kmp_match(pattern, text, stats, SPPRIME_Z);  }
-int strmat_kmp_sp_orig_match(STRING *pattern, STRING *text, int stats)
-{  return internal_kmp_match(pattern, text, stats, SP_ORIG);  }
-int strmat_kmp_spprime_orig_match(STRING *pattern, STRING *text, int stats)
-{  return internal_kmp_match(pattern, text, stats, SPPRIME_ORIG);  }
+                              MATCH_MODE *matchmode, int stats, kmp_types flag);
+
+int strmat_kmp_sp_z_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats)
+{  return internal_kmp_match(pattern, text, matchmode, stats, SP_Z);  }
+int strmat_kmp_spprime_z_match(STRING *pattern, STRING *text,
+                               MATCH_MODE *matchmode, int stats)
+{  return internal_kmp_match(pattern, text, matchmode, stats, SPPRIME_Z);  }
+int strmat_kmp_sp_orig_match(STRING *pattern, STRING *text,
+                             MATCH_MODE *matchmode, int stats)
+{  return internal_kmp_match(pattern, text, matchmode, stats, SP_ORIG);  }
+int strmat_kmp_spprime_orig_match(STRING *pattern, STRING *text,
+                                  MATCH_MODE *matchmode, int stats)
+{  return internal_kmp_match(pattern, text, matchmode, stats, SPPRIME_ORIG);  }
 
 static int internal_kmp_match(STRING *pattern, STRING *text,
-                              int stats, kmp_types flag)
+                              MATCH_MODE *matchmode, int stats, kmp_types flag)
 {
-  int M, N, len, pos, matchcount, matchflag;
+  int M, N, len, pos, status, matchflag;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   KMP_STRUCT *kmpstruct;
 
   if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
@@ -307,8 +539,7 @@ static int internal_kmp_match(STRING *pattern, STRING *text,
   T = text->sequence;
   N = text->length;
 
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
 
   /*
    * Do the preprocessing.
@@ -335,33 +566,24 @@ static int internal_kmp_match(STRING *pattern, STRING *text,
   while ((s = kmp_search(kmpstruct, s, len, matchflag)) != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       kmp_free(kmpstruct);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = ONESEQ_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + M - 1;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
 
-    len = N - pos;
+    len = N - pos + 1;
     matchflag = 1;
   }
 
   /*
    * Print the statistics and the matches.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -388,7 +610,7 @@ static int internal_kmp_match(STRING *pattern, STRING *text,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   kmp_free(kmpstruct);
 
   return 1;
@@ -404,16 +626,17 @@ static int internal_kmp_match(STRING *pattern, STRING *text,
  * Parameters:   pattern_ary   -  the pattern sequences
  *               num_patterns  -  the number of patterns
  *               text          -  the text sequence
+ *               matchmode     -  the result mode (NULL for all matches)
  *               stats         -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
 int strmat_ac_match(STRING **pattern_ary, int num_patterns, STRING *text,
-                    int stats)
+                    MATCH_MODE *matchmode, int stats)
 {
-  int i, M, N, pos, matchcount, matchlen, matchid, total_length;
+  int i, M, N, pos, status, matchlen, matchid, total_length;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   AC_STRUCT *acstruct;
 
   if (pattern_ary == NULL || num_patterns == 0 || text == NULL ||
@@ -423,8 +646,7 @@ int strmat_ac_match(STRING **pattern_ary, int num_patterns, STRING *text,
   T = text->sequence;
   N = text->length;
 
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
 
   /*
    * Perform the Aho-Corasick preprocessing.
@@ -452,31 +674,22 @@ int strmat_ac_match(STRING **pattern_ary, int num_patterns, STRING *text,
   while ((s = ac_search(acstruct, &matchlen, &matchid)) != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, SET_EXACT, matchid, 0,
+                        pos, pos + matchlen - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       ac_free(acstruct);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = SET_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + matchlen - 1;
-    newmatch->id = matchid;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
   }
 
   /*
    * Print the statistics and the matches.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -510,7 +723,7 @@ int strmat_ac_match(STRING **pattern_ary, int num_patterns, STRING *text,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   ac_free(acstruct);
 
   return 1;
@@ -528,19 +741,20 @@ int strmat_ac_match(STRING **pattern_ary, int num_patterns, STRING *text,
  * Parameters:   pattern_ary   -  the pattern sequences
  *               num_patterns  -  the number of patterns
  *               text          -  the text sequence
+ *               matchmode     -  the result mode (NULL for all matches)
  *               stats         -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
 int strmat_bmset_naive_match(STRING **pattern_ary, int num_patterns,
-                             STRING *text, int stats)
+                             STRING *text, MATCH_MODE *matchmode, int stats)
 {
-  int i, M, N, pos, matchcount, matchlen, matchid, total_length;
+  int i, M, N, pos, status, matchlen, matchid, total_length;
   char *s, *P, *T;
 #ifdef STATS
   float avg;
 #endif
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   BMSET_NAIVE_STRUCT *bmstruct;
 
   if (pattern_ary == NULL || num_patterns == 0 || text == NULL ||
@@ -571,38 +785,28 @@ int strmat_bmset_naive_match(STRING **pattern_ary, int num_patterns,
   /*
    * Perform the matching.
    */
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
 
   bmset_naive_search_init(bmstruct, T, N);
   while ((s = bmset_naive_search(bmstruct, &matchlen, &matchid)) != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, SET_EXACT, matchid, 0,
+                        pos, pos + matchlen - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       bmset_naive_free(bmstruct);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = SET_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + matchlen - 1;
-    newmatch->id = matchid;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
   }
 
   /*
    * Print the matches and the statistics.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -638,7 +842,7 @@ int strmat_bmset_naive_match(STRING **pattern_ary, int num_patterns,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   bmset_naive_free(bmstruct);
 
   return 1;
@@ -654,33 +858,36 @@ int strmat_bmset_naive_match(STRING **pattern_ary, int num_patterns,
  * Parameters:   pattern_ary   -  the pattern sequences
  *               num_patterns  -  the number of patterns
  *               text          -  the text sequence
+ *               matchmode     -  the result mode (NULL for all matches)
  *               stats         -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
 
 static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
-                                  STRING *text, int stats, BMSETALG_TYPE type);
+                                  STRING *text, MATCH_MODE *matchmode,
+                                  int stats, BMSETALG_TYPE type);
 
 int strmat_bmset_badonly_match(STRING **patterns, int num_patterns,
-                               STRING *text, int stats)
+                               STRING *text, MATCH_MODE *matchmode, int stats)
 {  return int_strmat_bmset_match(patterns, num_patterns,
-                                 text, stats, BMSET_BADONLY);  }
+                                 text, matchmode, stats, BMSET_BADONLY);  }
 int strmat_bmset_2trees_match(STRING **patterns, int num_patterns,
-                              STRING *text, int stats)
+                              STRING *text, MATCH_MODE *matchmode, int stats)
 {  return int_strmat_bmset_match(patterns, num_patterns,
-                                 text, stats, BMSET_2TREES);  }
+                                 text, matchmode, stats, BMSET_2TREES);  }
 int strmat_bmset_1tree_match(STRING **patterns, int num_patterns,
-                             STRING *text, int stats)
+                             STRING *text, MATCH_MODE *matchmode, int stats)
 {  return int_strmat_bmset_match(patterns, num_patterns,
-                                 text, stats, BMSET_1TREE);  }
+                                 text, matchmode, stats, BMSET_1TREE);  }
 
 static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
-                                  STRING *text, int stats, BMSETALG_TYPE type)
+                                  STRING *text, MATCH_MODE *matchmode,
+                                  int stats, BMSETALG_TYPE type)
 {
-  int i, M, N, pos, status, matchcount, matchlen, matchid, total_length;
+  int i, M, N, pos, status, matchlen, matchid, total_length;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   BMSET_STRUCT *bmstruct;
 
   if (patterns == NULL || num_patterns == 0 || text == NULL ||
@@ -690,8 +897,7 @@ static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
   T = text->sequence;
   N = text->length;
 
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
 
   /*
    * Perform the Boyer-Moore set matching preprocessing.
@@ -757,9 +963,10 @@ static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
   while (s != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, SET_EXACT, matchid, 0,
+                        pos, pos + matchlen - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       switch (type) {
       case BMSET_BADONLY:  bmset_badonly_free(bmstruct);  break;
       case BMSET_2TREES:   bmset_2trees_free(bmstruct);  break;
@@ -768,18 +975,8 @@ static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = SET_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + matchlen - 1;
-    newmatch->id = matchid;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
 
     switch (type) {
     case BMSET_BADONLY:  s = bmset_badonly_search(bmstruct,
@@ -794,7 +991,7 @@ static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
   /*
    * Print the matches and the statistics.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -834,7 +1031,7 @@ static int int_strmat_bmset_match(STRING **patterns, int num_patterns,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   switch (type) {
   case BMSET_BADONLY:  bmset_badonly_free(bmstruct);  break;
   case BMSET_2TREES:   bmset_2trees_free(bmstruct);  break;
@@ -932,17 +1129,19 @@ int strmat_z_build(STRING *string, int stats)
  * Performs the exact matching algorithm for a pattern and text using
  * the Z values matching algorithm.
  *
- * Parameters:   pattern  -  the pattern sequence
- *               text     -  the text sequence
- *               stats    -  should stats be printed
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
-int strmat_z_match(STRING *pattern, STRING *text, int stats)
+int strmat_z_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                   int stats)
 {
-  int M, N, len, pos, flag, matchcount;
+  int M, N, len, pos, flag, status;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch;
+  MATCH_RESULTS results;
   Z_STRUCT *zvalues;
 
   if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
@@ -963,41 +1162,31 @@ int strmat_z_match(STRING *pattern, STRING *text, int stats)
   /*
    * Perform the matching.
    */
-  matchlist = matchtail = NULL;
-  matchcount = 0;
+  init_results(&results, matchmode);
   flag = 0;
   s = T;
   len = N;
   while ((s = z_search(zvalues, s, len, flag)) != NULL) {
     pos = s - T + 1;
 
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+    status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
       z_free(zvalues);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = ONESEQ_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + M - 1;
-
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
-    }
-    matchcount++;
+    else if (status == 0)
+      break;
 
-    len = N - pos;
+    len = N - pos + 1;
     flag = 1;
   }
 
   /*
    * Print the statistics and the matches.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -1017,8 +1206,1467 @@ int strmat_z_match(STRING *pattern, STRING *text, int stats)
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   z_free(zvalues);
 
   return 1;
 }
+
+
+/*
+ * strmat_z_batch
+ *
+ * Performs exact matching of a batch of patterns against one text with
+ * the Z values algorithm, preprocessing the text once for all of the
+ * patterns and searching for the patterns with a pool of threads.
+ * With stats on, strmat_z_match's search (z_search, one pattern at a
+ * time) is timed on the same patterns and its matches checked against
+ * these.
+ *
+ * Parameters:   patterns      -  the pattern sequences
+ *               num_patterns  -  the number of patterns
+ *               text          -  the text sequence
+ *               nthreads      -  the number of threads to use
+ *               matchmode     -  the result mode (NULL for all matches)
+ *               stats         -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_z_batch(STRING **patterns, int num_patterns, STRING *text,
+                   int nthreads, MATCH_MODE *matchmode, int stats)
+{
+  int i, j, M, N, len, flag, status, agree, total_matches, *lengths;
+  double start, prep_secs, secs, cmp_secs;
+  char *s, *T, **P;
+  MATCH_RESULTS results;
+  Z_STRUCT *zvalues;
+  ZBATCH_TEXT *zt;
+  ZBATCH_STRUCT *zb;
+
+  if (patterns == NULL || num_patterns <= 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+  for (i=0; i < num_patterns; i++)
+    if (patterns[i] == NULL || patterns[i]->sequence == NULL ||
+        patterns[i]->length == 0)
+      return 0;
+
+  T = text->sequence;
+  N = text->length;
+
+  P = malloc(num_patterns * sizeof(char *));
+  lengths = malloc(num_patterns * sizeof(int));
+  if (P == NULL || lengths == NULL) {
+    if (P != NULL)
+      free(P);
+    if (lengths != NULL)
+      free(lengths);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+  for (i=0; i < num_patterns; i++) {
+    P[i] = patterns[i]->sequence;
+    lengths[i] = patterns[i]->length;
+  }
+
+  /*
+   * Preprocess the text, and search for all of the patterns.
+   */
+  start = bench_seconds();
+  zt = zbatch_text_prep(T, N, 0);
+  prep_secs = bench_seconds() - start;
+
+  start = bench_seconds();
+  zb = (zt != NULL ? zbatch_search(zt, P, lengths, num_patterns, nthreads)
+                   : NULL);
+  secs = bench_seconds() - start;
+
+  free(P);
+  free(lengths);
+  if (zb == NULL) {
+    fprintf(stderr, "Error in the batch search.  Stopping search.\n");
+    zbatch_text_free(zt);
+    return 0;
+  }
+
+  /*
+   * Time z_search on each pattern, checking that it finds the same
+   * matches.
+   */
+  agree = 1;
+  cmp_secs = 0.0;
+  for (i=0; stats && i < num_patterns; i++) {
+    start = bench_seconds();
+    if ((zvalues = z_build(patterns[i]->sequence, patterns[i]->length,
+                           0)) == NULL) {
+      agree = 0;
+      continue;
+    }
+
+    j = 0;
+    flag = 0;
+    s = T;
+    len = N;
+    while ((s = z_search(zvalues, s, len, flag)) != NULL) {
+      if (j >= zb->num_matches[i] || zb->matches[i][j] != s - T + 1)
+        agree = 0;
+      j++;
+
+      len = N - (s - T);
+      flag = 1;
+    }
+    if (j != zb->num_matches[i])
+      agree = 0;
+
+    z_free(zvalues);
+    cmp_secs += bench_seconds() - start;
+  }
+
+  /*
+   * Print the matches and the statistics.
+   */
+  total_matches = 0;
+  for (i=0; i < num_patterns; i++) {
+    M = patterns[i]->length;
+
+    init_results(&results, matchmode);
+    for (j=0; j < zb->num_matches[i]; j++) {
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          zb->matches[i][j], zb->matches[i][j] + M - 1, 0);
+      if (status == -1) {
+        free_results(&results);
+        zbatch_free(zb);
+        zbatch_text_free(zt);
+        mprintf("Memory Error:  Ran out of memory.\n");
+        return 0;
+      }
+      else if (status == 0)
+        break;
+    }
+
+    mprintf("Pattern %d:\n", i + 1);
+    print_results(text, NULL, 0, &results);
+    free_results(&results);
+
+    total_matches += zb->num_matches[i];
+  }
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Number of Patterns:         %d\n", num_patterns);
+    mprintf("   Number of Threads:          %d\n", zb->nthreads);
+    mprintf("   Number of Matches:          %d\n", total_matches);
+#ifdef STATS
+    mprintf("   Preprocessing Comparisons:  %d\n", zb->prep_compares);
+    mprintf("   Number of Comparisons:      %d\n", zb->num_compares);
+    mprintf("   Positions Skipped:          %d\n", zb->num_skipped);
+#endif
+    mprintf("   Text Preprocessing Time:    %.3f seconds\n", prep_secs);
+    mprintf("   Batch Search Time:          %.3f seconds\n", secs);
+    mprintf("   Z Search Time (each):       %.3f seconds\n", cmp_secs);
+    mprintf("   Matches Agree:              %s\n", (agree ? "yes" : "NO"));
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  zbatch_free(zb);
+  zbatch_text_free(zt);
+
+  return 1;
+}
+
+
+/*
+ * strmat_filter_bench, strmat_bm_bench
+ *
+ * Benchmark exact matching algorithms against each other on random
+ * DNA, random protein and the Fibonacci text.  strmat_filter_bench
+ * times the first/last character filter (with each kernel the processor
+ * supports) against the naive algorithm and the four variations of the
+ * Boyer-Moore algorithm, and strmat_bm_bench times the Boyer-Moore
+ * family (the four variations, the tuned Boyer-Moore, Horspool and
+ * Sunday).  For each text and pattern length, they time finding every
+ * match of 20 patterns taken from the text, and check that all of the
+ * algorithms find the same number of matches as the bad character
+ * Boyer-Moore.
+ *
+ * Parameters:   length  -  the length of the generated texts
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+#define EXACT_BENCH_QUERIES 20
+
+typedef enum {
+  EB_NAIVE, EB_BMBAD, EB_BMEXT, EB_BMGOOD, EB_BMEXTGOOD,
+  EB_FILTER_SCALAR, EB_FILTER_SSE2, EB_FILTER_AVX2,
+  EB_BMOPT, EB_HORSPOOL, EB_SUNDAY
+} exact_bench_algs;
+
+static char *exact_bench_names[] = {
+  "Naive", "BM-bad", "BM-ext", "BM-good", "BM-e+g", "Scalar", "SSE2", "AVX2",
+  "Tuned", "Horspl", "Sunday"
+};
+
+static int internal_exact_bench(int length, exact_bench_algs *algs,
+                                int num_algs);
+static int exact_bench_count(exact_bench_algs alg, char *P, int M, char *T,
+                             int N);
+static char *exact_bench_bm(BM_STRUCT *bmstruct, char *T, int N,
+                            int initmatch);
+
+int strmat_filter_bench(int length)
+{
+  static exact_bench_algs algs[] = {
+    EB_NAIVE, EB_BMBAD, EB_BMEXT, EB_BMGOOD, EB_BMEXTGOOD,
+    EB_FILTER_SCALAR, EB_FILTER_SSE2, EB_FILTER_AVX2
+  };
+
+  return internal_exact_bench(length, algs, 8);
+}
+
+int strmat_bm_bench(int length)
+{
+  static exact_bench_algs algs[] = {
+    EB_BMBAD, EB_BMEXT, EB_BMGOOD, EB_BMEXTGOOD, EB_BMOPT, EB_HORSPOOL,
+    EB_SUNDAY
+  };
+
+  return internal_exact_bench(length, algs, 7);
+}
+
+static int internal_exact_bench(int length, exact_bench_algs *algs,
+                                int num_algs)
+{
+  int i, t, p, a, M, count, ref, quit, total[16];
+  unsigned int seed;
+  char *T;
+  double start, secs[16];
+
+  static int types[3] = { BENCH_DNA, BENCH_PROTEIN, BENCH_REPETITIVE };
+  static int patlens[3] = { 4, 16, 64 };
+
+  ref = 0;
+  for (a=0; a < num_algs; a++)
+    if (algs[a] == EB_BMBAD)
+      ref = a;
+
+  mprintf("Exact matching of %d patterns, text length %d (seconds):\n\n",
+          EXACT_BENCH_QUERIES, length);
+  mprintf("  Text        M");
+  for (a=0; a < num_algs; a++)
+    mprintf(" %7s", exact_bench_names[algs[a]]);
+  mputc('\n');
+
+  quit = 0;
+  for (t=0; t < 3 && !quit; t++) {
+    if ((T = bench_text(types[t], length)) == NULL) {
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+
+    for (p=0; p < 3 && !quit && patlens[p] <= length; p++) {
+      M = patlens[p];
+
+      for (a=0; a < num_algs; a++) {
+        seed = 54321;
+        total[a] = 0;
+        start = bench_seconds();
+        for (i=0; i < EXACT_BENCH_QUERIES; i++) {
+          seed = seed * 1103515245 + 12345;
+          count = exact_bench_count(algs[a],
+                                    T + (seed >> 4) % (length - M + 1),
+                                    M, T, length);
+          if (count < 0)
+            break;
+          total[a] += count;
+        }
+        secs[a] = (i < EXACT_BENCH_QUERIES ? -1.0 : bench_seconds() - start);
+      }
+
+      mprintf("  %-10s %2d", bench_names[types[t]], M);
+      for (a=0; a < num_algs; a++) {
+        if (secs[a] < 0.0)
+          mprintf("       -");
+        else
+          mprintf(" %7.3f", secs[a]);
+      }
+      if (mputc('\n') == 0)
+        quit = 1;
+
+      for (a=0; a < num_algs && !quit; a++)
+        if (secs[a] >= 0.0 && total[a] != total[ref] &&
+            mprintf("     (%s found %d matches, %s found %d!)\n",
+                    exact_bench_names[algs[a]], total[a],
+                    exact_bench_names[algs[ref]], total[ref]) == 0)
+          quit = 1;
+    }
+
+    free(T);
+  }
+  mputc('\n');
+
+  return 1;
+}
+
+
+/*
+ * exact_bench_count
+ *
+ * Count the matches of a pattern in a text, using algorithm alg.
+ *
+ * Returns:  the number of matches, or -1 if the algorithm is not
+ *           available (or memory ran out).
+ */
+static int exact_bench_count(exact_bench_algs alg, char *P, int M, char *T,
+                             int N)
+{
+  int count;
+  char *s;
+  NAIVE_STRUCT *nstruct;
+  BM_STRUCT *bmstruct;
+  BMOPT_STRUCT *bostruct;
+  FILTER_STRUCT *fstruct;
+
+  count = 0;
+  switch (alg) {
+  case EB_NAIVE:
+    if ((nstruct = naive_prep(P, M, 0)) == NULL)
+      return -1;
+    for (s=naive_search(nstruct, T, N, 0); s != NULL;
+         s=naive_search(nstruct, s, N - (s - T), 1))
+      count++;
+    naive_free(nstruct);
+    break;
+
+  case EB_BMBAD:
+  case EB_BMEXT:
+  case EB_BMGOOD:
+  case EB_BMEXTGOOD:
+    bmstruct = NULL;
+    switch (alg) {
+    case EB_BMBAD:      bmstruct = bmbad_prep(P, M, 0);  break;
+    case EB_BMEXT:      bmstruct = bmext_prep(P, M, 0);  break;
+    case EB_BMGOOD:     bmstruct = bmgood_prep(P, M, 0);  break;
+    default:            bmstruct = bmextgood_prep(P, M, 0);  break;
+    }
+    if (bmstruct == NULL)
+      return -1;
+    for (s=exact_bench_bm(bmstruct, T, N, 0); s != NULL;
+         s=exact_bench_bm(bmstruct, s, N - (s - T), 1))
+      count++;
+    bm_free(bmstruct);
+    break;
+
+  case EB_FILTER_SCALAR:
+  case EB_FILTER_SSE2:
+  case EB_FILTER_AVX2:
+    if ((fstruct = filter_prep(P, M, 0)) == NULL)
+      return -1;
+    if (!filter_select(fstruct, FILTER_SCALAR + (alg - EB_FILTER_SCALAR))) {
+      filter_free(fstruct);
+      return -1;
+    }
+    for (s=filter_search(fstruct, T, N, 0); s != NULL;
+         s=filter_search(fstruct, s, N - (s - T), 1))
+      count++;
+    filter_free(fstruct);
+    break;
+
+  case EB_BMOPT:
+  case EB_HORSPOOL:
+  case EB_SUNDAY:
+    bostruct = internal_bmopt_prep(P, M, BMOPT_TUNED + (alg - EB_BMOPT));
+    if (bostruct == NULL)
+      return -1;
+    for (s=internal_bmopt_search(bostruct, T, N, 0); s != NULL;
+         s=internal_bmopt_search(bostruct, s, N - (s - T), 1))
+      count++;
+    bmopt_free(bostruct);
+    break;
+  }
+
+  return count;
+}
+
+static char *exact_bench_bm(BM_STRUCT *bmstruct, char *T, int N,
+                            int initmatch)
+{
+  switch (bmstruct->type) {
+  case BM_BAD:      return bmbad_search(bmstruct, T, N, initmatch);
+  case BM_EXT:      return bmext_search(bmstruct, T, N, initmatch);
+  case BM_GOOD:     return bmgood_search(bmstruct, T, N, initmatch);
+  case BM_EXTGOOD:  return bmextgood_search(bmstruct, T, N, initmatch);
+  }
+  return NULL;
+}
+
+
+/*
+ * strmat_pscan_*_match
+ *
+ * Performs the exact matching algorithm for a pattern and text by
+ * running the naive, Boyer-Moore (good suffix and extended bad
+ * character rules), Knuth-Morris-Pratt (sp' values) or Z values
+ * algorithm over chunks of the text on a pool of threads.
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               nthreads   -  the number of threads to use
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int internal_pscan_match(STRING *pattern, STRING *text, int nthreads,
+                                MATCH_MODE *matchmode, int stats,
+                                PSCAN_ALG alg);
+
+int strmat_pscan_naive_match(STRING *pattern, STRING *text, int nthreads,
+                             MATCH_MODE *matchmode, int stats)
+{  return internal_pscan_match(pattern, text, nthreads, matchmode, stats,
+                               PSCAN_NAIVE);  }
+int strmat_pscan_bm_match(STRING *pattern, STRING *text, int nthreads,
+                          MATCH_MODE *matchmode, int stats)
+{  return internal_pscan_match(pattern, text, nthreads, matchmode, stats,
+                               PSCAN_BMEXTGOOD);  }
+int strmat_pscan_kmp_match(STRING *pattern, STRING *text, int nthreads,
+                           MATCH_MODE *matchmode, int stats)
+{  return internal_pscan_match(pattern, text, nthreads, matchmode, stats,
+                               PSCAN_KMP);  }
+int strmat_pscan_z_match(STRING *pattern, STRING *text, int nthreads,
+                         MATCH_MODE *matchmode, int stats)
+{  return internal_pscan_match(pattern, text, nthreads, matchmode, stats,
+                               PSCAN_Z);  }
+
+static int internal_pscan_match(STRING *pattern, STRING *text, int nthreads,
+                                MATCH_MODE *matchmode, int stats, PSCAN_ALG alg)
+{
+  int i, M, N, status;
+  double start, secs;
+  MATCH_RESULTS results;
+  PSCAN_STRUCT *ps;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  M = pattern->length;
+  N = text->length;
+
+  /*
+   * Perform the matching.
+   */
+  start = bench_seconds();
+  ps = pscan_search(pattern->sequence, M, text->sequence, N, alg,
+                    nthreads, 0);
+  secs = bench_seconds() - start;
+  if (ps == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  init_results(&results, matchmode);
+  for (i=0; i < ps->num_matches; i++) {
+    status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                        ps->matches[i], ps->matches[i] + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
+      pscan_free(ps);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+  }
+
+  /*
+   * Print the matches and the statistics.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Algorithm:                  %s\n", pscan_name(alg));
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Threads:                    %d\n", ps->nthreads);
+    mprintf("   Chunks:                     %d (%d alignments each)\n",
+            ps->num_chunks, ps->chunk_size);
+#ifdef STATS
+    mprintf("   Number of Comparisons:      %d\n", ps->num_compares);
+    mprintf("   Avg. Compares per Position: %.2f\n",
+            (float) ps->num_compares / (float) N);
+#endif
+    mprintf("   Search Time:                %.3f seconds\n", secs);
+    mputc('\n');
+  }
+
+  free_results(&results);
+  pscan_free(ps);
+
+  return 1;
+}
+
+
+/*
+ * strmat_pscan_bench
+ *
+ * Benchmarks the multi-threaded chunked scanning of a random DNA text
+ * with the naive, Boyer-Moore, Knuth-Morris-Pratt and Z values
+ * algorithms, reporting the throughput and the speedup over one thread
+ * for 1, 2, 4, ... threads up to max_threads.  Each run searches for
+ * 5 patterns of length 16 taken from the text, and the number of
+ * matches is checked against the 1 thread run.
+ *
+ * Parameters:   length       -  the length of the generated text
+ *               max_threads  -  the largest number of threads to try
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+#define PSCAN_BENCH_QUERIES 5
+#define PSCAN_BENCH_PATLEN 16
+
+int strmat_pscan_bench(int length, int max_threads)
+{
+  int i, a, M, nthreads, count, first, quit;
+  unsigned int seed;
+  char *T;
+  double start, secs, base;
+  PSCAN_STRUCT *ps;
+
+  static PSCAN_ALG algs[4] = { PSCAN_NAIVE, PSCAN_BMEXTGOOD, PSCAN_KMP,
+                               PSCAN_Z };
+
+  M = (length < PSCAN_BENCH_PATLEN ? length : PSCAN_BENCH_PATLEN);
+  if ((T = bench_text(BENCH_DNA, length)) == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  mprintf("Chunked scanning of DNA, text length %d, %d patterns"
+          " of length %d:\n\n", length, PSCAN_BENCH_QUERIES, M);
+  mprintf("   Algorithm   Threads    Seconds     MB/sec   Speedup\n");
+
+  quit = 0;
+  for (a=0; a < 4 && !quit; a++) {
+    first = -1;
+    base = 0.0;
+    for (nthreads=1; nthreads <= max_threads && !quit;
+         nthreads=(nthreads < max_threads && nthreads * 2 > max_threads
+                     ? max_threads : nthreads * 2)) {
+      seed = 54321;
+      count = 0;
+      start = bench_seconds();
+      for (i=0; i < PSCAN_BENCH_QUERIES; i++) {
+        seed = seed * 1103515245 + 12345;
+        ps = pscan_search(T + (seed >> 4) % (length - M + 1), M, T, length,
+                          algs[a], nthreads, 0);
+        if (ps == NULL) {
+          mprintf("Memory Error:  Ran out of memory.\n");
+          free(T);
+          return 0;
+        }
+        count += ps->num_matches;
+        pscan_free(ps);
+      }
+      secs = bench_seconds() - start;
+      if (secs <= 0.0)
+        secs = 0.000001;
+
+      if (first < 0) {
+        first = count;
+        base = secs;
+      }
+
+      if (mprintf("   %-10s  %7d  %9.3f  %9.2f  %8.2f%s\n",
+                  pscan_name(algs[a]), nthreads, secs,
+                  PSCAN_BENCH_QUERIES * (double) length / secs / 1000000.0,
+                  base / secs,
+                  (count == first ? "" : "   (differs from 1 thread!)")) == 0)
+        quit = 1;
+    }
+  }
+  mputc('\n');
+
+  free(T);
+  return 1;
+}
+
+
+/*
+ * strmat_*_stream_match
+ *
+ * Performs the exact matching algorithm for a pattern and the contents
+ * of a file by feeding the file a buffer at a time to the streaming
+ * version of the Knuth-Morris-Pratt automaton (built from the sp'
+ * values) or of Boyer-Moore (good suffix and extended bad character
+ * rules), so the file is scanned in constant memory.  The raw pattern
+ * characters (unmapped) are matched against the bytes of the file.
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               path       -  the name of the file to scan
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+#define STREAM_BUFSIZE 65536
+
+static int internal_stream_match(STRING *pattern, char *path,
+                                 MATCH_MODE *matchmode, int stats, int use_kmp);
+
+int strmat_kmp_stream_match(STRING *pattern, char *path, MATCH_MODE *matchmode,
+                            int stats)
+{  return internal_stream_match(pattern, path, matchmode, stats, 1);  }
+int strmat_bm_stream_match(STRING *pattern, char *path, MATCH_MODE *matchmode,
+                           int stats)
+{  return internal_stream_match(pattern, path, matchmode, stats, 0);  }
+
+static int internal_stream_match(STRING *pattern, char *path,
+                                 MATCH_MODE *matchmode, int stats, int use_kmp)
+{
+  int M, len, num_buffers, printing, mode, done;
+  long pos, total, matchcount;
+  char *buf;
+  double start, secs;
+  FILE *fp;
+  KMP_STRUCT *kmpstruct;
+  KMP_STREAM *ks;
+  BM_STRUCT *bmstruct;
+  BM_STREAM *bs;
+
+  if (pattern == NULL || pattern->raw_seq == NULL || pattern->length == 0 ||
+      path == NULL)
+    return 0;
+
+  M = pattern->length;
+
+  if ((fp = fopen(path, "rb")) == NULL) {
+    mprintf("Error:  Unable to open %s.\n", path);
+    return 0;
+  }
+
+  kmpstruct = NULL;
+  ks = NULL;
+  bmstruct = NULL;
+  bs = NULL;
+  buf = malloc(STREAM_BUFSIZE);
+  if (use_kmp) {
+    if ((kmpstruct = kmp_spprime_orig_prep(pattern->raw_seq, M, 0)) != NULL)
+      ks = kmp_stream_open(kmpstruct);
+  }
+  else {
+    if ((bmstruct = bmextgood_prep(pattern->raw_seq, M, 0)) != NULL)
+      bs = bm_stream_open(bmstruct);
+  }
+
+  if (buf == NULL || (ks == NULL && bs == NULL)) {
+    kmp_stream_close(ks);
+    kmp_free(kmpstruct);
+    bm_stream_close(bs);
+    bm_free(bmstruct);
+    if (buf != NULL)
+      free(buf);
+    fclose(fp);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Feed the file through the matcher, printing the matches as they
+   * are found (until the output is stopped).  The file positions are
+   * longs, so the matches are not passed through a MATCH_RESULTS
+   * structure, but the count only and first match modes are followed
+   * (a callback is treated as all matches).
+   */
+  mode = (matchmode != NULL ? matchmode->mode : MATCH_ALL);
+  printing = (mode != MATCH_COUNT);
+  if (printing)
+    mprintf("The matches:\n");
+  matchcount = 0;
+  num_buffers = 0;
+  done = 0;
+  start = bench_seconds();
+  while (!done && (len = fread(buf, 1, STREAM_BUFSIZE, fp)) > 0) {
+    num_buffers++;
+    if (use_kmp)
+      kmp_stream_feed(ks, buf, len);
+    else
+      bm_stream_feed(bs, buf, len);
+
+    while (1) {
+      pos = (use_kmp ? kmp_stream_next(ks) : bm_stream_next(bs));
+      if (pos == 0)
+        break;
+
+      matchcount++;
+      if (printing && mprintf("    %ld-%ld\n", pos, pos + M - 1) == 0)
+        printing = 0;
+      if (mode == MATCH_FIRST) {
+        done = 1;
+        break;
+      }
+    }
+  }
+  total = (use_kmp ? kmp_stream_flush(ks) : bm_stream_flush(bs));
+  secs = bench_seconds() - start;
+
+  if (mode == MATCH_COUNT)
+    mprintf("Found %ld matches (count only).\n\n", matchcount);
+  else if (printing) {
+    if (matchcount == 0)
+      mprintf("    none\n");
+    mputc('\n');
+  }
+
+  if (ferror(fp))
+    mprintf("Error:  Unable to read all of %s.\n\n", path);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Algorithm:             %s\n",
+            (use_kmp ? "Knuth-Morris-Pratt automaton" : "Boyer-Moore"));
+    mprintf("   Stream Length:         %ld\n", total);
+    mprintf("   Pattern Length:        %d\n", M);
+    mprintf("   Number of Matches:     %ld\n", matchcount);
+    mprintf("   Buffers:               %d (%d bytes each)\n",
+            num_buffers, STREAM_BUFSIZE);
+#ifdef STATS
+    mprintf("   Number of Compares:    %d\n",
+            (use_kmp ? kmpstruct->num_compares : bmstruct->num_compares));
+#endif
+    mprintf("   Scan Time:             %.3f seconds\n", secs);
+    mputc('\n');
+  }
+
+  kmp_stream_close(ks);
+  kmp_free(kmpstruct);
+  bm_stream_close(bs);
+  bm_free(bmstruct);
+  free(buf);
+  fclose(fp);
+
+  return 1;
+}
+
+
+/*
+ * strmat_shiftor_match, strmat_bndm_match, strmat_shiftadd_match
+ *
+ * Performs the matching algorithm for a pattern and text using one of
+ * the bit-parallel algorithms, Shift-Or or BNDM for exact matching and
+ * Shift-Add for matching with at most k mismatches (whose matches are
+ * approximate matches scored by their number of mismatches).
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               k          -  the number of mismatches allowed
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int internal_bitpar_match(STRING *pattern, STRING *text, int k,
+                                 MATCH_MODE *matchmode, int stats,
+                                 BITPAR_TYPE type);
+
+int strmat_shiftor_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                         int stats)
+{  return internal_bitpar_match(pattern, text, 0, matchmode, stats,
+                                BITPAR_SHIFTOR);  }
+int strmat_bndm_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                      int stats)
+{  return internal_bitpar_match(pattern, text, 0, matchmode, stats,
+                                BITPAR_BNDM);  }
+int strmat_shiftadd_match(STRING *pattern, STRING *text, int k,
+                          MATCH_MODE *matchmode, int stats)
+{  return internal_bitpar_match(pattern, text, k, matchmode, stats,
+                                BITPAR_SHIFTADD);  }
+
+static int internal_bitpar_match(STRING *pattern, STRING *text, int k,
+                                 MATCH_MODE *matchmode, int stats,
+                                 BITPAR_TYPE type)
+{
+  int M, N, len, pos, flag, status;
+  char *s, *P, *T;
+  MATCH_RESULTS results;
+  BITPAR_STRUCT *bpstruct;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  P = pattern->sequence;
+  M = pattern->length;
+  T = text->sequence;
+  N = text->length;
+
+  /*
+   * Do the preprocessing.
+   */
+  switch (type) {
+  case BITPAR_SHIFTOR:   bpstruct = shiftor_prep(P, M, 0);  break;
+  case BITPAR_BNDM:      bpstruct = bndm_prep(P, M, 0);  break;
+  case BITPAR_SHIFTADD:  bpstruct = shiftadd_prep(P, M, k, 0);  break;
+  default:               bpstruct = NULL;
+  }
+  if (bpstruct == NULL) {
+    fprintf(stderr, "Error in bit-parallel preprocessing.  "
+            "Stopping search.\n");
+    return 0;
+  }
+
+  /*
+   * Perform the matching.
+   */
+  init_results(&results, matchmode);
+
+  flag = 0;
+  s = T;
+  len = N;
+  while (1) {
+    switch (type) {
+    case BITPAR_SHIFTOR:   s = shiftor_search(bpstruct, s, len, flag);  break;
+    case BITPAR_BNDM:      s = bndm_search(bpstruct, s, len, flag);  break;
+    case BITPAR_SHIFTADD:  s = shiftadd_search(bpstruct, s, len, flag);  break;
+    }
+    if (s == NULL)
+      break;
+
+    pos = s - T + 1;
+
+    if (type == BITPAR_SHIFTADD)
+      status = add_result(&results, ONESEQ_APPROX, 0, 0, pos, pos + M - 1,
+                          bpstruct->score);
+    else
+      status = add_result(&results, ONESEQ_EXACT, 0, 0, pos, pos + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
+      bitpar_free(bpstruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+
+    len = N - pos + 1;
+    flag = 1;
+  }
+
+  /*
+   * Print the matches and the statistics.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:                %d\n", N);
+    if (type == BITPAR_SHIFTADD) {
+      mprintf("   Mismatches Allowed:         %d\n", bpstruct->k);
+      mprintf("   Counter Width:              %d bits\n", bpstruct->fbits);
+    }
+    mprintf("   Words per Bit Vector:       %d\n", bpstruct->W);
+#ifdef STATS
+    mprintf("   Number of Steps:            %d\n", bpstruct->num_steps);
+    if (type == BITPAR_BNDM) {
+      mprintf("   Windows Read:               %d\n", bpstruct->num_windows);
+      mprintf("   Alignments Verified:        %d\n", bpstruct->num_verify);
+      mprintf("   Number of Comparisons:      %d\n", bpstruct->num_compares);
+    }
+    mprintf("   Avg. Steps per Position:    %.2f\n",
+            (float) bpstruct->num_steps / (float) N);
+#endif
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  free_results(&results);
+  bitpar_free(bpstruct);
+
+  return 1;
+}
+
+
+/*
+ * strmat_myers_match, strmat_sellers_match
+ *
+ * Performs the approximate matching algorithm for a pattern and text
+ * under the edit distance, using Myers' bit-vector algorithm or
+ * Sellers' dynamic programming algorithm.  Each text position where
+ * an alignment with at most k differences ends gives an approximate
+ * match, scored by its number of differences.
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               k          -  the number of differences allowed
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int internal_myers_match(STRING *pattern, STRING *text, int k,
+                                MATCH_MODE *matchmode, int stats,
+                                MYERS_TYPE type);
+
+int strmat_myers_match(STRING *pattern, STRING *text, int k,
+                       MATCH_MODE *matchmode, int stats)
+{  return internal_myers_match(pattern, text, k, matchmode, stats,
+                               MYERS_BITVEC);  }
+int strmat_sellers_match(STRING *pattern, STRING *text, int k,
+                         MATCH_MODE *matchmode, int stats)
+{  return internal_myers_match(pattern, text, k, matchmode, stats, MYERS_DP);  }
+
+static int internal_myers_match(STRING *pattern, STRING *text, int k,
+                                MATCH_MODE *matchmode, int stats,
+                                MYERS_TYPE type)
+{
+  int M, N, lend, rend, score, found, status;
+  double start, secs;
+  MATCH_RESULTS results;
+  MYERS_STRUCT *mstruct;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  M = pattern->length;
+  N = text->length;
+
+  /*
+   * Do the preprocessing.
+   */
+  if (type == MYERS_BITVEC)
+    mstruct = myers_prep(pattern->sequence, M, k, 0);
+  else
+    mstruct = sellers_prep(pattern->sequence, M, k, 0);
+  if (mstruct == NULL) {
+    fprintf(stderr, "Error in preprocessing.  Stopping search.\n");
+    return 0;
+  }
+
+  /*
+   * Perform the matching.
+   */
+  init_results(&results, matchmode);
+
+  start = bench_seconds();
+  found = myers_first(mstruct, text->sequence, N, &lend, &rend, &score);
+  while (found) {
+    status = add_result(&results, ONESEQ_APPROX, 0, 0, lend, rend, score);
+    if (status == -1) {
+      free_results(&results);
+      myers_free(mstruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+
+    found = myers_next(mstruct, &lend, &rend, &score);
+  }
+  secs = bench_seconds() - start;
+
+  /*
+   * Print the matches and the statistics.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Differences Allowed:        %d\n", mstruct->k);
+    if (type == MYERS_BITVEC)
+      mprintf("   Words per Bit Vector:       %d\n", mstruct->W);
+#ifdef STATS
+    mprintf("   Columns Computed:           %d\n", mstruct->num_columns);
+    mprintf("   Columns to Find Starts:     %d\n",
+            mstruct->num_start_columns);
+    if (type == MYERS_BITVEC)
+      mprintf("   Word Steps:                 %d\n", mstruct->num_steps);
+    else
+      mprintf("   Cells Computed:             %d\n", mstruct->num_steps);
+#endif
+    mprintf("   Search Time:                %.3f seconds\n", secs);
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  free_results(&results);
+  myers_free(mstruct);
+
+  return 1;
+}
+
+
+/*
+ * strmat_kdiff_match
+ *
+ * Performs the Landau-Vishkin k-differences algorithm for a pattern
+ * and text, using constant time longest common extension queries on
+ * the generalized suffix tree of the two strings.  The matches are
+ * those of strmat_myers_match, and with stats on, Myers' algorithm and
+ * Sellers' algorithm are timed on the same input and their matches
+ * checked against these.
+ *
+ * Parameters:   pattern          -  the pattern sequence
+ *               text             -  the text sequence
+ *               k                -  the number of differences allowed
+ *               build_policy     -  suffix tree build policy
+ *               build_threshold  -  threshold used by LIST_THEN_ARRAY
+ *               matchmode        -  the result mode (NULL for all matches)
+ *               stats            -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_kdiff_match(STRING *pattern, STRING *text, int k, int build_policy,
+                       int build_threshold, MATCH_MODE *matchmode, int stats)
+{
+  int i, j, M, N, lend, rend, score, found, status, complete, agree;
+  int lengths[2];
+  double start, build_secs, prep_secs, secs, cmp_secs[2];
+  STRING *strings[2];
+  MATCH_RESULTS results;
+  MATCHES m;
+  SUFFIX_TREE tree;
+  STREE_LCE *lce;
+  KDIFF_STRUCT *kd;
+  MYERS_STRUCT *mstruct;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  M = pattern->length;
+  N = text->length;
+
+  /*
+   * Build the suffix tree of the pattern (string 1) and the text
+   * (string 2), and preprocess it for the LCE queries.
+   */
+  strings[0] = pattern;
+  strings[1] = text;
+  lengths[0] = M;
+  lengths[1] = N;
+
+  start = bench_seconds();
+  tree = stree_gen_ukkonen_build(strings, 2, build_policy, build_threshold);
+  if (tree == NULL) {
+    fprintf(stderr, "Error in preprocessing.  Stopping search.\n");
+    return 0;
+  }
+  build_secs = bench_seconds() - start;
+
+  start = bench_seconds();
+  lce = stree_lce_prep(tree, 2, lengths);
+  kd = NULL;
+  if (lce != NULL)
+    kd = kdiff_prep(lce, pattern->sequence, M, text->sequence, N, k);
+  if (kd == NULL) {
+    fprintf(stderr, "Error in preprocessing.  Stopping search.\n");
+    stree_lce_free(lce);
+    stree_delete_tree(tree);
+    return 0;
+  }
+  prep_secs = bench_seconds() - start;
+
+  /*
+   * Perform the matching.
+   */
+  init_results(&results, matchmode);
+
+  start = bench_seconds();
+  found = kdiff_first(kd, &lend, &rend, &score);
+  while (found) {
+    status = add_result(&results, ONESEQ_APPROX, 0, 0, lend, rend, score);
+    if (status == -1) {
+      free_results(&results);
+      kdiff_free(kd);
+      stree_lce_free(lce);
+      stree_delete_tree(tree);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+
+    found = kdiff_next(kd, &lend, &rend, &score);
+  }
+  secs = bench_seconds() - start;
+  complete = !found;
+
+  /*
+   * Time Myers' and Sellers' algorithms on the same input, checking
+   * that they find the same matches (as far as the result mode kept or
+   * counted them).
+   */
+  agree = 1;
+  cmp_secs[0] = cmp_secs[1] = 0.0;
+  for (i=0; stats && i < 2; i++) {
+    if (i == 0)
+      mstruct = myers_prep(pattern->sequence, M, k, 0);
+    else
+      mstruct = sellers_prep(pattern->sequence, M, k, 0);
+    if (mstruct == NULL) {
+      agree = 0;
+      continue;
+    }
+
+    m = results.list;
+    j = 0;
+    start = bench_seconds();
+    found = myers_first(mstruct, text->sequence, N, &lend, &rend, &score);
+    while (found) {
+      if (m != NULL) {
+        if (m->lend != lend || m->rend != rend || m->score != score)
+          agree = 0;
+        m = m->next;
+      }
+      j++;
+
+      found = myers_next(mstruct, &lend, &rend, &score);
+    }
+    cmp_secs[i] = bench_seconds() - start;
+
+    if (m != NULL || (complete && j != results.count))
+      agree = 0;
+    myers_free(mstruct);
+  }
+
+  /*
+   * Print the matches and the statistics.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Differences Allowed:        %d\n", kd->k);
+    mprintf("   Diagonals:                  %d\n", kd->hi - kd->lo + 1);
+#ifdef STATS
+    mprintf("   Diagonal Extensions:        %d\n", kd->num_extends);
+    mprintf("   LCE Queries:                %d\n", kd->num_lces);
+    mprintf("   LCA Lookups:                %d\n", lce->num_queries);
+    mprintf("   Start Compares:             %d\n", kd->num_start_compares);
+#endif
+    mprintf("   Suffix Tree Build Time:     %.3f seconds\n", build_secs);
+    mprintf("   LCE Preprocessing Time:     %.3f seconds\n", prep_secs);
+    mprintf("   Search Time:                %.3f seconds\n", secs);
+    mprintf("   Myers Search Time:          %.3f seconds\n", cmp_secs[0]);
+    mprintf("   Sellers Search Time:        %.3f seconds\n", cmp_secs[1]);
+    mprintf("   Matches Agree:              %s\n", (agree ? "yes" : "NO"));
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  free_results(&results);
+  kdiff_free(kd);
+  stree_lce_free(lce);
+  stree_delete_tree(tree);
+
+  return 1;
+}
+
+
+/*
+ * strmat_kangaroo_match, strmat_kangaroo_batch
+ *
+ * Performs the "kangaroo" k-mismatches algorithm for one pattern or a
+ * batch of patterns and a text, using constant time longest common
+ * extension queries.  The generalized suffix tree of the text and all
+ * of the patterns is built and preprocessed once, and then serves the
+ * search of every pattern.  With stats on, the Shift-Add algorithm is
+ * timed on the same patterns and its matches checked against these.
+ *
+ * Parameters:   pattern          -  the pattern sequence
+ *               patterns         -  the pattern sequences (batch)
+ *               num_patterns     -  the number of patterns (batch)
+ *               text             -  the text sequence
+ *               k                -  the number of mismatches allowed
+ *               build_policy     -  suffix tree build policy
+ *               build_threshold  -  threshold used by LIST_THEN_ARRAY
+ *               matchmode        -  the result mode (NULL for all matches)
+ *               stats            -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int internal_kangaroo_match(STRING **patterns, int num_patterns,
+                                   STRING *text, int k, int build_policy,
+                                   int build_threshold, MATCH_MODE *matchmode,
+                                   int stats);
+
+int strmat_kangaroo_match(STRING *pattern, STRING *text, int k,
+                          int build_policy, int build_threshold,
+                          MATCH_MODE *matchmode, int stats)
+{
+  return internal_kangaroo_match(&pattern, 1, text, k, build_policy,
+                                 build_threshold, matchmode, stats);
+}
+
+int strmat_kangaroo_batch(STRING **patterns, int num_patterns, STRING *text,
+                          int k, int build_policy, int build_threshold,
+                          MATCH_MODE *matchmode, int stats)
+{
+  return internal_kangaroo_match(patterns, num_patterns, text, k, build_policy,
+                                 build_threshold, matchmode, stats);
+}
+
+static int internal_kangaroo_match(STRING **patterns, int num_patterns,
+                                   STRING *text, int k, int build_policy,
+                                   int build_threshold, MATCH_MODE *matchmode,
+                                   int stats)
+{
+  int i, j, M, N, len, lend, rend, score, found, status, complete, agree;
+  int total_matches, num_positions, num_lces, *lengths;
+  double start, build_secs, prep_secs, secs, cmp_secs;
+  char *s, *T;
+  STRING **strings;
+  MATCH_RESULTS results;
+  MATCHES m;
+  SUFFIX_TREE tree;
+  STREE_LCE *lce;
+  KANGAROO_STRUCT *kg;
+  BITPAR_STRUCT *bpstruct;
+
+  if (patterns == NULL || num_patterns <= 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+  for (i=0; i < num_patterns; i++)
+    if (patterns[i] == NULL || patterns[i]->sequence == NULL ||
+        patterns[i]->length == 0)
+      return 0;
+
+  T = text->sequence;
+  N = text->length;
+
+  /*
+   * Build the suffix tree of the text (string 1) and the patterns
+   * (strings 2 and up), and preprocess it for the LCE queries.
+   */
+  strings = malloc((num_patterns + 1) * sizeof(STRING *));
+  lengths = malloc((num_patterns + 1) * sizeof(int));
+  if (strings == NULL || lengths == NULL) {
+    if (strings != NULL)
+      free(strings);
+    if (lengths != NULL)
+      free(lengths);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+  strings[0] = text;
+  lengths[0] = N;
+  for (i=0; i < num_patterns; i++) {
+    strings[i+1] = patterns[i];
+    lengths[i+1] = patterns[i]->length;
+  }
+
+  start = bench_seconds();
+  tree = stree_gen_ukkonen_build(strings, num_patterns + 1, build_policy,
+                                 build_threshold);
+  build_secs = bench_seconds() - start;
+
+  start = bench_seconds();
+  lce = (tree != NULL ? stree_lce_prep(tree, num_patterns + 1, lengths)
+                      : NULL);
+  prep_secs = bench_seconds() - start;
+
+  free(strings);
+  free(lengths);
+  if (lce == NULL) {
+    fprintf(stderr, "Error in preprocessing.  Stopping search.\n");
+    if (tree != NULL)
+      stree_delete_tree(tree);
+    return 0;
+  }
+
+  /*
+   * Search for each pattern in turn.
+   */
+  total_matches = num_positions = num_lces = 0;
+  secs = cmp_secs = 0.0;
+  agree = 1;
+  for (i=0; i < num_patterns; i++) {
+    M = patterns[i]->length;
+
+    if ((kg = kangaroo_prep(lce, 1, i + 2, k)) == NULL) {
+      fprintf(stderr, "Error in preprocessing.  Stopping search.\n");
+      stree_lce_free(lce);
+      stree_delete_tree(tree);
+      return 0;
+    }
+
+    init_results(&results, matchmode);
+
+    start = bench_seconds();
+    found = kangaroo_first(kg, &lend, &rend, &score);
+    while (found) {
+      status = add_result(&results, ONESEQ_APPROX, 0, 0, lend, rend, score);
+      if (status == -1) {
+        free_results(&results);
+        kangaroo_free(kg);
+        stree_lce_free(lce);
+        stree_delete_tree(tree);
+        mprintf("Memory Error:  Ran out of memory.\n");
+        return 0;
+      }
+      else if (status == 0)
+        break;
+
+      found = kangaroo_next(kg, &lend, &rend, &score);
+    }
+    secs += bench_seconds() - start;
+    complete = !found;
+
+#ifdef STATS
+    num_positions += kg->num_positions;
+    num_lces += kg->num_lces;
+#endif
+
+    /*
+     * Time Shift-Add on the same pattern, checking that it finds the
+     * same matches and mismatch counts (as far as the result mode kept
+     * or counted them).
+     */
+    if (stats) {
+      start = bench_seconds();
+      if ((bpstruct = shiftadd_prep(patterns[i]->sequence, M, k, 0)) == NULL)
+        agree = 0;
+      else {
+        m = results.list;
+        j = 0;
+        s = shiftadd_search(bpstruct, T, N, 0);
+        while (s != NULL) {
+          if (m != NULL) {
+            if (m->lend != s - T + 1 || m->score != bpstruct->score)
+              agree = 0;
+            m = m->next;
+          }
+          j++;
+
+          len = N - (s - T);
+          s = shiftadd_search(bpstruct, s, len, 1);
+        }
+        if (m != NULL || (complete && j != results.count))
+          agree = 0;
+        bitpar_free(bpstruct);
+      }
+      cmp_secs += bench_seconds() - start;
+    }
+
+    /*
+     * Print the matches.
+     */
+    if (num_patterns > 1)
+      mprintf("Pattern %d:\n", i + 1);
+    print_results(text, NULL, 0, &results);
+
+    total_matches += results.count;
+    free_results(&results);
+    kangaroo_free(kg);
+  }
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:                %d\n", N);
+    mprintf("   Number of Patterns:         %d\n", num_patterns);
+    mprintf("   Mismatches Allowed:         %d\n", k);
+    mprintf("   Number of Matches:          %d\n", total_matches);
+#ifdef STATS
+    mprintf("   Alignments Checked:         %d\n", num_positions);
+    mprintf("   LCE Queries:                %d\n", num_lces);
+#endif
+    mprintf("   Suffix Tree Build Time:     %.3f seconds\n", build_secs);
+    mprintf("   LCE Preprocessing Time:     %.3f seconds\n", prep_secs);
+    mprintf("   Search Time:                %.3f seconds\n", secs);
+    mprintf("   Shift-Add Time:             %.3f seconds\n", cmp_secs);
+    mprintf("   Matches Agree:              %s\n", (agree ? "yes" : "NO"));
+    mputc('\n');
+  }
+
+  /*
+   * Free everything allocated.
+   */
+  stree_lce_free(lce);
+  stree_delete_tree(tree);
+
+  return 1;
+}
+
+
+/*
+ * strmat_myers_bench
+ *
+ * Benchmarks Myers' bit-vector algorithm against Sellers' dynamic
+ * programming algorithm on a random DNA text, for patterns of length
+ * 16 up to 512 taken from the text and k = M/8 differences.  Both
+ * compute the same columns (Myers 64 rows to a word operation), and
+ * their matches are checked against each other.
+ *
+ * Parameters:   length  -  the length of the generated text
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_myers_bench(int length)
+{
+  int i, M, k, lend, rend, score, count[2], sum[2];
+  unsigned int seed;
+  char *T, *P;
+  double start, secs[2];
+  MYERS_STRUCT *mstruct;
+
+  if ((T = bench_text(BENCH_DNA, length)) == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  mprintf("Edit distance search of DNA, text length %d:\n\n", length);
+  mprintf("   Pattern    k    DP Seconds   Myers Seconds   Speedup"
+          "   Matches\n");
+
+  seed = 24680;
+  for (M=16; M <= 512 && M <= length; M*=2) {
+    k = M / 8;
+    seed = seed * 1103515245 + 12345;
+    P = T + (seed >> 4) % (length - M + 1);
+
+    for (i=0; i < 2; i++) {
+      mstruct = (i == 0 ? sellers_prep(P, M, k, 1) : myers_prep(P, M, k, 1));
+      if (mstruct == NULL) {
+        mprintf("Memory Error:  Ran out of memory.\n");
+        free(T);
+        return 0;
+      }
+
+      count[i] = sum[i] = 0;
+      start = bench_seconds();
+      if (myers_first(mstruct, T, length, &lend, &rend, &score)) {
+        do {
+          count[i]++;
+          sum[i] += score + lend;
+        } while (myers_next(mstruct, &lend, &rend, &score));
+      }
+      secs[i] = bench_seconds() - start;
+      if (secs[i] <= 0.0)
+        secs[i] = 0.000001;
+
+      myers_free(mstruct);
+    }
+
+    if (mprintf("   %7d  %3d  %12.3f  %14.3f  %8.2f  %8d%s\n", M, k,
+                secs[0], secs[1], secs[0] / secs[1], count[1],
+                (count[0] == count[1] && sum[0] == sum[1]
+                   ? "" : "   (differs from DP!)")) == 0)
+      break;
+  }
+  mputc('\n');
+
+  free(T);
+  return 1;
+}
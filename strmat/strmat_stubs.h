@@ -1,22 +1,75 @@
 
-int strmat_naive_match(STRING *pattern, STRING *text, int stats);
-int strmat_bmbad_match(STRING *pattern, STRING *text, int stats);
-int strmat_bmext_match(STRING *pattern, STRING *text, int stats);
-int strmat_bmgood_match(STRING *pattern, STRING *text, int stats);
-int strmat_bmextgood_match(STRING *pattern, STRING *text, int stats);
-int strmat_kmp_sp_z_match(STRING *pattern, STRING *text, int stats);
-int strmat_kmp_spprime_z_match(STRING *pattern, STRING *text, int stats);
-int strmat_kmp_sp_orig_match(STRING *pattern, STRING *text, int stats);
-int strmat_kmp_spprime_orig_match(STRING *pattern, STRING *text, int stats);
+int strmat_naive_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats);
+int strmat_filter_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                        int stats);
+int strmat_filter_bench(int length);
+int strmat_bmbad_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats);
+int strmat_bmext_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats);
+int strmat_bmgood_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                        int stats);
+int strmat_bmextgood_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                           int stats);
+int strmat_bmopt_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                       int stats);
+int strmat_horspool_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats);
+int strmat_sunday_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                        int stats);
+int strmat_bm_bench(int length);
+int strmat_kmp_sp_z_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats);
+int strmat_kmp_spprime_z_match(STRING *pattern, STRING *text,
+                               MATCH_MODE *matchmode, int stats);
+int strmat_kmp_sp_orig_match(STRING *pattern, STRING *text,
+                             MATCH_MODE *matchmode, int stats);
+int strmat_kmp_spprime_orig_match(STRING *pattern, STRING *text,
+                                  MATCH_MODE *matchmode, int stats);
 int strmat_ac_match(STRING **pattern_ary, int num_patterns, STRING *text,
-                    int stats);
+                    MATCH_MODE *matchmode, int stats);
 int strmat_bmset_naive_match(STRING **pattern_ary, int num_patterns,
-                             STRING *text, int stats);
+                             STRING *text, MATCH_MODE *matchmode, int stats);
 int strmat_bmset_badonly_match(STRING **patterns, int num_patterns,
-                               STRING *text, int stats);
+                               STRING *text, MATCH_MODE *matchmode, int stats);
 int strmat_bmset_2trees_match(STRING **patterns, int num_patterns,
-                              STRING *text, int stats);
+                              STRING *text, MATCH_MODE *matchmode, int stats);
 int strmat_bmset_1tree_match(STRING **patterns, int num_patterns,
-                             STRING *text, int stats);
+                             STRING *text, MATCH_MODE *matchmode, int stats);
 int strmat_z_build(STRING *str, int stats);
-int strmat_z_match(STRING *pat, STRING *text, int stats);
+int strmat_z_match(STRING *pat, STRING *text, MATCH_MODE *matchmode, int stats);
+int strmat_z_batch(STRING **patterns, int num_patterns, STRING *text,
+                   int nthreads, MATCH_MODE *matchmode, int stats);
+int strmat_pscan_naive_match(STRING *pattern, STRING *text, int nthreads,
+                             MATCH_MODE *matchmode, int stats);
+int strmat_pscan_bm_match(STRING *pattern, STRING *text, int nthreads,
+                          MATCH_MODE *matchmode, int stats);
+int strmat_pscan_kmp_match(STRING *pattern, STRING *text, int nthreads,
+                           MATCH_MODE *matchmode, int stats);
+int strmat_pscan_z_match(STRING *pattern, STRING *text, int nthreads,
+                         MATCH_MODE *matchmode, int stats);
+int strmat_pscan_bench(int length, int max_threads);
+int strmat_kmp_stream_match(STRING *pattern, char *path, MATCH_MODE *matchmode,
+                            int stats);
+int strmat_bm_stream_match(STRING *pattern, char *path, MATCH_MODE *matchmode,
+                           int stats);
+int strmat_shiftor_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                         int stats);
+int strmat_bndm_match(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                      int stats);
+int strmat_shiftadd_match(STRING *pattern, STRING *text, int k,
+                          MATCH_MODE *matchmode, int stats);
+int strmat_myers_match(STRING *pattern, STRING *text, int k,
+                       MATCH_MODE *matchmode, int stats);
+int strmat_sellers_match(STRING *pattern, STRING *text, int k,
+                         MATCH_MODE *matchmode, int stats);
+int strmat_kdiff_match(STRING *pattern, STRING *text, int k, int build_policy,
+                       int build_threshold, MATCH_MODE *matchmode, int stats);
+int strmat_kangaroo_match(STRING *pattern, STRING *text, int k,
+                          int build_policy, int build_threshold,
+                          MATCH_MODE *matchmode, int stats);
+int strmat_kangaroo_batch(STRING **patterns, int num_patterns, STRING *text,
+                          int k, int build_policy, int build_threshold,
+                          MATCH_MODE *matchmode, int stats);
+int strmat_myers_bench(int length);
@@ -197,47 +197,36 @@ int strmat_weiner_build(STRING **strings, int num_strings, int build_policy,
  *               num_strings      -  the number of input strings
  *               build_policy     -  suffix tree build policy
  *               build_threshold  -  threshold used by LIST_THEN_ARRAY
+ *               matchmode        -  the result mode (NULL for all matches)
  *               print_stats      -  flag telling whether to print the stats
  *
  * Returns:  non-zero on success, zero on error
  */
-static MATCHES matchlist;
-static int matchcount, matcherror, patlen;
+static MATCH_RESULTS results;
+static int matchstatus, patlen;
 
 static int add_match(SUFFIX_TREE tree, STREE_NODE node)
 {
   int i, pos, id;
   char *seq;
-  MATCHES newmatch;
-  
-  for (i=1; stree_get_leaf(tree, node, i, &seq, &pos, &id); i++) {
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
-      matchlist = NULL;
-      matcherror = 1;
-      return 0;
-    }
 
-    /*
-     * Shift positions by 1 here (from 0..N-1 to 1..N).
-     */
-    newmatch->type = TEXT_SET_EXACT;
-    newmatch->lend = pos + 1;
-    newmatch->rend = pos + patlen;
-    newmatch->textid = id;
-
-    newmatch->next = matchlist;
-    matchlist = newmatch;
-    matchcount++;
-  }
+  /*
+   * The traversal cannot be cut short, so once the results say to stop
+   * (or memory runs out), the rest of the leaves are passed over.
+   * Shift positions by 1 here (from 0..N-1 to 1..N).
+   */
+  for (i=1; matchstatus == 1 &&
+            stree_get_leaf(tree, node, i, &seq, &pos, &id); i++)
+    matchstatus = add_result(&results, TEXT_SET_EXACT, 0, id,
+                             pos + 1, pos + patlen, 0);
 
-  return 1;
+  return (matchstatus == 1);
 }
 
 
 int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
-                       int build_policy, int build_threshold, int print_stats)
+                       int build_policy, int build_threshold,
+                       MATCH_MODE *matchmode, int print_stats)
 {
   int flag, pos, matchlen;
 #ifdef STATS
@@ -282,25 +271,27 @@ int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
   /*
    * Traverse the subtree, finding the matches.
    */
-  matchlist = NULL;
-  matchcount = matcherror = 0;
+  init_results(&results, matchmode);
+  matchstatus = 1;
   patlen = pattern->length;
 
   if (matchlen == pattern->length) {
     stree_traverse_subtree(tree, node, add_match, (int (*)()) NULL);
-    if (matcherror) {
+    if (matchstatus == -1) {
+      free_results(&results);
       stree_delete_tree(tree);
+      mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
       
     /*
      * Bubble sort the matches.
      */
-    flag = 1;
+    flag = (results.list != NULL);
     while (flag) {
       flag = 0;
       back = NULL;
-      current = matchlist;
+      current = results.list;
       while (current->next != NULL) {
         if (current->next->textid < current->textid ||
             (current->next->textid == current->textid &&
@@ -312,7 +303,7 @@ int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
           current->next = next->next;
           next->next = current;
           if (back == NULL)
-            back = matchlist = next;
+            back = results.list = next;
           else
             back = back->next = next;
           
@@ -329,7 +320,7 @@ int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
   /*
    * Print the matches and the statistics.
    */
-  print_matches(NULL, strings, num_strings, matchlist, matchcount);
+  print_results(NULL, strings, num_strings, &results);
 
   if (print_stats) {
     mprintf("Statistics:\n");
@@ -341,7 +332,7 @@ int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
     mprintf("      Cost of Edge Traversal:  %d\n", child_cost);
     mprintf("\n");
     mprintf("   Subtree Traversal:\n");
-    mprintf("      Number of Matches:       %d\n", matchcount);
+    mprintf("      Number of Matches:       %d\n", results.count);
     mprintf("      Number Edges Traversed:  %d\n", tree->edges_traversed);
     mprintf("      Cost of Edge Traversal:  %d\n", tree->child_cost);
 #else
@@ -353,7 +344,7 @@ int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   stree_delete_tree(tree);
 
   return 1;
@@ -4,7 +4,8 @@ int strmat_ukkonen_build(STRING **strings, int num_strings, int build_policy,
 int strmat_weiner_build(STRING **strings, int num_strings, int build_policy,
                         int build_threshold, int print_stats, int print_tree);
 int strmat_stree_match(STRING *pattern, STRING **strings, int num_strings,
-                       int build_policy, int build_threshold, int print_stats);
+                       int build_policy, int build_threshold,
+                       MATCH_MODE *matchmode, int print_stats);
 int strmat_stree_walkaround(STRING **strings, int num_strings,
                             int build_policy, int build_threshold);
 int strmat_stree_naive_lca(STRING **strings, int num_strings, int build_policy,
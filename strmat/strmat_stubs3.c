@@ -2,14 +2,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <unistd.h>
 #include "strmat.h"
 #include "strmat_match.h"
 #include "sary.h"
 #include "sary_match.h"
+#include "sary_pack.h"
+#include "sary_fm.h"
+#include "sary_gen.h"
+#include "sary_cmp.h"
+#include "sary_ext.h"
+#include "sary_lce.h"
+#include "sary_wt.h"
+#include "strmat_bench.h"
 
 
 
 static int print_lcp_values(int *lcp, int min, int max, int index, int depth);
+static int packed_file_match(STRING *pattern, char *path, int mode,
+                             int stats);
 
 
 
@@ -157,7 +169,7 @@ int strmat_sary_stree(STRING *string, int print_stats)
    */
   mprintf("The LCP Values:\n");
   midpoint = (1 + M) / 2;
-  if (print_lcp_values(sary->lcp, 1, midpoint, 2, 3)) {
+  if (M > 2 && print_lcp_values(sary->lcp, 1, midpoint, 2, 3)) {
     print_lcp_values(sary->lcp, midpoint, M, 3, 3);
     mprintf("\n");
   }
@@ -171,6 +183,1213 @@ int strmat_sary_stree(STRING *string, int print_stats)
 }
 
 
+/*
+ * strmat_sary_parallel
+ *
+ * Builds the suffix array of a sequence using the multi-threaded
+ * construction.
+ *
+ * Parameters:   string       -  the sequence
+ *               nthreads     -  the number of threads to use
+ *               print_stats  -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_parallel(STRING *string, int nthreads, int print_stats)
+{
+  int i, len, M, *Pos;
+  char format[32], buf[36];
+  double start, secs;
+  SARY_STRUCT *sary;
+
+  if (string == NULL || string->sequence == NULL || string->length == 0)
+    return 0;
+
+  start = bench_seconds();
+  sary = sary_parallel_build(string->sequence, string->length, nthreads);
+  secs = bench_seconds() - start;
+  if (sary == NULL)
+    return 0;
+
+  /*
+   * Print the statistics.
+   */
+  if (print_stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Number of Threads:   %d\n", nthreads);
+    mprintf("   Number of Compares:  %d\n", sary->num_compares);
+    mprintf("   Peak Memory:         %ld bytes\n", sary->mem_peak);
+    mprintf("   Build Time:          %.3f seconds\n", secs);
+    mprintf("\n");
+  }
+
+  /*
+   * Print the suffix array values.
+   */
+  mprintf("The Suffix Array:\n");
+
+  len = my_itoalen(string->length);
+  sprintf(format, "  %%%dd:  %%s\n", len);
+
+  buf[30] = buf[31] = buf[32] = '.';
+  buf[33] = '\0';
+
+  Pos = sary->Pos;
+  M = sary->M;
+  for (i=1; i <= M; i++) {
+    strncpy(buf, &string->raw_seq[Pos[i] - 1], 30);
+    if (mprintf(format, Pos[i], buf) == 0)
+      break;
+  }
+
+  sary_free(sary);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_zerkle_parallel
+ *
+ * Builds the suffix array of a sequence using Zerkle's algorithm, with
+ * the work of each pass spread across several threads.
+ *
+ * Parameters:   string       -  the sequence
+ *               nthreads     -  the number of threads to use
+ *               print_stats  -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_zerkle_parallel(STRING *string, int nthreads, int print_stats)
+{
+  int i, len, M, *Pos;
+  char format[32], buf[36];
+  double start, secs;
+  SARY_STRUCT *sary;
+
+  if (string == NULL || string->sequence == NULL || string->length == 0)
+    return 0;
+
+  start = bench_seconds();
+  sary = sary_zerkle_parallel_build(string->sequence, string->length,
+                                    nthreads);
+  secs = bench_seconds() - start;
+  if (sary == NULL)
+    return 0;
+
+  /*
+   * Print the statistics.
+   */
+  if (print_stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Number of Threads:   %d\n", nthreads);
+    mprintf("   Build Time:          %.3f seconds\n", secs);
+    mprintf("\n");
+  }
+
+  /*
+   * Print the suffix array values.
+   */
+  mprintf("The Suffix Array:\n");
+
+  len = my_itoalen(string->length);
+  sprintf(format, "  %%%dd:  %%s\n", len);
+
+  buf[30] = buf[31] = buf[32] = '.';
+  buf[33] = '\0';
+
+  Pos = sary->Pos;
+  M = sary->M;
+  for (i=1; i <= M; i++) {
+    strncpy(buf, &string->raw_seq[Pos[i] - 1], 30);
+    if (mprintf(format, Pos[i], buf) == 0)
+      break;
+  }
+
+  sary_free(sary);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_parallel_bench
+ *
+ * Benchmarks the multi-threaded suffix array construction on random DNA,
+ * random protein and a highly repetitive (Fibonacci) text, reporting the
+ * throughput, speedup and peak working memory for 1, 2, 4, ... threads
+ * up to max_threads.  The baseline is the single-threaded build of
+ * sary_qsort_build, which is timed first (as the "serial" row), and
+ * each parallel result is checked against it and its speedup measured
+ * from it.
+ *
+ * Parameters:   length       -  the length of the generated texts
+ *               max_threads  -  the largest number of threads to try
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_parallel_bench(int length, int max_threads)
+{
+  int type, nthreads, same, quit;
+  char *T;
+  double start, secs, base;
+  SARY_STRUCT *sary, *serial;
+
+  mprintf("Parallel suffix array construction, text length %d:\n\n", length);
+  mprintf("   Text        Threads    Seconds     MB/sec   Speedup"
+          "    Peak MB\n");
+
+  quit = 0;
+  for (type=0; type < NUM_BENCH_TEXTS && !quit; type++) {
+    if ((T = bench_text(type, length)) == NULL) {
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+
+    start = bench_seconds();
+    serial = sary_qsort_build(T, length, 0);
+    base = bench_seconds() - start;
+    if (serial == NULL) {
+      mprintf("Memory Error:  Ran out of memory.\n");
+      free(T);
+      return 0;
+    }
+    if (base <= 0.0)
+      base = 0.000001;
+
+    if (mprintf("   %-10s   serial  %9.3f  %9.2f  %8.2f  %9.2f\n",
+                bench_names[type], base, length / base / 1000000.0, 1.0,
+                serial->mem_peak / 1048576.0) == 0)
+      quit = 1;
+
+    for (nthreads=1; nthreads <= max_threads && !quit;
+         nthreads=(nthreads < max_threads && nthreads * 2 > max_threads
+                     ? max_threads : nthreads * 2)) {
+      start = bench_seconds();
+      sary = sary_parallel_build(T, length, nthreads);
+      secs = bench_seconds() - start;
+      if (sary == NULL) {
+        mprintf("Memory Error:  Ran out of memory.\n");
+        sary_free(serial);
+        free(T);
+        return 0;
+      }
+      if (secs <= 0.0)
+        secs = 0.000001;
+
+      same = (memcmp(serial->Pos + 1, sary->Pos + 1,
+                     length * sizeof(int)) == 0);
+
+      if (mprintf("   %-10s  %7d  %9.3f  %9.2f  %8.2f  %9.2f%s\n",
+                  bench_names[type], nthreads, secs,
+                  length / secs / 1000000.0, base / secs,
+                  sary->mem_peak / 1048576.0,
+                  (same ? "" : "   (differs from the serial build!)")) == 0)
+        quit = 1;
+
+      sary_free(sary);
+    }
+
+    sary_free(serial);
+    free(T);
+  }
+  mputc('\n');
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_cmp_bench
+ *
+ * Benchmarks the suffix comparison kernels (one character, an 8 byte
+ * word, or 16 or 32 bytes with SSE2 or AVX2 at a time) on random DNA
+ * and on the highly repetitive Fibonacci text, whose suffixes share
+ * very long prefixes.  For each kernel the processor supports, it
+ * times building the suffix array, computing its lcp values, and
+ * searching for 10000 substrings of length 1000 (or the text length)
+ * with the mlr accelerant.  Each suffix array is checked against the
+ * one built by the first kernel.
+ *
+ * Parameters:   length  -  the length of the generated texts
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+#define CMP_BENCH_QUERIES 10000
+#define CMP_BENCH_PATLEN 1000
+
+int strmat_sary_cmp_bench(int length)
+{
+  int i, type, kernel, patlen, same, quit, *first;
+  unsigned int seed;
+  char *T, *s;
+  double start, build_secs, lcp_secs, search_secs;
+  SARYMAT_STRUCT *smstruct;
+
+  static int types[2] = { BENCH_DNA, BENCH_REPETITIVE };
+
+  patlen = (length < CMP_BENCH_PATLEN ? length : CMP_BENCH_PATLEN);
+
+  mprintf("Suffix comparison kernels, text length %d:\n\n", length);
+  mprintf("   Text        Kernel        Build (s)   LCP (s)   Search (s)\n");
+
+  quit = 0;
+  for (type=0; type < 2 && !quit; type++) {
+    if ((T = bench_text(types[type], length)) == NULL) {
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+
+    first = NULL;
+    for (kernel=SARY_CMP_BYTE; kernel <= SARY_CMP_AVX2 && !quit; kernel++) {
+      if (!sary_cmp_select(kernel))
+        continue;
+
+      start = bench_seconds();
+      smstruct = sary_match_mlr_prep(T, length, 0);
+      build_secs = bench_seconds() - start;
+      if (smstruct == NULL) {
+        mprintf("Memory Error:  Ran out of memory.\n");
+        break;
+      }
+
+      start = bench_seconds();
+      sary_compute_lcp(smstruct->sary);
+      lcp_secs = bench_seconds() - start;
+
+      seed = 54321;
+      start = bench_seconds();
+      for (i=0; i < CMP_BENCH_QUERIES; i++) {
+        seed = seed * 1103515245 + 12345;
+        for (s=sary_match_mlr_first(smstruct,
+                                    T + (seed >> 4) % (length - patlen + 1),
+                                    patlen);
+             s != NULL; s=sary_match_mlr_next(smstruct))
+          ;
+      }
+      search_secs = bench_seconds() - start;
+
+      same = 1;
+      if (first == NULL) {
+        if ((first = malloc(length * sizeof(int))) != NULL)
+          memcpy(first, smstruct->sary->Pos + 1, length * sizeof(int));
+      }
+      else
+        same = (memcmp(first, smstruct->sary->Pos + 1,
+                       length * sizeof(int)) == 0);
+
+      if (mprintf("   %-10s  %-12s  %9.3f  %8.3f  %10.3f%s\n",
+                  bench_names[types[type]], sary_cmp_name(), build_secs,
+                  lcp_secs, search_secs,
+                  (same ? "" : "   (suffix array differs!)")) == 0)
+        quit = 1;
+
+      sary_match_free(smstruct);
+    }
+
+    if (first != NULL)
+      free(first);
+    free(T);
+  }
+  mputc('\n');
+
+  sary_cmp_select(SARY_CMP_AUTO);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_packed
+ *
+ * Builds the suffix array of a sequence with its entries packed to
+ * 32, 40 or 64 bits.
+ *
+ * Parameters:   string       -  the sequence
+ *               width        -  the entry width, or SARY_WIDTH_AUTO
+ *               print_stats  -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_packed(STRING *string, int width, int print_stats)
+{
+  int len;
+  long i, pos;
+  char format[32], buf[36];
+  double start, secs;
+  SARY_PACKED *sa;
+
+  if (string == NULL || string->sequence == NULL || string->length == 0)
+    return 0;
+
+  start = bench_seconds();
+  sa = sary_packed_build(string->sequence, string->length, width, 0);
+  secs = bench_seconds() - start;
+  if (sa == NULL) {
+    mprintf("Error:  Unable to build a suffix array with %d bit entries.\n",
+            width);
+    return 0;
+  }
+
+  /*
+   * Print the statistics.
+   */
+  if (print_stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Entry Width:         %d bits\n", sa->width);
+#ifdef STATS
+    mprintf("   Number of Compares:  %ld\n", sa->num_compares);
+#endif
+    mprintf("   Memory Used:         %ld bytes (%.2f bytes/char)\n",
+            sa->mem_bytes, (double) sa->mem_bytes / sa->M);
+    mprintf("   Build Time:          %.3f seconds\n", secs);
+    mprintf("\n");
+  }
+
+  /*
+   * Print the suffix array values.
+   */
+  mprintf("The Suffix Array:\n");
+
+  len = my_itoalen(string->length);
+  sprintf(format, "  %%%dld:  %%s\n", len);
+
+  buf[30] = buf[31] = buf[32] = '.';
+  buf[33] = '\0';
+
+  for (i=1; i <= sa->M; i++) {
+    pos = sary_packed_get(sa, i);
+    strncpy(buf, &string->raw_seq[pos - 1], 30);
+    if (mprintf(format, pos, buf) == 0)
+      break;
+  }
+
+  sary_packed_free(sa);
+
+  return 1;
+}
+
+
+static int cmp_positions(const void *a, const void *b)
+{
+  return *(const int *) a - *(const int *) b;
+}
+
+static int cmp_long_positions(const void *a, const void *b)
+{
+  long x = *(const long *) a, y = *(const long *) b;
+
+  return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+
+/*
+ * strmat_sary_packed_match
+ *
+ * Performs exact matching of a pattern and text using a packed
+ * suffix array.
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               width      -  the entry width, or SARY_WIDTH_AUTO
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_packed_match(STRING *pattern, STRING *text, int width,
+                             MATCH_MODE *matchmode, int stats)
+{
+  int i, M, N, *positions, matchcount, status;
+  long j, lo, hi, first;
+  char *s, *T;
+  MATCH_RESULTS results;
+  SARY_PACKED *sa;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  M = pattern->length;
+  T = text->sequence;
+  N = text->length;
+
+  if ((sa = sary_packed_build(T, N, width, 0)) == NULL) {
+    mprintf("Error:  Unable to build a suffix array with %d bit entries.\n",
+            width);
+    return 0;
+  }
+
+  /*
+   * Collect the matches, which come out in suffix array order, and put
+   * them into text order.  The count mode only needs the width of the
+   * suffix array interval, and the first-match mode only the leftmost
+   * position in it, so neither keeps the positions.
+   */
+  init_results(&results, matchmode);
+
+  status = 1;
+  if (results.mode == MATCH_COUNT || results.mode == MATCH_FIRST) {
+    matchcount = sary_packed_interval(sa, pattern->sequence, M, &lo, &hi);
+    if (results.mode == MATCH_COUNT)
+      add_count(&results, matchcount);
+    else if (matchcount > 0) {
+      first = sary_packed_get(sa, lo);
+      for (j=lo+1; j <= hi; j++)
+        if (sary_packed_get(sa, j) < first)
+          first = sary_packed_get(sa, j);
+
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          (int) first, (int) first + M - 1, 0);
+    }
+  }
+  else {
+    if ((positions = malloc((N + 1) * sizeof(int))) == NULL) {
+      sary_packed_free(sa);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+
+    matchcount = 0;
+    for (s=sary_packed_match_first(sa, pattern->sequence, M); s != NULL;
+         s=sary_packed_match_next(sa))
+      positions[matchcount++] = s - T + 1;
+
+    qsort(positions, matchcount, sizeof(int), cmp_positions);
+
+    for (i=0; i < matchcount; i++) {
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          positions[i], positions[i] + M - 1, 0);
+      if (status != 1)
+        break;
+    }
+    free(positions);
+  }
+
+  if (status == -1) {
+    free_results(&results);
+    sary_packed_free(sa);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Print the statistics and the matches.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+#ifdef STATS
+    mprintf("  Preprocessing:\n");
+    mprintf("     Text Length:         %d\n", N);
+    mprintf("     Entry Width:         %d bits\n", sa->width);
+    mprintf("     Number of Compares:  %ld\n", sa->num_compares);
+    mprintf("     Memory Used:         %ld bytes\n", sa->mem_bytes);
+    mprintf("\n");
+    mprintf("  Searching:\n");
+    mprintf("     Pattern Length:          %d\n", M);
+    mprintf("     Number of Compares:      %ld\n", sa->search_compares);
+    mprintf("     Number of Output Ops:    %d\n", matchcount);
+#else
+    mputs("   No statistics available.\n");
+#endif
+    mputc('\n');
+  }
+
+  free_results(&results);
+  sary_packed_free(sa);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_fm
+ *
+ * Performs exact matching of a pattern and text using the FM-index
+ * (backward search over the Burrows-Wheeler transform).
+ *
+ * Parameters:   pattern      -  the pattern sequence
+ *               text         -  the text sequence
+ *               sample_rate  -  the suffix array sampling rate
+ *               matchmode    -  the result mode (NULL for all matches)
+ *               stats        -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_fm(STRING *pattern, STRING *text, int sample_rate,
+                   MATCH_MODE *matchmode, int stats)
+{
+  int i, M, N, *positions, matchcount, status, count, count_ops;
+  char *s, *T;
+  MATCH_RESULTS results;
+  SARY_FM *fm;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  M = pattern->length;
+  T = text->sequence;
+  N = text->length;
+
+  if ((fm = sary_fm_prep(T, N, sample_rate)) == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Count the matches, then locate them and put them into text order.
+   * Locating is the expensive part, so the count mode locates nothing
+   * and the first-match mode locates only the match in the first row
+   * of the suffix array interval, which need not be the leftmost one.
+   */
+  count = sary_fm_count(fm, pattern->sequence, M);
+  count_ops = fm->num_rank_ops;
+
+  init_results(&results, matchmode);
+
+  status = 1;
+  matchcount = 0;
+  if (results.mode == MATCH_COUNT)
+    add_count(&results, count);
+  else if (results.mode == MATCH_FIRST) {
+    if ((s = sary_fm_next(fm)) != NULL) {
+      matchcount = 1;
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          s - T + 1, s - T + M, 0);
+    }
+  }
+  else {
+    if ((positions = malloc((count + 1) * sizeof(int))) == NULL) {
+      sary_fm_free(fm);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+
+    for (s=sary_fm_next(fm); s != NULL; s=sary_fm_next(fm))
+      positions[matchcount++] = s - T + 1;
+
+    qsort(positions, matchcount, sizeof(int), cmp_positions);
+
+    for (i=0; i < matchcount; i++) {
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          positions[i], positions[i] + M - 1, 0);
+      if (status != 1)
+        break;
+    }
+    free(positions);
+  }
+
+  if (status == -1) {
+    free_results(&results);
+    sary_fm_free(fm);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Print the statistics and the matches.
+   */
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+#ifdef STATS
+    mprintf("  Preprocessing:\n");
+    mprintf("     Text Length:         %d\n", N);
+    mprintf("     Alphabet Size:       %d\n", fm->sigma - 1);
+    mprintf("     SA Sample Rate:      %d\n", fm->sample_rate);
+    mprintf("     Index Size:          %ld bytes (%.2f bytes/char)\n",
+            fm->mem_bytes, (double) fm->mem_bytes / N);
+    mprintf("\n");
+    mprintf("  Counting:\n");
+    mprintf("     Pattern Length:          %d\n", M);
+    mprintf("     Number of Occurrences:   %d\n", count);
+    mprintf("     Number of Rank Ops:      %d\n", count_ops);
+    mprintf("\n");
+    mprintf("  Locating:\n");
+    mprintf("     Number of Rank Ops:      %d\n",
+            fm->num_rank_ops - count_ops);
+    mprintf("     Number of LF Steps:      %d\n", fm->num_lf_steps);
+    mprintf("     Number of Output Ops:    %d\n", matchcount);
+#else
+    mputs("   No statistics available.\n");
+#endif
+    mputc('\n');
+  }
+
+  free_results(&results);
+  sary_fm_free(fm);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_save
+ *
+ * Builds the suffix array and (optionally) an FM-index of a text and
+ * writes them to an index file.  Either the suffix array has int
+ * entries and is saved with its lcp values, or it is a packed suffix
+ * array of the given width, saved without them.
+ *
+ * Parameters:   text         -  the text sequence
+ *               path         -  the name of the index file
+ *               sample_rate  -  the FM-index sampling rate (0 for none)
+ *               width        -  the packed entry width, or 0 for an
+ *                               int suffix array with lcp values
+ *               stats        -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_save(STRING *text, char *path, int sample_rate, int width,
+                     int stats)
+{
+  int status;
+  long size;
+  double start, build_secs, save_secs;
+  SARYMAT_STRUCT *smstruct;
+  SARY_PACKED *sa;
+  SARY_FM *fm;
+
+  if (text == NULL || text->sequence == NULL || text->length == 0 ||
+      path == NULL)
+    return 0;
+
+  if (width != 0 && width != 32 && width != 40 && width != 64) {
+    mprintf("Error:  The entry width must be 32, 40 or 64 bits.\n");
+    return 0;
+  }
+  if (width > 32 && sample_rate > 0) {
+    mprintf("Error:  An FM-index can only be saved with 32 bit entries.\n");
+    return 0;
+  }
+
+  /*
+   * The FM-index of a packed suffix array is built from the array,
+   * while sary_fm_prep sorts the suffixes itself.
+   */
+  start = bench_seconds();
+  smstruct = NULL;
+  sa = NULL;
+  fm = NULL;
+  if (width == 0) {
+    smstruct = sary_match_lcp_prep(text->sequence, text->length, 0);
+    if (smstruct != NULL && sample_rate > 0)
+      fm = sary_fm_prep(text->sequence, text->length, sample_rate);
+  }
+  else {
+    sa = sary_packed_build(text->sequence, text->length, width, 0);
+    if (sa != NULL && sample_rate > 0)
+      fm = sary_fm_prep_packed(sa, sample_rate);
+  }
+  build_secs = bench_seconds() - start;
+
+  if ((smstruct == NULL && sa == NULL) || (sample_rate > 0 && fm == NULL)) {
+    sary_match_free(smstruct);
+    sary_packed_free(sa);
+    sary_fm_free(fm);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  start = bench_seconds();
+  if (width == 0)
+    status = sary_match_save(smstruct, fm, path);
+  else
+    status = sary_packed_save(sa, fm, path);
+  save_secs = bench_seconds() - start;
+
+  sary_match_free(smstruct);
+  sary_packed_free(sa);
+  sary_fm_free(fm);
+
+  if (!status) {
+    mprintf("Error:  Unable to write the index file %s.\n", path);
+    return 0;
+  }
+
+  /*
+   * Check the file by mapping it back in.
+   */
+  if ((sa = sary_packed_open(path)) == NULL) {
+    mprintf("Error:  Unable to open the index file %s.\n", path);
+    return 0;
+  }
+  size = sa->map_size;
+  width = sa->width;
+  sary_packed_free(sa);
+
+  mprintf("Wrote the index file %s.\n\n", path);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:         %d\n", text->length);
+    mprintf("   Entry Width:         %d bits\n", width);
+    mprintf("   FM-index:            %s\n", (sample_rate > 0 ? "yes" : "no"));
+    mprintf("   File Size:           %ld bytes (%.2f bytes/char)\n",
+            size, (double) size / text->length);
+    mprintf("   Build Time:          %.3f seconds\n", build_secs);
+    mprintf("   Write Time:          %.3f seconds\n", save_secs);
+    mputc('\n');
+  }
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_ext_save
+ *
+ * Builds a suffix array index file in external memory, using at most
+ * budget kilobytes of working memory and temporary files in tmp_dir,
+ * and reports the I/O volume of the build.  sary_ext_build reads its
+ * text from a file, so the text is first written to a temporary file.
+ *
+ * Parameters:   text     -  the text sequence
+ *               path     -  the name of the index file
+ *               tmp_dir  -  the directory for the temporary files
+ *               budget   -  the memory budget, in kilobytes
+ *               stats    -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_ext_save(STRING *text, char *path, char *tmp_dir, int budget,
+                         int stats)
+{
+  int fd, status, width;
+  long size;
+  char *text_path;
+  double start, build_secs;
+  FILE *fp;
+  SARY_PACKED *sa;
+  SARY_EXT_STATS ext;
+
+  if (text == NULL || text->sequence == NULL || text->length == 0 ||
+      path == NULL || tmp_dir == NULL)
+    return 0;
+
+  if ((text_path = malloc(strlen(tmp_dir) + 32)) == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+  sprintf(text_path, "%s/strmat_text_XXXXXX", tmp_dir);
+
+  fp = NULL;
+  if ((fd = mkstemp(text_path)) == -1 || (fp = fdopen(fd, "wb")) == NULL ||
+      fwrite(text->sequence, 1, text->length, fp) != (size_t) text->length ||
+      fclose(fp) != 0) {
+    if (fd != -1) {
+      if (fp == NULL)
+        close(fd);
+      unlink(text_path);
+    }
+    mprintf("Error:  Unable to write the text to the directory %s.\n",
+            tmp_dir);
+    free(text_path);
+    return 0;
+  }
+
+  start = bench_seconds();
+  status = sary_ext_build(text_path, path, tmp_dir, budget * 1024L, &ext);
+  build_secs = bench_seconds() - start;
+
+  unlink(text_path);
+  free(text_path);
+
+  if (!status) {
+    mprintf("Error:  Unable to build the index file %s.\n", path);
+    return 0;
+  }
+
+  /*
+   * Check the file by mapping it back in.  Its entries may be too wide
+   * for sary_match_open.
+   */
+  if ((sa = sary_packed_open(path)) == NULL) {
+    mprintf("Error:  Unable to open the index file %s.\n", path);
+    return 0;
+  }
+  size = sa->map_size;
+  width = sa->width;
+  sary_packed_free(sa);
+
+  mprintf("Wrote the index file %s.\n\n", path);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:         %d\n", text->length);
+    mprintf("   Entry Width:         %d bits\n", width);
+    mprintf("   Memory Budget:       %ld bytes\n", ext.mem_budget);
+    mprintf("   Peak Memory:         %ld bytes\n", ext.mem_peak);
+    mprintf("   Doubling Rounds:     %d\n", ext.num_rounds);
+    mprintf("   Sorted Runs:         %d\n", ext.num_runs);
+    mprintf("   Run Merges:          %d\n", ext.num_merges);
+    mprintf("   Bytes Read:          %ld (%.1f bytes/char)\n",
+            ext.bytes_read, (double) ext.bytes_read / text->length);
+    mprintf("   Bytes Written:       %ld (%.1f bytes/char)\n",
+            ext.bytes_written, (double) ext.bytes_written / text->length);
+    mprintf("   File Size:           %ld bytes (%.2f bytes/char)\n",
+            size, (double) size / text->length);
+    mprintf("   Build Time:          %.3f seconds\n", build_secs);
+    mputc('\n');
+  }
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_file_match
+ *
+ * Performs exact matching of a pattern against a text whose index was
+ * saved by strmat_sary_save, using the memory-mapped suffix array to
+ * find the interval of matching suffixes and then the sorted positions
+ * of the matches (and counting with the FM-index as well, when the file
+ * has one).  The text itself is not available in its original form, so
+ * only the positions of the matches are printed.
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               path       -  the name of the index file
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_file_match(STRING *pattern, char *path, MATCH_MODE *matchmode,
+                           int stats)
+{
+  int i, M, N, lo, hi, first, width, mode, *positions, matchcount, fmcount;
+  char format[32];
+  double start, open_secs, count_secs, locate_secs;
+  SARYMAT_STRUCT *smstruct;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      path == NULL)
+    return 0;
+
+  M = pattern->length;
+
+  mode = (matchmode != NULL ? matchmode->mode : MATCH_ALL);
+
+  start = bench_seconds();
+  smstruct = sary_match_open(path);
+  open_secs = bench_seconds() - start;
+  if (smstruct == NULL)
+    return packed_file_match(pattern, path, mode, stats);
+  N = smstruct->M;
+
+  /*
+   * Find the interval of the suffix array holding the matches, then
+   * copy out their positions sorted by text position.  Only the count
+   * was asked for in count mode, which is just the width of the
+   * interval, and only the leftmost position in first-match mode.
+   */
+  start = bench_seconds();
+  matchcount = sary_match_interval(smstruct, pattern->sequence, M, &lo, &hi);
+  count_secs = bench_seconds() - start;
+
+  positions = NULL;
+  first = 0;
+  start = bench_seconds();
+  if (mode == MATCH_FIRST)
+    first = sary_match_leftmost(smstruct, lo, hi);
+  else if (mode != MATCH_COUNT) {
+    if ((positions = malloc((matchcount + 1) * sizeof(int))) == NULL ||
+        !sary_match_locate(smstruct, lo, hi, positions, 1)) {
+      if (positions != NULL)
+        free(positions);
+      sary_match_free(smstruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+  }
+  locate_secs = bench_seconds() - start;
+
+  fmcount = -1;
+  if (smstruct->fm != NULL)
+    fmcount = sary_fm_count(smstruct->fm, pattern->sequence, M);
+
+  /*
+   * Print the matches and the statistics.
+   */
+  width = my_itoalen(N);
+  sprintf(format, "    %%%dd-%%%dd\n", width, width);
+  if (mode == MATCH_COUNT)
+    mprintf("Found %d matches (count only).\n", matchcount);
+  else if (mode == MATCH_FIRST) {
+    mprintf("Found %d matches, the leftmost at:\n", matchcount);
+    if (matchcount > 0)
+      mprintf(format, first, first + M - 1);
+  }
+  else {
+    mprintf("Found %d matches:\n", matchcount);
+    for (i=0; i < matchcount; i++)
+      if (mprintf(format, positions[i], positions[i] + M - 1) == 0)
+        break;
+  }
+  mputc('\n');
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:         %d\n", N);
+    mprintf("   Pattern Length:      %d\n", M);
+    mprintf("   File Size:           %ld bytes\n", smstruct->map_size);
+    mprintf("   Open Time:           %.6f seconds\n", open_secs);
+    mprintf("   Count Time:          %.6f seconds\n", count_secs);
+    mprintf("   Locate Time:         %.6f seconds\n", locate_secs);
+#ifdef STATS
+    mprintf("   Number of Compares:  %d\n", smstruct->num_compares);
+#endif
+    if (fmcount != -1)
+      mprintf("   FM-index Count:      %d\n", fmcount);
+    mputc('\n');
+  }
+
+  if (positions != NULL)
+    free(positions);
+  sary_match_free(smstruct);
+
+  return 1;
+}
+
+
+/*
+ * packed_file_match
+ *
+ * The part of strmat_sary_file_match for the index files that
+ * sary_match_open does not take (those with 40 or 64 bit entries),
+ * which are searched as packed suffix arrays.
+ *
+ * Parameters:   pattern  -  the pattern sequence
+ *               path     -  the name of the index file
+ *               mode     -  the result mode
+ *               stats    -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+static int packed_file_match(STRING *pattern, char *path, int mode,
+                             int stats)
+{
+  int M, width;
+  long j, N, lo, hi, first, *positions, matchcount;
+  char format[32];
+  double start, open_secs, count_secs, locate_secs;
+  SARY_PACKED *sa;
+
+  M = pattern->length;
+
+  start = bench_seconds();
+  sa = sary_packed_open(path);
+  open_secs = bench_seconds() - start;
+  if (sa == NULL) {
+    mprintf("Error:  %s is not a readable index file.\n", path);
+    return 0;
+  }
+  N = sa->M;
+
+  start = bench_seconds();
+  matchcount = sary_packed_interval(sa, pattern->sequence, M, &lo, &hi);
+  count_secs = bench_seconds() - start;
+
+  positions = NULL;
+  first = 0;
+  start = bench_seconds();
+  if (mode == MATCH_FIRST) {
+    for (j=lo; j <= hi; j++)
+      if (first == 0 || sary_packed_get(sa, j) < first)
+        first = sary_packed_get(sa, j);
+  }
+  else if (mode != MATCH_COUNT) {
+    if ((positions = malloc((matchcount + 1) * sizeof(long))) == NULL) {
+      sary_packed_free(sa);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    for (j=lo; j <= hi; j++)
+      positions[j-lo] = sary_packed_get(sa, j);
+    qsort(positions, matchcount, sizeof(long), cmp_long_positions);
+  }
+  locate_secs = bench_seconds() - start;
+
+  /*
+   * Print the matches and the statistics.
+   */
+  width = sprintf(format, "%ld", N);
+  sprintf(format, "    %%%dld-%%%dld\n", width, width);
+  if (mode == MATCH_COUNT)
+    mprintf("Found %ld matches (count only).\n", matchcount);
+  else if (mode == MATCH_FIRST) {
+    mprintf("Found %ld matches, the leftmost at:\n", matchcount);
+    if (matchcount > 0)
+      mprintf(format, first, first + M - 1);
+  }
+  else {
+    mprintf("Found %ld matches:\n", matchcount);
+    for (j=0; j < matchcount; j++)
+      if (mprintf(format, positions[j], positions[j] + M - 1) == 0)
+        break;
+  }
+  mputc('\n');
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:         %ld\n", N);
+    mprintf("   Pattern Length:      %d\n", M);
+    mprintf("   Entry Width:         %d bits\n", sa->width);
+    mprintf("   File Size:           %ld bytes\n", sa->map_size);
+    mprintf("   Open Time:           %.6f seconds\n", open_secs);
+    mprintf("   Count Time:          %.6f seconds\n", count_secs);
+    mprintf("   Locate Time:         %.6f seconds\n", locate_secs);
+#ifdef STATS
+    mprintf("   Number of Compares:  %ld\n", sa->search_compares);
+#endif
+    mputc('\n');
+  }
+
+  if (positions != NULL)
+    free(positions);
+  sary_packed_free(sa);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_gen_match
+ *
+ * Performs exact matching of a pattern against a set of texts, using
+ * a generalized suffix array over the texts.  The matches are reported
+ * as (text, position) pairs, in the same form as strmat_stree_match.
+ *
+ * Parameters:   pattern      -  the pattern sequence
+ *               strings      -  the texts
+ *               num_strings  -  the number of texts
+ *               matchmode    -  the result mode (NULL for all matches)
+ *               stats        -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_gen_match(STRING *pattern, STRING **strings, int num_strings,
+                          MATCH_MODE *matchmode, int stats)
+{
+  int i, id, M, lo, hi, pos, first, *positions, matchcount, status;
+  long index_size;
+  double start, build_secs, search_secs;
+  MATCH_RESULTS results;
+  SARY_GEN *gen;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      strings == NULL || num_strings == 0)
+    return 0;
+
+  M = pattern->length;
+
+  for (i=0; i < num_strings; i++) {
+    if (sary_gen_has_separator(strings[i])) {
+      mprintf("Error:  Text %d contains the separator character of "
+              "generalized suffix\n        arrays (%d).\n", i + 1,
+              (unsigned char) SARY_GEN_SEPARATOR);
+      return 0;
+    }
+  }
+
+  start = bench_seconds();
+  gen = sary_gen_build(strings, num_strings);
+  build_secs = bench_seconds() - start;
+  if (gen == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Find the matches.  Sorting the positions in the concatenated text
+   * sorts the matches by text and then by position in the text, so
+   * the first match is the one at the smallest position.  The count
+   * mode needs only the width of the suffix array interval.
+   */
+  init_results(&results, matchmode);
+
+  start = bench_seconds();
+  matchcount = sary_gen_interval(gen, pattern->sequence, M, &lo, &hi);
+
+  positions = NULL;
+  if (results.mode == MATCH_FIRST) {
+    if ((first = sary_match_leftmost(gen->smstruct, lo, hi)) > 0) {
+      positions = &first;
+      matchcount = 1;
+    }
+  }
+  else if (results.mode != MATCH_COUNT) {
+    if ((positions = malloc((matchcount + 1) * sizeof(int))) == NULL ||
+        !sary_match_locate(gen->smstruct, lo, hi, positions, 1)) {
+      if (positions != NULL)
+        free(positions);
+      sary_gen_free(gen);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+  }
+  search_secs = bench_seconds() - start;
+
+  status = 1;
+  if (results.mode == MATCH_COUNT)
+    add_count(&results, matchcount);
+  else if (positions != NULL) {
+    for (i=0,id=1; i < matchcount; i++) {
+      while (positions[i] >= gen->starts[id+1])
+        id++;
+
+      pos = positions[i] - gen->starts[id] + 1;
+      status = add_result(&results, TEXT_SET_EXACT, 0, id, pos, pos + M - 1,
+                          0);
+      if (status != 1)
+        break;
+    }
+    if (positions != &first)
+      free(positions);
+  }
+
+  if (status == -1) {
+    free_results(&results);
+    sary_gen_free(gen);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Print the matches and the statistics.
+   */
+  print_results(NULL, strings, num_strings, &results);
+
+  if (stats) {
+    index_size = (long) (gen->M + 2) +
+                 (long) (2 * gen->M + num_strings + 2) * sizeof(int);
+
+    mprintf("Statistics:\n");
+    mprintf("   Number of Texts:         %d\n", num_strings);
+    mprintf("   Sum of Text Lengths:     %d\n", gen->M - num_strings + 1);
+    mprintf("   Index Size:              %ld bytes (%.2f bytes/char)\n",
+            index_size, (double) index_size / gen->M);
+    mprintf("   Build Time:              %.6f seconds\n", build_secs);
+    mprintf("   Search Time:             %.6f seconds\n", search_secs);
+#ifdef STATS
+    mprintf("   Number of Compares:      %d\n", gen->smstruct->num_compares);
+    mprintf("   Depth of Binary Search:  %d\n",
+            gen->smstruct->search_depth);
+#endif
+    mputc('\n');
+  }
+
+  free_results(&results);
+  sary_gen_free(gen);
+
+  return 1;
+}
+
+
 static int print_lcp_values(int *lcp, int min, int max, int index, int depth)
 {
   int i, midpoint;
@@ -193,35 +1412,308 @@ static int print_lcp_values(int *lcp, int min, int max, int index, int depth)
 
 
 
+/*
+ * strmat_sary_wt_match
+ *
+ * Performs exact matching of a pattern against a window of the text,
+ * reporting only the matches lying entirely inside text positions
+ * l..r.  The suffix array search finds the interval of all matches,
+ * and a wavelet matrix over the suffix array counts and lists the ones
+ * inside the window without looking at the others.  For comparison,
+ * the statistics include the time to locate every match and filter
+ * them.
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               l, r     -  the window of the text
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_wt_match(STRING *pattern, STRING *text, int l, int r,
+                         MATCH_MODE *matchmode, int stats)
+{
+  int i, M, N, lo, hi, last, total, matchcount, status, filtercount, rank_ops;
+  int *positions;
+  double start, build_secs, count_secs, list_secs, filter_secs;
+  MATCH_RESULTS results;
+  SARYMAT_STRUCT *smstruct;
+  SARY_WT *wt;
+
+  if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
+      text == NULL || text->sequence == NULL || text->length == 0)
+    return 0;
+
+  M = pattern->length;
+  N = text->length;
+
+  start = bench_seconds();
+  smstruct = sary_match_mlr_prep(text->sequence, N, 0);
+  wt = NULL;
+  if (smstruct != NULL)
+    wt = sary_wt_build(smstruct->sary->Pos, N);
+  build_secs = bench_seconds() - start;
+
+  if (wt == NULL || (positions = malloc((N + 1) * sizeof(int))) == NULL) {
+    if (wt != NULL)
+      sary_wt_free(wt);
+    if (smstruct != NULL)
+      sary_match_free(smstruct);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * A match lies inside the window if it starts between l and r-M+1.
+   */
+  last = r - M + 1;
+  total = sary_match_interval(smstruct, pattern->sequence, M, &lo, &hi);
+
+  start = bench_seconds();
+  matchcount = sary_wt_count(wt, lo, hi, l, last);
+  count_secs = bench_seconds() - start;
+  rank_ops = wt->num_rank_ops;
+
+  start = bench_seconds();
+  sary_wt_list(wt, lo, hi, l, last, positions);
+  list_secs = bench_seconds() - start;
+
+  /*
+   * Build the match list.
+   */
+  init_results(&results, matchmode);
+  for (i=0; i < matchcount; i++) {
+    status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                        positions[i], positions[i] + M - 1, 0);
+    if (status == -1) {
+      free_results(&results);
+      free(positions);
+      sary_wt_free(wt);
+      sary_match_free(smstruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
+    }
+    else if (status == 0)
+      break;
+  }
+
+  /*
+   * Time the alternative, locating every match and filtering.
+   */
+  start = bench_seconds();
+  sary_match_locate(smstruct, lo, hi, positions, 0);
+  for (i=0,filtercount=0; i < total; i++)
+    if (positions[i] >= l && positions[i] <= last)
+      positions[filtercount++] = positions[i];
+  filter_secs = bench_seconds() - start;
+
+  print_results(text, NULL, 0, &results);
+
+  if (stats) {
+    mprintf("Statistics:\n");
+    mprintf("   Text Length:         %d\n", N);
+    mprintf("   Pattern Length:      %d\n", M);
+    mprintf("   Window:              %d-%d\n", l, r);
+    mprintf("   Matches in Text:     %d\n", total);
+    mprintf("   Matches in Window:   %d%s\n", matchcount,
+            (filtercount == matchcount ? "" : "  (filter disagrees)"));
+    mprintf("   Wavelet Matrix Size: %ld bytes (%d levels)\n", wt->mem_bytes,
+            wt->levels);
+    mprintf("   Build Time:          %.3f seconds\n", build_secs);
+    mprintf("   Count Time:          %.6f seconds\n", count_secs);
+    mprintf("   List Time:           %.6f seconds\n", list_secs);
+    mprintf("   Locate+Filter Time:  %.6f seconds\n", filter_secs);
+#ifdef STATS
+    mprintf("   Count Rank Ops:      %d\n", rank_ops);
+    mprintf("   List Rank Ops:       %d\n", wt->num_rank_ops - rank_ops);
+#endif
+    mputc('\n');
+  }
+
+  free_results(&results);
+  free(positions);
+  sary_wt_free(wt);
+  sary_match_free(smstruct);
+
+  return 1;
+}
+
+
+/*
+ * strmat_sary_lce
+ *
+ * Preprocesses a sequence for longest common extension queries using
+ * its suffix array, then reads pairs of positions from the user and
+ * prints the length of their common extension.  When the user quits,
+ * the statistics include the time of a batch of random queries.
+ *
+ * Parameters:   string       -  the sequence
+ *               small        -  use the small footprint mode?
+ *               print_stats  -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+#define LCE_BENCH_QUERIES 1000000
+
+int strmat_sary_lce(STRING *string, int small, int print_stats)
+{
+  int i, j, k, len, M, num_lces;
+  char *s, *line, buffer[64];
+  double start, prep_secs, query_secs;
+  SARY_LCE *lce;
+
+  if (string == NULL || string->sequence == NULL || string->length == 0)
+    return 0;
+
+  M = string->length;
+
+  printf("Preprocessing...\n");
+  start = bench_seconds();
+  lce = sary_lce_prep(string->sequence, M, 0,
+                      (small ? SARY_LCE_SMALL : SARY_LCE_FULL));
+  prep_secs = bench_seconds() - start;
+  if (lce == NULL) {
+    printf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  /*
+   * Query the user for pairs of positions.
+   */
+  printf("\n");
+  printf("Commands (1-%d 1-%d - Find the LCE of two positions, "
+         "Ctl-D - quit)\n", M, M);
+
+  num_lces = 0;
+  while (1) {
+    printf("Enter positions: ");
+
+    if ((line = my_getline(stdin, NULL)) == NULL) {
+      printf("\n\n");
+      break;
+    }
+
+    if (line[0] == '\0')
+      continue;
+
+    if (sscanf(line, "%d %d", &i, &j) == 2 && i >= 1 && i <= M &&
+        j >= 1 && j <= M) {
+      len = sary_lce(lce, i, j);
+      num_lces++;
+
+      s = (string->raw_seq != NULL ? string->raw_seq : string->sequence);
+      for (k=0; k < len && k < 50; k++)
+        buffer[k] = (isprint((int) s[i-1+k]) ? s[i-1+k] : '#');
+      if (len > 50) {
+        buffer[50] = buffer[51] = buffer[52] = '.';
+        k = 53;
+      }
+      buffer[k] = '\0';
+
+      printf("   LCE(%d, %d):  %d  %s\n\n", i, j, len, buffer);
+    }
+    else
+      printf("  Invalid input line.  Please reenter.\n\n");
+  }
+
+  if (print_stats) {
+    /*
+     * Time a batch of random queries.
+     */
+    srand(1);
+    start = bench_seconds();
+    for (k=0; k < LCE_BENCH_QUERIES; k++)
+      sary_lce(lce, 1 + rand() % M, 1 + rand() % M);
+    query_secs = bench_seconds() - start;
+
+    printf("\nStatistics:\n");
+    printf("   Sequence Length:        %d\n", M);
+    printf("   Mode:                   %s\n",
+           (small ? "small footprint" : "sparse table"));
+    printf("   Memory:                 %ld bytes (%.2f bytes/char)\n",
+           lce->mem_bytes, (double) lce->mem_bytes / M);
+    printf("   Preprocessing Time:     %.3f seconds\n", prep_secs);
+    printf("\n");
+    printf("   Number LCE's Computed:  %d\n", num_lces);
+    printf("   Random Query Time:      %.1f ns/query (%d queries)\n",
+           query_secs * 1e9 / LCE_BENCH_QUERIES, LCE_BENCH_QUERIES);
+#ifdef STATS
+    printf("   Answered Directly:      %d of %d\n", lce->num_direct,
+           lce->num_queries);
+    printf("   Character/LCP Compares: %d\n", lce->num_compares);
+#endif
+
+    putchar('\n');
+  }
+
+  sary_lce_free(lce);
+
+  return 1;
+}
+
+
 /*
  * strmat_sary_match_naive
  *
  * Performs the exact matching algorithm for a pattern and text using
  * a suffix array and the naive binary search algorithm.
  *
- * Parameters:   pattern  -  the pattern sequence
- *               text     -  the text sequence
- *               stats    -  should stats be printed
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
  *
  * Returns:  non-zero on success, zero on an error.
  */
 
-static int int_strmat_sary_match(STRING *pattern, STRING *text, int stats,
-                                 SARY_MATCH_TYPE type);
+static int int_strmat_sary_match(STRING *pattern, STRING *text,
+                                 MATCH_MODE *matchmode, int stats,
+                                 SARY_MATCH_TYPE type, int kmer_k);
+
+int strmat_sary_match_naive(STRING *pattern, STRING *text,
+                            MATCH_MODE *matchmode, int stats)
+{  return int_strmat_sary_match(pattern, text, matchmode, stats, NAIVE_MATCH,
+                                -1);  }
+int strmat_sary_match_mlr(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats)
+{  return int_strmat_sary_match(pattern, text, matchmode, stats, MLR_MATCH,
+                                -1);  }
+int strmat_sary_match_lcp(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats)
+{  return int_strmat_sary_match(pattern, text, matchmode, stats, LCP_MATCH,
+                                -1);  }
 
-int strmat_sary_match_naive(STRING *pattern, STRING *text, int stats)
-{  return int_strmat_sary_match(pattern, text, stats, NAIVE_MATCH);  }
-int strmat_sary_match_mlr(STRING *pattern, STRING *text, int stats)
-{  return int_strmat_sary_match(pattern, text, stats, MLR_MATCH);  }
-int strmat_sary_match_lcp(STRING *pattern, STRING *text, int stats)
-{  return int_strmat_sary_match(pattern, text, stats, LCP_MATCH);  }
 
-static int int_strmat_sary_match(STRING *pattern, STRING *text, int stats,
-                                 SARY_MATCH_TYPE type)
+/*
+ * strmat_sary_match_kmer
+ *
+ * Performs the exact matching algorithm for a pattern and text using
+ * a suffix array with a k-mer lookup table (the binary search, using
+ * the mlr accelerant, only looks at the suffixes starting with the
+ * pattern's first k characters).
+ *
+ * Parameters:   pattern    -  the pattern sequence
+ *               text       -  the text sequence
+ *               k          -  the k-mer length (0 to pick one from the
+ *                             text length and alphabet size)
+ *               matchmode  -  the result mode (NULL for all matches)
+ *               stats      -  should stats be printed
+ *
+ * Returns:  non-zero on success, zero on an error.
+ */
+int strmat_sary_match_kmer(STRING *pattern, STRING *text, int k,
+                           MATCH_MODE *matchmode, int stats)
+{  return int_strmat_sary_match(pattern, text, matchmode, stats, MLR_MATCH,
+                                k);  }
+
+static int int_strmat_sary_match(STRING *pattern, STRING *text,
+                                 MATCH_MODE *matchmode, int stats,
+                                 SARY_MATCH_TYPE type, int kmer_k)
 {
-  int M, N, pos, flag, matchcount, num_compares;
+  int i, M, N, lo, hi, first, matchcount, status, num_compares, *positions;
   char *s, *P, *T;
-  MATCHES matchlist, matchtail, newmatch, back, current, next;
+  MATCH_RESULTS results;
   SARYMAT_STRUCT *smstruct;
 
   if (pattern == NULL || pattern->sequence == NULL || pattern->length == 0 ||
@@ -234,8 +1726,6 @@ static int int_strmat_sary_match(STRING *pattern, STRING *text, int stats,
   N = text->length;
 
   num_compares = 0;
-  matchlist = matchtail = NULL;
-  matchcount = 0;
 
   /*
    * "Preprocess" the pattern.
@@ -249,84 +1739,107 @@ static int int_strmat_sary_match(STRING *pattern, STRING *text, int stats,
   if (smstruct == NULL)
     return 0;
 
+  if (kmer_k >= 0 &&
+      !sary_match_kmer_prep(smstruct, text->alpha_size, kmer_k)) {
+    mprintf("Error:  Unable to build a k-mer table of that size for a "
+            "%d character alphabet.\n", text->alpha_size);
+    sary_match_free(smstruct);
+    return 0;
+  }
+
   /*
-   * Perform the matching.
+   * Perform the matching.  The count and first-match modes keep no
+   * positions:  the naive and mlr searches count the matches as the
+   * width of their suffix array interval, and the first match is the
+   * leftmost one (as in the other modes, where the matches are sorted
+   * by their position in the text).
    */
-  matchlist = matchtail = NULL;
-  matchcount = 0;
-
-  s = NULL;
-  switch (type) {
-  case NAIVE_MATCH:  s = sary_match_naive_first(smstruct, P, M);  break;
-  case MLR_MATCH:    s = sary_match_mlr_first(smstruct, P, M);  break;
-  case LCP_MATCH:    s = sary_match_lcp_first(smstruct, P, M);  break;
+  init_results(&results, matchmode);
+
+  matchcount = first = 0;
+  positions = NULL;
+  if (results.mode == MATCH_COUNT || results.mode == MATCH_FIRST) {
+    if (type != LCP_MATCH) {
+      matchcount = sary_match_interval(smstruct, P, M, &lo, &hi);
+      if (results.mode == MATCH_FIRST)
+        first = sary_match_leftmost(smstruct, lo, hi);
+    }
+    else {
+      for (s=sary_match_lcp_first(smstruct, P, M); s != NULL;
+           s=sary_match_lcp_next(smstruct)) {
+        if (matchcount == 0 || s - T + 1 < first)
+          first = s - T + 1;
+        matchcount++;
+      }
+    }
   }
-
-  while (s != NULL) {
-    pos = s - T + 1;
-
-    newmatch = alloc_match();
-    if (newmatch == NULL) {
-      free_matches(matchlist);
+  else {
+    if ((positions = malloc((N + 1) * sizeof(int))) == NULL) {
       sary_match_free(smstruct);
       mprintf("Memory Error:  Ran out of memory.\n");
       return 0;
     }
-    newmatch->type = ONESEQ_EXACT;
-    newmatch->lend = pos;
-    newmatch->rend = pos + M - 1;
 
-    if (matchlist == NULL)
-      matchlist = matchtail = newmatch;
-    else {
-      matchtail->next = newmatch;
-      matchtail = newmatch;
+    s = NULL;
+    switch (type) {
+    case NAIVE_MATCH:  s = sary_match_naive_first(smstruct, P, M);  break;
+    case MLR_MATCH:    s = sary_match_mlr_first(smstruct, P, M);  break;
+    case LCP_MATCH:    s = sary_match_lcp_first(smstruct, P, M);  break;
     }
-    matchcount++;
 
-    switch (type) {
-    case NAIVE_MATCH:  s = sary_match_naive_next(smstruct);  break;
-    case MLR_MATCH:    s = sary_match_mlr_next(smstruct);  break;
-    case LCP_MATCH:    s = sary_match_lcp_next(smstruct);  break;
+    while (s != NULL) {
+      positions[matchcount++] = s - T + 1;
+
+      switch (type) {
+      case NAIVE_MATCH:  s = sary_match_naive_next(smstruct);  break;
+      case MLR_MATCH:    s = sary_match_mlr_next(smstruct);  break;
+      case LCP_MATCH:    s = sary_match_lcp_next(smstruct);  break;
+      }
+    }
+
+    /*
+     * Sort the matches by their position in the text.
+     */
+    if (!sary_match_sort_positions(positions, matchcount, N)) {
+      free(positions);
+      sary_match_free(smstruct);
+      mprintf("Memory Error:  Ran out of memory.\n");
+      return 0;
     }
   }
 
   /*
-   * Bubble sort the matches.
-   */
-  if (matchlist != NULL && matchlist->next != NULL) {
-    flag = 1;
-    while (flag) {
-      flag = 0;
-      back = NULL;
-      current = matchlist;
-      while (current->next != NULL) {
-        if (current->next->lend < current->lend) {
-          /*
-           * Move current->next before current in the list.
-           */
-          next = current->next;
-          current->next = next->next;
-          next->next = current;
-          if (back == NULL)
-            back = matchlist = next;
-          else
-            back = back->next = next;
-          
-          flag = 1;
-        }
-        else {
-          back = current;
-          current = current->next;
-        }
-      }
+   * Build the results.
+   */
+  status = 1;
+  if (results.mode == MATCH_COUNT)
+    add_count(&results, matchcount);
+  else if (results.mode == MATCH_FIRST) {
+    if (matchcount > 0)
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          first, first + M - 1, 0);
+  }
+  else {
+    for (i=0; i < matchcount; i++) {
+      status = add_result(&results, ONESEQ_EXACT, 0, 0,
+                          positions[i], positions[i] + M - 1, 0);
+      if (status != 1)
+        break;
     }
+    free(positions);
+  }
+
+  if (status == -1) {
+    free_results(&results);
+    sary_match_free(smstruct);
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
   }
-    
+
   /*
    * Print the statistics and the matches.
    */
-  print_matches(text, NULL, 0, matchlist, matchcount);
+  print_results(text, NULL, 0, &results);
 
   if (stats) {
     mprintf("Statistics:\n");
@@ -336,6 +1849,11 @@ static int int_strmat_sary_match(STRING *pattern, STRING *text, int stats,
     mprintf("     Number of Compares:  %d\n", smstruct->sary->num_compares);
     mprintf("     Number of Tree Ops:  %d\n", smstruct->sary->num_tree_ops);
     mprintf("     Number of LCP Ops:   %d\n", smstruct->sary->num_lcp_ops);
+    if (smstruct->kmer != NULL) {
+      mprintf("     K-mer Length:        %d\n", smstruct->kmer_k);
+      mprintf("     K-mer Table Size:    %ld bytes\n",
+              (long) ((smstruct->kmer_size + 1) * sizeof(int)));
+    }
     mprintf("\n");
     mprintf("  Searching:\n");
     mprintf("     Pattern Length:          %d\n", M);
@@ -351,7 +1869,7 @@ static int int_strmat_sary_match(STRING *pattern, STRING *text, int stats,
   /*
    * Free everything allocated.
    */
-  free_matches(matchlist);
+  free_results(&results);
   sary_match_free(smstruct);
 
   return 1;
@@ -2,6 +2,31 @@
 int strmat_sary_qsort(STRING *string, int print_stats);
 int strmat_sary_zerkle(STRING *string, int print_stats);
 int strmat_sary_stree(STRING *string, int print_stats);
-int strmat_sary_match_naive(STRING *pattern, STRING *text, int stats);
-int strmat_sary_match_mlr(STRING *pattern, STRING *text, int stats);
-int strmat_sary_match_lcp(STRING *pattern, STRING *text, int stats);
+int strmat_sary_parallel(STRING *string, int nthreads, int print_stats);
+int strmat_sary_parallel_bench(int length, int max_threads);
+int strmat_sary_cmp_bench(int length);
+int strmat_sary_zerkle_parallel(STRING *string, int nthreads, int print_stats);
+int strmat_sary_packed(STRING *string, int width, int print_stats);
+int strmat_sary_packed_match(STRING *pattern, STRING *text, int width,
+                             MATCH_MODE *matchmode, int stats);
+int strmat_sary_fm(STRING *pattern, STRING *text, int sample_rate,
+                   MATCH_MODE *matchmode, int stats);
+int strmat_sary_save(STRING *text, char *path, int sample_rate, int width,
+                     int stats);
+int strmat_sary_ext_save(STRING *text, char *path, char *tmp_dir, int budget,
+                         int stats);
+int strmat_sary_file_match(STRING *pattern, char *path, MATCH_MODE *matchmode,
+                           int stats);
+int strmat_sary_gen_match(STRING *pattern, STRING **strings, int num_strings,
+                          MATCH_MODE *matchmode, int stats);
+int strmat_sary_wt_match(STRING *pattern, STRING *text, int l, int r,
+                         MATCH_MODE *matchmode, int stats);
+int strmat_sary_lce(STRING *string, int small, int print_stats);
+int strmat_sary_match_naive(STRING *pattern, STRING *text,
+                            MATCH_MODE *matchmode, int stats);
+int strmat_sary_match_mlr(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats);
+int strmat_sary_match_lcp(STRING *pattern, STRING *text, MATCH_MODE *matchmode,
+                          int stats);
+int strmat_sary_match_kmer(STRING *pattern, STRING *text, int k,
+                           MATCH_MODE *matchmode, int stats);
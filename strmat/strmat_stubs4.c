@@ -9,8 +9,10 @@
 #include "strmat_print.h"
 #include "stree_strmat.h"
 #include "stree_ukkonen.h"
+#include "sary_esa.h"
 #include "repeats_primitives.h"
 #include "repeats_supermax.h"
+#include "repeats_maxpairs.h"
 #include "repeats_nonoverlapping.h"
 #include "repeats_bigpath.h"
 #include "repeats_tandem.h"
@@ -91,11 +93,11 @@ int strmat_repeats_primitives(STRING *string, int print_stats)
  *
  * Returns:  non-zero on success, zero on error.
  */
+static void print_supermax(STRING *string, SUPERMAXIMALS list);
+
 int strmat_repeats_supermax(STRING *string, int min_percent, int min_length)
 {
-  int pos;
-  char buffer[64];
-  SUPERMAXIMALS list, next;
+  SUPERMAXIMALS list;
 
   if (string == NULL || string->sequence == NULL || string->length == 0)
     return 0;
@@ -105,6 +107,63 @@ int strmat_repeats_supermax(STRING *string, int min_percent, int min_length)
    */
   list = supermax_find(string->sequence, string->length, min_percent,
                        min_length);
+  print_supermax(string, list);
+
+  return 1;
+}
+
+
+/*
+ * strmat_repeats_supermax_esa
+ *
+ * Find the supermaximals for a string, using an enhanced suffix array
+ * in place of the suffix tree.
+ *
+ * Parameters:  string       -  the string
+ *              min_percent  -  min percent for any reported supermaximal
+ *              min_length   -  min length for any reported supermaximal
+ *              print_stats  -  flag telling whether to print the stats
+ *
+ * Returns:  non-zero on success, zero on error.
+ */
+int strmat_repeats_supermax_esa(STRING *string, int min_percent,
+                                int min_length, int print_stats)
+{
+  SARY_ESA *esa;
+  SUPERMAXIMALS list;
+
+  if (string == NULL || string->sequence == NULL || string->length == 0)
+    return 0;
+
+  if ((esa = sary_esa_build(string->sequence, string->length, 0)) == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  list = supermax_find_esa(esa, min_percent, min_length);
+  print_supermax(string, list);
+
+  if (print_stats) {
+    mprintf("\nStatistics:\n");
+#ifdef STATS
+    mprintf("   String Length:          %d\n", string->length);
+    mprintf("   Number of Compares:     %d\n", esa->num_compares);
+#endif
+    mprintf("   Enhanced Suffix Array:  %ld bytes (%.2f bytes/char)\n",
+            esa->mem_bytes, (double) esa->mem_bytes / string->length);
+    mprintf("\n");
+  }
+
+  sary_esa_free(esa);
+
+  return 1;
+}
+
+static void print_supermax(STRING *string, SUPERMAXIMALS list)
+{
+  int pos;
+  char buffer[64];
+  SUPERMAXIMALS next;
 
   mprintf("Supermaximals:\n");
   if (list == NULL)
@@ -129,10 +188,83 @@ int strmat_repeats_supermax(STRING *string, int min_percent, int min_length)
       free(list);
     }
   }
+}
+
+
+/*
+ * strmat_repeats_maxpairs_esa
+ *
+ * Find all of the maximal pairs of a string, using an enhanced suffix
+ * array.
+ *
+ * Parameters:  string       -  the string
+ *              min_length   -  min length for any reported pair
+ *              print_stats  -  flag telling whether to print the stats
+ *
+ * Returns:  non-zero on success, zero on error.
+ */
+static int print_maxpair(int pos1, int pos2, int len, void *data);
+
+int strmat_repeats_maxpairs_esa(STRING *string, int min_length,
+                                int print_stats)
+{
+  int num_pairs;
+  SARY_ESA *esa;
+
+  if (string == NULL || string->sequence == NULL || string->length == 0)
+    return 0;
+
+  if ((esa = sary_esa_build(string->sequence, string->length, 0)) == NULL) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    return 0;
+  }
+
+  mprintf("The following maximal pairs were found:\n\n");
+  num_pairs = maxpairs_find(esa, min_length, print_maxpair, string->raw_seq);
+  if (num_pairs < 0) {
+    mprintf("Memory Error:  Ran out of memory.\n");
+    sary_esa_free(esa);
+    return 0;
+  }
+
+  mprintf("\nSummary:\n");
+  mprintf("   Maximal Pairs:  %d\n", num_pairs);
+
+  if (print_stats) {
+    mprintf("\nStatistics:\n");
+#ifdef STATS
+    mprintf("   String Length:          %d\n", string->length);
+    mprintf("   Number of Compares:     %d\n", esa->num_compares);
+#endif
+    mprintf("   Enhanced Suffix Array:  %ld bytes (%.2f bytes/char)\n",
+            esa->mem_bytes, (double) esa->mem_bytes / string->length);
+    mprintf("\n");
+  }
+
+  sary_esa_free(esa);
 
   return 1;
 }
 
+static int print_maxpair(int pos1, int pos2, int len, void *data)
+{
+  int i, textlen, restlen;
+  char *s, *t, buffer[77];
+
+  sprintf(buffer, "maximal pair (%d,%d,%d): ", pos1, pos2, len);
+  buffer[76] = '\0';
+
+  textlen = strlen(buffer);
+  restlen = 76 - textlen;
+  for (i=0, s=&buffer[textlen], t=(char *) data + pos1 - 1;
+       i < restlen && i < len;
+       i++, s++, t++)
+    *s = isprint((int) *t) ? *t : '#';
+  *s = '\0';
+
+  return mprintf("%s%s\n", buffer, (len > restlen ? "..." : ""));
+}
+
 
 /*
  * strmat_repeats_nonoverlapping
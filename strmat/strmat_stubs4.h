@@ -1,6 +1,10 @@
 
 int strmat_repeats_primitives(STRING *string, int print_stats);
 int strmat_repeats_supermax(STRING *string, int min_percent, int min_length);
+int strmat_repeats_supermax_esa(STRING *string, int min_percent,
+                                int min_length, int print_stats);
+int strmat_repeats_maxpairs_esa(STRING *string, int min_length,
+                                int print_stats);
 int strmat_repeats_nonoverlapping(STRING *string, int print_stats);
 int strmat_repeats_bigpath(STRING *string, int build_policy,
                           int build_threshold, int print_stats);
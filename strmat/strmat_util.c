@@ -174,6 +174,39 @@ int get_bounded(char *label, int low, int high, int def)
 }
 
 
+/*********************************************************************
+*  Function get_filename
+*  
+*  Parameter: label -- label for the prompt
+*
+* get_filename will read a file name from the user and return a copy
+* of it (which the calling function must free), or NULL if the user
+* cancels.
+*
+*********************************************************************/
+
+char *get_filename(char *label)
+{
+  char *filename;
+
+  do {
+    printf("\nEnter %s (Ctl-D to cancel): ", label);
+    if ((inbuf = my_getline(stdin, &buf_len)) == NULL) {
+      printf("\n\n");
+      return NULL;
+    }
+  } while(*inbuf == '\0');
+
+  if ((filename = malloc(buf_len + 1)) == NULL)  {
+    fprintf(stderr, "\nRan out of memory.\n\n");
+    return NULL;
+  }
+  strcpy(filename, inbuf);
+
+  return filename;
+}
+
+
 /********************************************************************** 
  *  Function: list_sequences()
  *                                                                    
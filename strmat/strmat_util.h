@@ -6,6 +6,7 @@ void fread_formatted(void), fread_unformatted(void);
 void fwrite_formatted(void);
 STRING *get_string(char *), **get_string_ary(char *, int *);
 int get_bounded(char *, int, int, int);
+char *get_filename(char *);
 char *get_seq_numbers(char *, int *);
 
 
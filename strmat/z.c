@@ -153,11 +153,11 @@ char *z_search(Z_STRUCT *node, char *T, int N, int initmatch)
    * Run the Z values algorithm over the sequence.  Stop at the first
    * position to match the complete pattern (i.e., Z[k] == M).
    */
-  l = 0;
-  r = (!initmatch ? 0 : M - 1);
+  l = (!initmatch ? 0 : 1);
+  r = (!initmatch ? 0 : M);
   k = (!initmatch ? 1 : 2);
 
-  for ( ; k + M <= N; k++) {
+  for ( ; k + M - 1 <= N; k++) {
     /*
      * Case 1.
      */
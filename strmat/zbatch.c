@@ -0,0 +1,409 @@
+/*
+ * zbatch.c
+ *
+ * Exact matching of a batch of patterns against one text with the Z
+ * values algorithm.  The text is preprocessed once, into the lists of
+ * the positions of each character, and then serves every pattern:  the
+ * scan of the text only ever starts a new Z-box at a position holding
+ * the pattern's first character, so it jumps from one entry of that
+ * character's list to the next in between Z-boxes instead of visiting
+ * every position.  Each pattern's Z values are computed over the
+ * pattern alone (by z_build), the Z-box extensions compare many
+ * characters at a time (using the kernels of sary_cmp.c), and a pool
+ * of threads takes the patterns one at a time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "z.h"
+#include "sary_cmp.h"
+#include "zbatch.h"
+
+
+typedef struct {
+  ZBATCH_TEXT *zt;
+  ZBATCH_STRUCT *zb;
+  char **P;
+  int *M;
+
+  pthread_mutex_t lock;
+  int next_pattern;
+} ZBATCH_SHARED;
+
+typedef struct {
+  ZBATCH_SHARED *sh;
+  int status, prep_compares, num_compares, num_skipped;
+} ZBATCH_WORKER;
+
+static void *zbatch_worker(void *arg);
+static int zbatch_scan(ZBATCH_WORKER *w, ZBATCH_TEXT *zt, Z_STRUCT *node,
+                       int **matches);
+
+
+/*
+ * zbatch_text_prep
+ *
+ * Preprocess a text for the batch search, bucketing its positions by
+ * character (a counting sort, so each list is in increasing order).
+ *
+ * Parameters:   T         -  the text
+ *               N         -  the text length
+ *               copyflag  -  make a copy of the text?
+ *
+ * Returns:  An initialized ZBATCH_TEXT structure, or NULL.
+ */
+ZBATCH_TEXT *zbatch_text_prep(char *T, int N, int copyflag)
+{
+  int c, i, *next;
+  ZBATCH_TEXT *zt;
+
+  if (T == NULL || N < 0)
+    return NULL;
+
+  if ((zt = malloc(sizeof(ZBATCH_TEXT))) == NULL)
+    return NULL;
+  memset(zt, 0, sizeof(ZBATCH_TEXT));
+
+  zt->N = N;
+  zt->copyflag = copyflag;
+
+  if (!copyflag)
+    zt->T = T;
+  else {
+    if ((zt->T = malloc(N + 1)) == NULL) {
+      free(zt);
+      return NULL;
+    }
+    memcpy(zt->T, T, N);
+    zt->T[N] = '\0';
+  }
+
+  zt->start = malloc(257 * sizeof(int));
+  zt->pos = malloc((N + 1) * sizeof(int));
+  next = malloc(256 * sizeof(int));
+  if (zt->start == NULL || zt->pos == NULL || next == NULL) {
+    if (next != NULL)
+      free(next);
+    zbatch_text_free(zt);
+    return NULL;
+  }
+
+  memset(zt->start, 0, 257 * sizeof(int));
+  for (i=0; i < N; i++)
+    zt->start[(unsigned char) zt->T[i] + 1]++;
+  for (c=0; c < 256; c++) {
+    zt->start[c+1] += zt->start[c];
+    next[c] = zt->start[c];
+  }
+  for (i=0; i < N; i++)
+    zt->pos[next[(unsigned char) zt->T[i]]++] = i + 1;
+
+  free(next);
+  return zt;
+}
+
+
+/*
+ * zbatch_search
+ *
+ * Find all of the matches of each of a set of patterns in a
+ * preprocessed text, with a pool of threads each taking the next
+ * unclaimed pattern until none are left.
+ *
+ * Parameters:   zt            -  the preprocessed text
+ *               P             -  the patterns
+ *               M             -  the pattern lengths
+ *               num_patterns  -  the number of patterns
+ *               nthreads      -  the number of threads to use
+ *
+ * Returns:  a ZBATCH_STRUCT holding the matches, or NULL on an error.
+ */
+ZBATCH_STRUCT *zbatch_search(ZBATCH_TEXT *zt, char **P, int *M,
+                             int num_patterns, int nthreads)
+{
+  int i, t, started, status;
+  pthread_t *threads;
+  ZBATCH_STRUCT *zb;
+  ZBATCH_SHARED sh;
+  ZBATCH_WORKER *workers;
+
+  if (zt == NULL || P == NULL || M == NULL || num_patterns <= 0)
+    return NULL;
+  for (i=0; i < num_patterns; i++)
+    if (P[i] == NULL || M[i] <= 0)
+      return NULL;
+  if (nthreads < 1)
+    nthreads = 1;
+  if (nthreads > num_patterns)
+    nthreads = num_patterns;
+
+  if ((zb = malloc(sizeof(ZBATCH_STRUCT))) == NULL)
+    return NULL;
+  memset(zb, 0, sizeof(ZBATCH_STRUCT));
+
+  zb->nthreads = nthreads;
+  zb->num_patterns = num_patterns;
+  zb->matches = malloc(num_patterns * sizeof(int *));
+  zb->num_matches = malloc(num_patterns * sizeof(int));
+  workers = malloc(nthreads * sizeof(ZBATCH_WORKER));
+  if (zb->matches == NULL || zb->num_matches == NULL || workers == NULL) {
+    if (workers != NULL)
+      free(workers);
+    zbatch_free(zb);
+    return NULL;
+  }
+  memset(zb->matches, 0, num_patterns * sizeof(int *));
+  memset(zb->num_matches, 0, num_patterns * sizeof(int));
+
+  memset(&sh, 0, sizeof(ZBATCH_SHARED));
+  sh.zt = zt;
+  sh.zb = zb;
+  sh.P = P;
+  sh.M = M;
+  pthread_mutex_init(&sh.lock, NULL);
+  sh.next_pattern = 0;
+
+  for (t=0; t < nthreads; t++) {
+    memset(&workers[t], 0, sizeof(ZBATCH_WORKER));
+    workers[t].sh = &sh;
+    workers[t].status = 1;
+  }
+
+  /*
+   * Run the threads (or just the calling thread).  If a thread cannot be
+   * started, the ones that were share the patterns between them.
+   */
+  started = 0;
+  if (nthreads > 1 &&
+      (threads = malloc(nthreads * sizeof(pthread_t))) != NULL) {
+    for (t=0; t < nthreads; t++) {
+      if (pthread_create(&threads[t], NULL, zbatch_worker, &workers[t]) != 0)
+        break;
+      started++;
+    }
+    for (t=0; t < started; t++)
+      pthread_join(threads[t], NULL);
+    free(threads);
+  }
+  if (started == 0) {
+    zbatch_worker(&workers[0]);
+    started = 1;
+  }
+
+  status = 1;
+  for (t=0; t < started; t++) {
+    if (!workers[t].status)
+      status = 0;
+#ifdef STATS
+    zb->prep_compares += workers[t].prep_compares;
+    zb->num_compares += workers[t].num_compares;
+    zb->num_skipped += workers[t].num_skipped;
+#endif
+  }
+
+  free(workers);
+  pthread_mutex_destroy(&sh.lock);
+
+  if (!status) {
+    zbatch_free(zb);
+    return NULL;
+  }
+
+  return zb;
+}
+
+
+/*
+ * zbatch_worker
+ *
+ * The thread body:  compute the Z values of the next unclaimed pattern
+ * and scan the text with them, until there are no patterns left.
+ */
+static void *zbatch_worker(void *arg)
+{
+  int i;
+  Z_STRUCT *node;
+  ZBATCH_WORKER *w;
+  ZBATCH_SHARED *sh;
+
+  w = (ZBATCH_WORKER *) arg;
+  sh = w->sh;
+
+  while (w->status) {
+    pthread_mutex_lock(&sh->lock);
+    i = (sh->next_pattern < sh->zb->num_patterns ? sh->next_pattern++ : -1);
+    pthread_mutex_unlock(&sh->lock);
+    if (i < 0)
+      break;
+
+    if ((node = z_build(sh->P[i], sh->M[i], 0)) == NULL) {
+      w->status = 0;
+      break;
+    }
+#ifdef STATS
+    w->prep_compares += node->prep_compares;
+#endif
+
+    sh->zb->num_matches[i] = zbatch_scan(w, sh->zt, node,
+                                         &sh->zb->matches[i]);
+    if (sh->zb->num_matches[i] < 0)
+      w->status = 0;
+
+    z_free(node);
+  }
+
+  return NULL;
+}
+
+
+/*
+ * zbatch_scan
+ *
+ * Run the Z values algorithm for one pattern over the whole text, as
+ * z_search does, except that when the scan is past the current Z-box,
+ * it jumps to the next position holding the pattern's first character
+ * (every position skipped has a Z value of 0 and leaves the Z-box as
+ * it is), and that the characters are compared by sary_cmp_length.
+ *
+ * Returns:  the number of matches (stored in a new array in *matches),
+ *           or -1 if memory ran out.
+ */
+static int zbatch_scan(ZBATCH_WORKER *w, ZBATCH_TEXT *zt, Z_STRUCT *node,
+                       int **matches)
+{
+  int j, k, l, r, M, N, ZT, beta, kprime, num, size, *Z, *list, *cur, *end;
+  char *P, *T;
+
+  P = node->S;      /* The pattern is P[1],...,P[M] */
+  M = node->M;
+  Z = node->Z;
+  T = zt->T - 1;    /* Shift to make the text be T[1],...,T[N] */
+  N = zt->N;
+
+  cur = zt->pos + zt->start[(unsigned char) P[1]];
+  end = zt->pos + zt->start[(unsigned char) P[1] + 1];
+
+  *matches = NULL;
+  num = size = 0;
+
+  l = r = 0;
+  for (k=1; k + M - 1 <= N; k++) {
+    /*
+     * Case 1, starting at the next occurrence of P[1].
+     */
+    if (k > r) {
+      while (cur < end && *cur < k)
+        cur++;
+      if (cur == end || *cur + M - 1 > N)
+        break;
+
+#ifdef STATS
+      w->num_skipped += *cur - k;
+#endif
+
+      k = *cur;
+      j = sary_cmp_length(P + 1, T + k, M);
+
+#ifdef STATS
+      w->num_compares += j + 1;
+#endif
+
+      ZT = j;
+      r = k + j - 1;
+      l = k;
+    }
+
+    else {
+      beta = r - k + 1;
+      kprime = k - l + 1;
+
+      /*
+       * Case 2a and case 2b.
+       */
+      if (Z[kprime] < beta)
+        ZT = Z[kprime];
+      else {
+        j = 1 + sary_cmp_length(P + beta + 1, T + r + 1,
+                                (M - beta < N - r ? M - beta : N - r));
+
+#ifdef STATS
+        w->num_compares += j;
+#endif
+
+        ZT = r + j - k;
+        r = r + j - 1;
+        l = k;
+      }
+    }
+
+    if (ZT == M) {
+      if (num == size) {
+        size = (size == 0 ? 64 : 2 * size);
+        if ((list = realloc(*matches, size * sizeof(int))) == NULL) {
+          if (*matches != NULL)
+            free(*matches);
+          *matches = NULL;
+          return -1;
+        }
+        *matches = list;
+      }
+      (*matches)[num++] = k;
+    }
+  }
+
+  return num;
+}
+
+
+/*
+ * zbatch_free
+ *
+ * Free up the allocated ZBATCH_STRUCT structure.
+ *
+ * Parameters:   zb  -  a ZBATCH_STRUCT structure
+ *
+ * Returns:  nothing.
+ */
+void zbatch_free(ZBATCH_STRUCT *zb)
+{
+  int i;
+
+  if (zb == NULL)
+    return;
+
+  if (zb->matches != NULL) {
+    for (i=0; i < zb->num_patterns; i++)
+      if (zb->matches[i] != NULL)
+        free(zb->matches[i]);
+    free(zb->matches);
+  }
+  if (zb->num_matches != NULL)
+    free(zb->num_matches);
+  free(zb);
+}
+
+
+/*
+ * zbatch_text_free
+ *
+ * Free up the allocated ZBATCH_TEXT structure.
+ *
+ * Parameters:   zt  -  a ZBATCH_TEXT structure
+ *
+ * Returns:  nothing.
+ */
+void zbatch_text_free(ZBATCH_TEXT *zt)
+{
+  if (zt == NULL)
+    return;
+
+  if (zt->copyflag && zt->T != NULL)
+    free(zt->T);
+  if (zt->start != NULL)
+    free(zt->start);
+  if (zt->pos != NULL)
+    free(zt->pos);
+  free(zt);
+}
@@ -0,0 +1,25 @@
+#ifndef _ZBATCH_H_
+#define _ZBATCH_H_
+
+typedef struct {
+  char *T;
+  int N, copyflag;
+  int *start;              /* pos[start[c]..start[c+1]-1] hold the */
+  int *pos;                /*   positions (1-based) of character c  */
+} ZBATCH_TEXT;
+
+typedef struct {
+  int nthreads, num_patterns;
+
+  int **matches, *num_matches;  /* each pattern's matches, in text order */
+
+  int prep_compares, num_compares, num_skipped;
+} ZBATCH_STRUCT;
+
+ZBATCH_TEXT *zbatch_text_prep(char *T, int N, int copyflag);
+ZBATCH_STRUCT *zbatch_search(ZBATCH_TEXT *zt, char **P, int *M,
+                             int num_patterns, int nthreads);
+void zbatch_free(ZBATCH_STRUCT *zb);
+void zbatch_text_free(ZBATCH_TEXT *zt);
+
+#endif